@@ -698,31 +698,62 @@ if (!(exp))                   \
 /************************************************************************/
 // BASIS Loading
 /************************************************************************/
-static bool loadBASISTextureDesc(FileStream* pStream, TextureDesc* pOutDesc, void** ppOutData, uint32_t* pOutDataSize)
+/// Everything the per-level transcode jobs need once the header has been parsed.
+/// The file contents stay resident until unloadBASISTexture so that image levels can be transcoded
+/// independently (and concurrently) straight into the destination memory.
+typedef struct BASISTextureInfo
+{
+	void*                                  pData;
+	uint32_t                               mDataSize;
+	basist::transcoder_texture_format      mTranscodeFormat;
+	basist::etc1_global_selector_codebook* pCodebook;
+	basist::basisu_transcoder*             pDecoder;
+} BASISTextureInfo;
+
+static void unloadBASISTexture(BASISTextureInfo* pInfo)
+{
+	if (pInfo->pDecoder)
+		tf_delete(pInfo->pDecoder);
+	if (pInfo->pCodebook)
+		tf_delete(pInfo->pCodebook);
+	if (pInfo->pData)
+		tf_free(pInfo->pData);
+
+	*pInfo = {};
+}
+
+/// Parses the file header, fills the texture description and prepares the decoder for transcoding.
+/// No image data is transcoded here, see transcodeBASISImageLevel.
+static bool loadBASISTextureHeader(FileStream* pStream, TextureDesc* pOutDesc, BASISTextureInfo* pOutInfo)
 {
 	if (pStream == NULL || fsGetStreamFileSize(pStream) <= 0)
 		return false;
 
-	basist::etc1_global_selector_codebook sel_codebook(basist::g_global_selector_cb_size, basist::g_global_selector_cb);
+	BASISTextureInfo& info = *pOutInfo;
+	info = {};
 
 	size_t memSize = (size_t)fsGetStreamFileSize(pStream);
-	void* basisData = tf_malloc(memSize);
-	fsReadFromStream(pStream, basisData, memSize);
+	info.pData = tf_malloc(memSize);
+	info.mDataSize = (uint32_t)memSize;
+	fsReadFromStream(pStream, info.pData, memSize);
 
-	basist::basisu_transcoder decoder(&sel_codebook);
+	info.pCodebook = tf_new(basist::etc1_global_selector_codebook, basist::g_global_selector_cb_size, basist::g_global_selector_cb);
+	info.pDecoder = tf_new(basist::basisu_transcoder, info.pCodebook);
+	basist::basisu_transcoder& decoder = *info.pDecoder;
 
 	basist::basisu_file_info fileinfo;
-	if (!decoder.get_file_info(basisData, (uint32_t)memSize, fileinfo))
+	if (!decoder.get_file_info(info.pData, info.mDataSize, fileinfo))
 	{
 		LOGF(LogLevel::eERROR, "Failed retrieving Basis file information!");
+		unloadBASISTexture(&info);
 		return false;
 	}
 
 	ASSERT(fileinfo.m_total_images == fileinfo.m_image_mipmap_levels.size());
-	ASSERT(fileinfo.m_total_images == decoder.get_total_images(basisData, (uint32_t)memSize));
+	ASSERT(fileinfo.m_total_images == decoder.get_total_images(info.pData, info.mDataSize));
 
 	basist::basisu_image_info imageinfo;
-	decoder.get_image_info(basisData, (uint32_t)memSize, imageinfo, 0);
+	decoder.get_image_info(info.pData, info.mDataSize, imageinfo, 0);
 
 	TextureDesc& textureDesc = *pOutDesc;
 	textureDesc.mWidth = imageinfo.m_width;
@@ -779,74 +810,42 @@ static bool loadBASISTextureDesc(FileStream* pStream, TextureDesc* pOutDesc, voi
 	}
 #endif
 
-	decoder.start_transcoding(basisData, (uint32_t)memSize);
-
-	uint32_t requiredSize = util_get_surface_size(textureDesc.mFormat,
-		textureDesc.mWidth, textureDesc.mHeight, textureDesc.mDepth, 1, 1,
-		0, textureDesc.mMipLevels,
-		0, textureDesc.mArraySize);
-	void* startData = tf_malloc(requiredSize);
-	uint8_t* data = (uint8_t*)startData;
+	info.mTranscodeFormat = basisTextureFormat;
 
-	for (uint32_t s = 0; s < fileinfo.m_total_images; ++s)
+	// Only reads the file after this point, so transcodeBASISImageLevel can be called from several threads
+	if (!decoder.start_transcoding(info.pData, info.mDataSize))
 	{
-		uint32_t w = textureDesc.mWidth;
-		uint32_t h = textureDesc.mHeight;
-		uint32_t d = textureDesc.mDepth;
-
-		for (uint32_t m = 0; m < fileinfo.m_image_mipmap_levels[s]; ++m)
-		{
-			uint32_t rowPitch = 0;
-			uint32_t numBytes = 0;
-			if (!util_get_surface_info(w, h, textureDesc.mFormat, &numBytes, &rowPitch, NULL))
-			{
-				return false;
-			}
-
-			uint32_t rowPitchInBlocks = rowPitch / (TinyImageFormat_BitSizeOfBlock(textureDesc.mFormat) >> 3);
-			basist::basisu_image_level_info level_info;
-
-			if (!decoder.get_image_level_info(basisData, (uint32_t)memSize, level_info, s, m))
-			{
-				LOGF(LogLevel::eERROR, "Failed retrieving image level information (%u %u)!\n", s, m);
-				tf_free(basisData);
-				tf_free(startData);
-				return false;
-			}
+		LOGF(LogLevel::eERROR, "Failed starting Basis transcoding!");
+		unloadBASISTexture(&info);
+		return false;
+	}
 
-			if (!decoder.transcode_image_level(basisData, (uint32_t)memSize, s, m, data,
-				(uint32_t)(rowPitchInBlocks * imageinfo.m_num_blocks_y), basisTextureFormat, 0, rowPitchInBlocks))
-			{
-				LOGF(LogLevel::eERROR, "Failed transcoding image level (%u %u)!", s, m);
-				tf_free(basisData);
-				tf_free(startData);
-				return false;
-			}
+	return true;
+}
 
-			data += numBytes;
+/// Transcodes a single image level into pDst, which has to be large enough for numRows * dstRowPitch bytes.
+/// Thread safe as long as every caller uses its own destination memory.
+static bool transcodeBASISImageLevel(
+	const BASISTextureInfo* pInfo, TinyImageFormat fmt, uint32_t image, uint32_t level, uint8_t* pDst, uint32_t dstRowPitch, uint32_t dstSize)
+{
+	uint32_t rowPitchInBlocks = dstRowPitch / (TinyImageFormat_BitSizeOfBlock(fmt) >> 3);
+	uint32_t blockCount = dstSize / (TinyImageFormat_BitSizeOfBlock(fmt) >> 3);
 
-			w = w >> 1;
-			h = h >> 1;
-			d = d >> 1;
-			if (w == 0)
-			{
-				w = 1;
-			}
-			if (h == 0)
-			{
-				h = 1;
-			}
-			if (d == 0)
-			{
-				d = 1;
-			}
-		}
+	basist::basisu_image_level_info level_info;
+	if (!pInfo->pDecoder->get_image_level_info(pInfo->pData, pInfo->mDataSize, level_info, image, level))
+	{
+		LOGF(LogLevel::eERROR, "Failed retrieving image level information (%u %u)!\n", image, level);
+		return false;
 	}
 
-	tf_free(basisData);
-
-	*ppOutData = startData;
-	*pOutDataSize = requiredSize;
+	// The decoder's default state is shared, every level gets its own so levels can run in parallel
+	basist::basisu_transcoder_state state;
+	if (!pInfo->pDecoder->transcode_image_level(pInfo->pData, pInfo->mDataSize, image, level, pDst,
+		blockCount, pInfo->mTranscodeFormat, 0, rowPitchInBlocks, &state))
+	{
+		LOGF(LogLevel::eERROR, "Failed transcoding image level (%u %u)!", image, level);
+		return false;
+	}
 
 	return true;
 }
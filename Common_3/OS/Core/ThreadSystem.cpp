@@ -25,6 +25,7 @@
 #include "../Interfaces/IThread.h"
 #include "../Interfaces/ILog.h"
 
+#include "Atomics.h"
 #include "ThreadSystem.h"
 #include "../Interfaces/IMemory.h"
 
@@ -248,6 +249,41 @@ void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void*
 	pThreadSystem->mQueueCond.WakeAll();
 }
 
+struct RangeTaskAndWait
+{
+	TaskFunc        mTask;
+	void*           pUser;
+	tfrg_atomic32_t mRemaining;
+};
+
+static void rangeTaskAndWaitFunc(void* pUser, uintptr_t index)
+{
+	RangeTaskAndWait* pJob = (RangeTaskAndWait*)pUser;
+	pJob->mTask(pJob->pUser, index);
+	tfrg_atomic32_add_relaxed(&pJob->mRemaining, -1);
+}
+
+void runThreadSystemRangeTaskAndWait(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t count)
+{
+	if (!pThreadSystem || count <= 1)
+	{
+		for (uintptr_t i = 0; i < count; ++i)
+			task(user, i);
+		return;
+	}
+
+	RangeTaskAndWait job = { task, user, 0 };
+	tfrg_atomic32_store_relaxed(&job.mRemaining, (uint32_t)count);
+	addThreadSystemRangeTask(pThreadSystem, rangeTaskAndWaitFunc, &job, count);
+
+	// Help out instead of spinning while tasks are still running
+	while (tfrg_atomic32_load_acquire(&job.mRemaining))
+	{
+		if (!assistThreadSystem(pThreadSystem))
+			Thread::Sleep(0);
+	}
+}
+
 void shutdownThreadSystem(ThreadSystem* pThreadSystem)
 {
 	pThreadSystem->mQueueMutex.Acquire();
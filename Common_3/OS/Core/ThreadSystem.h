@@ -55,6 +55,10 @@ void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void*
 void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t start, uintptr_t end);
 void addThreadSystemTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t index = 0);
 
+// Runs task for [0, count) on the workers and returns once all of them are done, the calling thread helps out meanwhile.
+// Without a thread system or with a single index everything runs inline on the calling thread.
+void runThreadSystemRangeTaskAndWait(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t count);
+
 uint32_t getThreadSystemThreadCount(ThreadSystem* pThreadSystem);
 
 bool assistThreadSystemTasks(ThreadSystem* pThreadSystem, uint32_t* pIds, size_t count);
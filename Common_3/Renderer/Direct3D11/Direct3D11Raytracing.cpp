@@ -21,4 +21,5 @@ void removeRaytracingShaderTable(Raytracing* /*pRaytracing*/, RaytracingShaderTa
 
 void cmdBuildAccelerationStructure(Cmd* /*pCmd*/, Raytracing* /*pRaytracing*/, RaytracingBuildASDesc* /*pDesc*/) {}
 void cmdDispatchRays(Cmd* /*pCmd*/, Raytracing* /*pRaytracing*/, const RaytracingDispatchDesc* /*pDesc*/) {}
+void beginRaytracingFrame(Raytracing* /*pRaytracing*/, uint32_t /*frameIndex*/) {}
 
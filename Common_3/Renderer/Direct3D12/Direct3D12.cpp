@@ -5280,7 +5280,9 @@ void cmdResourceBarrier(Cmd* pCmd,
 				pBarrier->Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
 			}
 			pBarrier->Transition.pResource = pTexture->pDxResource;
-			pBarrier->Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+			pBarrier->Transition.Subresource = pTransBarrier->mSubresourceBarrier
+				? D3D12CalcSubresource(pTransBarrier->mMipLevel, pTransBarrier->mArrayLayer, 0, pTexture->mMipLevels, pTexture->mArraySizeMinusOne + 1)
+				: D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
 			pBarrier->Transition.StateBefore = util_to_dx_resource_state(pTransBarrier->mCurrentState);
 			pBarrier->Transition.StateAfter = util_to_dx_resource_state(pTransBarrier->mNewState);
 
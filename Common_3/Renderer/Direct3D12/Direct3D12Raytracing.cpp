@@ -668,6 +668,11 @@ void cmdDispatchRays(Cmd* pCmd, Raytracing* pRaytracing, const RaytracingDispatc
 	pDxrCmd->DispatchRays(&dispatchDesc);
 	pDxrCmd->Release();
 }
+
+// The dispatches need no scratch memory
+void beginRaytracingFrame(Raytracing* /*pRaytracing*/, uint32_t /*frameIndex*/)
+{
+}
 /************************************************************************/
 // Utility Functions Implementation
 /************************************************************************/
@@ -1046,6 +1051,10 @@ void cmdDispatchRays(Cmd* pCmd, Raytracing* pRaytracing, const RaytracingDispatc
 {
 }
 
+void beginRaytracingFrame(Raytracing* pRaytracing, uint32_t frameIndex)
+{
+}
+
 void removeAccelerationStructure(Raytracing* pRaytracing, AccelerationStructure* pAccelerationStructure)
 {
 }
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2018-2020 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+
+#pragma once
+
+#include "../Renderer/IRenderer.h"
+
+// Records command lists on ThreadSystem workers.
+// Every slot owns a CmdPool per frame in flight, so a worker never shares a pool with another thread while recording.
+// Command lists are returned in slot order, independent of which thread recorded them or when it finished,
+// so submitting them in that order keeps the GPU work deterministic.
+
+struct ThreadSystem;
+
+typedef struct ParallelCmdRecorderDesc
+{
+	/// Queue the recorded command lists will be submitted to
+	Queue*        pQueue;
+	/// Workers recording the command lists. Everything is recorded on the calling thread when NULL.
+	ThreadSystem* pThreadSystem;
+	/// Frames in flight, each one gets its own set of pools
+	uint32_t      mFrameCount;
+	/// Maximum number of command lists recorded per frame
+	uint32_t      mMaxCmdCount;
+} ParallelCmdRecorderDesc;
+
+/// Records one command list. Called between beginCmd and endCmd, on any thread.
+typedef void (*ParallelCmdRecordFunc)(void* pUserData, Cmd* pCmd, uint32_t cmdIndex);
+
+typedef struct ParallelCmdRecorder ParallelCmdRecorder;
+
+void addParallelCmdRecorder(Renderer* pRenderer, const ParallelCmdRecorderDesc* pDesc, ParallelCmdRecorder** ppRecorder);
+void removeParallelCmdRecorder(Renderer* pRenderer, ParallelCmdRecorder* pRecorder);
+
+/// Resets the pools of frameIndex. The GPU has to be done with the command lists recorded for that frame.
+void resetParallelCmdRecorder(Renderer* pRenderer, ParallelCmdRecorder* pRecorder, uint32_t frameIndex);
+
+/// Records cmdCount command lists for frameIndex and waits until all of them are recorded. The calling thread helps out while waiting.
+/// ppOutCmds[i] is the command list pfnRecord was called with for cmdIndex i.
+/// Can be called several times per frame as long as the total stays below mMaxCmdCount.
+void recordParallelCmds(
+	ParallelCmdRecorder* pRecorder, uint32_t frameIndex, uint32_t cmdCount, ParallelCmdRecordFunc pfnRecord, void* pUserData,
+	Cmd** ppOutCmds);
+
+/// Splits itemCount items into cmdCount contiguous ranges of nearly equal size and returns the range of cmdIndex
+void getParallelCmdRange(uint32_t itemCount, uint32_t cmdCount, uint32_t cmdIndex, uint32_t* pFirstItem, uint32_t* pItemCount);
@@ -218,6 +218,9 @@ API_INTERFACE void FORGE_CALLCONV removeRaytracingShaderTable(Raytracing* pRaytr
 
 API_INTERFACE void FORGE_CALLCONV cmdBuildAccelerationStructure(Cmd* pCmd, Raytracing* pRaytracing, RaytracingBuildASDesc* pDesc);
 API_INTERFACE void FORGE_CALLCONV cmdDispatchRays(Cmd* pCmd, Raytracing* pRaytracing, const RaytracingDispatchDesc* pDesc);
+/// Call once per frame before its cmdDispatchRays, after waiting for the GPU to finish the last frame with the same frameIndex
+/// The scratch memory of the dispatches is recycled per frameIndex, which has to stay below 3 (the frames in flight)
+API_INTERFACE void FORGE_CALLCONV beginRaytracingFrame(Raytracing* pRaytracing, uint32_t frameIndex);
 
 #ifdef METAL
 API_INTERFACE void FORGE_CALLCONV addSSVGFDenoiser(Renderer* pRenderer, SSVGFDenoiser** ppDenoiser);
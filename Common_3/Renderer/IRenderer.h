@@ -673,6 +673,11 @@ typedef struct TextureBarrier
 	uint8_t        mAcquire : 1;
 	uint8_t        mRelease : 1;
 	uint8_t        mQueueType : 5;
+	/// Specifiy whether following barrier targets particular subresource
+	uint8_t        mSubresourceBarrier : 1;
+	/// Following values are ignored if mSubresourceBarrier is false
+	uint8_t        mMipLevel : 7;
+	uint16_t       mArrayLayer;
 } TextureBarrier;
 
 typedef struct RenderTargetBarrier
@@ -79,6 +79,8 @@ typedef struct TextureLoadDesc
 	TextureCreationFlags mCreationFlag;
 	/// The texture file format (dds/ktx/...)
 	TextureContainerType mContainer;
+	/// Only upload the mip tail on load. Higher mips get streamed in afterwards by updateTextureStreaming (DDS only)
+	bool                 mStreamMips;
 } TextureLoadDesc;
 
 typedef struct Geometry
@@ -95,6 +97,12 @@ typedef struct Geometry
 		void*                   pAttributes[MAX_VERTEX_ATTRIBS];
 	};
 
+	struct Bounds
+	{
+		float3                  mMin;
+		float3                  mMax;
+	};
+
 	/// Index buffer to bind when drawing this geometry
 	Buffer*                     pIndexBuffer;
 	/// The array of vertex buffers to bind when drawing this geometry
@@ -102,6 +110,8 @@ typedef struct Geometry
 	uint32_t                    mVertexStrides[MAX_VERTEX_BINDINGS];
 	/// The array of traditional draw arguments to draw each subset in this geometry
 	IndirectDrawIndexArguments* pDrawArgs;
+	/// Object-space bounding box of the positions of each subset, same order as pDrawArgs
+	Bounds*                     pDrawBounds;
 	/// Shadow copy of the geometry vertex and index data if requested through the load flags
 	ShadowData*                 pShadow;
 
@@ -125,10 +135,9 @@ typedef struct Geometry
 	/// Number of vertices in the geometry
 	uint32_t                    mVertexCount;
 
+#if defined(_WINDOWS) && !defined(_WIN64)
 	uint32_t                    mPadA;
 	uint32_t                    mPadB;
-#if defined(_WINDOWS) && !defined(_WIN64)
-	uint32_t                    mPadC;
 #endif
 } Geometry;
 static_assert(sizeof(Geometry) % 16 == 0, "GLTFContainer size must be a multiple of 16");
@@ -321,6 +330,16 @@ SyncToken getLastTokenCompleted();
 bool isTokenCompleted(const SyncToken* token);
 void waitForToken(const SyncToken* token);
 
+// MARK: Texture Streaming
+
+/// Publishes the mips which finished uploading and queues the next mip of the highest priority textures
+/// loaded with TextureLoadDesc::mStreamMips. At most frameBudget bytes are queued per call (at least one mip).
+void updateTextureStreaming(uint64_t frameBudget);
+/// Higher priority textures get their next mip queued first
+void setTextureStreamingPriority(Texture* pTexture, float priority);
+/// Most detailed mip which can be sampled. 0 for textures which are not streamed.
+uint32_t getTextureResidentMip(Texture* pTexture);
+
 /// Either loads the cached shader bytecode or compiles the shader to create new bytecode depending on whether source is newer than binary
 void addShader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** pShader);
 
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2018-2020 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#pragma once
+
+#include "../Renderer/IRenderer.h"
+
+// Records the current state of textures and render targets so passes only have to say which state they need.
+// Requests are merged until cmdFlushResourceStates, which issues all of them as one batched barrier.
+// Requests for the state a resource is already in are dropped.
+// A tracker is not thread safe, use one per thread / command list.
+
+typedef struct ResourceStateTrackerStats
+{
+	/// Transitions recorded into command lists
+	uint32_t mIssuedBarriers;
+	/// Requests which were dropped because the resource was already in that state or a later request overrode them
+	uint32_t mElidedBarriers;
+	/// Number of cmdResourceBarrier calls made by cmdFlushResourceStates
+	uint32_t mBatches;
+} ResourceStateTrackerStats;
+
+typedef struct ResourceStateTracker ResourceStateTracker;
+
+void addResourceStateTracker(Renderer* pRenderer, ResourceStateTracker** ppTracker);
+void removeResourceStateTracker(Renderer* pRenderer, ResourceStateTracker* pTracker);
+
+/// Starts tracking a resource which is currently in state
+void trackTextureState(ResourceStateTracker* pTracker, Texture* pTexture, ResourceState state);
+void trackRenderTargetState(ResourceStateTracker* pTracker, RenderTarget* pRenderTarget, ResourceState state);
+/// Stops tracking a resource. Pending requests for it are dropped.
+void untrackTextureState(ResourceStateTracker* pTracker, Texture* pTexture);
+void untrackRenderTargetState(ResourceStateTracker* pTracker, RenderTarget* pRenderTarget);
+
+/// Asks for the resource to be in state before the next command using it. Recorded on the next flush.
+/// Requesting RESOURCE_STATE_UNORDERED_ACCESS while already in it issues a UAV barrier.
+void requestTextureState(ResourceStateTracker* pTracker, Texture* pTexture, ResourceState state);
+void requestRenderTargetState(ResourceStateTracker* pTracker, RenderTarget* pRenderTarget, ResourceState state);
+
+/// State after all flushed requests
+ResourceState getTrackedTextureState(ResourceStateTracker* pTracker, Texture* pTexture);
+ResourceState getTrackedRenderTargetState(ResourceStateTracker* pTracker, RenderTarget* pRenderTarget);
+
+/// Records every pending transition with a single cmdResourceBarrier call
+void cmdFlushResourceStates(Cmd* pCmd, ResourceStateTracker* pTracker);
+
+void getResourceStateTrackerStats(ResourceStateTracker* pTracker, ResourceStateTrackerStats* pStats);
+void resetResourceStateTrackerStats(ResourceStateTracker* pTracker);
@@ -221,6 +221,8 @@ kernel void classifyIntersections(constant ClassifyIntersectionsArguments& argum
 #define MAX_BUFFER_BINDINGS 31
 
 #define THREADS_PER_THREADGROUP 64
+// Frames the ray sorting scratch memory is kept for, the frameIndex of beginRaytracingFrame has to stay below it
+#define MAX_RAYTRACING_FRAMES 3
 
 extern void mtl_createShaderReflection(Renderer* pRenderer, Shader* shader, const uint8_t* shaderCode, uint32_t shaderSize, ShaderStage shaderStage, eastl::unordered_map<uint32_t, MTLVertexFormat>* vertexAttributeFormats, ShaderReflection* pOutReflection);
 extern void add_texture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** pTexture, const bool isRT);
@@ -338,7 +340,7 @@ bool initRaytracing(Renderer* pRenderer, Raytracing** ppRaytracing)
 	pRaytracing->pIntersector.rayMaskOptions = MPSRayMaskOptionPrimitive;
 	pRaytracing->pRenderer = pRenderer;
 	
-	pRaytracing->pParallelPrimitives = tf_new(ParallelPrimitives, pRenderer);
+	pRaytracing->pParallelPrimitives = tf_new(ParallelPrimitives, pRenderer, MAX_RAYTRACING_FRAMES);
 	
 	NSString* classificationShaderSource = [NSString stringWithUTF8String:pClassificationShader];
 	NSError* error = nil;
@@ -1452,6 +1454,13 @@ void cmdDispatchRays(Cmd* pCmd, Raytracing* pRaytracing, const RaytracingDispatc
 				  threadgroups);
 }
 
+void beginRaytracingFrame(Raytracing* pRaytracing, uint32_t frameIndex)
+{
+	// The caller waited for the last frame with this index, so its ray sorting scratch memory can be handed out again
+	ASSERT(frameIndex < MAX_RAYTRACING_FRAMES);
+	pRaytracing->pParallelPrimitives->beginFrame(frameIndex);
+}
+
 void mtl_cmdBindRaytracingPipeline(Cmd* pCmd, Pipeline* pPipeline)
 {
 	UNREF_PARAM(pCmd);
@@ -1582,6 +1591,10 @@ void cmdDispatchRays(Cmd* pCmd, Raytracing* pRaytracing, const RaytracingDispatc
 {
 }
 
+void beginRaytracingFrame(Raytracing* pRaytracing, uint32_t frameIndex)
+{
+}
+
 void removeAccelerationStructure(Raytracing* pRaytracing, AccelerationStructure* pAccelerationStructure)
 {
 }
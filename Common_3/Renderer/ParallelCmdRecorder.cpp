@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2018-2020 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+
+#include "IParallelCmdRecorder.h"
+
+#include "../OS/Core/ThreadSystem.h"
+
+#include "../OS/Interfaces/ILog.h"
+
+#include "../OS/Interfaces/IMemory.h"
+
+struct ParallelCmdRecorder
+{
+	ThreadSystem* pThreadSystem;
+	uint32_t      mFrameCount;
+	uint32_t      mMaxCmdCount;
+	/// mFrameCount * mMaxCmdCount, indexed by frameIndex * mMaxCmdCount + slot
+	CmdPool**     ppCmdPools;
+	Cmd**         ppCmds;
+	/// Slots already handed out for each frame since its last reset
+	uint32_t*     pUsedCmdCounts;
+};
+
+typedef struct ParallelCmdRecordJob
+{
+	ParallelCmdRecordFunc pfnRecord;
+	void*                 pUserData;
+	Cmd**                 ppCmds;
+} ParallelCmdRecordJob;
+
+static void recordParallelCmdTask(void* pUser, uintptr_t index)
+{
+	ParallelCmdRecordJob* pJob = (ParallelCmdRecordJob*)pUser;
+	Cmd* pCmd = pJob->ppCmds[index];
+
+	beginCmd(pCmd);
+	pJob->pfnRecord(pJob->pUserData, pCmd, (uint32_t)index);
+	endCmd(pCmd);
+}
+
+void addParallelCmdRecorder(Renderer* pRenderer, const ParallelCmdRecorderDesc* pDesc, ParallelCmdRecorder** ppRecorder)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(pDesc->pQueue);
+	ASSERT(pDesc->mFrameCount && pDesc->mMaxCmdCount);
+	ASSERT(ppRecorder);
+
+	const uint32_t totalCount = pDesc->mFrameCount * pDesc->mMaxCmdCount;
+
+	ParallelCmdRecorder* pRecorder = (ParallelCmdRecorder*)tf_calloc(1, sizeof(ParallelCmdRecorder));
+	pRecorder->pThreadSystem = pDesc->pThreadSystem;
+	pRecorder->mFrameCount = pDesc->mFrameCount;
+	pRecorder->mMaxCmdCount = pDesc->mMaxCmdCount;
+	pRecorder->ppCmdPools = (CmdPool**)tf_calloc(totalCount, sizeof(CmdPool*));
+	pRecorder->ppCmds = (Cmd**)tf_calloc(totalCount, sizeof(Cmd*));
+	pRecorder->pUsedCmdCounts = (uint32_t*)tf_calloc(pDesc->mFrameCount, sizeof(uint32_t));
+
+	for (uint32_t i = 0; i < totalCount; ++i)
+	{
+		CmdPoolDesc cmdPoolDesc = {};
+		cmdPoolDesc.pQueue = pDesc->pQueue;
+		addCmdPool(pRenderer, &cmdPoolDesc, &pRecorder->ppCmdPools[i]);
+
+		CmdDesc cmdDesc = {};
+		cmdDesc.pPool = pRecorder->ppCmdPools[i];
+		addCmd(pRenderer, &cmdDesc, &pRecorder->ppCmds[i]);
+	}
+
+	*ppRecorder = pRecorder;
+}
+
+void removeParallelCmdRecorder(Renderer* pRenderer, ParallelCmdRecorder* pRecorder)
+{
+	ASSERT(pRenderer);
+	ASSERT(pRecorder);
+
+	const uint32_t totalCount = pRecorder->mFrameCount * pRecorder->mMaxCmdCount;
+	for (uint32_t i = 0; i < totalCount; ++i)
+	{
+		removeCmd(pRenderer, pRecorder->ppCmds[i]);
+		removeCmdPool(pRenderer, pRecorder->ppCmdPools[i]);
+	}
+
+	tf_free(pRecorder->ppCmdPools);
+	tf_free(pRecorder->ppCmds);
+	tf_free(pRecorder->pUsedCmdCounts);
+	tf_free(pRecorder);
+}
+
+void resetParallelCmdRecorder(Renderer* pRenderer, ParallelCmdRecorder* pRecorder, uint32_t frameIndex)
+{
+	ASSERT(pRecorder);
+	ASSERT(frameIndex < pRecorder->mFrameCount);
+
+	// Only the pools which were used since the last reset have anything to release
+	CmdPool** ppCmdPools = pRecorder->ppCmdPools + frameIndex * pRecorder->mMaxCmdCount;
+	for (uint32_t i = 0; i < pRecorder->pUsedCmdCounts[frameIndex]; ++i)
+	{
+		resetCmdPool(pRenderer, ppCmdPools[i]);
+	}
+
+	pRecorder->pUsedCmdCounts[frameIndex] = 0;
+}
+
+void recordParallelCmds(
+	ParallelCmdRecorder* pRecorder, uint32_t frameIndex, uint32_t cmdCount, ParallelCmdRecordFunc pfnRecord, void* pUserData,
+	Cmd** ppOutCmds)
+{
+	ASSERT(pRecorder);
+	ASSERT(frameIndex < pRecorder->mFrameCount);
+	ASSERT(pfnRecord);
+	ASSERT(ppOutCmds || !cmdCount);
+
+	if (!cmdCount)
+		return;
+
+	uint32_t& usedCmdCount = pRecorder->pUsedCmdCounts[frameIndex];
+	if (usedCmdCount + cmdCount > pRecorder->mMaxCmdCount)
+	{
+		LOGF(LogLevel::eERROR, "Recording %u command lists would exceed the %u available for this frame", cmdCount, pRecorder->mMaxCmdCount - usedCmdCount);
+		ASSERT(false);
+		return;
+	}
+
+	ParallelCmdRecordJob job = {};
+	job.pfnRecord = pfnRecord;
+	job.pUserData = pUserData;
+	job.ppCmds = pRecorder->ppCmds + frameIndex * pRecorder->mMaxCmdCount + usedCmdCount;
+	usedCmdCount += cmdCount;
+
+	runThreadSystemRangeTaskAndWait(pRecorder->pThreadSystem, recordParallelCmdTask, &job, cmdCount);
+
+	// Slot order, not completion order
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		ppOutCmds[i] = job.ppCmds[i];
+	}
+}
+
+void getParallelCmdRange(uint32_t itemCount, uint32_t cmdCount, uint32_t cmdIndex, uint32_t* pFirstItem, uint32_t* pItemCount)
+{
+	ASSERT(cmdCount);
+	ASSERT(cmdIndex < cmdCount);
+	ASSERT(pFirstItem && pItemCount);
+
+	// The first (itemCount % cmdCount) ranges get one item more
+	const uint32_t baseCount = itemCount / cmdCount;
+	const uint32_t remainder = itemCount % cmdCount;
+	*pFirstItem = cmdIndex * baseCount + (cmdIndex < remainder ? cmdIndex : remainder);
+	*pItemCount = baseCount + (cmdIndex < remainder ? 1 : 0);
+}
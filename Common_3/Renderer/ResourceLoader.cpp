@@ -45,6 +45,10 @@
 #endif
 
 #include "../OS/Core/TextureContainers.h"
+#include "../OS/Core/ThreadSystem.h"
+
+#include "../ThirdParty/OpenSource/EASTL/unordered_map.h"
+#include "../ThirdParty/OpenSource/EASTL/sort.h"
 
 #include "../OS/Interfaces/IMemory.h"
 
@@ -322,6 +326,34 @@ typedef struct TextureUpdateDescInternal
 	bool              mMipsAfterSlice;
 } TextureUpdateDescInternal;
 
+/// Mips at or below this size are uploaded with the texture, bigger ones get streamed in afterwards
+#define TEXTURE_STREAMING_MIP_TAIL_SIZE 128u
+
+/// Book keeping for a texture loaded with TextureLoadDesc::mStreamMips
+typedef struct StreamedTexture
+{
+	Texture*        pTexture;
+	char            mFileName[FS_MAX_PATH];
+	/// Offset of the first image in the file
+	ssize_t         mDataOffset;
+	/// Size of one array layer with its full mip chain in the file
+	uint64_t        mLayerSize;
+	float           mPriority;
+	/// Most detailed mip the GPU can sample. Written by the main thread only.
+	uint32_t        mResidentMip;
+	/// Mip currently being uploaded by the streamer. UINT32_MAX if none.
+	uint32_t        mRequestedMip;
+	SyncToken       mRequestToken;
+	/// Set by the streamer thread if reading the requested mip failed
+	tfrg_atomic32_t mFailed;
+} StreamedTexture;
+
+typedef struct TextureMipStreamDesc
+{
+	StreamedTexture* pStreamedTexture;
+	uint32_t         mMipLevel;
+} TextureMipStreamDesc;
+
 typedef struct CopyResourceSet
 {
 #ifndef DIRECT3D11
@@ -355,6 +387,7 @@ typedef enum UpdateRequestType
 	UPDATE_REQUEST_TEXTURE_BARRIER,
 	UPDATE_REQUEST_LOAD_TEXTURE,
 	UPDATE_REQUEST_LOAD_GEOMETRY,
+	UPDATE_REQUEST_STREAM_TEXTURE_MIP,
 	UPDATE_REQUEST_INVALID,
 } UpdateRequestType;
 
@@ -373,6 +406,7 @@ struct UpdateRequest
 	UpdateRequest(const GeometryLoadDesc& geom) :             mType(UPDATE_REQUEST_LOAD_GEOMETRY), geomLoadDesc(geom) {}
 	UpdateRequest(const BufferBarrier& barrier) :             mType(UPDATE_REQUEST_BUFFER_BARRIER), bufferBarrier(barrier) {}
 	UpdateRequest(const TextureBarrier& barrier) :            mType(UPDATE_REQUEST_TEXTURE_BARRIER), textureBarrier(barrier) {}
+	UpdateRequest(const TextureMipStreamDesc& mip) :          mType(UPDATE_REQUEST_STREAM_TEXTURE_MIP), texMipStreamDesc(mip) {}
 
 	UpdateRequestType             mType = UPDATE_REQUEST_INVALID;
 	uint64_t                      mWaitIndex = 0;
@@ -385,6 +419,7 @@ struct UpdateRequest
 		GeometryLoadDesc          geomLoadDesc;
 		BufferBarrier             bufferBarrier;
 		TextureBarrier            textureBarrier;
+		TextureMipStreamDesc      texMipStreamDesc;
 	};
 };
 
@@ -413,6 +448,13 @@ struct ResourceLoader
 	uint32_t                     mNextSet;
 	uint32_t                     mSubmittedSets;
 
+	/// Workers for the CPU heavy parts of a load (BASIS transcoding)
+	ThreadSystem*                pThreadSystem;
+
+	/// Textures which still have mips to stream in. Guarded by mStreamingMutex.
+	Mutex                        mStreamingMutex;
+	eastl::unordered_map<Texture*, StreamedTexture*> mStreamedTextures;
+
 #if defined(NX64)
 	ThreadTypeNX                 mThreadType;
 	void*                        mThreadStackPtr;
@@ -779,6 +821,251 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
 	return UPLOAD_FUNCTION_RESULT_COMPLETED;
 }
 
+/// Uploads mips [baseMip, baseMip + mipCount) of every layer of a streamed DDS texture.
+/// DDS stores layers one after the other with their full mip chain, so each (layer, mip) gets its own seek.
+/// The first upload covers the mip tail and transitions the whole texture, later ones only touch the streamed in mip.
+static UploadFunctionResult updateStreamedTextureMips(
+	Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const StreamedTexture* pStreamed, FileStream* pStream,
+	uint32_t baseMip, uint32_t mipCount, bool firstUpload)
+{
+	Texture* texture = pStreamed->pTexture;
+	const TinyImageFormat fmt = (TinyImageFormat)texture->mFormat;
+	const uint32_t layerCount = texture->mArraySizeMinusOne + 1;
+	Cmd* cmd = acquireCmd(pCopyEngine, activeSet);
+
+	const uint32_t sliceAlignment = util_get_texture_subresource_alignment(pRenderer, fmt);
+	const uint32_t rowAlignment = util_get_texture_row_alignment(pRenderer);
+	const uint64_t requiredSize = util_get_surface_size(fmt,
+		MIP_REDUCE(texture->mWidth, baseMip), MIP_REDUCE(texture->mHeight, baseMip), 1,
+		rowAlignment, sliceAlignment, 0, mipCount, 0, layerCount);
+
+	MappedMemoryRange upload = allocateStagingMemory(requiredSize, sliceAlignment);
+	if (!upload.pData)
+	{
+		return UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL;
+	}
+
+#if defined(VULKAN)
+	eastl::vector<TextureBarrier> barriers;
+	if (firstUpload)
+	{
+		barriers.push_back({ texture, RESOURCE_STATE_UNDEFINED, RESOURCE_STATE_COPY_DEST });
+	}
+	else
+	{
+		for (uint32_t layer = 0; layer < layerCount; ++layer)
+		{
+			TextureBarrier barrier = { texture, RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_COPY_DEST };
+			barrier.mSubresourceBarrier = 1;
+			barrier.mMipLevel = baseMip;
+			barrier.mArrayLayer = (uint16_t)layer;
+			barriers.push_back(barrier);
+		}
+	}
+	cmdResourceBarrier(cmd, 0, NULL, (uint32_t)barriers.size(), barriers.data(), 0, NULL);
+#endif
+
+	uint64_t offset = 0;
+	for (uint32_t layer = 0; layer < layerCount; ++layer)
+	{
+		for (uint32_t mip = baseMip; mip < baseMip + mipCount; ++mip)
+		{
+			uint32_t w = MIP_REDUCE(texture->mWidth, mip);
+			uint32_t h = MIP_REDUCE(texture->mHeight, mip);
+
+			uint32_t rowBytes = 0;
+			uint32_t numRows = 0;
+			if (!util_get_surface_info(w, h, fmt, NULL, &rowBytes, &numRows))
+			{
+				return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+			}
+
+			// Offset of this mip inside the tightly packed layer
+			ssize_t mipOffset = util_get_surface_size(fmt, texture->mWidth, texture->mHeight, 1, 1, 1, 0, mip, 0, 1);
+			if (!fsSeekStream(pStream, SBO_START_OF_FILE, pStreamed->mDataOffset + (ssize_t)(layer * pStreamed->mLayerSize) + mipOffset))
+			{
+				return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+			}
+
+			uint32_t subRowPitch = round_up(rowBytes, rowAlignment);
+			uint32_t subSlicePitch = round_up(subRowPitch * numRows, sliceAlignment);
+			uint8_t* data = upload.pData + offset;
+
+			for (uint32_t r = 0; r < numRows; ++r)
+			{
+				ssize_t bytesRead = fsReadFromStream(pStream, data + r * subRowPitch, rowBytes);
+				if (bytesRead != rowBytes)
+				{
+					return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+				}
+			}
+
+			SubresourceDataDesc subresourceDesc = {};
+			subresourceDesc.mArrayLayer = layer;
+			subresourceDesc.mMipLevel = mip;
+			subresourceDesc.mSrcOffset = upload.mOffset + offset;
+#if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN)
+			subresourceDesc.mRowPitch = subRowPitch;
+			subresourceDesc.mSlicePitch = subSlicePitch;
+#endif
+			cmdUpdateSubresource(cmd, texture, upload.pBuffer, &subresourceDesc);
+			offset += subSlicePitch;
+		}
+	}
+
+#if defined(VULKAN)
+	for (TextureBarrier& barrier : barriers)
+	{
+		barrier.mCurrentState = RESOURCE_STATE_COPY_DEST;
+		barrier.mNewState = RESOURCE_STATE_SHADER_RESOURCE;
+	}
+	cmdResourceBarrier(cmd, 0, NULL, (uint32_t)barriers.size(), barriers.data(), 0, NULL);
+#endif
+
+	return UPLOAD_FUNCTION_RESULT_COMPLETED;
+}
+
+static UploadFunctionResult streamTextureMip(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const TextureMipStreamDesc& mipDesc)
+{
+	StreamedTexture* pStreamed = mipDesc.pStreamedTexture;
+
+	FileStream stream = {};
+	UploadFunctionResult result = UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+	if (fsOpenStreamFromPath(RD_TEXTURES, pStreamed->mFileName, FM_READ_BINARY, &stream))
+	{
+		result = updateStreamedTextureMips(pRenderer, pCopyEngine, activeSet, pStreamed, &stream, mipDesc.mMipLevel, 1, false);
+		fsCloseStream(&stream);
+	}
+
+	if (result == UPLOAD_FUNCTION_RESULT_INVALID_REQUEST)
+	{
+		LOGF(LogLevel::eERROR, "Failed to stream mip %u of texture %s", mipDesc.mMipLevel, pStreamed->mFileName);
+		tfrg_atomic32_store_release(&pStreamed->mFailed, 1);
+	}
+
+	return result;
+}
+
+/// One image level of a BASIS texture, transcoded by a worker directly into its staging memory slot
+typedef struct BASISTranscodeJob
+{
+	const BASISTextureInfo* pInfo;
+	uint8_t*                pDst;
+	uint64_t                mOffset;
+	uint32_t                mImage;
+	uint32_t                mLevel;
+	uint32_t                mRowPitch;
+	uint32_t                mSlicePitch;
+	TinyImageFormat         mFormat;
+	bool                    mSuccess;
+} BASISTranscodeJob;
+
+static void transcodeBASISLevelTask(void* pUser, uintptr_t index)
+{
+	BASISTranscodeJob* pJob = (BASISTranscodeJob*)pUser + index;
+	pJob->mSuccess = transcodeBASISImageLevel(pJob->pInfo, pJob->mFormat, pJob->mImage, pJob->mLevel, pJob->pDst, pJob->mRowPitch, pJob->mSlicePitch);
+}
+
+/// Transcodes all image levels of a BASIS texture on the loader thread pool.
+/// Levels are written straight into staging memory, the streamer thread helps with the transcoding and records the copies once all are done.
+static UploadFunctionResult updateBASISTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, Texture* texture, const BASISTextureInfo* pInfo)
+{
+	const TinyImageFormat fmt = (TinyImageFormat)texture->mFormat;
+	const uint32_t mipLevels = texture->mMipLevels;
+	const uint32_t layerCount = texture->mArraySizeMinusOne + 1;
+	Cmd* cmd = acquireCmd(pCopyEngine, activeSet);
+
+	ASSERT(pCopyEngine->pQueue->mNodeIndex == texture->mNodeIndex);
+
+	const uint32_t sliceAlignment = util_get_texture_subresource_alignment(pRenderer, fmt);
+	const uint32_t rowAlignment = util_get_texture_row_alignment(pRenderer);
+	const uint64_t requiredSize = util_get_surface_size(fmt, texture->mWidth, texture->mHeight, texture->mDepth,
+		rowAlignment,
+		sliceAlignment,
+		0, mipLevels,
+		0, layerCount);
+
+	MappedMemoryRange upload = allocateStagingMemory(requiredSize, sliceAlignment);
+	if (!upload.pData)
+	{
+		return UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL;
+	}
+
+	const uint32_t jobCount = mipLevels * layerCount;
+	BASISTranscodeJob* pJobs = (BASISTranscodeJob*)tf_calloc(jobCount, sizeof(BASISTranscodeJob));
+
+	uint64_t offset = 0;
+	uint32_t jobIndex = 0;
+	for (uint32_t mip = mipLevels; mip-- > 0;)
+	{
+		uint32_t w = MIP_REDUCE(texture->mWidth, mip);
+		uint32_t h = MIP_REDUCE(texture->mHeight, mip);
+
+		uint32_t rowBytes = 0;
+		uint32_t numRows = 0;
+		if (!util_get_surface_info(w, h, fmt, NULL, &rowBytes, &numRows))
+		{
+			tf_free(pJobs);
+			return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
+
+		const uint32_t subRowPitch = round_up(rowBytes, rowAlignment);
+		const uint32_t subSlicePitch = round_up(subRowPitch * numRows, sliceAlignment);
+
+		for (uint32_t layer = 0; layer < layerCount; ++layer)
+		{
+			BASISTranscodeJob& job = pJobs[jobIndex++];
+			job.pInfo = pInfo;
+			job.pDst = upload.pData + offset;
+			job.mOffset = offset;
+			job.mImage = layer;
+			job.mLevel = mip;
+			job.mRowPitch = subRowPitch;
+			job.mSlicePitch = subSlicePitch;
+			job.mFormat = fmt;
+
+			offset += subSlicePitch;
+		}
+	}
+
+	runThreadSystemRangeTaskAndWait(pResourceLoader->pThreadSystem, transcodeBASISLevelTask, pJobs, jobCount);
+
+#if defined(VULKAN)
+	TextureBarrier barrier = { texture, RESOURCE_STATE_UNDEFINED, RESOURCE_STATE_COPY_DEST };
+	cmdResourceBarrier(cmd, 0, NULL, 1, &barrier, 0, NULL);
+#endif
+
+	bool success = true;
+	for (uint32_t i = 0; i < jobCount; ++i)
+	{
+		const BASISTranscodeJob& job = pJobs[i];
+		if (!job.mSuccess)
+		{
+			success = false;
+			break;
+		}
+
+		SubresourceDataDesc subresourceDesc = {};
+		subresourceDesc.mArrayLayer = job.mImage;
+		subresourceDesc.mMipLevel = job.mLevel;
+		subresourceDesc.mSrcOffset = upload.mOffset + job.mOffset;
+#if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN)
+		subresourceDesc.mRowPitch = job.mRowPitch;
+		subresourceDesc.mSlicePitch = job.mSlicePitch;
+#endif
+		cmdUpdateSubresource(cmd, texture, upload.pBuffer, &subresourceDesc);
+	}
+
+#if defined(VULKAN)
+	barrier = { texture, RESOURCE_STATE_COPY_DEST, RESOURCE_STATE_SHADER_RESOURCE };
+	cmdResourceBarrier(cmd, 0, NULL, 1, &barrier, 0, NULL);
+#endif
+
+	tf_free(pJobs);
+
+	return success ? UPLOAD_FUNCTION_RESULT_COMPLETED : UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+}
+
 static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const UpdateRequest& pTextureUpdate)
 {
 	const TextureLoadDesc* pTextureDesc = &pTextureUpdate.texLoadDesc;
@@ -859,16 +1146,23 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 		}
 		case TEXTURE_CONTAINER_BASIS:
 		{
-			void* data = NULL;
-			uint32_t dataSize = 0;
 			success = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, &stream);
 			if (success)
 			{
-				success = loadBASISTextureDesc(&stream, &textureDesc, &data, &dataSize);
+				BASISTextureInfo basisInfo = {};
+				success = loadBASISTextureHeader(&stream, &textureDesc, &basisInfo);
+				fsCloseStream(&stream);
+
 				if (success)
 				{
-					fsCloseStream(&stream);
-					fsOpenStreamFromMemory(data, dataSize, FM_READ_BINARY, true, &stream);
+					textureDesc.mStartState = RESOURCE_STATE_COMMON;
+					textureDesc.mFlags |= pTextureDesc->mCreationFlag;
+					textureDesc.mNodeIndex = pTextureDesc->mNodeIndex;
+					addTexture(pRenderer, &textureDesc, pTextureDesc->ppTexture);
+
+					UploadFunctionResult result = updateBASISTexture(pRenderer, pCopyEngine, activeSet, *pTextureDesc->ppTexture, &basisInfo);
+					unloadBASISTexture(&basisInfo);
+					return result;
 				}
 			}
 			break;
@@ -899,6 +1193,40 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 			textureDesc.mNodeIndex = pTextureDesc->mNodeIndex;
 			addTexture(pRenderer, &textureDesc, pTextureDesc->ppTexture);
 
+			// Only the mip tail gets uploaded now, the rest is left to updateTextureStreaming
+			uint32_t tailMip = 0;
+			while (tailMip + 1 < textureDesc.mMipLevels &&
+				max(MIP_REDUCE(textureDesc.mWidth, tailMip), MIP_REDUCE(textureDesc.mHeight, tailMip)) > TEXTURE_STREAMING_MIP_TAIL_SIZE)
+			{
+				++tailMip;
+			}
+
+			if (pTextureDesc->mStreamMips && TEXTURE_CONTAINER_DDS == container && 1 == textureDesc.mDepth && tailMip > 0)
+			{
+				StreamedTexture* pStreamed = (StreamedTexture*)tf_calloc(1, sizeof(StreamedTexture));
+				pStreamed->pTexture = *pTextureDesc->ppTexture;
+				strncpy(pStreamed->mFileName, fileName, FS_MAX_PATH - 1);
+				pStreamed->mDataOffset = fsGetStreamSeekPosition(&stream);
+				pStreamed->mLayerSize = util_get_surface_size((TinyImageFormat)textureDesc.mFormat, textureDesc.mWidth, textureDesc.mHeight, 1,
+					1, 1, 0, textureDesc.mMipLevels, 0, 1);
+				pStreamed->mResidentMip = tailMip;
+				pStreamed->mRequestedMip = UINT32_MAX;
+
+				UploadFunctionResult result = updateStreamedTextureMips(pRenderer, pCopyEngine, activeSet, pStreamed, &stream,
+					tailMip, textureDesc.mMipLevels - tailMip, true);
+				fsCloseStream(&stream);
+
+				if (UPLOAD_FUNCTION_RESULT_COMPLETED != result)
+				{
+					tf_free(pStreamed);
+					return result;
+				}
+
+				MutexLock lock(pResourceLoader->mStreamingMutex);
+				pResourceLoader->mStreamedTextures[pStreamed->pTexture] = pStreamed;
+				return result;
+			}
+
 			updateDesc.mStream = stream;
 			updateDesc.pTexture = *pTextureDesc->ppTexture;
 			updateDesc.mBaseMipLevel = 0;
@@ -1218,6 +1546,7 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 		uint32_t totalSize = 0;
 		totalSize += round_up(sizeof(Geometry), 16);
 		totalSize += round_up(drawCount * sizeof(IndirectDrawIndexArguments), 16);
+		totalSize += round_up(drawCount * sizeof(Geometry::Bounds), 16);
 		totalSize += round_up(jointCount * sizeof(mat4), 16);
 		totalSize += round_up(jointCount * sizeof(uint32_t), 16);
 
@@ -1225,7 +1554,8 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 		ASSERT(geom);
 
 		geom->pDrawArgs = (IndirectDrawIndexArguments*)(geom + 1);
-		geom->pInverseBindPoses = (mat4*)((uint8_t*)geom->pDrawArgs + round_up(drawCount * sizeof(*geom->pDrawArgs), 16));
+		geom->pDrawBounds = (Geometry::Bounds*)((uint8_t*)geom->pDrawArgs + round_up(drawCount * sizeof(*geom->pDrawArgs), 16));
+		geom->pInverseBindPoses = (mat4*)((uint8_t*)geom->pDrawBounds + round_up(drawCount * sizeof(*geom->pDrawBounds), 16));
 		geom->pJointRemaps = (uint32_t*)((uint8_t*)geom->pInverseBindPoses + round_up(jointCount * sizeof(*geom->pInverseBindPoses), 16));
 
 		uint32_t shadowSize = 0;
@@ -1378,6 +1708,36 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 				// With this approach, we can draw everything in one draw call or use the traditional draw per subset without the
 				// need for changing shader code
 				geom->pDrawArgs[drawCount].mVertexOffset = 0;
+				/************************************************************************/
+				// Bounding box of this primitive
+				/************************************************************************/
+				const cgltf_accessor* positions = NULL;
+				for (uint32_t a = 0; a < prim->attributes_count; ++a)
+					if (cgltf_attribute_type_position == prim->attributes[a].type)
+						positions = prim->attributes[a].data;
+
+				Geometry::Bounds& bounds = geom->pDrawBounds[drawCount];
+				if (positions && positions->has_min && positions->has_max)
+				{
+					// Exporters have to write these for positions, so there is usually no need to go over the vertices
+					bounds.mMin = float3(positions->min[0], positions->min[1], positions->min[2]);
+					bounds.mMax = float3(positions->max[0], positions->max[1], positions->max[2]);
+				}
+				else if (positions && positions->count)
+				{
+					bounds.mMin = float3(FLT_MAX);
+					bounds.mMax = float3(-FLT_MAX);
+					for (uint32_t e = 0; e < positions->count; ++e)
+					{
+						float position[3] = {};
+						cgltf_accessor_read_float(positions, e, position, 3);
+						for (uint32_t c = 0; c < 3; ++c)
+						{
+							bounds.mMin[c] = min(bounds.mMin[c], position[c]);
+							bounds.mMax[c] = max(bounds.mMax[c], position[c]);
+						}
+					}
+				}
 
 				indexCount += (uint32_t)prim->indices->count;
 				vertexCount += (uint32_t)prim->attributes->data->count;
@@ -1590,6 +1950,9 @@ static void streamerThreadFunc(void* pThreadData)
 				case UPDATE_REQUEST_LOAD_GEOMETRY:
 					result = loadGeometry(pLoader->pRenderer, &copyEngine, pLoader->mNextSet, updateState);
 					break;
+				case UPDATE_REQUEST_STREAM_TEXTURE_MIP:
+					result = streamTextureMip(pLoader->pRenderer, &copyEngine, pLoader->mNextSet, updateState.texMipStreamDesc);
+					break;
 				case UPDATE_REQUEST_INVALID:
 					break;
 				}
@@ -1650,6 +2013,7 @@ static void addResourceLoader(Renderer* pRenderer, ResourceLoaderDesc* pDesc, Re
 	pLoader->mTokenMutex.Init();
 	pLoader->mQueueCond.Init();
 	pLoader->mTokenCond.Init();
+	pLoader->mStreamingMutex.Init();
 
 	pLoader->mTokenCounter = 0;
 	pLoader->mTokenCompleted = 0;
@@ -1660,6 +2024,8 @@ static void addResourceLoader(Renderer* pRenderer, ResourceLoaderDesc* pDesc, Re
 		setupCopyEngine(pLoader->pRenderer, &pLoader->pCopyEngines[i], i, pLoader->mDesc.mBufferSize, pLoader->mDesc.mBufferCount);
 	}
 
+	initThreadSystem(&pLoader->pThreadSystem);
+
 	pLoader->mThreadDesc.pFunc = streamerThreadFunc;
 	pLoader->mThreadDesc.pData = pLoader;
 
@@ -1680,11 +2046,19 @@ static void removeResourceLoader(ResourceLoader* pLoader)
 	pLoader->mRun = false;
 	pLoader->mQueueCond.WakeOne();
 	destroy_thread(pLoader->mThread);
+	shutdownThreadSystem(pLoader->pThreadSystem);
 	pLoader->mQueueCond.Destroy();
 	pLoader->mTokenCond.Destroy();
 	pLoader->mQueueMutex.Destroy();
 	pLoader->mTokenMutex.Destroy();
 
+	for (eastl::pair<Texture* const, StreamedTexture*>& entry : pLoader->mStreamedTextures)
+	{
+		tf_free(entry.second);
+	}
+	pLoader->mStreamedTextures.clear();
+	pLoader->mStreamingMutex.Destroy();
+
 	tf_delete(pLoader);
 }
 
@@ -1719,6 +2093,20 @@ static void queueTextureLoad(ResourceLoader* pLoader, TextureLoadDesc* pTextureU
 	if (token) *token = max(t, *token);
 }
 
+static void queueTextureMipStream(ResourceLoader* pLoader, TextureMipStreamDesc* pMipStream, SyncToken* token)
+{
+	uint32_t nodeIndex = pMipStream->pStreamedTexture->pTexture->mNodeIndex;
+	pLoader->mQueueMutex.Acquire();
+
+	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+
+	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pMipStream));
+	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
+	pLoader->mQueueMutex.Release();
+	pLoader->mQueueCond.WakeOne();
+	if (token) *token = max(t, *token);
+}
+
 static void queueGeometryLoad(ResourceLoader* pLoader, GeometryLoadDesc* pGeometryLoad, SyncToken* token)
 {
 	uint32_t nodeIndex = pGeometryLoad->mNodeIndex;
@@ -1930,6 +2318,27 @@ void removeResource(Buffer* pBuffer)
 
 void removeResource(Texture* pTexture)
 {
+	StreamedTexture* pStreamed = NULL;
+	{
+		MutexLock lock(pResourceLoader->mStreamingMutex);
+		eastl::unordered_map<Texture*, StreamedTexture*>::iterator it = pResourceLoader->mStreamedTextures.find(pTexture);
+		if (it != pResourceLoader->mStreamedTextures.end())
+		{
+			pStreamed = it->second;
+			pResourceLoader->mStreamedTextures.erase(it);
+		}
+	}
+
+	if (pStreamed)
+	{
+		// The streamer might still be copying into this texture
+		if (pStreamed->mRequestedMip != UINT32_MAX)
+		{
+			waitForToken(pResourceLoader, &pStreamed->mRequestToken);
+		}
+		tf_free(pStreamed);
+	}
+
 	removeTexture(pResourceLoader->pRenderer, pTexture);
 }
 
@@ -2065,6 +2474,83 @@ void waitForAllResourceLoads()
 	waitForToken(pResourceLoader, &token);
 }
 /************************************************************************/
+// Texture streaming
+/************************************************************************/
+void updateTextureStreaming(uint64_t frameBudget)
+{
+	MutexLock lock(pResourceLoader->mStreamingMutex);
+
+	eastl::vector<StreamedTexture*> candidates;
+	candidates.reserve(pResourceLoader->mStreamedTextures.size());
+
+	for (eastl::pair<Texture* const, StreamedTexture*>& entry : pResourceLoader->mStreamedTextures)
+	{
+		StreamedTexture* pStreamed = entry.second;
+		if (pStreamed->mRequestedMip != UINT32_MAX)
+		{
+			if (!isTokenCompleted(&pStreamed->mRequestToken))
+			{
+				continue;
+			}
+
+			// Upload is done, shaders can start sampling the new mip
+			if (!tfrg_atomic32_load_acquire(&pStreamed->mFailed))
+			{
+				pStreamed->mResidentMip = pStreamed->mRequestedMip;
+			}
+			pStreamed->mRequestedMip = UINT32_MAX;
+		}
+
+		if (pStreamed->mResidentMip > 0 && !tfrg_atomic32_load_relaxed(&pStreamed->mFailed))
+		{
+			candidates.push_back(pStreamed);
+		}
+	}
+
+	eastl::sort(candidates.begin(), candidates.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+	{
+		return a->mPriority > b->mPriority;
+	});
+
+	uint64_t queuedBytes = 0;
+	for (StreamedTexture* pStreamed : candidates)
+	{
+		Texture* pTexture = pStreamed->pTexture;
+		uint32_t mip = pStreamed->mResidentMip - 1;
+		uint64_t mipSize = util_get_surface_size((TinyImageFormat)pTexture->mFormat,
+			MIP_REDUCE(pTexture->mWidth, mip), MIP_REDUCE(pTexture->mHeight, mip), 1, 1, 1, 0, 1, 0, pTexture->mArraySizeMinusOne + 1);
+
+		// Always let at least one mip through so a small budget cannot stall streaming
+		if (queuedBytes > 0 && queuedBytes + mipSize > frameBudget)
+		{
+			break;
+		}
+
+		TextureMipStreamDesc mipDesc = { pStreamed, mip };
+		pStreamed->mRequestedMip = mip;
+		pStreamed->mRequestToken = 0;
+		queueTextureMipStream(pResourceLoader, &mipDesc, &pStreamed->mRequestToken);
+		queuedBytes += mipSize;
+	}
+}
+
+void setTextureStreamingPriority(Texture* pTexture, float priority)
+{
+	MutexLock lock(pResourceLoader->mStreamingMutex);
+	eastl::unordered_map<Texture*, StreamedTexture*>::iterator it = pResourceLoader->mStreamedTextures.find(pTexture);
+	if (it != pResourceLoader->mStreamedTextures.end())
+	{
+		it->second->mPriority = priority;
+	}
+}
+
+uint32_t getTextureResidentMip(Texture* pTexture)
+{
+	MutexLock lock(pResourceLoader->mStreamingMutex);
+	eastl::unordered_map<Texture*, StreamedTexture*>::iterator it = pResourceLoader->mStreamedTextures.find(pTexture);
+	return it != pResourceLoader->mStreamedTextures.end() ? it->second->mResidentMip : 0;
+}
+/************************************************************************/
 // Shader loading
 /************************************************************************/
 #if defined(__ANDROID__)
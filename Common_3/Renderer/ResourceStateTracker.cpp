@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2018-2020 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#include "IResourceStateTracker.h"
+
+#include "../ThirdParty/OpenSource/EASTL/unordered_map.h"
+#include "../ThirdParty/OpenSource/EASTL/vector.h"
+
+#include "../OS/Interfaces/ILog.h"
+
+#include "../OS/Interfaces/IMemory.h"
+
+typedef struct TrackedResourceState
+{
+	ResourceState mState;
+	ResourceState mPendingState;
+	bool          mRenderTarget;
+	bool          mPending;
+} TrackedResourceState;
+
+struct ResourceStateTracker
+{
+	/// Keyed by Texture* or RenderTarget*
+	eastl::unordered_map<const void*, TrackedResourceState> mResources;
+	eastl::vector<const void*>                              mPending;
+	eastl::vector<TextureBarrier>                           mTextureBarriers;
+	eastl::vector<RenderTargetBarrier>                      mRenderTargetBarriers;
+	ResourceStateTrackerStats                               mStats;
+};
+
+static void trackResourceState(ResourceStateTracker* pTracker, const void* pResource, bool renderTarget, ResourceState state)
+{
+	ASSERT(pTracker);
+	ASSERT(pResource);
+
+	TrackedResourceState& tracked = pTracker->mResources[pResource];
+	tracked.mState = state;
+	tracked.mPendingState = state;
+	tracked.mRenderTarget = renderTarget;
+	tracked.mPending = false;
+}
+
+static void untrackResourceState(ResourceStateTracker* pTracker, const void* pResource)
+{
+	ASSERT(pTracker);
+
+	pTracker->mResources.erase(pResource);
+	for (uint32_t i = 0; i < (uint32_t)pTracker->mPending.size(); ++i)
+	{
+		if (pTracker->mPending[i] == pResource)
+		{
+			pTracker->mPending.erase_unsorted(pTracker->mPending.begin() + i);
+			break;
+		}
+	}
+}
+
+static void requestResourceState(ResourceStateTracker* pTracker, const void* pResource, ResourceState state)
+{
+	ASSERT(pTracker);
+
+	eastl::unordered_map<const void*, TrackedResourceState>::iterator it = pTracker->mResources.find(pResource);
+	if (it == pTracker->mResources.end())
+	{
+		LOGF(LogLevel::eERROR, "Requested a state for a resource which is not tracked");
+		ASSERT(false);
+		return;
+	}
+
+	TrackedResourceState& tracked = it->second;
+	if (tracked.mPending)
+	{
+		// Both requests collapse into a single transition from the last flushed state
+		tracked.mPendingState = state;
+		++pTracker->mStats.mElidedBarriers;
+		return;
+	}
+
+	if (tracked.mState == state && RESOURCE_STATE_UNORDERED_ACCESS != state)
+	{
+		++pTracker->mStats.mElidedBarriers;
+		return;
+	}
+
+	tracked.mPendingState = state;
+	tracked.mPending = true;
+	pTracker->mPending.push_back(pResource);
+}
+
+static ResourceState getTrackedResourceState(ResourceStateTracker* pTracker, const void* pResource)
+{
+	eastl::unordered_map<const void*, TrackedResourceState>::iterator it = pTracker->mResources.find(pResource);
+	ASSERT(it != pTracker->mResources.end());
+	return it != pTracker->mResources.end() ? it->second.mState : RESOURCE_STATE_UNDEFINED;
+}
+
+void addResourceStateTracker(Renderer* pRenderer, ResourceStateTracker** ppTracker)
+{
+	ASSERT(pRenderer);
+	ASSERT(ppTracker);
+
+	ResourceStateTracker* pTracker = tf_new(ResourceStateTracker);
+	pTracker->mStats = {};
+	*ppTracker = pTracker;
+}
+
+void removeResourceStateTracker(Renderer* pRenderer, ResourceStateTracker* pTracker)
+{
+	ASSERT(pRenderer);
+	ASSERT(pTracker);
+
+	tf_delete(pTracker);
+}
+
+void trackTextureState(ResourceStateTracker* pTracker, Texture* pTexture, ResourceState state)
+{
+	trackResourceState(pTracker, pTexture, false, state);
+}
+
+void trackRenderTargetState(ResourceStateTracker* pTracker, RenderTarget* pRenderTarget, ResourceState state)
+{
+	trackResourceState(pTracker, pRenderTarget, true, state);
+}
+
+void untrackTextureState(ResourceStateTracker* pTracker, Texture* pTexture)
+{
+	untrackResourceState(pTracker, pTexture);
+}
+
+void untrackRenderTargetState(ResourceStateTracker* pTracker, RenderTarget* pRenderTarget)
+{
+	untrackResourceState(pTracker, pRenderTarget);
+}
+
+void requestTextureState(ResourceStateTracker* pTracker, Texture* pTexture, ResourceState state)
+{
+	requestResourceState(pTracker, pTexture, state);
+}
+
+void requestRenderTargetState(ResourceStateTracker* pTracker, RenderTarget* pRenderTarget, ResourceState state)
+{
+	requestResourceState(pTracker, pRenderTarget, state);
+}
+
+ResourceState getTrackedTextureState(ResourceStateTracker* pTracker, Texture* pTexture)
+{
+	return getTrackedResourceState(pTracker, pTexture);
+}
+
+ResourceState getTrackedRenderTargetState(ResourceStateTracker* pTracker, RenderTarget* pRenderTarget)
+{
+	return getTrackedResourceState(pTracker, pRenderTarget);
+}
+
+void cmdFlushResourceStates(Cmd* pCmd, ResourceStateTracker* pTracker)
+{
+	ASSERT(pCmd);
+	ASSERT(pTracker);
+
+	pTracker->mTextureBarriers.clear();
+	pTracker->mRenderTargetBarriers.clear();
+
+	for (const void* pResource : pTracker->mPending)
+	{
+		TrackedResourceState& tracked = pTracker->mResources[pResource];
+		tracked.mPending = false;
+
+		// Request chain ended up where it started (RT -> SRV -> RT)
+		if (tracked.mState == tracked.mPendingState && RESOURCE_STATE_UNORDERED_ACCESS != tracked.mState)
+		{
+			++pTracker->mStats.mElidedBarriers;
+			continue;
+		}
+
+		if (tracked.mRenderTarget)
+		{
+			RenderTargetBarrier barrier = { (RenderTarget*)pResource, tracked.mState, tracked.mPendingState };
+			pTracker->mRenderTargetBarriers.push_back(barrier);
+		}
+		else
+		{
+			TextureBarrier barrier = { (Texture*)pResource, tracked.mState, tracked.mPendingState };
+			pTracker->mTextureBarriers.push_back(barrier);
+		}
+		tracked.mState = tracked.mPendingState;
+	}
+	pTracker->mPending.clear();
+
+	uint32_t textureBarrierCount = (uint32_t)pTracker->mTextureBarriers.size();
+	uint32_t rtBarrierCount = (uint32_t)pTracker->mRenderTargetBarriers.size();
+	if (textureBarrierCount || rtBarrierCount)
+	{
+		cmdResourceBarrier(pCmd, 0, NULL,
+			textureBarrierCount, pTracker->mTextureBarriers.data(),
+			rtBarrierCount, pTracker->mRenderTargetBarriers.data());
+		pTracker->mStats.mIssuedBarriers += textureBarrierCount + rtBarrierCount;
+		++pTracker->mStats.mBatches;
+	}
+}
+
+void getResourceStateTrackerStats(ResourceStateTracker* pTracker, ResourceStateTrackerStats* pStats)
+{
+	ASSERT(pTracker);
+	ASSERT(pStats);
+	*pStats = pTracker->mStats;
+}
+
+void resetResourceStateTrackerStats(ResourceStateTracker* pTracker)
+{
+	ASSERT(pTracker);
+	pTracker->mStats = {};
+}
@@ -6157,10 +6157,10 @@ void cmdResourceBarrier(Cmd* pCmd,
 		{
 			pImageBarrier->image = pTexture->pVkImage;
 			pImageBarrier->subresourceRange.aspectMask = (VkImageAspectFlags)pTexture->mAspectMask;
-			pImageBarrier->subresourceRange.baseMipLevel = 0;
-			pImageBarrier->subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
-			pImageBarrier->subresourceRange.baseArrayLayer = 0;
-			pImageBarrier->subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+			pImageBarrier->subresourceRange.baseMipLevel = pTrans->mSubresourceBarrier ? pTrans->mMipLevel : 0;
+			pImageBarrier->subresourceRange.levelCount = pTrans->mSubresourceBarrier ? 1 : VK_REMAINING_MIP_LEVELS;
+			pImageBarrier->subresourceRange.baseArrayLayer = pTrans->mSubresourceBarrier ? pTrans->mArrayLayer : 0;
+			pImageBarrier->subresourceRange.layerCount = pTrans->mSubresourceBarrier ? 1 : VK_REMAINING_ARRAY_LAYERS;
 
 			if (pTrans->mAcquire)
 			{
@@ -582,6 +582,11 @@ void cmdDispatchRays(Cmd* pCmd, Raytracing* pRaytracing, const RaytracingDispatc
 	);
 }
 
+// The dispatches need no scratch memory
+void beginRaytracingFrame(Raytracing* /*pRaytracing*/, uint32_t /*frameIndex*/)
+{
+}
+
 void removeAccelerationStructure(Raytracing* pRaytracing, AccelerationStructure* pAccelerationStructure) 
 {
 	ASSERT(pRaytracing);
@@ -863,6 +868,10 @@ void cmdDispatchRays(Cmd* pCmd, Raytracing* pRaytracing, const RaytracingDispatc
 {
 }
 
+void beginRaytracingFrame(Raytracing* pRaytracing, uint32_t frameIndex)
+{
+}
+
 void removeAccelerationStructure(Raytracing* pRaytracing, AccelerationStructure* pAccelerationStructure)
 {
 }
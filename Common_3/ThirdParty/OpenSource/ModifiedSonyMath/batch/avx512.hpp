@@ -0,0 +1,90 @@
+//========================================= #TheForgeMathExtensionsBegin ================================================
+
+/*
+* Copyright (c) 2018-2020 The Forge Interactive Inc.
+*
+* This file is part of The-Forge
+* (see https://github.com/ConfettiFX/The-Forge).
+*
+* Licensed to the Apache Software Foundation (ASF) under one
+* or more contributor license agreements.  See the NOTICE file
+* distributed with this work for additional information
+* regarding copyright ownership.  The ASF licenses this file
+* to you under the Apache License, Version 2.0 (the
+* "License"); you may not use this file except in compliance
+* with the License.  You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing,
+* software distributed under the License is distributed on an
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+* KIND, either express or implied.  See the License for the
+* specific language governing permissions and limitations
+* under the License.
+*/
+
+
+#ifndef VECTORMATH_BATCH_AVX512_HPP
+#define VECTORMATH_BATCH_AVX512_HPP
+
+#include <immintrin.h>
+
+// Everything in here is compiled for AVX-512F whatever the rest of the build targets, batch.hpp only calls it once
+// the CPU and the OS reported it
+#if defined(__clang__)
+    #pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+    #pragma GCC push_options
+    #pragma GCC target("avx512f")
+#endif
+
+namespace Vectormath
+{
+namespace Batch
+{
+namespace AVX512
+{
+
+// Sixteen elements per register
+struct Lanes
+{
+    typedef __m512 Type;
+    static const uint32_t kWidth = 16;
+
+    static inline Type Load(const float * p)         { return _mm512_loadu_ps(p); }
+    static inline void Store(float * p, Type v)      { _mm512_storeu_ps(p, v); }
+    static inline Type Splat(float f)                { return _mm512_set1_ps(f); }
+    static inline Type Add(Type a, Type b)           { return _mm512_add_ps(a, b); }
+    static inline Type Sub(Type a, Type b)           { return _mm512_sub_ps(a, b); }
+    static inline Type Mul(Type a, Type b)           { return _mm512_mul_ps(a, b); }
+    static inline Type MulAdd(Type a, Type b, Type c){ return _mm512_fmadd_ps(a, b, c); }
+    // The float and / andnot are AVX-512DQ, F only has them on integers
+    static inline Type Abs(Type a)                   { return _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(a), _mm512_set1_epi32(0x7fffffff))); }
+
+    // Matrix products, the whole matrix in one register, the column of the left matrix in all four quarters.
+    // Zero masked with all lanes set, the unmasked forms take an undefined source GCC warns about.
+    static inline Type LoadColumn(const float * p)   { return _mm512_maskz_broadcast_f32x4(0xffff, _mm_loadu_ps(p)); }
+    static inline Type SplatX(Type v)                { return _mm512_maskz_permute_ps(0xffff, v, _MM_SHUFFLE(0, 0, 0, 0)); }
+    static inline Type SplatY(Type v)                { return _mm512_maskz_permute_ps(0xffff, v, _MM_SHUFFLE(1, 1, 1, 1)); }
+    static inline Type SplatZ(Type v)                { return _mm512_maskz_permute_ps(0xffff, v, _MM_SHUFFLE(2, 2, 2, 2)); }
+    static inline Type SplatW(Type v)                { return _mm512_maskz_permute_ps(0xffff, v, _MM_SHUFFLE(3, 3, 3, 3)); }
+};
+
+#define VECTORMATH_BATCH_LANES_HOLD_COLUMNS 1
+#include "kernels.inl"
+#undef VECTORMATH_BATCH_LANES_HOLD_COLUMNS
+
+} // namespace AVX512
+} // namespace Batch
+} // namespace Vectormath
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#elif defined(__GNUC__)
+    #pragma GCC pop_options
+#endif
+
+#endif // VECTORMATH_BATCH_AVX512_HPP
+
+//========================================= #TheForgeMathExtensionsEnd ================================================
@@ -0,0 +1,353 @@
+//========================================= #TheForgeMathExtensionsBegin ================================================
+
+/*
+* Copyright (c) 2018-2020 The Forge Interactive Inc.
+*
+* This file is part of The-Forge
+* (see https://github.com/ConfettiFX/The-Forge).
+*
+* Licensed to the Apache Software Foundation (ASF) under one
+* or more contributor license agreements.  See the NOTICE file
+* distributed with this work for additional information
+* regarding copyright ownership.  The ASF licenses this file
+* to you under the Apache License, Version 2.0 (the
+* "License"); you may not use this file except in compliance
+* with the License.  You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing,
+* software distributed under the License is distributed on an
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+* KIND, either express or implied.  See the License for the
+* specific language governing permissions and limitations
+* under the License.
+*/
+
+
+// Batch functions running one matrix over many elements, or many matrix pairs, as wide as the CPU allows.
+// The elements come as structure of arrays streams, element i of a Stream3 is (x[i], y[i], z[i]), so the kernels load
+// Lanes::kWidth elements per register without any shuffling. The backend is chosen once at runtime from what the CPU
+// supports, AVX-512 and AVX2 are compiled in next to SSE on x86 whatever the compiler flags, set
+// VECTORMATH_BATCH_RUNTIME_DISPATCH to 0 to only get the ones the build targets anyway.
+// None of the streams has to be aligned, an output may be the matching input to transform in place.
+
+#ifndef VECTORMATH_BATCH_HPP
+#define VECTORMATH_BATCH_HPP
+
+#include <stdint.h>
+
+#ifndef VECTORMATH_BATCH_RUNTIME_DISPATCH
+    #define VECTORMATH_BATCH_RUNTIME_DISPATCH 1
+#endif
+
+#if VECTORMATH_MODE_SSE
+    #define VECTORMATH_BATCH_HAS_SSE 1
+#else
+    #define VECTORMATH_BATCH_HAS_SSE 0
+#endif
+
+#if VECTORMATH_MODE_NEON
+    #define VECTORMATH_BATCH_HAS_NEON 1
+#else
+    #define VECTORMATH_BATCH_HAS_NEON 0
+#endif
+
+// The consoles build for one known CPU, only the desktop x86 targets get the wide backends
+#if VECTORMATH_MODE_SSE && !VECTORMATH_MODE_SCE
+    #if (VECTORMATH_BATCH_RUNTIME_DISPATCH && (defined(__clang__) || defined(__GNUC__) || defined(_MSC_VER))) || (defined(__AVX2__) && defined(__FMA__))
+        #define VECTORMATH_BATCH_HAS_AVX2 1
+    #else
+        #define VECTORMATH_BATCH_HAS_AVX2 0
+    #endif
+    #if (VECTORMATH_BATCH_RUNTIME_DISPATCH && (defined(__clang__) || defined(__GNUC__) || _MSC_VER >= 1911)) || defined(__AVX512F__)
+        #define VECTORMATH_BATCH_HAS_AVX512 1
+    #else
+        #define VECTORMATH_BATCH_HAS_AVX512 0
+    #endif
+#else
+    #define VECTORMATH_BATCH_HAS_AVX2 0
+    #define VECTORMATH_BATCH_HAS_AVX512 0
+#endif
+
+#if VECTORMATH_BATCH_HAS_AVX2 || VECTORMATH_BATCH_HAS_AVX512
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+namespace Vectormath
+{
+namespace Batch
+{
+
+// ========================================================
+// Streams
+// ========================================================
+
+// Read only when passed as an input
+struct Stream3
+{
+    float * x;
+    float * y;
+    float * z;
+};
+
+struct Stream4
+{
+    float * x;
+    float * y;
+    float * z;
+    float * w;
+};
+
+struct AabbStream
+{
+    Stream3 min;
+    Stream3 max;
+};
+
+} // namespace Batch
+} // namespace Vectormath
+
+#include "generic.hpp"
+#if VECTORMATH_BATCH_HAS_SSE
+    #include "sse.hpp"
+#endif
+#if VECTORMATH_BATCH_HAS_NEON
+    #include "neon.hpp"
+#endif
+#if VECTORMATH_BATCH_HAS_AVX2
+    #include "avx2.hpp"
+#endif
+#if VECTORMATH_BATCH_HAS_AVX512
+    #include "avx512.hpp"
+#endif
+
+namespace Vectormath
+{
+namespace Batch
+{
+
+// ========================================================
+// Backends
+// ========================================================
+
+// From the slowest to the fastest
+enum Backend
+{
+    BACKEND_GENERIC = 0,
+    BACKEND_SSE,
+    BACKEND_NEON,
+    BACKEND_AVX2,
+    BACKEND_AVX512,
+    BACKEND_COUNT,
+};
+
+inline const char * getBackendName(Backend backend)
+{
+    static const char * names[BACKEND_COUNT] = { "Generic", "SSE", "NEON", "AVX2", "AVX-512" };
+    return backend < BACKEND_COUNT ? names[backend] : "Unknown";
+}
+
+#if VECTORMATH_BATCH_HAS_AVX2 || VECTORMATH_BATCH_HAS_AVX512
+// Registers of CPUID leaf and subleaf, EAX EBX ECX EDX
+inline void getCpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuidex(info, (int)leaf, (int)subleaf);
+    for (uint32_t i = 0; i < 4; ++i)
+        regs[i] = (uint32_t)info[i];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Register state the OS saves on context switches, only valid once CPUID reported OSXSAVE
+inline uint64_t getEnabledXsaveFeatures()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+// False when the instruction set is missing, or when the OS does not save its registers
+inline bool isX86BackendSupported(Backend backend)
+{
+    uint32_t regs[4];
+    getCpuid(0, 0, regs);
+    if (regs[0] < 7)
+        return false;
+
+    getCpuid(1, 0, regs);
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool avx = (regs[2] & (1u << 28)) != 0;
+    const bool fma = (regs[2] & (1u << 12)) != 0;
+    if (!osxsave || !avx)
+        return false;
+
+    getCpuid(7, 0, regs);
+    const uint64_t xcr0 = getEnabledXsaveFeatures();
+    // XMM and YMM, then the opmask and both halves of ZMM
+    const bool ymmState = (xcr0 & 0x6) == 0x6;
+    const bool zmmState = (xcr0 & 0xe6) == 0xe6;
+
+    if (BACKEND_AVX2 == backend)
+        return ymmState && fma && (regs[1] & (1u << 5)) != 0;
+    if (BACKEND_AVX512 == backend)
+        return zmmState && (regs[1] & (1u << 16)) != 0;
+    return false;
+}
+#endif
+
+inline bool isBackendSupported(Backend backend)
+{
+    switch (backend)
+    {
+    case BACKEND_GENERIC:
+        return true;
+    case BACKEND_SSE:
+        return VECTORMATH_BATCH_HAS_SSE;
+    case BACKEND_NEON:
+        return VECTORMATH_BATCH_HAS_NEON;
+#if VECTORMATH_BATCH_HAS_AVX2
+    case BACKEND_AVX2:
+    {
+        static const bool supported = isX86BackendSupported(BACKEND_AVX2);
+        return supported;
+    }
+#endif
+#if VECTORMATH_BATCH_HAS_AVX512
+    case BACKEND_AVX512:
+    {
+        static const bool supported = isX86BackendSupported(BACKEND_AVX512);
+        return supported;
+    }
+#endif
+    default:
+        return false;
+    }
+}
+
+inline Backend detectBackend()
+{
+    for (int i = BACKEND_COUNT - 1; i > BACKEND_GENERIC; --i)
+    {
+        if (isBackendSupported((Backend)i))
+            return (Backend)i;
+    }
+    return BACKEND_GENERIC;
+}
+
+inline Backend & getActiveBackend()
+{
+    static Backend backend = detectBackend();
+    return backend;
+}
+
+// The fastest backend the CPU supports, unless setBackend picked another one
+inline Backend getBackend()
+{
+    return getActiveBackend();
+}
+
+// Forces a backend, to compare them or to rule one out. Not thread safe against the batch functions running.
+// Returns false and keeps the current one when the CPU does not support it.
+inline bool setBackend(Backend backend)
+{
+    if (!isBackendSupported(backend))
+        return false;
+    getActiveBackend() = backend;
+    return true;
+}
+
+#if VECTORMATH_BATCH_HAS_SSE
+    #define VECTORMATH_BATCH_CASE_SSE(function, ...) case BACKEND_SSE: SSE::function(__VA_ARGS__); return;
+#else
+    #define VECTORMATH_BATCH_CASE_SSE(function, ...)
+#endif
+#if VECTORMATH_BATCH_HAS_NEON
+    #define VECTORMATH_BATCH_CASE_NEON(function, ...) case BACKEND_NEON: Neon::function(__VA_ARGS__); return;
+#else
+    #define VECTORMATH_BATCH_CASE_NEON(function, ...)
+#endif
+#if VECTORMATH_BATCH_HAS_AVX2
+    #define VECTORMATH_BATCH_CASE_AVX2(function, ...) case BACKEND_AVX2: AVX2::function(__VA_ARGS__); return;
+#else
+    #define VECTORMATH_BATCH_CASE_AVX2(function, ...)
+#endif
+#if VECTORMATH_BATCH_HAS_AVX512
+    #define VECTORMATH_BATCH_CASE_AVX512(function, ...) case BACKEND_AVX512: AVX512::function(__VA_ARGS__); return;
+#else
+    #define VECTORMATH_BATCH_CASE_AVX512(function, ...)
+#endif
+
+#define VECTORMATH_BATCH_DISPATCH(function, ...)                \
+    switch (getBackend())                                       \
+    {                                                           \
+    VECTORMATH_BATCH_CASE_AVX512(function, __VA_ARGS__)         \
+    VECTORMATH_BATCH_CASE_AVX2(function, __VA_ARGS__)           \
+    VECTORMATH_BATCH_CASE_NEON(function, __VA_ARGS__)           \
+    VECTORMATH_BATCH_CASE_SSE(function, __VA_ARGS__)            \
+    default: Generic::function(__VA_ARGS__); return;            \
+    }
+
+// ========================================================
+// Batch functions
+// ========================================================
+
+// out[i] = (m * Point3(in[i])).xyz, the projective row of m is ignored
+inline void transformPoints(const Matrix4 & m, const Stream3 & in, const Stream3 & out, uint32_t count)
+{
+    VECTORMATH_BATCH_DISPATCH(transformPoints, toFloatPtr(m), in, out, count)
+}
+
+// out[i] = m * Point3(in[i]), the homogeneous result, as for clip space positions
+inline void transformPoints(const Matrix4 & m, const Stream3 & in, const Stream4 & out, uint32_t count)
+{
+    VECTORMATH_BATCH_DISPATCH(transformPoints, toFloatPtr(m), in, out, count)
+}
+
+// out[i] = (m * Vector3(in[i])).xyz, the translation of m is ignored
+inline void transformVectors(const Matrix4 & m, const Stream3 & in, const Stream3 & out, uint32_t count)
+{
+    VECTORMATH_BATCH_DISPATCH(transformVectors, toFloatPtr(m), in, out, count)
+}
+
+// out[i] is the axis aligned box around in[i] transformed by the affine m
+inline void transformAabbs(const Matrix4 & m, const AabbStream & in, const AabbStream & out, uint32_t count)
+{
+    VECTORMATH_BATCH_DISPATCH(transformAabbs, toFloatPtr(m), in, out, count)
+}
+
+// pOut[i] = pA[i] * pB[i], pOut may be pA or pB
+inline void mulMatrices(const Matrix4 * pA, const Matrix4 * pB, Matrix4 * pOut, uint32_t count)
+{
+    VECTORMATH_BATCH_DISPATCH(mulMatrices, pA, pB, pOut, count)
+}
+
+// pOut[i] = a * pB[i], as for a view projection over many world matrices
+inline void mulMatrices(const Matrix4 & a, const Matrix4 * pB, Matrix4 * pOut, uint32_t count)
+{
+    VECTORMATH_BATCH_DISPATCH(mulMatrices, a, pB, pOut, count)
+}
+
+#undef VECTORMATH_BATCH_DISPATCH
+#undef VECTORMATH_BATCH_CASE_SSE
+#undef VECTORMATH_BATCH_CASE_NEON
+#undef VECTORMATH_BATCH_CASE_AVX2
+#undef VECTORMATH_BATCH_CASE_AVX512
+
+} // namespace Batch
+} // namespace Vectormath
+
+#endif // VECTORMATH_BATCH_HPP
+
+//========================================= #TheForgeMathExtensionsEnd ================================================
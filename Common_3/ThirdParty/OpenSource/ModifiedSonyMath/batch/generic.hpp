@@ -0,0 +1,88 @@
+//========================================= #TheForgeMathExtensionsBegin ================================================
+
+/*
+* Copyright (c) 2018-2020 The Forge Interactive Inc.
+*
+* This file is part of The-Forge
+* (see https://github.com/ConfettiFX/The-Forge).
+*
+* Licensed to the Apache Software Foundation (ASF) under one
+* or more contributor license agreements.  See the NOTICE file
+* distributed with this work for additional information
+* regarding copyright ownership.  The ASF licenses this file
+* to you under the Apache License, Version 2.0 (the
+* "License"); you may not use this file except in compliance
+* with the License.  You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing,
+* software distributed under the License is distributed on an
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+* KIND, either express or implied.  See the License for the
+* specific language governing permissions and limitations
+* under the License.
+*/
+
+
+#ifndef VECTORMATH_BATCH_GENERIC_HPP
+#define VECTORMATH_BATCH_GENERIC_HPP
+
+namespace Vectormath
+{
+namespace Batch
+{
+namespace Generic
+{
+
+// One element at a time in plain floats, the fallback of every platform and the reference of the others
+struct Lanes
+{
+    typedef float Type;
+    static const uint32_t kWidth = 1;
+
+    static inline Type Load(const float * p)         { return *p; }
+    static inline void Store(float * p, Type v)      { *p = v; }
+    static inline Type Splat(float f)                { return f; }
+    static inline Type Add(Type a, Type b)           { return a + b; }
+    static inline Type Sub(Type a, Type b)           { return a - b; }
+    static inline Type Mul(Type a, Type b)           { return a * b; }
+    static inline Type MulAdd(Type a, Type b, Type c){ return a * b + c; }
+    static inline Type Abs(Type a)                   { return fabsf(a); }
+};
+
+#define VECTORMATH_BATCH_LANES_HOLD_COLUMNS 0
+#include "kernels.inl"
+#undef VECTORMATH_BATCH_LANES_HOLD_COLUMNS
+
+static inline void mulMatricesBlock(const float * pA, const float * pB, float * pOut)
+{
+    float result[16];
+    for (uint32_t col = 0; col < 4; ++col)
+        for (uint32_t row = 0; row < 4; ++row)
+            result[col * 4 + row] = pA[row] * pB[col * 4] + pA[4 + row] * pB[col * 4 + 1] + pA[8 + row] * pB[col * 4 + 2] + pA[12 + row] * pB[col * 4 + 3];
+    for (uint32_t i = 0; i < 16; ++i)
+        pOut[i] = result[i];
+}
+
+inline void mulMatrices(const Matrix4 * pA, const Matrix4 * pB, Matrix4 * pOut, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        mulMatricesBlock(toFloatPtr(pA[i]), toFloatPtr(pB[i]), toFloatPtr(pOut[i]));
+}
+
+inline void mulMatrices(const Matrix4 & a, const Matrix4 * pB, Matrix4 * pOut, uint32_t count)
+{
+    // A copy, pOut may overlap a
+    const Matrix4 aCopy = a;
+    for (uint32_t i = 0; i < count; ++i)
+        mulMatricesBlock(toFloatPtr(aCopy), toFloatPtr(pB[i]), toFloatPtr(pOut[i]));
+}
+
+} // namespace Generic
+} // namespace Batch
+} // namespace Vectormath
+
+#endif // VECTORMATH_BATCH_GENERIC_HPP
+
+//========================================= #TheForgeMathExtensionsEnd ================================================
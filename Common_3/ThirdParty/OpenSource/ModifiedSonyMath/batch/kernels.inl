@@ -0,0 +1,269 @@
+//========================================= #TheForgeMathExtensionsBegin ================================================
+
+/*
+* Copyright (c) 2018-2020 The Forge Interactive Inc.
+*
+* This file is part of The-Forge
+* (see https://github.com/ConfettiFX/The-Forge).
+*
+* Licensed to the Apache Software Foundation (ASF) under one
+* or more contributor license agreements.  See the NOTICE file
+* distributed with this work for additional information
+* regarding copyright ownership.  The ASF licenses this file
+* to you under the Apache License, Version 2.0 (the
+* "License"); you may not use this file except in compliance
+* with the License.  You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing,
+* software distributed under the License is distributed on an
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+* KIND, either express or implied.  See the License for the
+* specific language governing permissions and limitations
+* under the License.
+*/
+
+
+// Kernels of the batch functions, written once against the Lanes of a backend.
+// Included by every backend header inside its own namespace and, on GCC / Clang, inside the target pragma of its
+// instruction set, so nothing in here may be a template or rely on code compiled for another target.
+// Each kernel works on Lanes::kWidth elements at a time, the last partial block goes through a padded copy on the
+// stack so the streams never get read or written past count.
+
+typedef Lanes::Type LaneType;
+static const uint32_t kLaneWidth = Lanes::kWidth;
+
+// Matrix elements splatted across the lanes, column major like Matrix4
+struct SplatMatrix
+{
+    LaneType c[4][4];
+};
+
+static inline void loadSplatMatrix(const float * pMatrix, SplatMatrix * pOut)
+{
+    for (uint32_t col = 0; col < 4; ++col)
+        for (uint32_t row = 0; row < 4; ++row)
+            pOut->c[col][row] = Lanes::Splat(pMatrix[col * 4 + row]);
+}
+
+// The partial last block, padded with zeros on the way in
+static inline void loadTail(float * pDst, const float * pSrc, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i < count; ++i)
+        pDst[i] = pSrc[i];
+    for (; i < kLaneWidth; ++i)
+        pDst[i] = 0.0f;
+}
+
+static inline void storeTail(float * pDst, const float * pSrc, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        pDst[i] = pSrc[i];
+}
+
+// ========================================================
+// Points and vectors
+// ========================================================
+
+static inline void transformPointsBlock(const SplatMatrix & m, const float * pX, const float * pY, const float * pZ,
+                                        float * pOutX, float * pOutY, float * pOutZ, float * pOutW)
+{
+    const LaneType x = Lanes::Load(pX);
+    const LaneType y = Lanes::Load(pY);
+    const LaneType z = Lanes::Load(pZ);
+
+    const LaneType outX = Lanes::MulAdd(m.c[0][0], x, Lanes::MulAdd(m.c[1][0], y, Lanes::MulAdd(m.c[2][0], z, m.c[3][0])));
+    const LaneType outY = Lanes::MulAdd(m.c[0][1], x, Lanes::MulAdd(m.c[1][1], y, Lanes::MulAdd(m.c[2][1], z, m.c[3][1])));
+    const LaneType outZ = Lanes::MulAdd(m.c[0][2], x, Lanes::MulAdd(m.c[1][2], y, Lanes::MulAdd(m.c[2][2], z, m.c[3][2])));
+    if (pOutW)
+        Lanes::Store(pOutW, Lanes::MulAdd(m.c[0][3], x, Lanes::MulAdd(m.c[1][3], y, Lanes::MulAdd(m.c[2][3], z, m.c[3][3]))));
+    Lanes::Store(pOutX, outX);
+    Lanes::Store(pOutY, outY);
+    Lanes::Store(pOutZ, outZ);
+}
+
+static inline void transformPointsStreams(const float * pMatrix, const Stream3 & in, float * pOutX, float * pOutY,
+                                          float * pOutZ, float * pOutW, uint32_t count)
+{
+    SplatMatrix m;
+    loadSplatMatrix(pMatrix, &m);
+
+    uint32_t i = 0;
+    for (; i + kLaneWidth <= count; i += kLaneWidth)
+        transformPointsBlock(m, in.x + i, in.y + i, in.z + i, pOutX + i, pOutY + i, pOutZ + i, pOutW ? pOutW + i : NULL);
+
+    if (i < count)
+    {
+        const uint32_t tailCount = count - i;
+        float tail[7][kLaneWidth];
+        loadTail(tail[0], in.x + i, tailCount);
+        loadTail(tail[1], in.y + i, tailCount);
+        loadTail(tail[2], in.z + i, tailCount);
+        transformPointsBlock(m, tail[0], tail[1], tail[2], tail[3], tail[4], tail[5], tail[6]);
+        storeTail(pOutX + i, tail[3], tailCount);
+        storeTail(pOutY + i, tail[4], tailCount);
+        storeTail(pOutZ + i, tail[5], tailCount);
+        if (pOutW)
+            storeTail(pOutW + i, tail[6], tailCount);
+    }
+}
+
+inline void transformPoints(const float * pMatrix, const Stream3 & in, const Stream3 & out, uint32_t count)
+{
+    transformPointsStreams(pMatrix, in, out.x, out.y, out.z, NULL, count);
+}
+
+inline void transformPoints(const float * pMatrix, const Stream3 & in, const Stream4 & out, uint32_t count)
+{
+    transformPointsStreams(pMatrix, in, out.x, out.y, out.z, out.w, count);
+}
+
+static inline void transformVectorsBlock(const SplatMatrix & m, const float * pX, const float * pY, const float * pZ,
+                                         float * pOutX, float * pOutY, float * pOutZ)
+{
+    const LaneType x = Lanes::Load(pX);
+    const LaneType y = Lanes::Load(pY);
+    const LaneType z = Lanes::Load(pZ);
+
+    const LaneType outX = Lanes::MulAdd(m.c[0][0], x, Lanes::MulAdd(m.c[1][0], y, Lanes::Mul(m.c[2][0], z)));
+    const LaneType outY = Lanes::MulAdd(m.c[0][1], x, Lanes::MulAdd(m.c[1][1], y, Lanes::Mul(m.c[2][1], z)));
+    const LaneType outZ = Lanes::MulAdd(m.c[0][2], x, Lanes::MulAdd(m.c[1][2], y, Lanes::Mul(m.c[2][2], z)));
+    Lanes::Store(pOutX, outX);
+    Lanes::Store(pOutY, outY);
+    Lanes::Store(pOutZ, outZ);
+}
+
+inline void transformVectors(const float * pMatrix, const Stream3 & in, const Stream3 & out, uint32_t count)
+{
+    SplatMatrix m;
+    loadSplatMatrix(pMatrix, &m);
+
+    uint32_t i = 0;
+    for (; i + kLaneWidth <= count; i += kLaneWidth)
+        transformVectorsBlock(m, in.x + i, in.y + i, in.z + i, out.x + i, out.y + i, out.z + i);
+
+    if (i < count)
+    {
+        const uint32_t tailCount = count - i;
+        float tail[6][kLaneWidth];
+        loadTail(tail[0], in.x + i, tailCount);
+        loadTail(tail[1], in.y + i, tailCount);
+        loadTail(tail[2], in.z + i, tailCount);
+        transformVectorsBlock(m, tail[0], tail[1], tail[2], tail[3], tail[4], tail[5]);
+        storeTail(out.x + i, tail[3], tailCount);
+        storeTail(out.y + i, tail[4], tailCount);
+        storeTail(out.z + i, tail[5], tailCount);
+    }
+}
+
+// ========================================================
+// Bounding boxes
+// ========================================================
+
+// The box goes through the matrix as center and extents, the extents through the absolute 3x3 part
+static inline void transformAabbsBlock(const SplatMatrix & m, const SplatMatrix & absM, const float * const pIn[6],
+                                       float * const pOut[6])
+{
+    const LaneType half = Lanes::Splat(0.5f);
+    const LaneType minX = Lanes::Load(pIn[0]);
+    const LaneType minY = Lanes::Load(pIn[1]);
+    const LaneType minZ = Lanes::Load(pIn[2]);
+    const LaneType maxX = Lanes::Load(pIn[3]);
+    const LaneType maxY = Lanes::Load(pIn[4]);
+    const LaneType maxZ = Lanes::Load(pIn[5]);
+
+    const LaneType centerX = Lanes::Mul(Lanes::Add(minX, maxX), half);
+    const LaneType centerY = Lanes::Mul(Lanes::Add(minY, maxY), half);
+    const LaneType centerZ = Lanes::Mul(Lanes::Add(minZ, maxZ), half);
+    const LaneType extentX = Lanes::Mul(Lanes::Sub(maxX, minX), half);
+    const LaneType extentY = Lanes::Mul(Lanes::Sub(maxY, minY), half);
+    const LaneType extentZ = Lanes::Mul(Lanes::Sub(maxZ, minZ), half);
+
+    LaneType center[3];
+    LaneType extent[3];
+    for (uint32_t row = 0; row < 3; ++row)
+    {
+        center[row] = Lanes::MulAdd(m.c[0][row], centerX, Lanes::MulAdd(m.c[1][row], centerY, Lanes::MulAdd(m.c[2][row], centerZ, m.c[3][row])));
+        extent[row] = Lanes::MulAdd(absM.c[0][row], extentX, Lanes::MulAdd(absM.c[1][row], extentY, Lanes::Mul(absM.c[2][row], extentZ)));
+    }
+    for (uint32_t row = 0; row < 3; ++row)
+    {
+        Lanes::Store(pOut[row], Lanes::Sub(center[row], extent[row]));
+        Lanes::Store(pOut[3 + row], Lanes::Add(center[row], extent[row]));
+    }
+}
+
+inline void transformAabbs(const float * pMatrix, const AabbStream & in, const AabbStream & out, uint32_t count)
+{
+    SplatMatrix m;
+    SplatMatrix absM;
+    loadSplatMatrix(pMatrix, &m);
+    for (uint32_t col = 0; col < 4; ++col)
+        for (uint32_t row = 0; row < 4; ++row)
+            absM.c[col][row] = Lanes::Abs(m.c[col][row]);
+
+    uint32_t i = 0;
+    for (; i + kLaneWidth <= count; i += kLaneWidth)
+    {
+        const float * const pIn[6] = { in.min.x + i, in.min.y + i, in.min.z + i, in.max.x + i, in.max.y + i, in.max.z + i };
+        float * const pOut[6] = { out.min.x + i, out.min.y + i, out.min.z + i, out.max.x + i, out.max.y + i, out.max.z + i };
+        transformAabbsBlock(m, absM, pIn, pOut);
+    }
+
+    if (i < count)
+    {
+        const uint32_t tailCount = count - i;
+        const float * const pIn[6] = { in.min.x + i, in.min.y + i, in.min.z + i, in.max.x + i, in.max.y + i, in.max.z + i };
+        float * const pOut[6] = { out.min.x + i, out.min.y + i, out.min.z + i, out.max.x + i, out.max.y + i, out.max.z + i };
+        float tailIn[6][kLaneWidth];
+        float tailOut[6][kLaneWidth];
+        const float * const pTailIn[6] = { tailIn[0], tailIn[1], tailIn[2], tailIn[3], tailIn[4], tailIn[5] };
+        float * const pTailOut[6] = { tailOut[0], tailOut[1], tailOut[2], tailOut[3], tailOut[4], tailOut[5] };
+        for (uint32_t s = 0; s < 6; ++s)
+            loadTail(tailIn[s], pIn[s], tailCount);
+        transformAabbsBlock(m, absM, pTailIn, pTailOut);
+        for (uint32_t s = 0; s < 6; ++s)
+            storeTail(pOut[s], tailOut[s], tailCount);
+    }
+}
+
+// ========================================================
+// Matrix products
+// ========================================================
+
+#if VECTORMATH_BATCH_LANES_HOLD_COLUMNS
+// The lanes hold kLaneWidth / 4 columns of the result, each one the columns of a combined with the elements of the
+// matching column of b. All of a is read before anything is stored, so out may be a or b.
+static inline void mulMatricesBlock(const LaneType a[4], const float * pB, float * pOut)
+{
+    for (uint32_t col = 0; col < 16; col += kLaneWidth)
+    {
+        const LaneType b = Lanes::Load(pB + col);
+        LaneType result = Lanes::Mul(a[0], Lanes::SplatX(b));
+        result = Lanes::MulAdd(a[1], Lanes::SplatY(b), result);
+        result = Lanes::MulAdd(a[2], Lanes::SplatZ(b), result);
+        result = Lanes::MulAdd(a[3], Lanes::SplatW(b), result);
+        Lanes::Store(pOut + col, result);
+    }
+}
+
+inline void mulMatrices(const Matrix4 * pA, const Matrix4 * pB, Matrix4 * pOut, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const float * pAi = toFloatPtr(pA[i]);
+        const LaneType a[4] = { Lanes::LoadColumn(pAi), Lanes::LoadColumn(pAi + 4), Lanes::LoadColumn(pAi + 8), Lanes::LoadColumn(pAi + 12) };
+        mulMatricesBlock(a, toFloatPtr(pB[i]), toFloatPtr(pOut[i]));
+    }
+}
+
+inline void mulMatrices(const Matrix4 & a, const Matrix4 * pB, Matrix4 * pOut, uint32_t count)
+{
+    const float * pA = toFloatPtr(a);
+    const LaneType columns[4] = { Lanes::LoadColumn(pA), Lanes::LoadColumn(pA + 4), Lanes::LoadColumn(pA + 8), Lanes::LoadColumn(pA + 12) };
+    for (uint32_t i = 0; i < count; ++i)
+        mulMatricesBlock(columns, toFloatPtr(pB[i]), toFloatPtr(pOut[i]));
+}
+#endif // VECTORMATH_BATCH_LANES_HOLD_COLUMNS
@@ -0,0 +1,77 @@
+//========================================= #TheForgeMathExtensionsBegin ================================================
+
+/*
+* Copyright (c) 2018-2020 The Forge Interactive Inc.
+*
+* This file is part of The-Forge
+* (see https://github.com/ConfettiFX/The-Forge).
+*
+* Licensed to the Apache Software Foundation (ASF) under one
+* or more contributor license agreements.  See the NOTICE file
+* distributed with this work for additional information
+* regarding copyright ownership.  The ASF licenses this file
+* to you under the Apache License, Version 2.0 (the
+* "License"); you may not use this file except in compliance
+* with the License.  You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing,
+* software distributed under the License is distributed on an
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+* KIND, either express or implied.  See the License for the
+* specific language governing permissions and limitations
+* under the License.
+*/
+
+
+#ifndef VECTORMATH_BATCH_NEON_HPP
+#define VECTORMATH_BATCH_NEON_HPP
+
+#include <arm_neon.h>
+
+namespace Vectormath
+{
+namespace Batch
+{
+namespace Neon
+{
+
+// Four elements per register
+struct Lanes
+{
+    typedef float32x4_t Type;
+    static const uint32_t kWidth = 4;
+
+    static inline Type Load(const float * p)         { return vld1q_f32(p); }
+    static inline void Store(float * p, Type v)      { vst1q_f32(p, v); }
+    static inline Type Splat(float f)                { return vdupq_n_f32(f); }
+    static inline Type Add(Type a, Type b)           { return vaddq_f32(a, b); }
+    static inline Type Sub(Type a, Type b)           { return vsubq_f32(a, b); }
+    static inline Type Mul(Type a, Type b)           { return vmulq_f32(a, b); }
+#if defined(__aarch64__) || defined(_M_ARM64)
+    static inline Type MulAdd(Type a, Type b, Type c){ return vfmaq_f32(c, a, b); }
+#else
+    static inline Type MulAdd(Type a, Type b, Type c){ return vmlaq_f32(c, a, b); }
+#endif
+    static inline Type Abs(Type a)                   { return vabsq_f32(a); }
+
+    // Matrix products, one column per register
+    static inline Type LoadColumn(const float * p)   { return vld1q_f32(p); }
+    static inline Type SplatX(Type v)                { return vdupq_lane_f32(vget_low_f32(v), 0); }
+    static inline Type SplatY(Type v)                { return vdupq_lane_f32(vget_low_f32(v), 1); }
+    static inline Type SplatZ(Type v)                { return vdupq_lane_f32(vget_high_f32(v), 0); }
+    static inline Type SplatW(Type v)                { return vdupq_lane_f32(vget_high_f32(v), 1); }
+};
+
+#define VECTORMATH_BATCH_LANES_HOLD_COLUMNS 1
+#include "kernels.inl"
+#undef VECTORMATH_BATCH_LANES_HOLD_COLUMNS
+
+} // namespace Neon
+} // namespace Batch
+} // namespace Vectormath
+
+#endif // VECTORMATH_BATCH_NEON_HPP
+
+//========================================= #TheForgeMathExtensionsEnd ================================================
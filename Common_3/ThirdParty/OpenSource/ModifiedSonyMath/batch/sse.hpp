@@ -0,0 +1,73 @@
+//========================================= #TheForgeMathExtensionsBegin ================================================
+
+/*
+* Copyright (c) 2018-2020 The Forge Interactive Inc.
+*
+* This file is part of The-Forge
+* (see https://github.com/ConfettiFX/The-Forge).
+*
+* Licensed to the Apache Software Foundation (ASF) under one
+* or more contributor license agreements.  See the NOTICE file
+* distributed with this work for additional information
+* regarding copyright ownership.  The ASF licenses this file
+* to you under the Apache License, Version 2.0 (the
+* "License"); you may not use this file except in compliance
+* with the License.  You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing,
+* software distributed under the License is distributed on an
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+* KIND, either express or implied.  See the License for the
+* specific language governing permissions and limitations
+* under the License.
+*/
+
+
+#ifndef VECTORMATH_BATCH_SSE_HPP
+#define VECTORMATH_BATCH_SSE_HPP
+
+#include <xmmintrin.h>
+
+namespace Vectormath
+{
+namespace Batch
+{
+namespace SSE
+{
+
+// Four elements per register, SSE1 only so it runs wherever the SSE mode of the library does
+struct Lanes
+{
+    typedef __m128 Type;
+    static const uint32_t kWidth = 4;
+
+    static inline Type Load(const float * p)         { return _mm_loadu_ps(p); }
+    static inline void Store(float * p, Type v)      { _mm_storeu_ps(p, v); }
+    static inline Type Splat(float f)                { return _mm_set1_ps(f); }
+    static inline Type Add(Type a, Type b)           { return _mm_add_ps(a, b); }
+    static inline Type Sub(Type a, Type b)           { return _mm_sub_ps(a, b); }
+    static inline Type Mul(Type a, Type b)           { return _mm_mul_ps(a, b); }
+    static inline Type MulAdd(Type a, Type b, Type c){ return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static inline Type Abs(Type a)                   { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+    // Matrix products, one column per register
+    static inline Type LoadColumn(const float * p)   { return _mm_loadu_ps(p); }
+    static inline Type SplatX(Type v)                { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)); }
+    static inline Type SplatY(Type v)                { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)); }
+    static inline Type SplatZ(Type v)                { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)); }
+    static inline Type SplatW(Type v)                { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)); }
+};
+
+#define VECTORMATH_BATCH_LANES_HOLD_COLUMNS 1
+#include "kernels.inl"
+#undef VECTORMATH_BATCH_LANES_HOLD_COLUMNS
+
+} // namespace SSE
+} // namespace Batch
+} // namespace Vectormath
+
+#endif // VECTORMATH_BATCH_SSE_HPP
+
+//========================================= #TheForgeMathExtensionsEnd ================================================
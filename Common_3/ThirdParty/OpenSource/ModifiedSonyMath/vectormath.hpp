@@ -80,6 +80,10 @@ using namespace Vectormath::Soa;
 #include "vec2d.hpp"  // - Extended 2D vector and point classes; not aligned and always in scalar floats mode.
 #include "common.hpp" // - Miscellaneous helper functions.
 
+//========================================= #TheForgeMathExtensionsBegin ================================================
+#include "batch/batch.hpp" // - One matrix over streams of points, vectors and boxes, and matrix products, up to AVX-512.
+//========================================= #TheForgeMathExtensionsEnd ================================================
+
 using namespace Vectormath;
 
 #endif // VECTORMATH_HPP
@@ -100,6 +100,40 @@ class Animation {
 
   void Deallocate();
 
+  //CONFFX_BEGIN
+  // Mapped form of an animation, a MappedHeader followed by the translation,
+  // rotation and scale keys and the name, laid out exactly as they are used at
+  // runtime. Unlike an archive it needs no per key decoding, so it can be used
+  // in place from a file read in one go or memory mapped. Keys keep their
+  // quantized 16 bits values.
+  struct MappedHeader {
+    char tag[4];
+    uint32_t version;
+    float duration;
+    int32_t num_tracks;
+    uint32_t name_len;
+    uint32_t translation_count;
+    uint32_t rotation_count;
+    uint32_t scale_count;
+  };
+
+  // Gets the size in bytes of the mapped form of *this.
+  size_t mapped_size() const;
+
+  // Writes the mapped form of *this to _buffer, which must be at least
+  // mapped_size() bytes and aligned to 4 bytes.
+  void WriteMapped(void* _buffer) const;
+
+  // Points *this at the keys of the mapped animation in _buffer instead of
+  // copying them. _buffer is not owned and must outlive *this, any number of
+  // animations can map the same buffer. Returns false if _buffer does not hold
+  // a valid mapped animation.
+  bool Map(const void* _buffer, size_t _size);
+
+  // Tests whether _buffer starts with the header of a mapped animation.
+  static bool IsMapped(const void* _buffer, size_t _size);
+  //CONFFX_END
+
  protected:
  private:
   // Disables copy and assignation.
@@ -128,6 +162,9 @@ class Animation {
   Range<TranslationKey> translations_;
   Range<RotationKey> rotations_;
   Range<ScaleKey> scales_;
+
+  // The keys point into a mapped buffer that *this does not own.
+  bool mapped_; //CONFFX_BEGIN
 };
 }  // namespace animation
 
@@ -35,6 +35,10 @@
 
 namespace ozz {
 
+namespace memory {
+class Allocator;
+}
+
 //CONFFX_END
 
 namespace animation {
@@ -105,7 +109,8 @@ class SamplingCache {
   // Construct a cache that can be used to sample any animation with at most
   // _max_tracks tracks. _num_tracks is internally aligned to a multiple of
   // soa size.
-  SamplingCache(int _max_tracks);
+  // The cache memory comes from _allocator, the default allocator if NULL.
+  SamplingCache(int _max_tracks, memory::Allocator* _allocator = NULL); //CONFFX_BEGIN
 
   // Deallocate cache.
   ~SamplingCache();
@@ -166,6 +171,9 @@ class SamplingCache {
   unsigned char* outdated_translations_;
   unsigned char* outdated_rotations_;
   unsigned char* outdated_scales_;
+
+  // The allocator of the cache memory.
+  memory::Allocator* allocator_; //CONFFX_BEGIN
 };
 }  // namespace animation
 }  // namespace ozz
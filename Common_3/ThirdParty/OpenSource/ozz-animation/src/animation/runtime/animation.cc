@@ -48,7 +48,7 @@
 namespace ozz {
 namespace animation {
 
-Animation::Animation() : duration_(0.f), num_tracks_(0), name_(NULL) {}
+Animation::Animation() : duration_(0.f), num_tracks_(0), name_(NULL), mapped_(false) {}
 
 Animation::~Animation() {
 	
@@ -98,7 +98,12 @@ void Animation::Allocate(size_t _name_len, size_t _translation_count,
 
 void Animation::Deallocate() {
 
-  memory::default_allocator()->Deallocate(translations_.begin);
+  //CONFFX_BEGIN
+  if (!mapped_) {
+    memory::default_allocator()->Deallocate(translations_.begin);
+  }
+  mapped_ = false;
+  //CONFFX_END
 
   name_ = NULL;
   translations_ = ozz::Range<TranslationKey>();
@@ -112,6 +117,106 @@ size_t Animation::size() const {
   return size;
 }
 
+//CONFFX_BEGIN
+namespace {
+const char kMappedTag[4] = {'O', 'Z', 'M', 'A'};
+// Bumped whenever the layout of the header or of the keys changes.
+const uint32_t kMappedVersion = 1;
+}  // namespace
+
+size_t Animation::mapped_size() const {
+  const size_t name_len = name_ ? eastl::CharStrlen(name_) : 0;
+  return sizeof(MappedHeader) + translations_.size() + rotations_.size() +
+         scales_.size() + name_len + 1;
+}
+
+void Animation::WriteMapped(void* _buffer) const {
+  assert(math::IsAligned(_buffer, OZZ_ALIGN_OF(TranslationKey)));
+
+  const size_t name_len = name_ ? eastl::CharStrlen(name_) : 0;
+
+  MappedHeader* header = reinterpret_cast<MappedHeader*>(_buffer);
+  memcpy(header->tag, kMappedTag, sizeof(kMappedTag));
+  header->version = kMappedVersion;
+  header->duration = duration_;
+  header->num_tracks = num_tracks_;
+  header->name_len = static_cast<uint32_t>(name_len);
+  header->translation_count = static_cast<uint32_t>(translations_.count());
+  header->rotation_count = static_cast<uint32_t>(rotations_.count());
+  header->scale_count = static_cast<uint32_t>(scales_.count());
+
+  // Same order as Allocate, so the alignment of every key type holds.
+  char* cursor = reinterpret_cast<char*>(header + 1);
+  memcpy(cursor, translations_.begin, translations_.size());
+  cursor += translations_.size();
+  memcpy(cursor, rotations_.begin, rotations_.size());
+  cursor += rotations_.size();
+  memcpy(cursor, scales_.begin, scales_.size());
+  cursor += scales_.size();
+  if (name_len > 0) {
+    memcpy(cursor, name_, name_len);
+  }
+  cursor[name_len] = 0;
+}
+
+bool Animation::IsMapped(const void* _buffer, size_t _size) {
+  return _size >= sizeof(MappedHeader) &&
+         memcmp(_buffer, kMappedTag, sizeof(kMappedTag)) == 0;
+}
+
+bool Animation::Map(const void* _buffer, size_t _size) {
+  // Destroy animation in case it was already used before.
+  Deallocate();
+  duration_ = 0.f;
+  num_tracks_ = 0;
+
+  if (!IsMapped(_buffer, _size) ||
+      !math::IsAligned(_buffer, OZZ_ALIGN_OF(TranslationKey))) {
+    LOGF(LogLevel::eERROR, "Buffer does not contain a mapped Animation.");
+    return false;
+  }
+
+  const MappedHeader* header = reinterpret_cast<const MappedHeader*>(_buffer);
+  if (header->version != kMappedVersion) {
+    LOGF(LogLevel::eERROR, "Unsupported mapped Animation version %u.",
+         header->version);
+    return false;
+  }
+
+  const size_t required_size =
+      sizeof(MappedHeader) +
+      header->translation_count * sizeof(TranslationKey) +
+      header->rotation_count * sizeof(RotationKey) +
+      header->scale_count * sizeof(ScaleKey) + header->name_len + 1;
+  if (_size < required_size) {
+    LOGF(LogLevel::eERROR, "Mapped Animation is truncated.");
+    return false;
+  }
+
+  // The keys are only read, the ranges are not const for the allocated case.
+  char* cursor = const_cast<char*>(reinterpret_cast<const char*>(header + 1));
+  translations_.begin = reinterpret_cast<TranslationKey*>(cursor);
+  cursor += header->translation_count * sizeof(TranslationKey);
+  translations_.end = reinterpret_cast<TranslationKey*>(cursor);
+
+  rotations_.begin = reinterpret_cast<RotationKey*>(cursor);
+  cursor += header->rotation_count * sizeof(RotationKey);
+  rotations_.end = reinterpret_cast<RotationKey*>(cursor);
+
+  scales_.begin = reinterpret_cast<ScaleKey*>(cursor);
+  cursor += header->scale_count * sizeof(ScaleKey);
+  scales_.end = reinterpret_cast<ScaleKey*>(cursor);
+
+  name_ = header->name_len > 0 ? cursor : NULL;
+
+  duration_ = header->duration;
+  num_tracks_ = header->num_tracks;
+  mapped_ = true;
+
+  return true;
+}
+//CONFFX_END
+
 void Animation::Save(ozz::io::OArchive& _archive) const {
   _archive << duration_;
   _archive << static_cast<int32_t>(num_tracks_);
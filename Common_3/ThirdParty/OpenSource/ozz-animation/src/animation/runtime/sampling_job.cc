@@ -452,7 +452,7 @@ bool SamplingJob::Run() const {
   return true;
 }
 
-SamplingCache::SamplingCache(int _max_tracks)
+SamplingCache::SamplingCache(int _max_tracks, memory::Allocator* _allocator) //CONFFX_BEGIN
     : animation_(NULL),
       ratio_(0.f),
       max_soa_tracks_((_max_tracks + 3) / 4),
@@ -467,7 +467,8 @@ SamplingCache::SamplingCache(int _max_tracks)
       scale_cursor_(0),
       outdated_translations_(NULL),
       outdated_rotations_(NULL),
-      outdated_scales_(NULL) {
+      outdated_scales_(NULL),
+      allocator_(_allocator ? _allocator : memory::default_allocator()) {
   using internal::InterpSoaRotation;
   using internal::InterpSoaScale;
   using internal::InterpSoaTranslation;
@@ -488,9 +489,8 @@ SamplingCache::SamplingCache(int _max_tracks)
       sizeof(unsigned char) * 3 * num_outdated;
 
   // Allocates all at once.
-  memory::Allocator* allocator = memory::default_allocator();
   char* alloc_begin = reinterpret_cast<char*>(
-      allocator->Allocate(size, OZZ_ALIGN_OF(InterpSoaTranslation)));
+      allocator_->Allocate(size, OZZ_ALIGN_OF(InterpSoaTranslation)));
   char* alloc_cursor = alloc_begin;
 
   // Dispatches allocated memory, from the highest alignment requirement to the
@@ -521,7 +521,7 @@ SamplingCache::SamplingCache(int _max_tracks)
 
 SamplingCache::~SamplingCache() {
   // Deallocates everything at once.
-  memory::default_allocator()->Deallocate(soa_translations_);
+  allocator_->Deallocate(soa_translations_);
 }
 
 void SamplingCache::Step(const Animation& _animation, float _ratio) {
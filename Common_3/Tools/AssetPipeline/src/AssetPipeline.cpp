@@ -1149,17 +1149,25 @@ bool AssetPipeline::CreateRuntimeAnimation(
 		return false;
 	}
 
-	// Write animation to disk
+	// Write animation to disk in the mapped form, the runtime uses the keys in place instead of decoding an archive
+	// and all instances of the clip can share the file contents
+	const size_t mappedSize = animation.mapped_size();
+	void*        mappedData = tf_malloc(mappedSize);
+	animation.WriteMapped(mappedData);
+	//Deallocate animation
+	animation.Deallocate();
+
 	FileStream file = {};
 
 	if (!fsOpenStreamFromPath(RD_OUTPUT, animationOutput, FM_WRITE_BINARY, &file))
+	{
+		tf_free(mappedData);
 		return false;
+	}
 
-	ozz::io::OArchive archive(&file);
-	archive << animation;
+	const bool written = fsWriteToStream(&file, mappedData, mappedSize) == mappedSize;
 	fsCloseStream(&file);
-	//Deallocate animation
-	animation.Deallocate();
+	tf_free(mappedData);
 
-	return true;
+	return written;
 }
@@ -0,0 +1,261 @@
+#include "AnimationCrowd.h"
+
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
+#include "../../../../Common_3/OS/Interfaces/ITime.h"
+#include "../../../../Common_3/OS/Core/ThreadSystem.h"
+
+#include "../../../../Middleware_3/Animation/AnimationArena.h"
+#include "../../../../Middleware_3/Animation/AnimationWorld.h"
+#include "../../../../Middleware_3/Animation/Clip.h"
+#include "../../../../Middleware_3/Animation/ClipController.h"
+#include "../../../../Middleware_3/Animation/ClipMask.h"
+#include "../../../../Middleware_3/Animation/Rig.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"
+
+struct CrowdMember
+{
+    Rig             mRig;
+    ClipController  mClipController;
+    Animation       mAnimation;
+    AnimatedObject  mAnimatedObject;
+};
+
+// Forwards to the allocator it stands in for and adds up the bytes handed out
+class CountingAllocator : public ozz::memory::Allocator
+{
+public:
+    explicit CountingAllocator(ozz::memory::Allocator * pAllocator) : pAllocator(pAllocator), mAllocatedSize(0) {}
+
+    void * Allocate(size_t size, size_t alignment) override
+    {
+        mAllocatedSize += size;
+        return pAllocator->Allocate(size, alignment);
+    }
+
+    void Deallocate(void * pBlock) override { pAllocator->Deallocate(pBlock); }
+
+    void * Reallocate(void * pBlock, size_t size, size_t alignment) override
+    {
+        mAllocatedSize += size;
+        return pAllocator->Reallocate(pBlock, size, alignment);
+    }
+
+    ozz::memory::Allocator *    pAllocator;
+    size_t                      mAllocatedSize;
+};
+
+// Reads the clip file into one buffer in the mapped format, converting it when it is an archive, and maps pClip onto it.
+// *ppData has to outlive the clip and be freed with tf_free.
+static bool loadMappedClip(ResourceDirectory resourceDir, const char * pClipFile, Rig * pRig, Clip * pClip, void ** ppData, size_t * pSize)
+{
+    FileStream file = {};
+    if (!fsOpenStreamFromPath(resourceDir, pClipFile, FM_READ_BINARY, &file))
+        return false;
+
+    size_t const fileSize = (size_t)fsGetStreamFileSize(&file);
+    void * pFileData = tf_malloc(fileSize);
+    fsReadFromStream(&file, pFileData, fileSize);
+    fsCloseStream(&file);
+
+    if (ozz::animation::Animation::IsMapped(pFileData, fileSize))
+    {
+        *ppData = pFileData;
+        *pSize = fileSize;
+    }
+    else
+    {
+        // The memory stream owns the file data from here on
+        FileStream memStream = {};
+        fsOpenStreamFromMemory(pFileData, fileSize, FM_READ, true, &memStream);
+        ozz::io::IArchive archive(&memStream);
+        if (!archive.TestTag<ozz::animation::Animation>())
+        {
+            fsCloseStream(&memStream);
+            return false;
+        }
+
+        ozz::animation::Animation animation;
+        archive >> animation;
+        fsCloseStream(&memStream);
+
+        *pSize = animation.mapped_size();
+        *ppData = tf_memalign(ozz::memory::kDefaultAlignment, *pSize);
+        animation.WriteMapped(*ppData);
+        animation.Deallocate();
+    }
+
+    if (!pClip->Initialize(*ppData, *pSize, pRig))
+    {
+        tf_free(*ppData);
+        *ppData = NULL;
+        return false;
+    }
+    return true;
+}
+
+uint32_t benchmarkAnimationCrowd(ResourceDirectory resourceDir, const char * pSkeletonFile, const char * pClipFile,
+    const uint32_t * pObjectCounts, uint32_t objectCountCount, const uint32_t * pWorkerCounts, uint32_t workerCountCount,
+    uint32_t frameCount, const AnimationCrowdOptions * pOptions, AnimationCrowdTiming * pOutTimings, AnimationCrowdMemory * pOutMemory)
+{
+    ASSERT(pSkeletonFile && pClipFile && pObjectCounts && pWorkerCounts && pOptions && pOutTimings);
+    ASSERT(objectCountCount && frameCount && pOptions->mUpdateInterval);
+
+    uint32_t memberCount = 0;
+    for (uint32_t i = 0; i < objectCountCount; ++i)
+        memberCount = max(memberCount, pObjectCounts[i]);
+
+    // Everything the rigs and the animation state take from the heap during the setup goes through counter
+    CountingAllocator counter(ozz::memory::default_allocator());
+    ozz::memory::SetDefaulAllocator(&counter);
+
+    AnimationArena arena;
+    if (pOptions->mArenaAllocator)
+        arena.Initialize(1024 * 1024);
+    ozz::memory::Allocator * pStateAllocator = pOptions->mArenaAllocator ? &arena : NULL;
+
+    CrowdMember * pMembers = (CrowdMember *)tf_calloc(memberCount, sizeof(CrowdMember));
+    for (uint32_t i = 0; i < memberCount; ++i)
+    {
+        tf_placement_new<CrowdMember>(pMembers + i);
+        pMembers[i].mRig.Initialize(resourceDir, pSkeletonFile);
+    }
+
+    Clip clip;
+    void * pMappedClipData = NULL;
+    size_t clipSize = 0;
+    size_t const allocatedBeforeClip = counter.mAllocatedSize;
+    bool succeeded = true;
+    if (pOptions->mMappedClip)
+        succeeded = loadMappedClip(resourceDir, pClipFile, &pMembers[0].mRig, &clip, &pMappedClipData, &clipSize);
+    else
+        clip.Initialize(resourceDir, pClipFile, &pMembers[0].mRig);
+    size_t const clipAllocatedSize = counter.mAllocatedSize - allocatedBeforeClip;
+    if (!pOptions->mMappedClip)
+        clipSize = clipAllocatedSize;
+
+    if (!succeeded)
+    {
+        LOGF(LogLevel::eERROR, "Animation crowd: cannot load %s as a mapped clip", pClipFile);
+        ozz::memory::SetDefaulAllocator(counter.pAllocator);
+        for (uint32_t i = 0; i < memberCount; ++i)
+        {
+            pMembers[i].mRig.Destroy();
+            pMembers[i].~CrowdMember();
+        }
+        tf_free(pMembers);
+        if (pOptions->mArenaAllocator)
+            arena.Destroy();
+        return 0;
+    }
+
+    // The weights only depend on the skeleton, so one mask serves every object
+    ClipMask mask;
+    bool const masked = pOptions->mMaskJoint >= 0 && pOptions->mMaskJoint < (int32_t)pMembers[0].mRig.GetNumJoints();
+    LOGF_IF(LogLevel::eWARNING, pOptions->mMaskJoint >= 0 && !masked, "Animation crowd: the skeleton has no joint %d, nothing is masked",
+        pOptions->mMaskJoint);
+    if (masked)
+    {
+        mask.Initialize(&pMembers[0].mRig);
+        mask.SetAllChildrenOf(pOptions->mMaskJoint, 1.0f);
+    }
+
+    AnimationLOD lod;
+    lod.mUpdateInterval = pOptions->mUpdateInterval;
+    lod.mJointMask = masked ? &mask : NULL;
+    lod.mPoseBones = pOptions->mPoseBones;
+
+    for (uint32_t i = 0; i < memberCount; ++i)
+    {
+        CrowdMember & member = pMembers[i];
+        member.mClipController.Initialize(clip.GetDuration());
+
+        AnimationDesc animationDesc = {};
+        animationDesc.mRig = &member.mRig;
+        animationDesc.mNumLayers = 1;
+        animationDesc.mLayerProperties[0].mClip = &clip;
+        animationDesc.mLayerProperties[0].mClipController = &member.mClipController;
+        animationDesc.mAllocator = pStateAllocator;
+        member.mAnimation.Initialize(animationDesc);
+
+        // Spread over the clip so the objects do not sample the same keys
+        float const phase = float(i) * 0.618034f;
+        member.mAnimation.SetTimeRatio(phase - floorf(phase));
+
+        member.mAnimatedObject.Initialize(&member.mRig, &member.mAnimation, pStateAllocator);
+
+        lod.mUpdateOffset = i * pOptions->mUpdateOffsetStride;
+        member.mAnimatedObject.SetLOD(lod);
+    }
+
+    ozz::memory::SetDefaulAllocator(counter.pAllocator);
+    if (pOutMemory)
+    {
+        size_t const characterSize = counter.mAllocatedSize - clipAllocatedSize + (pOptions->mArenaAllocator ? arena.GetUsedSize() : 0);
+        pOutMemory->mBytesPerCharacter = characterSize / memberCount;
+        pOutMemory->mClipBytes = clipSize;
+        pOutMemory->mArenaReservedBytes = pOptions->mArenaAllocator ? arena.GetReservedSize() : 0;
+    }
+
+    float const dt = 1.0f / 60.0f;
+    uint32_t timingCount = 0;
+    uint32_t lastWorkerCount = ~0u;
+    for (uint32_t w = 0; w < workerCountCount && succeeded; ++w)
+    {
+        ThreadSystem * pThreadSystem = NULL;
+        if (pWorkerCounts[w])
+            initThreadSystem(&pThreadSystem, pWorkerCounts[w], 0, true, "AnimationCrowd");
+
+        uint32_t const workerCount = pThreadSystem ? getThreadSystemThreadCount(pThreadSystem) : 0;
+        // Clamped to the same thread count as the previous entry
+        if (workerCount != lastWorkerCount)
+        {
+            for (uint32_t o = 0; o < objectCountCount && succeeded; ++o)
+            {
+                AnimationWorld world;
+                world.Initialize(pThreadSystem, pMembers[0].mRig.GetNumJoints());
+                for (uint32_t i = 0; i < pObjectCounts[o]; ++i)
+                    world.AddObject(&pMembers[i].mAnimatedObject);
+
+                // Untimed, the first update brings the objects into the caches
+                succeeded = world.Update(dt);
+
+                int64_t const start = getUSec();
+                for (uint32_t f = 0; f < frameCount && succeeded; ++f)
+                    succeeded = world.Update(dt);
+
+                AnimationCrowdTiming & timing = pOutTimings[timingCount++];
+                timing.mObjectCount = pObjectCounts[o];
+                timing.mWorkerCount = workerCount;
+                timing.mUpdateMs = double(getUSec() - start) / 1000.0 / frameCount;
+
+                world.Destroy();
+            }
+            lastWorkerCount = workerCount;
+        }
+
+        if (pThreadSystem)
+            shutdownThreadSystem(pThreadSystem);
+    }
+
+    for (uint32_t i = 0; i < memberCount; ++i)
+    {
+        pMembers[i].mAnimatedObject.Destroy();
+        pMembers[i].mAnimation.Destroy();
+    }
+    if (masked)
+        mask.Destroy();
+    clip.Destroy();
+    tf_free(pMappedClipData);
+    if (pOptions->mArenaAllocator)
+        arena.Destroy();
+    for (uint32_t i = 0; i < memberCount; ++i)
+    {
+        pMembers[i].mRig.Destroy();
+        pMembers[i].~CrowdMember();
+    }
+    tf_free(pMembers);
+
+    return succeeded ? timingCount : 0;
+}
@@ -0,0 +1,55 @@
+// Times AnimationWorld::Update on crowds of one character, for several crowd sizes and worker thread counts.
+// Every object samples its own rig, as the AnimationWorld requires, so the rig is loaded once per object.
+// The options put the whole crowd on an AnimationLOD, to measure what throttled and masked updates save, and choose
+// where the per instance state and the clip keys live, to measure what a character costs in memory.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+
+struct AnimationCrowdOptions
+{
+    // AnimationLOD::mUpdateInterval of every object, 1 samples every frame
+    uint32_t    mUpdateInterval = 1;
+    // Object i gets the AnimationLOD::mUpdateOffset i * mUpdateOffsetStride, 0 has the whole crowd sample in the same frame
+    uint32_t    mUpdateOffsetStride = 1;
+    // Joint which keeps animating with its children while the others stay in the bind pose, -1 animates all joints
+    int32_t     mMaskJoint = -1;
+    // AnimationLOD::mPoseBones, the bone matrices are only needed to draw the skeletons
+    bool        mPoseBones = true;
+    // Allocates the sampling state of every Animation and AnimatedObject from one AnimationArena instead of the heap
+    bool        mArenaAllocator = false;
+    // Samples the keys in place from one buffer in the mapped clip format, converted on load when the file is an archive
+    bool        mMappedClip = false;
+};
+
+// Counted from what goes through the ozz allocators and the arena while the crowd is set up. The world and bone
+// matrices a Rig keeps in eastl vectors are not included.
+struct AnimationCrowdMemory
+{
+    // Rig and animation state of one character
+    size_t      mBytesPerCharacter;
+    // The clip every character samples, held once for the whole crowd
+    size_t      mClipBytes;
+    // Heap blocks the arena took, 0 without it
+    size_t      mArenaReservedBytes;
+};
+
+struct AnimationCrowdTiming
+{
+    uint32_t    mObjectCount;
+    // Workers the ThreadSystem ended up with, 0 when the world updated on the calling thread
+    uint32_t    mWorkerCount;
+    // Average of one Update
+    double      mUpdateMs;
+};
+
+// pOutTimings needs objectCountCount * workerCountCount entries, ordered by worker count first. Worker counts beyond the
+// cores of the machine are clamped by the ThreadSystem and only timed once. Returns the number of timings written,
+// 0 if the clip could not be loaded or an update failed. A mask joint the skeleton does not have is ignored with a
+// warning. pOutMemory can be NULL.
+uint32_t benchmarkAnimationCrowd(ResourceDirectory resourceDir, const char * pSkeletonFile, const char * pClipFile,
+    const uint32_t * pObjectCounts, uint32_t objectCountCount, const uint32_t * pWorkerCounts, uint32_t workerCountCount,
+    uint32_t frameCount, const AnimationCrowdOptions * pOptions, AnimationCrowdTiming * pOutTimings, AnimationCrowdMemory * pOutMemory);
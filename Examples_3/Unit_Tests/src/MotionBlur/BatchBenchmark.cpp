@@ -0,0 +1,79 @@
+#include "BatchBenchmark.h"
+#include "Random.h"
+
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+#include "../../../../Common_3/OS/Interfaces/ITime.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/EASTL/vector.h"
+
+using namespace Vectormath::Batch;
+
+static Stream3 getStream3(eastl::vector<float> & data, uint32_t count, uint32_t first)
+{
+    Stream3 stream = { &data[first * count], &data[(first + 1) * count], &data[(first + 2) * count] };
+    return stream;
+}
+
+void benchmarkBatchTransforms(uint32_t elementCount, uint32_t runCount, uint32_t seed, BatchBenchmarkTiming * pOutTimings)
+{
+    ASSERT(elementCount && runCount && pOutTimings);
+
+    uint32_t state = seed;
+    // Points and vectors in [-100, 100], the same values feed the box corners
+    eastl::vector<float> input(elementCount * 6);
+    for (float & v : input)
+        v = randomUnorm(&state) * 200.0f - 100.0f;
+    eastl::vector<float> output(elementCount * 6);
+
+    Stream3 const in = getStream3(input, elementCount, 0);
+    Stream3 const out = getStream3(output, elementCount, 0);
+    AabbStream boxesIn = { getStream3(input, elementCount, 0), getStream3(input, elementCount, 3) };
+    AabbStream boxesOut = { getStream3(output, elementCount, 0), getStream3(output, elementCount, 3) };
+
+    eastl::vector<mat4> matricesA(elementCount);
+    eastl::vector<mat4> matricesB(elementCount);
+    eastl::vector<mat4> matricesOut(elementCount);
+    for (uint32_t i = 0; i < elementCount; ++i)
+    {
+        vec3 const translation = vec3(randomUnorm(&state), randomUnorm(&state), randomUnorm(&state)) * 20.0f;
+        matricesA[i] = mat4::translation(translation) * mat4::rotationY(randomUnorm(&state) * 2.0f * PI);
+        matricesB[i] = mat4::rotationX(randomUnorm(&state) * 2.0f * PI) * mat4::scale(vec3(0.5f + randomUnorm(&state)));
+    }
+
+    mat4 const m = mat4::perspective(1.0f, 1.5f, 0.1f, 1000.0f) * mat4::lookAt(Point3(10.0f, 20.0f, -30.0f), Point3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+
+    double const nsPerRun = 1000.0 / (double(runCount) * elementCount);
+    Backend const previousBackend = getBackend();
+    for (uint32_t b = 0; b < BACKEND_COUNT; ++b)
+    {
+        BatchBenchmarkTiming & timing = pOutTimings[b];
+        timing = {};
+        timing.mBackend = (Backend)b;
+        timing.mSupported = setBackend((Backend)b);
+        if (!timing.mSupported)
+            continue;
+
+        // Untimed, brings the streams into the caches and the wide units out of their power saving state
+        transformPoints(m, in, out, elementCount);
+
+        int64_t start = getUSec();
+        for (uint32_t run = 0; run < runCount; ++run)
+            transformPoints(m, in, out, elementCount);
+        timing.mTransformPointsNs = double(getUSec() - start) * nsPerRun;
+
+        start = getUSec();
+        for (uint32_t run = 0; run < runCount; ++run)
+            transformVectors(m, in, out, elementCount);
+        timing.mTransformVectorsNs = double(getUSec() - start) * nsPerRun;
+
+        start = getUSec();
+        for (uint32_t run = 0; run < runCount; ++run)
+            transformAabbs(matricesA[0], boxesIn, boxesOut, elementCount);
+        timing.mTransformAabbsNs = double(getUSec() - start) * nsPerRun;
+
+        start = getUSec();
+        for (uint32_t run = 0; run < runCount; ++run)
+            mulMatrices(matricesA.data(), matricesB.data(), matricesOut.data(), elementCount);
+        timing.mMulMatricesNs = double(getUSec() - start) * nsPerRun;
+    }
+    setBackend(previousBackend);
+}
@@ -0,0 +1,24 @@
+// Times the Vectormath::Batch functions on every backend the CPU supports, by forcing each one with setBackend.
+// The backend that was active before is restored afterwards.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../../../../Common_3/OS/Math/MathTypes.h"
+
+struct BatchBenchmarkTiming
+{
+    Vectormath::Batch::Backend  mBackend;
+    // False when the CPU or the build lacks the backend, the times are 0 then
+    bool                        mSupported;
+    // Average per element of one call over all the elements
+    double                      mTransformPointsNs;
+    double                      mTransformVectorsNs;
+    double                      mTransformAabbsNs;
+    double                      mMulMatricesNs;
+};
+
+// Runs each batch function runCount times over elementCount random elements per backend. pOutTimings needs
+// Vectormath::Batch::BACKEND_COUNT entries, one per backend in enum order.
+void benchmarkBatchTransforms(uint32_t elementCount, uint32_t runCount, uint32_t seed, BatchBenchmarkTiming * pOutTimings);
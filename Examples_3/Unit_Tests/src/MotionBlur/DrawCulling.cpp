@@ -0,0 +1,242 @@
+#include "DrawCulling.h"
+#include "Random.h"
+
+#include <string.h>
+
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+
+void resizeCullingBoxes(CullingBoxes * pBoxes, uint32_t count)
+{
+    ASSERT(pBoxes);
+
+    uint32_t const paddedCount = (count + CULLING_BATCH_SIZE - 1) / CULLING_BATCH_SIZE * CULLING_BATCH_SIZE;
+    pBoxes->mCenterX.resize(paddedCount, 0.0f);
+    pBoxes->mCenterY.resize(paddedCount, 0.0f);
+    pBoxes->mCenterZ.resize(paddedCount, 0.0f);
+    pBoxes->mExtentX.resize(paddedCount, 0.0f);
+    pBoxes->mExtentY.resize(paddedCount, 0.0f);
+    pBoxes->mExtentZ.resize(paddedCount, 0.0f);
+    pBoxes->mCount = count;
+}
+
+void setCullingBox(CullingBoxes * pBoxes, uint32_t index, const vec3 & min, const vec3 & max)
+{
+    ASSERT(index < pBoxes->mCount);
+
+    vec3 const center = (min + max) * 0.5f;
+    vec3 const extent = (max - min) * 0.5f;
+    pBoxes->mCenterX[index] = center.getX();
+    pBoxes->mCenterY[index] = center.getY();
+    pBoxes->mCenterZ[index] = center.getZ();
+    pBoxes->mExtentX[index] = extent.getX();
+    pBoxes->mExtentY[index] = extent.getY();
+    pBoxes->mExtentZ[index] = extent.getZ();
+}
+
+void setCullingBox(CullingBoxes * pBoxes, uint32_t index, const vec3 & min, const vec3 & max, const mat4 & toWorld)
+{
+    vec3 const center = (min + max) * 0.5f;
+    vec3 const extent = (max - min) * 0.5f;
+
+    // Smallest world space box around the transformed one, every axis of the box adds its projection onto the world axes
+    vec3 const worldCenter = (toWorld * vec4(center, 1.0f)).getXYZ();
+    vec3 const worldExtent =
+        absPerElem(toWorld.getCol0().getXYZ()) * extent.getX() +
+        absPerElem(toWorld.getCol1().getXYZ()) * extent.getY() +
+        absPerElem(toWorld.getCol2().getXYZ()) * extent.getZ();
+
+    setCullingBox(pBoxes, index, worldCenter - worldExtent, worldCenter + worldExtent);
+}
+
+void getCullingFrustum(const mat4 & viewProject, CullingFrustum * pFrustum)
+{
+    // Clip space point p is inside when -w <= x <= w, -w <= y <= w and 0 <= z <= w.
+    // Each of these is a dot product of a combination of the matrix rows with the world space point.
+    vec4 const row0 = viewProject.getRow(0);
+    vec4 const row1 = viewProject.getRow(1);
+    vec4 const row2 = viewProject.getRow(2);
+    vec4 const row3 = viewProject.getRow(3);
+
+    pFrustum->mPlanes[0] = row3 + row0;
+    pFrustum->mPlanes[1] = row3 - row0;
+    pFrustum->mPlanes[2] = row3 + row1;
+    pFrustum->mPlanes[3] = row3 - row1;
+    pFrustum->mPlanes[4] = row2;
+    pFrustum->mPlanes[5] = row3 - row2;
+}
+
+// Appends the lanes set in mask, without branching on them
+static inline uint32_t appendVisible(uint32_t mask, uint32_t first, uint32_t laneCount, uint32_t visibleCount, uint32_t * pVisible)
+{
+    for (uint32_t lane = 0; lane < laneCount; ++lane)
+    {
+        pVisible[visibleCount] = first + lane;
+        visibleCount += (mask >> lane) & 1;
+    }
+    return visibleCount;
+}
+
+uint32_t cullBoxesScalar(const CullingBoxes * pBoxes, const CullingFrustum * pFrustum, uint32_t * pVisible)
+{
+    uint32_t visibleCount = 0;
+    for (uint32_t i = 0; i < pBoxes->mCount; ++i)
+    {
+        bool inside = true;
+        for (uint32_t p = 0; p < 6; ++p)
+        {
+            vec4 const & plane = pFrustum->mPlanes[p];
+            // Distance of the center, and how far the box reaches towards the plane
+            float const d = (plane.getX() * pBoxes->mCenterX[i] + plane.getY() * pBoxes->mCenterY[i]) + (plane.getZ() * pBoxes->mCenterZ[i] + plane.getW());
+            float const r = fabsf(plane.getX()) * pBoxes->mExtentX[i] + fabsf(plane.getY()) * pBoxes->mExtentY[i] + fabsf(plane.getZ()) * pBoxes->mExtentZ[i];
+            inside &= d + r >= 0.0f;
+        }
+
+        pVisible[visibleCount] = i;
+        visibleCount += inside ? 1 : 0;
+    }
+    return visibleCount;
+}
+
+uint32_t cullBoxes(const CullingBoxes * pBoxes, const CullingFrustum * pFrustum, uint32_t * pVisible)
+{
+#if VECTORMATH_MODE_SSE
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+    __m128 absX[6], absY[6], absZ[6];
+    for (uint32_t p = 0; p < 6; ++p)
+    {
+        vec4 const & plane = pFrustum->mPlanes[p];
+        planeX[p] = _mm_set1_ps(plane.getX());
+        planeY[p] = _mm_set1_ps(plane.getY());
+        planeZ[p] = _mm_set1_ps(plane.getZ());
+        planeW[p] = _mm_set1_ps(plane.getW());
+        absX[p] = _mm_set1_ps(fabsf(plane.getX()));
+        absY[p] = _mm_set1_ps(fabsf(plane.getY()));
+        absZ[p] = _mm_set1_ps(fabsf(plane.getZ()));
+    }
+
+    __m128 const zero = _mm_setzero_ps();
+    uint32_t visibleCount = 0;
+    for (uint32_t i = 0; i < pBoxes->mCount; i += CULLING_BATCH_SIZE)
+    {
+        __m128 const cx = _mm_loadu_ps(&pBoxes->mCenterX[i]);
+        __m128 const cy = _mm_loadu_ps(&pBoxes->mCenterY[i]);
+        __m128 const cz = _mm_loadu_ps(&pBoxes->mCenterZ[i]);
+        __m128 const ex = _mm_loadu_ps(&pBoxes->mExtentX[i]);
+        __m128 const ey = _mm_loadu_ps(&pBoxes->mExtentY[i]);
+        __m128 const ez = _mm_loadu_ps(&pBoxes->mExtentZ[i]);
+
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for (uint32_t p = 0; p < 6; ++p)
+        {
+            __m128 const d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)), _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+            __m128 const r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), zero));
+        }
+
+        uint32_t const laneCount = min(CULLING_BATCH_SIZE, pBoxes->mCount - i);
+        visibleCount = appendVisible((uint32_t)_mm_movemask_ps(inside), i, laneCount, visibleCount, pVisible);
+    }
+    return visibleCount;
+#elif VECTORMATH_MODE_NEON
+    float32x4_t planeX[6], planeY[6], planeZ[6], planeW[6];
+    float32x4_t absX[6], absY[6], absZ[6];
+    for (uint32_t p = 0; p < 6; ++p)
+    {
+        vec4 const & plane = pFrustum->mPlanes[p];
+        planeX[p] = vdupq_n_f32(plane.getX());
+        planeY[p] = vdupq_n_f32(plane.getY());
+        planeZ[p] = vdupq_n_f32(plane.getZ());
+        planeW[p] = vdupq_n_f32(plane.getW());
+        absX[p] = vdupq_n_f32(fabsf(plane.getX()));
+        absY[p] = vdupq_n_f32(fabsf(plane.getY()));
+        absZ[p] = vdupq_n_f32(fabsf(plane.getZ()));
+    }
+
+    float32x4_t const zero = vdupq_n_f32(0.0f);
+    uint32_t const laneBitsData[CULLING_BATCH_SIZE] = { 1, 2, 4, 8 };
+    uint32x4_t const laneBits = vld1q_u32(laneBitsData);
+    uint32_t visibleCount = 0;
+    for (uint32_t i = 0; i < pBoxes->mCount; i += CULLING_BATCH_SIZE)
+    {
+        float32x4_t const cx = vld1q_f32(&pBoxes->mCenterX[i]);
+        float32x4_t const cy = vld1q_f32(&pBoxes->mCenterY[i]);
+        float32x4_t const cz = vld1q_f32(&pBoxes->mCenterZ[i]);
+        float32x4_t const ex = vld1q_f32(&pBoxes->mExtentX[i]);
+        float32x4_t const ey = vld1q_f32(&pBoxes->mExtentY[i]);
+        float32x4_t const ez = vld1q_f32(&pBoxes->mExtentZ[i]);
+
+        uint32x4_t inside = vdupq_n_u32(~0u);
+        for (uint32_t p = 0; p < 6; ++p)
+        {
+            float32x4_t const d = vaddq_f32(vmlaq_f32(vmulq_f32(planeX[p], cx), planeY[p], cy), vmlaq_f32(planeW[p], planeZ[p], cz));
+            float32x4_t const r = vmlaq_f32(vmlaq_f32(vmulq_f32(absX[p], ex), absY[p], ey), absZ[p], ez);
+            inside = vandq_u32(inside, vcgeq_f32(vaddq_f32(d, r), zero));
+        }
+
+        // Same layout as _mm_movemask_ps
+        uint32x4_t const bits = vandq_u32(inside, laneBits);
+        uint32x2_t const pairs = vorr_u32(vget_low_u32(bits), vget_high_u32(bits));
+        uint32_t const mask = vget_lane_u32(pairs, 0) | vget_lane_u32(pairs, 1);
+
+        uint32_t const laneCount = min(CULLING_BATCH_SIZE, pBoxes->mCount - i);
+        visibleCount = appendVisible(mask, i, laneCount, visibleCount, pVisible);
+    }
+    return visibleCount;
+#else
+    return cullBoxesScalar(pBoxes, pFrustum, pVisible);
+#endif
+}
+
+void generateCullingBenchmarkBoxes(uint32_t count, uint32_t seed, CullingBoxes * pBoxes)
+{
+    resizeCullingBoxes(pBoxes, count);
+
+    uint32_t state = seed;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        vec3 const center = vec3(randomUnorm(&state), randomUnorm(&state), randomUnorm(&state)) * 200.0f - vec3(100.0f);
+        vec3 const extent = vec3(randomUnorm(&state), randomUnorm(&state), randomUnorm(&state)) * 4.5f + vec3(0.5f);
+        setCullingBox(pBoxes, i, center - extent, center + extent);
+    }
+}
+
+uint32_t verifyCullBoxes(uint32_t boxCount, uint32_t frustumCount, uint32_t seed)
+{
+    CullingBoxes boxes;
+    generateCullingBenchmarkBoxes(boxCount, seed, &boxes);
+    eastl::vector<uint32_t> visible(boxCount);
+    eastl::vector<uint32_t> visibleScalar(boxCount);
+
+    uint32_t state = seed;
+    uint32_t mismatchCount = 0;
+    for (uint32_t f = 0; f < frustumCount; ++f)
+    {
+        // Cameras inside and around the cube of boxes, so plenty of boxes straddle the planes
+        vec3 const eye = vec3(randomUnorm(&state), randomUnorm(&state), randomUnorm(&state)) * 300.0f - vec3(150.0f);
+        vec3 const target = vec3(randomUnorm(&state), randomUnorm(&state), randomUnorm(&state)) * 200.0f - vec3(100.0f);
+        vec3 const up = fabsf(normalize(target - eye).getY()) > 0.99f ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f, 1.0f, 0.0f);
+        mat4 const view = mat4::lookAt(Point3(eye), Point3(target), up);
+        mat4 const project = (f & 1) ?
+            mat4::perspective(0.5f + randomUnorm(&state) * 1.5f, 0.5f + randomUnorm(&state), 0.1f + randomUnorm(&state), 1000.0f) :
+            mat4::perspectiveReverseZ(0.5f + randomUnorm(&state) * 1.5f, 0.5f + randomUnorm(&state), 0.1f + randomUnorm(&state), 1000.0f);
+
+        CullingFrustum frustum;
+        getCullingFrustum(project * view, &frustum);
+
+        // Points moved onto the planes, where the rounding of the plane distance decides
+        for (uint32_t i = boxCount - boxCount / 4; i < boxCount; ++i)
+        {
+            vec4 const & plane = frustum.mPlanes[i % 6];
+            vec3 const normal = plane.getXYZ();
+            vec3 const point = vec3(randomUnorm(&state), randomUnorm(&state), randomUnorm(&state)) * 200.0f - vec3(100.0f);
+            vec3 const onPlane = point - normal * ((dot(normal, point) + plane.getW()) / dot(normal, normal));
+            setCullingBox(&boxes, i, onPlane, onPlane);
+        }
+
+        uint32_t const visibleCount = cullBoxes(&boxes, &frustum, visible.data());
+        uint32_t const visibleScalarCount = cullBoxesScalar(&boxes, &frustum, visibleScalar.data());
+        if (visibleCount != visibleScalarCount || memcmp(visible.data(), visibleScalar.data(), visibleCount * sizeof(uint32_t)))
+            ++mismatchCount;
+    }
+    return mismatchCount;
+}
@@ -0,0 +1,53 @@
+// Frustum culling of the G-buffer draws on the CPU.
+// Boxes are kept as structure of arrays (centers and half extents), so the SSE / NEON kernels test four boxes
+// against a plane with a handful of multiply-adds and no shuffles. The arrays are padded to a multiple of four, so
+// the kernels never need a scalar tail, the padding lanes are masked out of the results.
+// Visible boxes come out as a compacted list of indices, ready to be turned into a compacted indirect draw list.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../../../../Common_3/OS/Math/MathTypes.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/EASTL/vector.h"
+
+static constexpr uint32_t CULLING_BATCH_SIZE = 4;
+
+struct CullingBoxes
+{
+    eastl::vector<float>    mCenterX;
+    eastl::vector<float>    mCenterY;
+    eastl::vector<float>    mCenterZ;
+    eastl::vector<float>    mExtentX;
+    eastl::vector<float>    mExtentY;
+    eastl::vector<float>    mExtentZ;
+    // Boxes set with setCullingBox, the arrays hold it rounded up to CULLING_BATCH_SIZE
+    uint32_t                mCount = 0;
+};
+
+// Planes as (normal, distance) pointing inside, normals are not normalized since only the sign of the distance is used
+struct CullingFrustum
+{
+    vec4                    mPlanes[6];
+};
+
+void resizeCullingBoxes(CullingBoxes * pBoxes, uint32_t count);
+void setCullingBox(CullingBoxes * pBoxes, uint32_t index, const vec3 & min, const vec3 & max);
+// World space bounds of an object space box
+void setCullingBox(CullingBoxes * pBoxes, uint32_t index, const vec3 & min, const vec3 & max, const mat4 & toWorld);
+
+// Left, right, bottom, top, near and far planes of a projection with a [0, 1] depth range, reversed or not
+void getCullingFrustum(const mat4 & viewProject, CullingFrustum * pFrustum);
+
+// Writes the index of every box touching the frustum to pVisible (room for pBoxes->mCount indices) in increasing order,
+// returns how many there are. Uses SSE or NEON when ModifiedSonyMath does.
+uint32_t cullBoxes(const CullingBoxes * pBoxes, const CullingFrustum * pFrustum, uint32_t * pVisible);
+// Plain C++ version of cullBoxes, same results: the kernels add the terms of the plane distance in the same order
+uint32_t cullBoxesScalar(const CullingBoxes * pBoxes, const CullingFrustum * pFrustum, uint32_t * pVisible);
+
+// Random boxes scattered in a cube around the origin, for measuring the kernels
+void generateCullingBenchmarkBoxes(uint32_t count, uint32_t seed, CullingBoxes * pBoxes);
+
+// Culls random boxes against frustumCount random views with cullBoxes and cullBoxesScalar,
+// returns the number of views for which the visible lists differ
+uint32_t verifyCullBoxes(uint32_t boxCount, uint32_t frustumCount, uint32_t seed);
@@ -0,0 +1,153 @@
+#include "FrameGraph.h"
+
+#include "../../../../Common_3/ThirdParty/OpenSource/EASTL/sort.h"
+
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+
+static uint64_t alignFrameGraphSize(uint64_t size, uint64_t alignment)
+{
+    return alignment ? ((size + alignment - 1) / alignment) * alignment : size;
+}
+
+static bool frameGraphLifetimesOverlap(const FrameGraphResource & a, const FrameGraphResource & b)
+{
+    return a.mFirstPass <= b.mLastPass && b.mFirstPass <= a.mLastPass;
+}
+
+uint32_t addFrameGraphResource(FrameGraph * pGraph, const FrameGraphResourceDesc * pDesc)
+{
+    ASSERT(pGraph && pDesc);
+
+    FrameGraphResource resource = {};
+    resource.mDesc = *pDesc;
+    pGraph->mResources.push_back(resource);
+    return (uint32_t)pGraph->mResources.size() - 1;
+}
+
+uint32_t addFrameGraphPass(FrameGraph * pGraph, const char * pName)
+{
+    ASSERT(pGraph);
+
+    FrameGraphPass pass = {};
+    pass.pName = pName;
+    pGraph->mPasses.push_back(pass);
+    return (uint32_t)pGraph->mPasses.size() - 1;
+}
+
+void addFrameGraphAccess(FrameGraph * pGraph, uint32_t pass, uint32_t resource, FrameGraphAccess access)
+{
+    ASSERT(pass < pGraph->mPasses.size());
+    ASSERT(resource < pGraph->mResources.size());
+    ASSERT(access != FRAME_GRAPH_ACCESS_UNDEFINED);
+
+    // A resource can only be in one state at a time during a pass
+    for (const FrameGraphAccessDesc & existing : pGraph->mPasses[pass].mAccesses)
+    {
+        ASSERT(existing.mResource != resource);
+    }
+
+    pGraph->mPasses[pass].mAccesses.push_back({ resource, access });
+}
+
+void compileFrameGraph(FrameGraph * pGraph)
+{
+    ASSERT(pGraph);
+
+    const uint32_t resourceCount = (uint32_t)pGraph->mResources.size();
+    const uint32_t passCount = (uint32_t)pGraph->mPasses.size();
+
+    pGraph->mHeaps.clear();
+    pGraph->mDedicatedMemory = 0;
+    pGraph->mAliasedMemory = 0;
+
+    // Lifetimes
+    for (uint32_t r = 0; r < resourceCount; ++r)
+    {
+        FrameGraphResource & resource = pGraph->mResources[r];
+        resource.mFirstPass = FRAME_GRAPH_INVALID_INDEX;
+        resource.mLastPass = FRAME_GRAPH_INVALID_INDEX;
+        resource.mHeap = FRAME_GRAPH_INVALID_INDEX;
+    }
+
+    for (uint32_t p = 0; p < passCount; ++p)
+    {
+        const FrameGraphPass & pass = pGraph->mPasses[p];
+        for (const FrameGraphAccessDesc & access : pass.mAccesses)
+        {
+            FrameGraphResource & resource = pGraph->mResources[access.mResource];
+            if (FRAME_GRAPH_INVALID_INDEX == resource.mFirstPass)
+            {
+                resource.mFirstPass = p;
+            }
+            resource.mLastPass = p;
+        }
+    }
+
+    // Alias transient resources, biggest first so the small ones fill up the existing heaps
+    eastl::vector<uint32_t> transients;
+    for (uint32_t r = 0; r < resourceCount; ++r)
+    {
+        const FrameGraphResource & resource = pGraph->mResources[r];
+        if (resource.mDesc.mTransient && FRAME_GRAPH_INVALID_INDEX != resource.mFirstPass)
+        {
+            transients.push_back(r);
+            pGraph->mDedicatedMemory += alignFrameGraphSize(resource.mDesc.mSize, resource.mDesc.mAlignment);
+        }
+    }
+
+    const eastl::vector<FrameGraphResource> & resources = pGraph->mResources;
+    eastl::stable_sort(transients.begin(), transients.end(), [&resources](uint32_t a, uint32_t b)
+    {
+        return resources[a].mDesc.mSize > resources[b].mDesc.mSize;
+    });
+
+    for (uint32_t r : transients)
+    {
+        FrameGraphResource & resource = pGraph->mResources[r];
+
+        uint32_t heapIndex = FRAME_GRAPH_INVALID_INDEX;
+        for (uint32_t h = 0; h < (uint32_t)pGraph->mHeaps.size() && FRAME_GRAPH_INVALID_INDEX == heapIndex; ++h)
+        {
+            bool fits = true;
+            for (uint32_t other : pGraph->mHeaps[h].mResources)
+            {
+                if (frameGraphLifetimesOverlap(resource, pGraph->mResources[other]))
+                {
+                    fits = false;
+                    break;
+                }
+            }
+
+            if (fits)
+            {
+                heapIndex = h;
+            }
+        }
+
+        if (FRAME_GRAPH_INVALID_INDEX == heapIndex)
+        {
+            pGraph->mHeaps.push_back(FrameGraphHeap());
+            heapIndex = (uint32_t)pGraph->mHeaps.size() - 1;
+        }
+
+        FrameGraphHeap & heap = pGraph->mHeaps[heapIndex];
+        heap.mSize = heap.mSize > resource.mDesc.mSize ? heap.mSize : resource.mDesc.mSize;
+        heap.mAlignment = heap.mAlignment > resource.mDesc.mAlignment ? heap.mAlignment : resource.mDesc.mAlignment;
+        heap.mResources.push_back(r);
+        resource.mHeap = heapIndex;
+    }
+
+    for (const FrameGraphHeap & heap : pGraph->mHeaps)
+    {
+        pGraph->mAliasedMemory += alignFrameGraphSize(heap.mSize, heap.mAlignment);
+    }
+}
+
+void resetFrameGraph(FrameGraph * pGraph)
+{
+    pGraph->mResources.set_capacity(0);
+    pGraph->mPasses.set_capacity(0);
+    pGraph->mHeaps.set_capacity(0);
+    pGraph->mDedicatedMemory = 0;
+    pGraph->mAliasedMemory = 0;
+}
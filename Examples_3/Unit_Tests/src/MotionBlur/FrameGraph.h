@@ -0,0 +1,82 @@
+// A small frame graph for the motion blur passes.
+// Passes declare which resources they read and write, compileFrameGraph then derives
+// the lifetime of each resource and plans which transient resources can share memory.
+// The accesses themselves are turned into barriers by the resource state tracker.
+// It only deals with indices, sizes and access types so it can be used (and tested) without a GPU.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../../../../Common_3/ThirdParty/OpenSource/EASTL/vector.h"
+
+static constexpr uint32_t FRAME_GRAPH_INVALID_INDEX = ~0u;
+
+enum FrameGraphAccess
+{
+    FRAME_GRAPH_ACCESS_UNDEFINED = 0,
+    FRAME_GRAPH_ACCESS_RENDER_TARGET,
+    FRAME_GRAPH_ACCESS_DEPTH_WRITE,
+    FRAME_GRAPH_ACCESS_SHADER_READ,
+    FRAME_GRAPH_ACCESS_UNORDERED_ACCESS,
+    FRAME_GRAPH_ACCESS_PRESENT,
+};
+
+struct FrameGraphResourceDesc
+{
+    const char *        pName           = NULL;
+    uint64_t            mSize           = 0;
+    uint64_t            mAlignment      = 0;
+    // State the resource is in when the frame starts, and has to be returned to when it ends
+    FrameGraphAccess    mInitialAccess  = FRAME_GRAPH_ACCESS_UNDEFINED;
+    // Contents do not have to survive outside of the passes using it, so its memory can be shared
+    bool                mTransient      = false;
+};
+
+struct FrameGraphAccessDesc
+{
+    uint32_t            mResource;
+    FrameGraphAccess    mAccess;
+};
+
+struct FrameGraphPass
+{
+    const char *                          pName = NULL;
+    eastl::vector<FrameGraphAccessDesc>   mAccesses;
+};
+
+struct FrameGraphResource
+{
+    FrameGraphResourceDesc  mDesc;
+    // Filled by compileFrameGraph
+    uint32_t                mFirstPass  = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t                mLastPass   = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t                mHeap       = FRAME_GRAPH_INVALID_INDEX;
+};
+
+// Memory block shared by transient resources whose lifetimes never overlap
+struct FrameGraphHeap
+{
+    uint64_t                mSize       = 0;
+    uint64_t                mAlignment  = 0;
+    eastl::vector<uint32_t> mResources;
+};
+
+struct FrameGraph
+{
+    eastl::vector<FrameGraphResource>     mResources;
+    eastl::vector<FrameGraphPass>         mPasses;
+
+    // Filled by compileFrameGraph
+    eastl::vector<FrameGraphHeap>         mHeaps;
+    // Memory needed when every transient resource gets its own allocation
+    uint64_t                              mDedicatedMemory  = 0;
+    // Memory needed when transient resources are aliased into mHeaps
+    uint64_t                              mAliasedMemory    = 0;
+};
+
+uint32_t addFrameGraphResource(FrameGraph * pGraph, const FrameGraphResourceDesc * pDesc);
+uint32_t addFrameGraphPass(FrameGraph * pGraph, const char * pName);
+void     addFrameGraphAccess(FrameGraph * pGraph, uint32_t pass, uint32_t resource, FrameGraphAccess access);
+void     compileFrameGraph(FrameGraph * pGraph);
+void     resetFrameGraph(FrameGraph * pGraph);
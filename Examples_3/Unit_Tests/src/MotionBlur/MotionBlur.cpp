@@ -10,12 +10,28 @@
 #include "../../../../Common_3/OS/Interfaces/ITime.h"
 #include "../../../../Common_3/OS/Interfaces/IProfiler.h"
 #include "../../../../Middleware_3/UI/AppUI.h"
+#include "../../../../Middleware_3/Animation/AnimationWorld.h"
+#include "../../../../Middleware_3/Animation/SkinningPalette.h"
 #include "../../../../Common_3/Renderer/IRenderer.h"
 #include "../../../../Common_3/Renderer/IResourceLoader.h"
+#include "../../../../Common_3/Renderer/IResourceStateTracker.h"
+#include "../../../../Common_3/Renderer/IParallelCmdRecorder.h"
+#include "../../../../Common_3/OS/Core/ThreadSystem.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/tinyimageformat/tinyimageformat_query.h"
 
 //Math
 #include "../../../../Common_3/OS/Math/MathTypes.h"
 
+#include "../../../../Common_3/ThirdParty/OpenSource/EASTL/sort.h"
+#include "FrameGraph.h"
+#include "VelocityTiles.h"
+#include "ReconstructReference.h"
+#include "DrawCulling.h"
+#include "MotionBlurTuner.h"
+#include "VelocityEncoding.h"
+#include "AnimationCrowd.h"
+#include "BatchBenchmark.h"
+
 #include "../../../../Common_3/OS/Interfaces/IMemory.h"
 
 /// Demo structures
@@ -23,10 +39,64 @@
 float gTileSize     = 20.0f;    // Tile size, suggested amount by the paper - 45.0 to see the effect better
 float gSampleCount  = 15.0f;    // Sample taps, suggested amount by the paper
 float gExposure     = 0.01f;   //  0.03 to see the effect better
+float const gCameraNear = 0.1f;
+float const gCameraFar  = 1000.0f;
+bool  gFuseTilePasses = true;   // Tile max and neighbor max in a single dispatch, without the intermediate tile texture
+bool  gTilePassesFused = false; // gFuseTilePasses as it was when the tile passes were last loaded
+bool  gComputeReconstruct = false;      // Reconstruction filter in a compute shader which caches its taps in shared memory
+bool  gReconstructUsesCompute = false;  // gComputeReconstruct as it was when the reconstruct pass was last loaded
+bool  gCameraVelocityFromDepth = false;  // Static geometry writes no velocity, a compute pass reprojects its depth instead
+bool  gCameraVelocityPassActive = false; // gCameraVelocityFromDepth as it was when the frame graph was last built
+uint32_t gJitterMode = JITTER_MODE_HASH;   // Where the reconstruction filter gets the offset of its taps from
+uint32_t gFrameCounter = 0;                // Rotates the jitter every frame
+uint32_t const gMinTileSize = 5;           // Smallest K, the tile and neighbor textures are sized for it so K can change freely
+float gReconstructScale = 1.0f;            // Fraction of the resolution the compute reconstruction filters at, upscaled when blitting
+bool  gTemporalReconstruct = false;        // Compute reconstruction averages its taps over the frames, reprojected with the velocity
+bool  gTemporalReconstructActive = false;  // gTemporalReconstruct as it was when the reconstruct buffers were last added
+uint32_t gVelocityEncoding = VELOCITY_ENCODING_HALF;        // Format of the velocity target, see VelocityEncoding.h
+uint32_t gVelocityEncodingLoaded = VELOCITY_ENCODING_HALF;  // gVelocityEncoding as it was when the G-buffer was last added
+uint32_t gTemporalSampleDivisor = 3;       // The temporal mode takes S / divisor taps a frame, the history makes up for the rest
+float gTemporalHistoryWeight = 0.8f;       // Share of the history in the taps of a pixel
+
+// Frame time budget
+bool     gAutoTune                = false;  // gMotionBlurTuner picks S, K and the reconstruction scale, the sliders are its upper bounds
+bool     gAutoTuneActive          = false;  // gAutoTune as it was when the tuner was last started
+bool     gAutoTuneCompute         = false;  // gReconstructUsesCompute as it was when the tuner was last started
+float    gMotionBlurBudget        = 1.5f;   // GPU milliseconds of the tile, neighbor and reconstruct passes together
+MotionBlurTuner gMotionBlurTuner;
+
+// Texture streaming
+bool     gStreamTextures          = true;               // Only wait for the mip tails on startup, stream the rest in afterwards
+uint64_t gTextureStreamingBudget  = 4 * 1024 * 1024;    // Bytes of mip data queued per frame
+
+// Instancing
+uint32_t        gLionCount          = 1;    // Lion instances, all drawn with the same instanced draws
+uint32_t        gCharacterCount     = 8;    // Skinned characters, every one animated on its own
+
+// Animation crowd benchmark
+AnimationCrowdOptions gCrowdOptions;    // LOD the whole crowd runs at
+
+// Culling
+bool            gFrustumCulling     = true;     // Skip the building draws outside of the view frustum
+bool            gIndirectDraws      = false;    // Draw from a compacted indirect argument list instead of one draw call per draw
+
+// Multithreaded recording
+uint32_t const  MAX_GBUFFER_CMDS    = 8;
+uint32_t        gGBufferCmdCount    = 4;    // Command lists the G-buffer draws are split over, recorded on the worker threads
 
 // General
 VirtualJoystickUI	gVirtualJoystick;
 ProfileToken		gGpuProfileToken	= PROFILE_INVALID_TOKEN;
+
+// Timers of the passes gMotionBlurTuner keeps within the budget
+struct MotionBlurTimers
+{
+    ProfileToken    mTile               = PROFILE_INVALID_TOKEN;
+    ProfileToken    mNeighbor           = PROFILE_INVALID_TOKEN;
+    ProfileToken    mTileNeighbor       = PROFILE_INVALID_TOKEN;
+    ProfileToken    mReconstruct        = PROFILE_INVALID_TOKEN;
+    ProfileToken    mReconstructCompute = PROFILE_INVALID_TOKEN;
+} gMotionBlurTimers;
 ICameraController *	pCameraController	= NULL;
 GuiComponent *		pGuiWindow;
 
@@ -39,18 +109,31 @@ float               gDeltaTime      = 0.0f;
 Queue *				pGraphicsQueue			= NULL;
 CmdPool *			pCmdPools[gImageCount]	= {NULL};
 Cmd *				pCmds[gImageCount]		= {NULL};
+Cmd *				pPostCmds[gImageCount]	= {NULL}; // Everything after the G-buffer draws
 Renderer *			pRenderer               = NULL;
 
+ThreadSystem *              pThreadSystem   = NULL;
+ParallelCmdRecorder *       pCmdRecorder    = NULL;
+
+ResourceStateTracker *      pStateTracker   = NULL;
+ResourceStateTrackerStats   gBarrierStats   = {};   // Barriers of the previous frame
+
 SwapChain *			pSwapChain								= NULL;
 Fence *				pRenderCompleteFences[gImageCount]		= {NULL};
 Semaphore *			pImageAcquiredSemaphore					= NULL;
 Semaphore *			pRenderCompleteSemaphores[gImageCount]	= {NULL};
 
+// Velocity target clear value while static geometry skips it, decoding to a velocity way past the K / 2 the G-buffer clamps to.
+// Largest half for VELOCITY_ENCODING_HALF, the largest value of both channels for the fixed point encoding.
+float const         VELOCITY_UNWRITTEN                   = 65504.0f;
+float const         VELOCITY_UNWRITTEN_FIXED             = 1.0f;
+
 uint32_t const      SAMPLERS_COUNT                       = 2;
 Sampler	*			pStaticSamplers[SAMPLERS_COUNT]      = {NULL};
 char const *		pStaticSamplersNames[]               = {"uSampler", "uSamplerLinear"};
 
 VertexLayout		gVertexLayout;
+VertexLayout		gSkinnedVertexLayout;   // gVertexLayout followed by the joint weights and indices
 
 struct ObjectInfo
 {
@@ -62,20 +145,37 @@ struct ObjectInfo
 class Sponza
 {
 public: // must match with the shader
-    static constexpr uint32_t TOTAL_MODELS = 2;
+    static constexpr uint32_t TOTAL_MODELS = 3;
     static constexpr uint32_t TOTAL_IMAGES = 84;
+    static constexpr uint32_t BUILDING_MODEL = 0;
+    static constexpr uint32_t LION_MODEL = 1;
+    static constexpr uint32_t CHARACTER_MODEL = 2;
+    // Instances per frame, the building, the lions and the skinned characters at the end
+    static constexpr uint32_t MAX_INSTANCES = 4096;
+    static constexpr uint32_t MAX_CHARACTERS = 32;
+    static constexpr uint32_t BUILDING_INSTANCE = 0;
+    static constexpr uint32_t FIRST_LION_INSTANCE = 1;
+    static constexpr uint32_t FIRST_CHARACTER_INSTANCE = MAX_INSTANCES - MAX_CHARACTERS;
 
 public:
     void                assignTextures();
 
 public:
-    Buffer *		    pUniformBuffer[gImageCount]	    = {NULL};
+    // gImageCount slices of MAX_INSTANCES, every frame writes the slice of gFrameIndex
+    Buffer *		    pInstanceBuffer                 = NULL;
     Texture *           pMaterialTextures[TOTAL_IMAGES] = {NULL};
+    uint32_t            mResidentMips[TOTAL_IMAGES]     = {0};
 
     eastl::vector<int>  mTextureIndexforMaterial;
 
-    const char *        mModelNames[TOTAL_MODELS] = { "Sponza.gltf", "lion.gltf", };
+    const char *        mModelNames[TOTAL_MODELS] = { "Sponza.gltf", "lion.gltf", "stormtrooper/riggedMesh.gltf", };
+    // Transform never changes, so the camera velocity pass can take care of their velocity
+    bool                mStaticModels[TOTAL_MODELS] = { true, false, false, };
+    // Loaded with gSkinnedVertexLayout and drawn with the skinned pipeline
+    bool                mSkinnedModels[TOTAL_MODELS] = { false, false, true, };
     Geometry *          mModels[TOTAL_MODELS];
+    // First G-buffer draw of every model, the last entry is the total draw count
+    uint32_t            mFirstDraws[TOTAL_MODELS + 1] = {};
     uint32_t            mMaterialIds[103] = 
     {
         0,  3,  1,  4,  5,  6,  7,  8,  6,  9,  7,  6, 10, 5, 7,  5, 6, 7,  6, 7,  6,  7,  6,  7,  6,  7,  6,  7,  6,  7,  6,  7,  6,  7,  6,
@@ -83,14 +183,48 @@ public:
         19, 18, 17, 20, 21, 20, 21, 20, 21, 20, 21, 3, 1,  3, 1,  3, 1, 3,  1, 3,  1,  3,  1,  3,  1,  22, 23, 4,  23, 4,  5,  24, 5,
     };
 
-    struct UniformBlock
+    ObjectInfo          mInstances[MAX_INSTANCES];
+
+    // Every lion runs back and forth along the hall on its own lane
+    struct Lion
     {
-        ObjectInfo mBuilding;
-        ObjectInfo mLion;
-    } mUniformBlock;
+        vec3    mPosition;
+        float   mVelocity;
+        float   mRotation;
+    };
+    eastl::vector<Lion> mLions;
+    // Lions updated and drawn this frame, the UI can change gLionCount in between
+    uint32_t            mLionCount = 0;
+
+    // Building draws sorted by material, and their world space bounds in the same order
+    eastl::vector<uint32_t> mDrawOrder;
+    CullingBoxes        mDrawBoxes;
+    // G-buffer draws of this frame, the building draws which passed the culling followed by the lion draws
+    eastl::vector<uint32_t> mVisibleDraws;
+    uint32_t            mVisibleDrawCount = 0;
+    // gImageCount slices with the compacted draw arguments of mVisibleDraws
+    Buffer *            pIndirectBuffer = NULL;
 
 } gSponza;
 
+// Skinned characters dancing in the hall. Every one poses its own rig, so they can be animated on different threads.
+struct Characters
+{
+    // Holds the first mCount animated objects, their palettes get built right after they were sampled
+    AnimationWorld      mWorld;
+    Clip                mClip;
+    ClipController      mClipControllers[Sponza::MAX_CHARACTERS];
+    Rig                 mRigs[Sponza::MAX_CHARACTERS];
+    Animation           mAnimations[Sponza::MAX_CHARACTERS];
+    AnimatedObject      mAnimatedObjects[Sponza::MAX_CHARACTERS];
+    SkinningPalette     mPalettes[Sponza::MAX_CHARACTERS];
+
+    // Characters animated and drawn this frame, the UI can change gCharacterCount in between
+    uint32_t            mCount = 0;
+    // gImageCount slices of MAX_CHARACTERS pairs of palettes (current, previous), every frame writes the slice of gFrameIndex
+    Buffer *            pPaletteBuffer = NULL;
+} gCharacters;
+
 // UI
 UIApp gAppUI;
 TextDrawDesc gFrameTimeDraw = TextDrawDesc(0, 0xff00ffff, 18);
@@ -100,8 +234,25 @@ struct
     vec2  tileSize		    = {};
     float kFactor			= gTileSize;
     float sFactor			= gSampleCount;
+    uint32_t jitterMode     = 0;
+    uint32_t frameIndex     = 0;
+    float reconstructScale  = 1.0f;
+    float historyWeight     = 0.0f;     // 0 when there is no history to reproject
+    float historyScale      = 0.0f;     // Velocity target value to pixels moved since the last frame
+    float targetSampleCount = 0.0f;     // Taps the averaged history stands in for
+    // Velocity target value to half velocity, set with setVelocityDecode after every initialization
+    float velocityDecodeScale = 1.0f;
+    float velocityDecodeBias  = 0.0f;
+    // Tiles in use at the current K, set with setTileCount after every initialization
+    vec2  tileCount         = {};
+    // View depth is 1 / (x + y * z) for a depth target value z, only set for the compute reconstruction
+    vec2  depthLinearize    = {};
 } gPushConstant;
 
+// Jitter sources of the reconstruction filter
+Texture *               pBlueNoiseTexture = NULL;
+eastl::vector<float>    gBlueNoise;     // CPU copy for the quality measurements
+
 // Environment block
 struct Environment
 {
@@ -113,6 +264,7 @@ struct Environment
         mat4 mProjectPrev		= {};
         vec4 mLightDirection	= { -1.0f, -1.0f, -1.0f, 0.0f };
         vec4 mLightColor		= { 1.0f, 1.0f, 1.0f, 1.0f };
+        mat4 mViewProjectInv    = {};
     } mUniformData;
     Buffer * pUniformBuffer[gImageCount]	= {NULL};
 } gEnv;
@@ -125,24 +277,58 @@ struct GBufferPass
     DescriptorSet * pDescriptorSets_PerFrame	= {NULL}; // object info
     RootSignature * pRootSignature				= NULL;
     Pipeline *		pPipeline					= NULL;
+    // Variant without the previous frame transform and velocity output
+    Shader *		pStaticShader				= NULL;
+    Pipeline *		pStaticPipeline				= NULL;
+    // Variant which skins every vertex with the current and the previous palette
+    Shader *		pSkinnedShader				= NULL;
+    Pipeline *		pSkinnedPipeline			= NULL;
+    CommandSignature *  pCommandSignature       = NULL;
 
     RenderTarget *	pColorRT;
     RenderTarget *	pNormRT;
     RenderTarget *	pVelocityRT;
     RenderTarget *	pDepthBuffer;
 
-    struct 
+    struct PushConstant
     {
         vec2  viewport		= {};
         float kFactor       = gTileSize;
         uint  textureMapIds = 0;
-        uint  objectIndex   = 0;
+        uint  instanceOffset = 0; // Into pInstanceBuffer, includes the slice of this frame
         float exposure	    = gExposure;
         float deltaTime		= 0.0f;
-    } mPushConstant;
+        uint  albedoMinLod  = 0;
+        uint  paletteOffset = 0;  // Into gCharacters.pPaletteBuffer, includes the slice of this frame
+        uint  jointCount    = 0;
+        float velocityEncodeScale = 1.0f;
+        float velocityEncodeBias  = 0.0f;
+    };
 
 } gGBufferPass;
 
+// Velocity of the static geometry, reprojected from the depth with the camera matrices
+struct CameraVelocityPass
+{
+    Shader *		pShader						= NULL;
+    Shader *		pFixedShader				= NULL;    // Storage image format of VELOCITY_ENCODING_FIXED_8
+    DescriptorSet * pDescriptorSets_PerFrame	= {NULL};
+    RootSignature * pRootSignature				= NULL;
+    Pipeline *		pPipeline					= NULL;
+
+    struct PushConstant
+    {
+        vec2  viewport      = {};
+        float kFactor       = gTileSize;
+        float exposure      = gExposure;
+        float deltaTime     = 0.0f;
+        float velocityEncodeScale = 1.0f;
+        float velocityEncodeBias  = 0.0f;
+        float velocityDecodeScale = 1.0f;
+        float velocityDecodeBias  = 0.0f;
+    };
+} gCameraVelocityPass;
+
 // Second pass (finds the most dominant velocity for each tile)
 struct TilePass
 {
@@ -164,6 +350,15 @@ struct NeighborPass
     Texture *	    pNeighborTexture            = {NULL};
 } gNeighborPass;
 
+// Second and third pass in one dispatch (writes straight into gNeighborPass.pNeighborTexture)
+struct TileNeighborPass
+{
+    Shader *		pShader						= NULL;
+    DescriptorSet * pDescriptorSets_PerFrame	= {NULL};
+    RootSignature * pRootSignature				= NULL;
+    Pipeline *		pPipeline					= NULL;
+} gTileNeighborPass;
+
 // Forth pass (reconstruction filter)
 struct ReconstructPass
 {
@@ -173,6 +368,62 @@ struct ReconstructPass
     Pipeline *		pPipeline		 = NULL;
 } gReconstructPass;
 
+// Forth pass as a compute shader, writes into a texture which then gets copied to the back buffer
+struct ReconstructComputePass
+{
+    Shader *		pShader			        = NULL;
+    DescriptorSet * pDescriptorSets	        = {NULL};
+    RootSignature * pRootSignature	        = NULL;
+    Pipeline *		pPipeline		        = NULL;
+    Texture *       pOutputTexture          = NULL;
+
+    Shader *		pBlitShader			    = NULL;
+    DescriptorSet * pBlitDescriptorSets	    = {NULL};
+    RootSignature * pBlitRootSignature	    = NULL;
+    Pipeline *		pBlitPipeline		    = NULL;
+
+    // Temporal mode, reads the history of the last frame and writes the other one. pDescriptorSets[i] writes history i.
+    Shader *		pTemporalShader		    = NULL;
+    Pipeline *		pTemporalPipeline	    = NULL;
+    Texture *       pHistoryTextures[2]     = {NULL};
+    uint32_t        mHistoryIndex           = 0;
+    bool            mHistoryValid           = false;
+} gReconstructComputePass;
+
+// Reads and writes of every pass above, the barriers between them are derived from it
+struct MotionBlurFrameGraph
+{
+    static constexpr uint32_t MAX_RESOURCES = 10;
+    // Placement alignment of render targets on desktop GPUs
+    static constexpr uint64_t RESOURCE_ALIGNMENT = 64 * 1024;
+
+    FrameGraph      mGraph;
+
+    uint32_t        mColor      = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mNormal     = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mVelocity   = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mDepth      = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mTile       = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mNeighbor   = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mReconstruct = FRAME_GRAPH_INVALID_INDEX;
+    // Swap every frame, they get patched in Draw
+    uint32_t        mHistory    = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mHistoryOutput = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mBackBuffer = FRAME_GRAPH_INVALID_INDEX;
+
+    uint32_t        mGBufferPass     = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mCameraVelocityPass = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mTilePass        = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mNeighborPass    = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mReconstructPass = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mBlitPass        = FRAME_GRAPH_INVALID_INDEX;
+    uint32_t        mUIPass          = FRAME_GRAPH_INVALID_INDEX;
+
+    // GPU object behind each graph resource, either a render target or a texture
+    RenderTarget *  pRenderTargets[MAX_RESOURCES] = {NULL};
+    Texture *       pTextures[MAX_RESOURCES]      = {NULL};
+} gFrameGraph;
+
 class MotionBlur : public IApp
 {
 public:
@@ -190,6 +441,7 @@ public:
             fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT,	RD_GPU_CONFIG,		"GPUCfg");
             fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT,	RD_TEXTURES,		"Textures");
             fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT,  RD_MESHES,          "Meshes");
+            fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT,  RD_ANIMATIONS,      "Animation");
             fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT,	RD_FONTS,			"Fonts");
         }
 
@@ -216,6 +468,7 @@ public:
                 CmdDesc cmdDesc = {};
                 cmdDesc.pPool = pCmdPools[i];
                 addCmd(pRenderer, &cmdDesc, &pCmds[i]);
+                addCmd(pRenderer, &cmdDesc, &pPostCmds[i]);
 
                 addFence(pRenderer, &pRenderCompleteFences[i]);
                 addSemaphore(pRenderer, &pRenderCompleteSemaphores[i]);
@@ -224,6 +477,17 @@ public:
 
             initResourceLoaderInterface(pRenderer);
 
+            addResourceStateTracker(pRenderer, &pStateTracker);
+
+            initThreadSystem(&pThreadSystem);
+
+            ParallelCmdRecorderDesc recorderDesc = {};
+            recorderDesc.pQueue = pGraphicsQueue;
+            recorderDesc.pThreadSystem = pThreadSystem;
+            recorderDesc.mFrameCount = gImageCount;
+            recorderDesc.mMaxCmdCount = MAX_GBUFFER_CMDS;
+            addParallelCmdRecorder(pRenderer, &recorderDesc, &pCmdRecorder);
+
             if (!gVirtualJoystick.Init(pRenderer, "circlepad"))
             {
                 LOGF(LogLevel::eERROR, "Could not initialize Virtual Joystick.");
@@ -275,6 +539,19 @@ public:
             gVertexLayout.mAttribs[2].mBinding = 0;
             gVertexLayout.mAttribs[2].mLocation = 2;
             gVertexLayout.mAttribs[2].mOffset = 6 * sizeof(float);
+
+            gSkinnedVertexLayout = gVertexLayout;
+            gSkinnedVertexLayout.mAttribCount = 5;
+            gSkinnedVertexLayout.mAttribs[3].mSemantic = SEMANTIC_WEIGHTS;
+            gSkinnedVertexLayout.mAttribs[3].mFormat = TinyImageFormat_R32G32B32A32_SFLOAT;
+            gSkinnedVertexLayout.mAttribs[3].mBinding = 0;
+            gSkinnedVertexLayout.mAttribs[3].mLocation = 3;
+            gSkinnedVertexLayout.mAttribs[3].mOffset = 8 * sizeof(float);
+            gSkinnedVertexLayout.mAttribs[4].mSemantic = SEMANTIC_JOINTS;
+            gSkinnedVertexLayout.mAttribs[4].mFormat = TinyImageFormat_R16G16B16A16_UINT;
+            gSkinnedVertexLayout.mAttribs[4].mBinding = 0;
+            gSkinnedVertexLayout.mAttribs[4].mLocation = 4;
+            gSkinnedVertexLayout.mAttribs[4].mOffset = 12 * sizeof(float);
         }
         
         // Loading Sponza
@@ -294,11 +571,21 @@ public:
 
         waitForAllResourceLoads();
 
+        if (gStreamTextures)
+        {
+            setTextureStreamingPriorities();
+        }
+
         createEnvironmentBlock();
+        createCharacters();
         createGBufferPass();
+        createCameraVelocityPass();
         createTilePass();
         createNeighborPass();
+        createTileNeighborPass();
         createReconstructPass();
+        createReconstructComputePass();
+        createBlueNoiseTexture();
 
         if (!gAppUI.Init(pRenderer))
             return false;
@@ -331,9 +618,74 @@ public:
     #if !defined(TARGET_IOS)
             pGuiWindow->AddWidget(CheckboxWidget("Toggle VSync\t\t\t\t\t", &bToggleVSync));
     #endif
-            pGuiWindow->AddWidget(SliderFloatWidget("K (Tile size/radius)", &gTileSize,     5.0f,  100.0f, 1.0f));
+            pGuiWindow->AddWidget(SliderFloatWidget("K (Tile size/radius)", &gTileSize,     float(gMinTileSize), 100.0f, 1.0f));
             pGuiWindow->AddWidget(SliderFloatWidget("S (Sample count)",     &gSampleCount,  1.0f,  100.0f, 1.0f));
             pGuiWindow->AddWidget(SliderFloatWidget("Exposure time",        &gExposure,     0.01f, 0.4f,   0.00001f));
+            pGuiWindow->AddWidget(SliderFloatWidget("Reconstruction scale (compute)", &gReconstructScale, 0.5f, 1.0f, 0.125f));
+            pGuiWindow->AddWidget(CheckboxWidget("Auto-tune S, K and scale", &gAutoTune));
+            pGuiWindow->AddWidget(SliderFloatWidget("Motion blur budget (ms)", &gMotionBlurBudget, 0.1f, 10.0f, 0.1f));
+            pGuiWindow->AddWidget(SliderUintWidget("GBuffer command lists", &gGBufferCmdCount, 1, MAX_GBUFFER_CMDS));
+            pGuiWindow->AddWidget(SliderUintWidget("Lion instances", &gLionCount, 1, Sponza::FIRST_CHARACTER_INSTANCE - Sponza::FIRST_LION_INSTANCE));
+            pGuiWindow->AddWidget(SliderUintWidget("Skinned characters", &gCharacterCount, 0, Sponza::MAX_CHARACTERS));
+            pGuiWindow->AddWidget(CheckboxWidget("Frustum culling", &gFrustumCulling));
+            pGuiWindow->AddWidget(CheckboxWidget("Indirect G-buffer draws", &gIndirectDraws));
+            pGuiWindow->AddWidget(CheckboxWidget("Fuse tile and neighbor passes", &gFuseTilePasses));
+            pGuiWindow->AddWidget(CheckboxWidget("Compute reconstruction", &gComputeReconstruct));
+            pGuiWindow->AddWidget(CheckboxWidget("Temporal reconstruction (compute)", &gTemporalReconstruct));
+            pGuiWindow->AddWidget(SliderUintWidget("Temporal S divisor", &gTemporalSampleDivisor, 1, 4));
+            pGuiWindow->AddWidget(SliderFloatWidget("Temporal history weight", &gTemporalHistoryWeight, 0.0f, 0.95f, 0.05f));
+            pGuiWindow->AddWidget(CheckboxWidget("Static velocity from depth", &gCameraVelocityFromDepth));
+
+            static const char * velocityEncodingNames[] = { "Half float (RG16F)", "Fixed point (RG8)" };
+            static const uint32_t velocityEncodingValues[] = { VELOCITY_ENCODING_HALF, VELOCITY_ENCODING_FIXED_8 };
+            pGuiWindow->AddWidget(DropdownWidget("Velocity encoding", &gVelocityEncoding, velocityEncodingNames, velocityEncodingValues, VELOCITY_ENCODING_GPU_COUNT));
+
+            static const char * jitterModeNames[] = { "Hash", "Interleaved gradient noise", "Blue noise", "R2" };
+            static const uint32_t jitterModeValues[] = { JITTER_MODE_HASH, JITTER_MODE_IGN, JITTER_MODE_BLUE_NOISE, JITTER_MODE_R2 };
+            pGuiWindow->AddWidget(DropdownWidget("Jitter", &gJitterMode, jitterModeNames, jitterModeValues, JITTER_MODE_COUNT));
+
+            ButtonWidget measureJitter("Measure jitter quality (CPU)");
+            measureJitter.pOnEdited = logJitterQuality;
+            pGuiWindow->AddWidget(measureJitter);
+
+            ButtonWidget measureVelocityEncoding("Measure velocity encodings (CPU)");
+            measureVelocityEncoding.pOnEdited = logVelocityEncodingQuality;
+            pGuiWindow->AddWidget(measureVelocityEncoding);
+
+            ButtonWidget measureTemporal("Measure temporal reuse (CPU)");
+            measureTemporal.pOnEdited = logTemporalQuality;
+            pGuiWindow->AddWidget(measureTemporal);
+
+            ButtonWidget compareTileModels("Compare fused tile models (CPU)");
+            compareTileModels.pOnEdited = logFusedTileModelComparison;
+            pGuiWindow->AddWidget(compareTileModels);
+
+            ButtonWidget replayTuner("Replay auto-tune traces (CPU)");
+            replayTuner.pOnEdited = logTunerReplay;
+            pGuiWindow->AddWidget(replayTuner);
+
+            ButtonWidget benchmarkCulling("Benchmark culling (CPU)");
+            benchmarkCulling.pOnEdited = logCullingBenchmark;
+            pGuiWindow->AddWidget(benchmarkCulling);
+
+            ButtonWidget verifyCulling("Verify SIMD culling (CPU)");
+            verifyCulling.pOnEdited = logCullingCheck;
+            pGuiWindow->AddWidget(verifyCulling);
+
+            pGuiWindow->AddWidget(SliderUintWidget("Crowd LOD update interval", &gCrowdOptions.mUpdateInterval, 1, 8));
+            pGuiWindow->AddWidget(SliderUintWidget("Crowd LOD offset stride", &gCrowdOptions.mUpdateOffsetStride, 0, 4));
+            pGuiWindow->AddWidget(SliderIntWidget("Crowd LOD mask joint (-1 all)", &gCrowdOptions.mMaskJoint, -1, 63));
+            pGuiWindow->AddWidget(CheckboxWidget("Crowd LOD pose bones", &gCrowdOptions.mPoseBones));
+            pGuiWindow->AddWidget(CheckboxWidget("Crowd arena allocator", &gCrowdOptions.mArenaAllocator));
+            pGuiWindow->AddWidget(CheckboxWidget("Crowd mapped clip", &gCrowdOptions.mMappedClip));
+
+            ButtonWidget benchmarkCrowd("Benchmark animation crowd (CPU)");
+            benchmarkCrowd.pOnEdited = logAnimationCrowdBenchmark;
+            pGuiWindow->AddWidget(benchmarkCrowd);
+
+            ButtonWidget benchmarkBatch("Benchmark batch math backends (CPU)");
+            benchmarkBatch.pOnEdited = logBatchBenchmark;
+            pGuiWindow->AddWidget(benchmarkBatch);
         }
 
         // App Actions
@@ -383,10 +735,15 @@ public:
         gAppUI.Exit();
         exitProfiler();
 
+        destroyBlueNoiseTexture();
+        destroyReconstructComputePass();
         destroyReconstructPass();
+        destroyTileNeighborPass();
         destroyNeighborPass();
         destroyTilePass();
+        destroyCameraVelocityPass();
         destroyGBufferPass();
+        destroyCharacters();
         destroyEnvironmentBlock();
         
         for (uint32_t i = 0; i < 2; ++i)
@@ -397,11 +754,17 @@ public:
             removeFence(pRenderer, pRenderCompleteFences[i]);
             removeSemaphore(pRenderer, pRenderCompleteSemaphores[i]);
 
+            removeCmd(pRenderer, pPostCmds[i]);
             removeCmd(pRenderer, pCmds[i]);
             removeCmdPool(pRenderer, pCmdPools[i]);
         }
         removeSemaphore(pRenderer, pImageAcquiredSemaphore);
 
+        removeParallelCmdRecorder(pRenderer, pCmdRecorder);
+        shutdownThreadSystem(pThreadSystem);
+
+        removeResourceStateTracker(pRenderer, pStateTracker);
+
         exitResourceLoaderInterface(pRenderer);
         removeQueue(pRenderer, pGraphicsQueue);
         removeRenderer(pRenderer);
@@ -415,15 +778,26 @@ public:
         if (!loadGBufferPass())
             return false;
 
+        if (!loadCameraVelocityPass())
+            return false;
+
         if (!loadTilePass())
             return false;
         
         if (!loadNeighborPass())
             return false;
 
+        if (!loadTileNeighborPass())
+            return false;
+
         if (!loadReconstructPass())
             return false;
 
+        if (!loadReconstructComputePass())
+            return false;
+
+        addFrameGraph();
+
         if (!gAppUI.Load(pSwapChain->ppRenderTargets, 1))
             return false;
 
@@ -442,10 +816,17 @@ public:
         gAppUI.Unload();
         gVirtualJoystick.Unload();
 
+        removeFrameGraph();
+
+        unloadTileNeighborPass();
         unloadNeighborPass();
         unloadTilePass();
+        unloadCameraVelocityPass();
         unloadGBufferPass();
+        unloadReconstructComputePass();
         unloadReconstructPass();
+
+        removeSwapChain(pRenderer, pSwapChain);
     }
 
     void Update(float deltaTime)
@@ -455,9 +836,37 @@ public:
         {
             waitQueueIdle(pGraphicsQueue);
             gFrameIndex = 0;
+            for (uint32_t i = 0; i < pSwapChain->mImageCount; ++i)
+                untrackRenderTargetState(pStateTracker, pSwapChain->ppRenderTargets[i]);
             ::toggleVSync(pRenderer, &pSwapChain);
+            for (uint32_t i = 0; i < pSwapChain->mImageCount; ++i)
+                trackRenderTargetState(pStateTracker, pSwapChain->ppRenderTargets[i], RESOURCE_STATE_PRESENT);
         }
 #endif
+        updateMotionBlurTuning();
+
+        // Every pass reading the velocity target has it in a descriptor set, start over
+        if (gVelocityEncodingLoaded != gVelocityEncoding)
+        {
+            Unload();
+            Load();
+        }
+
+        if (gTilePassesFused != gFuseTilePasses || gReconstructUsesCompute != gComputeReconstruct ||
+            gCameraVelocityPassActive != gCameraVelocityFromDepth || gTemporalReconstructActive != gTemporalReconstruct)
+        {
+            waitQueueIdle(pGraphicsQueue);
+            removeFrameGraph();
+            removeTileBuffer();
+            removeReconstructBuffer();
+            gTilePassesFused = gFuseTilePasses;
+            gReconstructUsesCompute = gComputeReconstruct;
+            gCameraVelocityPassActive = gCameraVelocityFromDepth;
+            gTemporalReconstructActive = gTemporalReconstruct;
+            addTileBuffer();
+            addReconstructBuffer();
+            addFrameGraph();
+        }
         updateInputSystem(mSettings.mWidth, mSettings.mHeight);
 
         // Scene update
@@ -482,8 +891,10 @@ public:
                         mat4 viewMat = pCameraController->getViewMatrix();
                         gEnv.mUniformData.mView = viewMat;
 
-                        mat4 projMat = mat4::perspective(horizontal_fov, aspectInverse, 0.1f, 1000.f);
+                        mat4 projMat = mat4::perspective(horizontal_fov, aspectInverse, gCameraNear, gCameraFar);
                         gEnv.mUniformData.mProject = projMat;
+
+                        gEnv.mUniformData.mViewProjectInv = inverse(projMat * viewMat);
                     }
                 }
 
@@ -493,26 +904,51 @@ public:
             }
         }
 
-        // Update one object and copy the lastest MVP
+        // Update the lions and copy the lastest MVP
         {
-            static float vel = 50.0f;
-            static vec3 pos = { 0.0f, -6.0f, 1.0f };
-            static float rot = 0.0f;
-            static mat4 lionTransform = mat4::scale({0.2f, 0.2f, -0.2f}) * mat4::identity();
+            addLions(gLionCount);
 
-            if (pos.getX() >= 10.0f)
-            {
-                vel = ::abs(vel) * -1.0f;
-            }else if (pos.getX() <= -10.0f)
+            uint32_t const lastLionCount = gSponza.mLionCount;
+            gSponza.mLionCount = gLionCount;
+            for (uint32_t i = 0; i < gSponza.mLionCount; ++i)
             {
-                vel = ::abs(vel);
+                Sponza::Lion & lion = gSponza.mLions[i];
+                vec3 & pos = lion.mPosition;
+
+                if (pos.getX() >= 10.0f)
+                {
+                    lion.mVelocity = ::abs(lion.mVelocity) * -1.0f;
+                }else if (pos.getX() <= -10.0f)
+                {
+                    lion.mVelocity = ::abs(lion.mVelocity);
+                }
+                pos.setX(pos.getX() + (deltaTime * lion.mVelocity));
+                lion.mRotation += deltaTime * (::abs(lion.mVelocity)/5.0f);
+
+                auto & obj = gSponza.mInstances[Sponza::FIRST_LION_INSTANCE + i];
+                obj.mToWorldMatPrev = obj.mToWorldMat;
+                obj.mToWorldMat = getLionToWorld(lion);
+
+                // Was not drawn last frame, so it has no motion yet
+                if (i >= lastLionCount)
+                    obj.mToWorldMatPrev = obj.mToWorldMat;
             }
-            pos.setX(pos.getX() + (deltaTime * vel));
-            rot += deltaTime * (::abs(vel)/5.0f);
+        }
 
-            auto & obj = gSponza.mUniformBlock.mLion;				
-            obj.mToWorldMatPrev = obj.mToWorldMat;
-            obj.mToWorldMat = mat4::translation(pos) * mat4::rotationY(rot) * lionTransform;
+        // Animate the characters, the rigs are sampled and the palettes computed on the worker threads
+        {
+            uint32_t const lastCharacterCount = gCharacters.mCount;
+            gCharacters.mCount = gCharacterCount;
+
+            for (uint32_t i = lastCharacterCount; i-- > gCharacters.mCount;)
+                gCharacters.mWorld.RemoveObject(&gCharacters.mAnimatedObjects[i]);
+            for (uint32_t i = lastCharacterCount; i < gCharacters.mCount; ++i)
+                gCharacters.mWorld.AddObject(&gCharacters.mAnimatedObjects[i], false, SkinningPalette::PostUpdate, &gCharacters.mPalettes[i]);
+            gCharacters.mWorld.Update(deltaTime);
+
+            // Were not drawn last frame, so their old palettes are stale
+            for (uint32_t i = lastCharacterCount; i < gCharacters.mCount; ++i)
+                gCharacters.mPalettes[i].ResetHistory();
         }
 
         // Update fps
@@ -547,40 +983,134 @@ public:
                 endUpdateResource(&envBuffer, NULL);
             }
 
-            // Update objects buffer
+            // Update the instances, only the ones drawn this frame
+            {
+                uint32_t const instanceCount = Sponza::FIRST_LION_INSTANCE + gSponza.mLionCount;
+                BufferUpdateDesc buffer = { gSponza.pInstanceBuffer, getInstanceOffset(0) * sizeof(ObjectInfo), instanceCount * sizeof(ObjectInfo) };
+                beginUpdateResource(&buffer);
+                memcpy(buffer.pMappedData, gSponza.mInstances, instanceCount * sizeof(ObjectInfo));
+                endUpdateResource(&buffer, NULL);
+
+                if (gCharacters.mCount)
+                {
+                    BufferUpdateDesc characterBuffer = { gSponza.pInstanceBuffer, getInstanceOffset(Sponza::FIRST_CHARACTER_INSTANCE) * sizeof(ObjectInfo), gCharacters.mCount * sizeof(ObjectInfo) };
+                    beginUpdateResource(&characterBuffer);
+                    memcpy(characterBuffer.pMappedData, &gSponza.mInstances[Sponza::FIRST_CHARACTER_INSTANCE], gCharacters.mCount * sizeof(ObjectInfo));
+                    endUpdateResource(&characterBuffer, NULL);
+                }
+            }
+
+            // Current and previous palette of every character drawn this frame
+            if (gCharacters.mCount)
+            {
+                uint32_t const jointCount = getCharacterJointCount();
+                BufferUpdateDesc buffer = { gCharacters.pPaletteBuffer, getPaletteOffset(0) * sizeof(mat4), gCharacters.mCount * 2 * jointCount * sizeof(mat4) };
+                beginUpdateResource(&buffer);
+                mat4 * pPalettes = (mat4 *)buffer.pMappedData;
+                for (uint32_t i = 0; i < gCharacters.mCount; ++i)
+                {
+                    memcpy(pPalettes + (2 * i + 0) * jointCount, gCharacters.mPalettes[i].GetPalette(), jointCount * sizeof(mat4));
+                    memcpy(pPalettes + (2 * i + 1) * jointCount, gCharacters.mPalettes[i].GetPreviousPalette(), jointCount * sizeof(mat4));
+                }
+                endUpdateResource(&buffer, NULL);
+            }
+
+            cullGBufferDraws();
+
+            // Compacted arguments of the visible draws, in the order drawGBufferRange goes over them
+            if (gIndirectDraws)
             {
-                BufferUpdateDesc buffer = { gSponza.pUniformBuffer[gFrameIndex] };
+                BufferUpdateDesc buffer = { gSponza.pIndirectBuffer, getIndirectDrawOffset(0), gSponza.mVisibleDrawCount * sizeof(IndirectDrawIndexArguments) };
                 beginUpdateResource(&buffer);
-                *(Sponza::UniformBlock *)buffer.pMappedData = gSponza.mUniformBlock;
+                IndirectDrawIndexArguments * pArgs = (IndirectDrawIndexArguments *)buffer.pMappedData;
+                for (uint32_t i = 0; i < gSponza.mVisibleDrawCount; ++i)
+                {
+                    uint32_t modelDraw = 0;
+                    uint32_t const model = getDrawModel(gSponza.mVisibleDraws[i], &modelDraw);
+                    IndirectDrawIndexArguments args = gSponza.mModels[model]->pDrawArgs[modelDraw];
+                    args.mInstanceCount = getModelInstanceCount(model);
+                    args.mStartInstance = 0;
+                    pArgs[i] = args;
+                }
                 endUpdateResource(&buffer, NULL);
             }
         }
 
-        // Reset cmd pool for this frame
+        // Stream in the next texture mips and pick up the ones which finished uploading
+        if (gStreamTextures)
+        {
+            updateTextureStreaming(gTextureStreamingBudget);
+            for (uint32_t i = 0; i < Sponza::TOTAL_IMAGES; ++i)
+            {
+                gSponza.mResidentMips[i] = getTextureResidentMip(gSponza.pMaterialTextures[i]);
+            }
+        }
+
+        // Reset cmd pools for this frame
         resetCmdPool(pRenderer, pCmdPools[gFrameIndex]);
+        resetParallelCmdRecorder(pRenderer, pCmdRecorder, gFrameIndex);
 
-        Cmd * cmd = pCmds[gFrameIndex];
-        beginCmd(cmd);
+        gFrameGraph.pRenderTargets[gFrameGraph.mBackBuffer] = pRenderTarget;
+        if (FRAME_GRAPH_INVALID_INDEX != gFrameGraph.mHistory)
+        {
+            uint32_t const historyIndex = gReconstructComputePass.mHistoryIndex;
+            gFrameGraph.pTextures[gFrameGraph.mHistory] = gReconstructComputePass.pHistoryTextures[1 - historyIndex];
+            gFrameGraph.pTextures[gFrameGraph.mHistoryOutput] = gReconstructComputePass.pHistoryTextures[historyIndex];
+        }
+
+        getResourceStateTrackerStats(pStateTracker, &gBarrierStats);
+        resetResourceStateTrackerStats(pStateTracker);
+
+        // 1. GBuffer pass, cleared on this thread and drawn from the worker threads
+        Cmd * gbufferCmd = pCmds[gFrameIndex];
+        beginCmd(gbufferCmd);
         {
-cmdBeginGpuFrameProfile(cmd, gGpuProfileToken);
+cmdBeginGpuFrameProfile(gbufferCmd, gGpuProfileToken);
+            beginGBufferPass(gbufferCmd);
+        }
+        endCmd(gbufferCmd);
+
+        uint32_t const drawCmdCount = gGBufferCmdCount;
+        Cmd * pDrawCmds[MAX_GBUFFER_CMDS] = {NULL};
+        GBufferRecordDesc recordDesc = { this, drawCmdCount };
+        recordParallelCmds(pCmdRecorder, gFrameIndex, drawCmdCount, recordGBufferCmd, &recordDesc, pDrawCmds);
 
+        Cmd * cmd = pPostCmds[gFrameIndex];
+        beginCmd(cmd);
+        {
             // Draw each pass
             {
-                // 1. GBuffer pass
-                drawGBufferPass(cmd);
+                endGBufferPass(cmd);
 
-                // 2. Tile pass
-                drawTilePass(cmd);
+                // 1.5 Velocity of the static geometry
+                if (gCameraVelocityPassActive)
+                    drawCameraVelocityPass(cmd);
+
+                if (gTilePassesFused)
+                {
+                    // 2. + 3. Tile and neighbor pass
+                    drawTileNeighborPass(cmd);
+                }
+                else
+                {
+                    // 2. Tile pass
+                    drawTilePass(cmd);
 
-                // 3. Neighbor pass
-                drawNeighborPass(cmd);
+                    // 3. Neighbor pass
+                    drawNeighborPass(cmd);
+                }
 
                 // 2. Reconstruct pass
-                drawReconstructPass(cmd, swapchainImageIndex);
+                if (gReconstructUsesCompute)
+                    drawReconstructComputePass(cmd, swapchainImageIndex);
+                else
+                    drawReconstructPass(cmd, swapchainImageIndex);
             }
 
             // UI and finilization
             {
+                cmdFrameGraphBarriers(cmd, gFrameGraph.mUIPass);
+
                 LoadActionsDesc loadActions = {};
                 loadActions.mLoadActionsColor[0] = LOAD_ACTION_LOAD;
                 cmdBindRenderTargets(cmd, 1, &pRenderTarget, NULL, &loadActions, NULL, NULL, -1, -1);
@@ -589,18 +1119,22 @@ cmdBeginGpuFrameProfile(cmd, gGpuProfileToken);
                 gVirtualJoystick.Draw(cmd, {1.0f, 1.0f, 1.0f, 1.0f});
                 const float txtIndent = 8.f;
                 float2 txtSizePx = cmdDrawCpuProfile(cmd, float2(txtIndent, 15.f), &gFrameTimeDraw);
-                cmdDrawGpuProfile(cmd, float2(txtIndent, txtSizePx.y + 30.f), gGpuProfileToken, &gFrameTimeDraw);
+                float2 gpuTxtSizePx = cmdDrawGpuProfile(cmd, float2(txtIndent, txtSizePx.y + 30.f), gGpuProfileToken, &gFrameTimeDraw);
+
+                char barrierTxt[128] = {};
+                sprintf(barrierTxt, "Barriers: %u issued, %u elided, %u batches", gBarrierStats.mIssuedBarriers, gBarrierStats.mElidedBarriers, gBarrierStats.mBatches);
+                gAppUI.DrawText(cmd, float2(txtIndent, txtSizePx.y + gpuTxtSizePx.y + 45.f), barrierTxt, &gFrameTimeDraw);
+
+                char drawTxt[128] = {};
+                sprintf(drawTxt, "G-buffer draws: %u of %u", gSponza.mVisibleDrawCount, getTotalGBufferDrawCount());
+                gAppUI.DrawText(cmd, float2(txtIndent, txtSizePx.y + gpuTxtSizePx.y + 65.f), drawTxt, &gFrameTimeDraw);
                 cmdDrawProfilerUI();
                 gAppUI.Gui(pGuiWindow);
                 gAppUI.Draw(cmd);
                 cmdBindRenderTargets(cmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
 cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
 
-                RenderTargetBarrier barriers[] =
-                {
-                    { pRenderTarget, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_PRESENT },
-                };
-                cmdResourceBarrier(cmd, 0, NULL, 0, NULL, 1, barriers);
+                cmdFrameGraphRestoreStates(cmd);
 cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
             }
         }
@@ -608,11 +1142,19 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
 
         // Sumbit and present the queue
         {
+            // Always in recording order, no matter which worker finished first
+            Cmd * ppSubmitCmds[MAX_GBUFFER_CMDS + 2] = {NULL};
+            uint32_t submitCmdCount = 0;
+            ppSubmitCmds[submitCmdCount++] = gbufferCmd;
+            for (uint32_t i = 0; i < drawCmdCount; ++i)
+                ppSubmitCmds[submitCmdCount++] = pDrawCmds[i];
+            ppSubmitCmds[submitCmdCount++] = cmd;
+
             QueueSubmitDesc submitDesc = {};
-            submitDesc.mCmdCount = 1;
+            submitDesc.mCmdCount = submitCmdCount;
             submitDesc.mSignalSemaphoreCount = 1;
             submitDesc.mWaitSemaphoreCount = 1;
-            submitDesc.ppCmds = &cmd;
+            submitDesc.ppCmds = ppSubmitCmds;
             submitDesc.ppSignalSemaphores = &pRenderCompleteSemaphore;
             submitDesc.ppWaitSemaphores = &pImageAcquiredSemaphore;
             submitDesc.pSignalFence = pRenderCompleteFence;
@@ -629,6 +1171,7 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
         }
 
         gFrameIndex = (gFrameIndex + 1) % gImageCount;
+        ++gFrameCounter;
     }
 
     // Environment
@@ -654,7 +1197,61 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
             removeResource(gEnv.pUniformBuffer[i]);
         }
     }
-    
+
+    // Characters
+    void createCharacters()
+    {
+        Geometry const & mesh = *gSponza.mModels[Sponza::CHARACTER_MODEL];
+
+        // Every character samples its own rig, so they can be updated on different threads
+        for (uint32_t i = 0; i < Sponza::MAX_CHARACTERS; ++i)
+        {
+            gCharacters.mRigs[i].Initialize(RD_ANIMATIONS, "stormtrooper/skeleton.ozz");
+        }
+
+        gCharacters.mClip.Initialize(RD_ANIMATIONS, "stormtrooper/animations/dance.ozz", &gCharacters.mRigs[0]);
+        gCharacters.mWorld.Initialize(pThreadSystem, gCharacters.mRigs[0].GetNumJoints());
+
+        for (uint32_t i = 0; i < Sponza::MAX_CHARACTERS; ++i)
+        {
+            gCharacters.mClipControllers[i].Initialize(gCharacters.mClip.GetDuration());
+
+            AnimationDesc animationDesc = {};
+            animationDesc.mRig = &gCharacters.mRigs[i];
+            animationDesc.mNumLayers = 1;
+            animationDesc.mLayerProperties[0].mClip = &gCharacters.mClip;
+            animationDesc.mLayerProperties[0].mClipController = &gCharacters.mClipControllers[i];
+            gCharacters.mAnimations[i].Initialize(animationDesc);
+
+            // Spread them over the clip so they do not dance in lockstep
+            float const phase = float(i) * 0.618034f;
+            gCharacters.mAnimations[i].SetTimeRatio(phase - floorf(phase));
+
+            gCharacters.mAnimatedObjects[i].Initialize(&gCharacters.mRigs[i], &gCharacters.mAnimations[i]);
+            gCharacters.mPalettes[i].Initialize(&gCharacters.mAnimatedObjects[i], mesh.mJointCount, mesh.pInverseBindPoses, mesh.pJointRemaps);
+        }
+
+        gCharacters.mCount = 0;
+    }
+    void destroyCharacters()
+    {
+        gCharacters.mWorld.Destroy();
+
+        for (uint32_t i = 0; i < Sponza::MAX_CHARACTERS; ++i)
+        {
+            gCharacters.mPalettes[i].Destroy();
+            gCharacters.mAnimatedObjects[i].Destroy();
+            gCharacters.mAnimations[i].Destroy();
+        }
+
+        gCharacters.mClip.Destroy();
+
+        for (uint32_t i = 0; i < Sponza::MAX_CHARACTERS; ++i)
+        {
+            gCharacters.mRigs[i].Destroy();
+        }
+    }
+
     // GBuffer pass
     void createGBufferPass()
     {
@@ -664,13 +1261,25 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
             shader.mStages[0] = {"gbuffer.vert", NULL, 0};
             shader.mStages[1] = {"gbuffer.frag", NULL, 0};
             addShader(pRenderer, &shader, &gGBufferPass.pShader);
-            Shader * shaders[] = { gGBufferPass.pShader };
+
+            ShaderMacro staticMacro = { "STATIC_GEOMETRY", "1" };
+            shader.mStages[0] = {"gbuffer.vert", &staticMacro, 1};
+            shader.mStages[1] = {"gbuffer.frag", &staticMacro, 1};
+            addShader(pRenderer, &shader, &gGBufferPass.pStaticShader);
+
+            ShaderMacro skinnedMacro = { "SKINNED", "1" };
+            shader.mStages[0] = {"gbuffer.vert", &skinnedMacro, 1};
+            shader.mStages[1] = {"gbuffer.frag", NULL, 0};
+            addShader(pRenderer, &shader, &gGBufferPass.pSkinnedShader);
+
+            // Shared, so switching between the variants keeps the bound sets and push constants
+            Shader * shaders[] = { gGBufferPass.pShader, gGBufferPass.pStaticShader, gGBufferPass.pSkinnedShader };
 
             RootSignatureDesc rootDesc = {};
             rootDesc.mStaticSamplerCount = 1;
             rootDesc.ppStaticSamplerNames = &pStaticSamplersNames[0];
             rootDesc.ppStaticSamplers = &pStaticSamplers[0];
-            rootDesc.mShaderCount = 1;
+            rootDesc.mShaderCount = sizeof(shaders) / sizeof(shaders[0]);
             rootDesc.ppShaders = shaders;
             addRootSignature(pRenderer, &rootDesc, &gGBufferPass.pRootSignature);
 
@@ -681,30 +1290,132 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
             addDescriptorSet(pRenderer, &desc, &gGBufferPass.pDescriptorSets_PerFrame);
         }
 
-        // Setup pass uniform blocks
+        // Setup the instance ring
         {
-            BufferLoadDesc ubDesc = {};
-            ubDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            ubDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
-            ubDesc.mDesc.mSize = sizeof(Sponza::UniformBlock);
-            ubDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
-            ubDesc.pData = NULL;
-            for (uint32_t i = 0; i < gImageCount; ++i)
-            {
-                ubDesc.ppBuffer = &gSponza.pUniformBuffer[i];
-                addResource(&ubDesc, NULL);
-            }
+            BufferLoadDesc sbDesc = {};
+            sbDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
+            sbDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+            sbDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+            sbDesc.mDesc.mFirstElement = 0;
+            sbDesc.mDesc.mElementCount = gImageCount * Sponza::MAX_INSTANCES;
+            sbDesc.mDesc.mStructStride = sizeof(ObjectInfo);
+            sbDesc.mDesc.mSize = sbDesc.mDesc.mElementCount * sbDesc.mDesc.mStructStride;
+            sbDesc.mDesc.pName = "Instance Buffer";
+            sbDesc.pData = NULL;
+            sbDesc.ppBuffer = &gSponza.pInstanceBuffer;
+            addResource(&sbDesc, NULL);
+        }
+
+        // Setup the palette ring
+        {
+            BufferLoadDesc sbDesc = {};
+            sbDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
+            sbDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+            sbDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+            sbDesc.mDesc.mFirstElement = 0;
+            sbDesc.mDesc.mElementCount = gImageCount * Sponza::MAX_CHARACTERS * 2 * getCharacterJointCount();
+            sbDesc.mDesc.mStructStride = sizeof(mat4);
+            sbDesc.mDesc.mSize = sbDesc.mDesc.mElementCount * sbDesc.mDesc.mStructStride;
+            sbDesc.mDesc.pName = "Palette Buffer";
+            sbDesc.pData = NULL;
+            sbDesc.ppBuffer = &gCharacters.pPaletteBuffer;
+            addResource(&sbDesc, NULL);
         }
 
         // Setup building positions
         {
-            auto & building = gSponza.mUniformBlock.mBuilding;
+            auto & building = gSponza.mInstances[Sponza::BUILDING_INSTANCE];
             building.mToWorldMat = mat4::translation({0.0f, -6.0f, 0.0f}) * mat4::scale({0.02f, 0.02f, 0.02f}) * mat4::identity();
             building.mToWorldMatPrev = building.mToWorldMat;
+
+            // Two rows of characters facing each other across the hall
+            static mat4 characterTransform = mat4::scale({1.5f, 1.5f, -1.5f}) * mat4::identity();
+            for (uint32_t i = 0; i < Sponza::MAX_CHARACTERS; ++i)
+            {
+                uint32_t const row = i % 2;
+                float const x = -9.0f + 18.0f * float(i / 2) / float(Sponza::MAX_CHARACTERS / 2 - 1);
+                auto & character = gSponza.mInstances[Sponza::FIRST_CHARACTER_INSTANCE + i];
+                character.mToWorldMat = mat4::translation({x, -6.0f, row ? 3.0f : -3.0f}) * mat4::rotationY(row ? PI : 0.0f) * characterTransform;
+                character.mToWorldMatPrev = character.mToWorldMat;
+            }
+        }
+
+        // Setup the culling, the building never moves so its bounds only have to be transformed once
+        {
+            for (uint32_t i = 0; i < Sponza::TOTAL_MODELS; ++i)
+                gSponza.mFirstDraws[i + 1] = gSponza.mFirstDraws[i] + gSponza.mModels[i]->mDrawArgCount;
+
+            Geometry & building = *gSponza.mModels[Sponza::BUILDING_MODEL];
+            uint32_t const sponzaDrawCount = building.mDrawArgCount;
+            ASSERT(sponzaDrawCount <= sizeof(gSponza.mMaterialIds) / sizeof(gSponza.mMaterialIds[0]));
+
+            // Draws sharing a material end up next to each other, so they share push constants and indirect draws
+            gSponza.mDrawOrder.resize(sponzaDrawCount);
+            for (uint32_t i = 0; i < sponzaDrawCount; ++i)
+                gSponza.mDrawOrder[i] = i;
+            eastl::stable_sort(gSponza.mDrawOrder.begin(), gSponza.mDrawOrder.end(), [](uint32_t a, uint32_t b)
+            {
+                return gSponza.mMaterialIds[a] < gSponza.mMaterialIds[b];
+            });
+
+            mat4 const & toWorld = gSponza.mInstances[Sponza::BUILDING_INSTANCE].mToWorldMat;
+            resizeCullingBoxes(&gSponza.mDrawBoxes, sponzaDrawCount);
+            for (uint32_t i = 0; i < sponzaDrawCount; ++i)
+            {
+                const Geometry::Bounds & bounds = building.pDrawBounds[gSponza.mDrawOrder[i]];
+                setCullingBox(&gSponza.mDrawBoxes, i, f3Tov3(bounds.mMin), f3Tov3(bounds.mMax), toWorld);
+            }
+
+            gSponza.mVisibleDraws.resize(getTotalGBufferDrawCount());
+
+            BufferLoadDesc indirectDesc = {};
+            indirectDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_INDIRECT_BUFFER;
+            indirectDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+            indirectDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+            indirectDesc.mDesc.mSize = gImageCount * getTotalGBufferDrawCount() * sizeof(IndirectDrawIndexArguments);
+            indirectDesc.mDesc.pName = "Indirect Draw Buffer";
+            indirectDesc.pData = NULL;
+            indirectDesc.ppBuffer = &gSponza.pIndirectBuffer;
+            addResource(&indirectDesc, NULL);
+
+            // Packed, the arguments are written back to back
+            IndirectArgumentDescriptor indirectArg = {};
+            indirectArg.mType = INDIRECT_DRAW_INDEX;
+            CommandSignatureDesc signatureDesc = { gGBufferPass.pRootSignature, 1, &indirectArg, true };
+            addIndirectCommandSignature(pRenderer, &signatureDesc, &gGBufferPass.pCommandSignature);
+        }
+    }
+    // Lanes beyond the first lion are spread over the hall, every lion starts somewhere else along it
+    void addLions(uint32_t count)
+    {
+        for (uint32_t i = (uint32_t)gSponza.mLions.size(); i < count; ++i)
+        {
+            uint32_t const lane = i % 16;
+            uint32_t const row = (i / 16) % 16;
+            float const lateral = i ? (float(lane) - 7.5f) * 0.25f : 0.0f;
+            float const height = i ? float(row) * 0.5f : 0.0f;
+            float const start = i ? -10.0f + 20.0f * float((i * 37) % 101) / 100.0f : 0.0f;
+
+            Sponza::Lion lion = {};
+            lion.mPosition = vec3(start, -6.0f + height, 1.0f + lateral);
+            lion.mVelocity = (i % 2) ? -50.0f : 50.0f;
+            lion.mRotation = float(i) * 0.7f;
+            gSponza.mLions.push_back(lion);
         }
     }
+    static mat4 getLionToWorld(const Sponza::Lion & lion)
+    {
+        static mat4 lionTransform = mat4::scale({0.2f, 0.2f, -0.2f}) * mat4::identity();
+        return mat4::translation(lion.mPosition) * mat4::rotationY(lion.mRotation) * lionTransform;
+    }
+    // Index of an instance in the slice of the current frame
+    static uint32_t getInstanceOffset(uint32_t instance)
+    {
+        return gFrameIndex * Sponza::MAX_INSTANCES + instance;
+    }
     bool loadGBufferPass()
     {
+        gVelocityEncodingLoaded = gVelocityEncoding;
         if (!addGBuffers())
             return false;
 
@@ -746,6 +1457,34 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
             graphicsPipelineDesc.pVertexLayout = &gVertexLayout;
             graphicsPipelineDesc.pRasterizerState = &rasterizerStateDesc;
             addPipeline(pRenderer, &pipelineDesc, &gGBufferPass.pPipeline);
+
+            pipelineDesc.pName = "GBuffer Skinned Pipeline";
+            graphicsPipelineDesc.pShaderProgram = gGBufferPass.pSkinnedShader;
+            graphicsPipelineDesc.pVertexLayout = &gSkinnedVertexLayout;
+            addPipeline(pRenderer, &pipelineDesc, &gGBufferPass.pSkinnedPipeline);
+
+            graphicsPipelineDesc.pVertexLayout = &gVertexLayout;
+
+            // Static geometry leaves the velocity target alone
+            BlendStateDesc blendStateDesc = {};
+            for (uint32_t i = 0; i < GBUFFER_RT_COUNT; ++i)
+            {
+                blendStateDesc.mSrcFactors[i] = BC_ONE;
+                blendStateDesc.mDstFactors[i] = BC_ZERO;
+                blendStateDesc.mSrcAlphaFactors[i] = BC_ONE;
+                blendStateDesc.mDstAlphaFactors[i] = BC_ZERO;
+                blendStateDesc.mBlendModes[i] = BM_ADD;
+                blendStateDesc.mBlendAlphaModes[i] = BM_ADD;
+                blendStateDesc.mMasks[i] = ALL;
+            }
+            blendStateDesc.mMasks[2] = NONE;
+            blendStateDesc.mRenderTargetMask = BLEND_STATE_TARGET_0 | BLEND_STATE_TARGET_1 | BLEND_STATE_TARGET_2;
+            blendStateDesc.mIndependentBlend = true;
+
+            pipelineDesc.pName = "GBuffer Static Pipeline";
+            graphicsPipelineDesc.pShaderProgram = gGBufferPass.pStaticShader;
+            graphicsPipelineDesc.pBlendState = &blendStateDesc;
+            addPipeline(pRenderer, &pipelineDesc, &gGBufferPass.pStaticPipeline);
         }
 
         // Prepare descriptor sets
@@ -764,13 +1503,16 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
             {
                 for (uint32_t i = 0; i < gImageCount; ++i)
                 {
-                    constexpr uint32_t PARAMS_COUNT = 2;
+                    constexpr uint32_t PARAMS_COUNT = 3;
                     DescriptorData params[PARAMS_COUNT] = {};
                     params[0].pName = "envUniformBlock";
                     params[0].ppBuffers = &gEnv.pUniformBuffer[i];
 
-                    params[1].pName = "objectsUniformBlock";
-                    params[1].ppBuffers = &gSponza.pUniformBuffer[i];
+                    params[1].pName = "objectsBuffer";
+                    params[1].ppBuffers = &gSponza.pInstanceBuffer;
+
+                    params[2].pName = "paletteBuffer";
+                    params[2].ppBuffers = &gCharacters.pPaletteBuffer;
 
                     updateDescriptorSet(pRenderer, i, gGBufferPass.pDescriptorSets_PerFrame, PARAMS_COUNT, params);
                 }
@@ -781,6 +1523,8 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
     }
     void unloadGBufferPass()
     {
+        removePipeline(pRenderer, gGBufferPass.pSkinnedPipeline);
+        removePipeline(pRenderer, gGBufferPass.pStaticPipeline);
         removePipeline(pRenderer, gGBufferPass.pPipeline);
 
         removeRenderTarget(pRenderer, gGBufferPass.pColorRT);
@@ -790,10 +1534,15 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
     }
     void destroyGBufferPass()
     { 
-        for (uint32_t i = 0; i < gImageCount; ++i)
-        {
-            removeResource(gSponza.pUniformBuffer[i]);
-        }
+        removeResource(gSponza.pInstanceBuffer);
+        removeResource(gCharacters.pPaletteBuffer);
+        gSponza.mLions.set_capacity(0);
+
+        removeIndirectCommandSignature(pRenderer, gGBufferPass.pCommandSignature);
+        removeResource(gSponza.pIndirectBuffer);
+        gSponza.mDrawOrder.set_capacity(0);
+        gSponza.mVisibleDraws.set_capacity(0);
+        gSponza.mDrawBoxes = CullingBoxes();
 
         for (uint32_t i = 0; i < Sponza::TOTAL_MODELS; ++i)
         {
@@ -803,6 +1552,8 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
         removeDescriptorSet(pRenderer, gGBufferPass.pDescriptorSets_NonFreq);
         removeDescriptorSet(pRenderer, gGBufferPass.pDescriptorSets_PerFrame);
 
+        removeShader(pRenderer, gGBufferPass.pSkinnedShader);
+        removeShader(pRenderer, gGBufferPass.pStaticShader);
         removeShader(pRenderer, gGBufferPass.pShader);
         removeRootSignature(pRenderer, gGBufferPass.pRootSignature);
 
@@ -856,12 +1607,15 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
             RenderTargetDesc velocityRT = {};
             velocityRT.mArraySize = 1;
             velocityRT.mClearValue = { { 1.0f, 0.0f, 0.0f, 1.0f } };
+            // Resting at 0, the unit velocity of the half float clear would decode to the far corner of the fixed point range
+            if (VELOCITY_ENCODING_FIXED_8 == gVelocityEncodingLoaded)
+                velocityRT.mClearValue = { { 128.0f / 255.0f, 128.0f / 255.0f, 0.0f, 1.0f } };
             velocityRT.mDepth = 1;
-            velocityRT.mDescriptors = DESCRIPTOR_TYPE_TEXTURE;
+            velocityRT.mDescriptors = DESCRIPTOR_TYPE_TEXTURE | DESCRIPTOR_TYPE_RW_TEXTURE;
             velocityRT.mWidth	= mSettings.mWidth;
             velocityRT.mHeight	= mSettings.mHeight;
             velocityRT.mSampleCount = SAMPLE_COUNT_1;
-            velocityRT.mFormat = TinyImageFormat_R16G16_SFLOAT;
+            velocityRT.mFormat = getVelocityEncodingFormat(VelocityEncoding(gVelocityEncodingLoaded));
             velocityRT.mSampleQuality = 0;
             velocityRT.mStartState = RESOURCE_STATE_SHADER_RESOURCE;
             velocityRT.pName = "Velocity RT";
@@ -890,20 +1644,15 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
 
         return gGBufferPass.pDepthBuffer != NULL;
     }
-    void drawGBufferPass(Cmd * cmd)
-    {   
+    // Transitions and clears the G-buffer, the draws are recorded by drawGBufferRange
+    void beginGBufferPass(Cmd * cmd)
+    {
         RenderTarget * colorBuffer	  = gGBufferPass.pColorRT;
         RenderTarget * normBuffer	  = gGBufferPass.pNormRT;
         RenderTarget * velocityBuffer = gGBufferPass.pVelocityRT;
         RenderTarget * depthBuffer	  = gGBufferPass.pDepthBuffer;
 
-        RenderTargetBarrier barriers[] =
-        {
-            { colorBuffer,	  RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_RENDER_TARGET },
-            { normBuffer,	  RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_RENDER_TARGET },
-            { velocityBuffer, RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_RENDER_TARGET },
-        };
-        cmdResourceBarrier(cmd, 0, NULL, 0, NULL, 3, barriers);
+        cmdFrameGraphBarriers(cmd, gFrameGraph.mGBufferPass);
         
         // Clear
         {
@@ -914,90 +1663,372 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
             loadActions.mLoadActionsColor[2] = LOAD_ACTION_CLEAR;
             loadActions.mLoadActionDepth	 = LOAD_ACTION_CLEAR;
 
+            // Marks the pixels the camera velocity pass has to fill in
+            if (gCameraVelocityPassActive && VELOCITY_ENCODING_FIXED_8 == gVelocityEncodingLoaded)
+                loadActions.mClearColorValues[2] = { { VELOCITY_UNWRITTEN_FIXED, VELOCITY_UNWRITTEN_FIXED, 0.0f, 0.0f } };
+            else if (gCameraVelocityPassActive)
+                loadActions.mClearColorValues[2] = { { VELOCITY_UNWRITTEN, 0.0f, 0.0f, 0.0f } };
+
             loadActions.mClearDepth = depthBuffer->mClearValue;
             cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "GBuffer");
+            cmdBindRenderTargets(cmd, 3, renderTargets, depthBuffer, &loadActions, NULL, NULL, -1, -1);
+            cmdBindRenderTargets(cmd, 0, NULL, 0, NULL, NULL, NULL, -1, -1);
+        }
+    }
+
+    void endGBufferPass(Cmd * cmd)
+    {
+        cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
+    }
+
+    // Sponza draws first, then the lion and the characters
+    static uint32_t getTotalGBufferDrawCount()
+    {
+        return gSponza.mFirstDraws[Sponza::TOTAL_MODELS];
+    }
+
+    // Draws recorded this frame, see cullGBufferDraws
+    uint32_t getGBufferDrawCount()
+    {
+        return gSponza.mVisibleDrawCount;
+    }
+
+    // Model of a G-buffer draw, and the index of the draw within the draw arguments of that model
+    static uint32_t getDrawModel(uint32_t draw, uint32_t * pModelDraw)
+    {
+        uint32_t model = 0;
+        while (draw >= gSponza.mFirstDraws[model + 1])
+            ++model;
+
+        *pModelDraw = draw - gSponza.mFirstDraws[model];
+        return model;
+    }
+
+    // Every draw of a model is instanced this many times, starting at getModelFirstInstance
+    static uint32_t getModelInstanceCount(uint32_t model)
+    {
+        if (Sponza::LION_MODEL == model)
+            return gSponza.mLionCount;
+        if (Sponza::CHARACTER_MODEL == model)
+            return gCharacters.mCount;
+        return 1;
+    }
+
+    static uint32_t getModelFirstInstance(uint32_t model)
+    {
+        if (Sponza::LION_MODEL == model)
+            return Sponza::FIRST_LION_INSTANCE;
+        if (Sponza::CHARACTER_MODEL == model)
+            return Sponza::FIRST_CHARACTER_INSTANCE;
+        return Sponza::BUILDING_INSTANCE;
+    }
+
+    static uint32_t getCharacterJointCount()
+    {
+        return gSponza.mModels[Sponza::CHARACTER_MODEL]->mJointCount;
+    }
+
+    // Index of the first palette matrix of a character in the slice of the current frame
+    static uint32_t getPaletteOffset(uint32_t character)
+    {
+        return (gFrameIndex * Sponza::MAX_CHARACTERS + character) * 2 * getCharacterJointCount();
+    }
+
+    // Byte offset of an indirect draw in the slice of the current frame
+    static uint64_t getIndirectDrawOffset(uint32_t draw)
+    {
+        return uint64_t(gFrameIndex * getTotalGBufferDrawCount() + draw) * sizeof(IndirectDrawIndexArguments);
+    }
+
+    // Fills gSponza.mVisibleDraws. The lions and characters are spread all over the hall, so only the building draws get culled.
+    void cullGBufferDraws()
+    {
+        uint32_t const sponzaDrawCount = gSponza.mFirstDraws[Sponza::BUILDING_MODEL + 1];
+
+        uint32_t visibleCount = sponzaDrawCount;
+        if (gFrustumCulling)
+        {
+            CullingFrustum frustum;
+            getCullingFrustum(gEnv.mUniformData.mProject * gEnv.mUniformData.mView, &frustum);
+            visibleCount = cullBoxes(&gSponza.mDrawBoxes, &frustum, gSponza.mVisibleDraws.data());
+
+            // Box indices are positions in the material sorted order
+            for (uint32_t i = 0; i < visibleCount; ++i)
+                gSponza.mVisibleDraws[i] = gSponza.mDrawOrder[gSponza.mVisibleDraws[i]];
+        }
+        else
+        {
+            memcpy(gSponza.mVisibleDraws.data(), gSponza.mDrawOrder.data(), sponzaDrawCount * sizeof(uint32_t));
+        }
+
+        for (uint32_t model = Sponza::BUILDING_MODEL + 1; model < Sponza::TOTAL_MODELS; ++model)
+        {
+            if (!getModelInstanceCount(model))
+                continue;
+
+            for (uint32_t draw = gSponza.mFirstDraws[model]; draw < gSponza.mFirstDraws[model + 1]; ++draw)
+                gSponza.mVisibleDraws[visibleCount++] = draw;
+        }
+
+        gSponza.mVisibleDrawCount = visibleCount;
+    }
+
+    // Packed texture ids of a G-buffer draw, and the albedo texture whose resident mip clamps the sampling
+    static uint getDrawTextureMaps(uint32_t model, uint32_t modelDraw, uint32_t * pAlbedoTexture)
+    {
+        // Lion uses the same textures for all of its draws, the characters borrow them and end up as stone statues
+        if (Sponza::BUILDING_MODEL != model)
+        {
+            *pAlbedoTexture = 63;
+            return ((63 & 0xFF) << 0) | ((83 & 0xFF) << 8) | ((6 & 0xFF) << 16) | ((6 & 0xFF) << 24);
+        }
+
+        int materialID = gSponza.mMaterialIds[modelDraw];
+        materialID *= 5;    //because it uses 5 basic textures for redering BRDF
+
+        *pAlbedoTexture = gSponza.mTextureIndexforMaterial[materialID + 0];
+        return ((gSponza.mTextureIndexforMaterial[materialID + 0] & 0xFF) << 0)  |
+               ((gSponza.mTextureIndexforMaterial[materialID + 1] & 0xFF) << 8)  |
+               ((gSponza.mTextureIndexforMaterial[materialID + 2] & 0xFF) << 16) |
+               ((gSponza.mTextureIndexforMaterial[materialID + 3] & 0xFF) << 24);
+    }
+
+    // Records draws [firstDraw, firstDraw + drawCount) into the already cleared G-buffer, safe to call from any thread
+    void drawGBufferRange(Cmd * cmd, uint32_t firstDraw, uint32_t drawCount)
+    {
+        RenderTarget * colorBuffer	  = gGBufferPass.pColorRT;
+        RenderTarget * normBuffer	  = gGBufferPass.pNormRT;
+        RenderTarget * velocityBuffer = gGBufferPass.pVelocityRT;
+        RenderTarget * depthBuffer	  = gGBufferPass.pDepthBuffer;
+
+        // Bind
+        {
+            RenderTarget * renderTargets[] = { colorBuffer, normBuffer, velocityBuffer };
+            LoadActionsDesc loadActions = {};
+            loadActions.mLoadActionsColor[0] = LOAD_ACTION_LOAD;
+            loadActions.mLoadActionsColor[1] = LOAD_ACTION_LOAD;
+            loadActions.mLoadActionsColor[2] = LOAD_ACTION_LOAD;
+            loadActions.mLoadActionDepth	 = LOAD_ACTION_LOAD;
+
             cmdBindRenderTargets(cmd, 3, renderTargets, depthBuffer, &loadActions, NULL, NULL, -1, -1);
             cmdSetViewport(cmd, 0.0f, 0.0f, float(colorBuffer->mWidth), float(colorBuffer->mHeight), 0.0f, 1.0f);
             cmdSetScissor(cmd, 0, 0, colorBuffer->mWidth, colorBuffer->mHeight);
         }
         
-        // Draw
+        // Draw, consecutive draws of the same model and material become one indirect draw when gIndirectDraws is set
         {
-            cmdBindPipeline(cmd, gGBufferPass.pPipeline);
-            cmdBindDescriptorSet(cmd, 0, gGBufferPass.pDescriptorSets_NonFreq);
-            cmdBindDescriptorSet(cmd, gFrameIndex, gGBufferPass.pDescriptorSets_PerFrame);
-            
-            // Draw sponza building
-            {                
-                Geometry & sponzaMesh = *gSponza.mModels[0];
-                uint32_t const drawCount = (uint32_t)sponzaMesh.mDrawArgCount;
+            uint32_t boundModel = ~0u;
+            uint boundTextureMaps = 0;
+            Pipeline * pBoundPipeline = NULL;
+            uint32_t batchStart = firstDraw;
+            for (uint32_t i = firstDraw; i < firstDraw + drawCount; ++i)
+            {
+                uint32_t modelDraw = 0;
+                uint32_t const model = getDrawModel(gSponza.mVisibleDraws[i], &modelDraw);
+                Geometry & mesh = *gSponza.mModels[model];
 
-                Buffer * pSponzaVertexBuffers[] = { sponzaMesh.pVertexBuffers[0] };
-                cmdBindVertexBuffer(cmd, 1, pSponzaVertexBuffers, sponzaMesh.mVertexStrides, NULL);
-                cmdBindIndexBuffer(cmd, sponzaMesh.pIndexBuffer, sponzaMesh.mIndexType, 0);
+                uint32_t albedoTexture = 0;
+                uint const textureMaps = getDrawTextureMaps(model, modelDraw, &albedoTexture);
 
-                for (uint32_t i = 0; i < drawCount; ++i)
+                if (model != boundModel || textureMaps != boundTextureMaps)
                 {
-                    // Set the textureId
+                    drawGBufferIndirect(cmd, batchStart, i);
+                    batchStart = i;
+                }
+
+                if (model != boundModel)
+                {
+                    Pipeline * pPipeline = gGBufferPass.pPipeline;
+                    if (gSponza.mSkinnedModels[model])
+                        pPipeline = gGBufferPass.pSkinnedPipeline;
+                    else if (gCameraVelocityPassActive && gSponza.mStaticModels[model])
+                        pPipeline = gGBufferPass.pStaticPipeline;
+
+                    if (pPipeline != pBoundPipeline)
                     {
-                        int materialID = gSponza.mMaterialIds[i];
-                        materialID *= 5;    //because it uses 5 basic textures for redering BRDF
-
-                        uint textureMaps = ((gSponza.mTextureIndexforMaterial[materialID + 0] & 0xFF) << 0)  |
-                                           ((gSponza.mTextureIndexforMaterial[materialID + 1] & 0xFF) << 8)  |
-                                           ((gSponza.mTextureIndexforMaterial[materialID + 2] & 0xFF) << 16) |
-                                           ((gSponza.mTextureIndexforMaterial[materialID + 3] & 0xFF) << 24);
-                        gGBufferPass.mPushConstant =
-                        {
-                            { float(mSettings.mWidth), float(mSettings.mHeight) },
-                            gTileSize,
-                            textureMaps,
-                            0, // object index
-                            gExposure,
-                            gDeltaTime,
-                        };
-                        cmdBindPushConstants(cmd, gGBufferPass.pRootSignature, "cbRootConstants", &gGBufferPass.mPushConstant);
+                        cmdBindPipeline(cmd, pPipeline);
+                        cmdBindDescriptorSet(cmd, 0, gGBufferPass.pDescriptorSets_NonFreq);
+                        cmdBindDescriptorSet(cmd, gFrameIndex, gGBufferPass.pDescriptorSets_PerFrame);
+                        pBoundPipeline = pPipeline;
                     }
 
-                    IndirectDrawIndexArguments & cmdData = sponzaMesh.pDrawArgs[i];
-                    cmdDrawIndexed(cmd, cmdData.mIndexCount, cmdData.mStartIndex, cmdData.mVertexOffset);
+                    Buffer * pVertexBuffers[] = { mesh.pVertexBuffers[0] };
+                    cmdBindVertexBuffer(cmd, 1, pVertexBuffers, mesh.mVertexStrides, NULL);
+                    cmdBindIndexBuffer(cmd, mesh.pIndexBuffer, mesh.mIndexType, 0);
                 }
-            }
 
-            // Draw lion
-            {
-                // Set the textureId
+                if (model != boundModel || textureMaps != boundTextureMaps)
                 {
-                    uint textureMaps = ((63 & 0xFF) << 0) | ((83 & 0xFF) << 8) | ((6 & 0xFF) << 16) | ((6 & 0xFF) << 24);
-                    gGBufferPass.mPushConstant =
-                    {
-                        { float(mSettings.mWidth), float(mSettings.mHeight) },
-                        gTileSize,
-                        textureMaps,
-                        1, // object index
-                        gExposure,
-                        gDeltaTime,
-                    };
-                    cmdBindPushConstants(cmd, gGBufferPass.pRootSignature, "cbRootConstants", &gGBufferPass.mPushConstant);
+                    bindGBufferPushConstants(cmd, textureMaps, getInstanceOffset(getModelFirstInstance(model)), albedoTexture);
+                    boundModel = model;
+                    boundTextureMaps = textureMaps;
                 }
 
-                Geometry & lionMesh = *gSponza.mModels[1];
-                Buffer * pLionVertexBuffers[] = { lionMesh.pVertexBuffers[0] };
-                cmdBindVertexBuffer(cmd, 1, pLionVertexBuffers, lionMesh.mVertexStrides, NULL);
-                cmdBindIndexBuffer(cmd, lionMesh.pIndexBuffer, lionMesh.mIndexType, 0);
-
-                for (uint32_t i = 0; i < (uint32_t)lionMesh.mDrawArgCount; ++i)
+                if (!gIndirectDraws)
                 {
-                    IndirectDrawIndexArguments& cmdData = lionMesh.pDrawArgs[i];
-                    cmdDrawIndexed(cmd, cmdData.mIndexCount, cmdData.mStartIndex, cmdData.mVertexOffset);
+                    // Every lion (or character) in one draw, the vertex shader picks its transforms with the instance index
+                    IndirectDrawIndexArguments & cmdData = mesh.pDrawArgs[modelDraw];
+                    cmdDrawIndexedInstanced(cmd, cmdData.mIndexCount, cmdData.mStartIndex, getModelInstanceCount(model), cmdData.mVertexOffset, 0);
                 }
             }
+
+            drawGBufferIndirect(cmd, batchStart, firstDraw + drawCount);
         }
 
         cmdBindRenderTargets(cmd, 0, NULL, 0, NULL, NULL, NULL, -1, -1);
-        cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
+    }
+
+    // Visible draws [firstDraw, endDraw) straight from the indirect buffer, they all use the bound state
+    void drawGBufferIndirect(Cmd * cmd, uint32_t firstDraw, uint32_t endDraw)
+    {
+        if (gIndirectDraws && endDraw > firstDraw)
+            cmdExecuteIndirect(cmd, gGBufferPass.pCommandSignature, endDraw - firstDraw, gSponza.pIndirectBuffer, getIndirectDrawOffset(firstDraw), NULL, 0);
+    }
+
+    void bindGBufferPushConstants(Cmd * cmd, uint textureMaps, uint instanceOffset, uint albedoTexture)
+    {
+        GBufferPass::PushConstant pushConstant =
+        {
+            { float(mSettings.mWidth), float(mSettings.mHeight) },
+            gTileSize,
+            textureMaps,
+            instanceOffset,
+            gExposure,
+            gDeltaTime,
+            gSponza.mResidentMips[albedoTexture],
+            getPaletteOffset(0),
+            getCharacterJointCount(),
+        };
+        VelocityEncodingParams velocityParams;
+        getVelocityEncodingParams(VelocityEncoding(gVelocityEncodingLoaded), gTileSize, &velocityParams);
+        pushConstant.velocityEncodeScale = velocityParams.mEncodeScale;
+        pushConstant.velocityEncodeBias = velocityParams.mEncodeBias;
+        cmdBindPushConstants(cmd, gGBufferPass.pRootSignature, "cbRootConstants", &pushConstant);
+    }
+
+    struct GBufferRecordDesc
+    {
+        MotionBlur *    pApp;
+        uint32_t        mCmdCount;
+    };
+
+    // ParallelCmdRecordFunc, every command list gets a contiguous slice of the G-buffer draws
+    static void recordGBufferCmd(void * pUserData, Cmd * cmd, uint32_t cmdIndex)
+    {
+        GBufferRecordDesc * pDesc = (GBufferRecordDesc *)pUserData;
+
+        uint32_t firstDraw = 0;
+        uint32_t drawCount = 0;
+        getParallelCmdRange(pDesc->pApp->getGBufferDrawCount(), pDesc->mCmdCount, cmdIndex, &firstDraw, &drawCount);
+        pDesc->pApp->drawGBufferRange(cmd, firstDraw, drawCount);
     }
     
+    // Camera velocity pass
+    void createCameraVelocityPass()
+    {
+        // Root Sig, sets and shaders
+        {
+            ShaderLoadDesc shader = {};
+            shader.mStages[0] = {"camera_velocity.comp", NULL, 0};
+            addShader(pRenderer, &shader, &gCameraVelocityPass.pShader);
+
+            ShaderMacro fixedMacro = { "VELOCITY_FIXED_8", "1" };
+            shader.mStages[0] = {"camera_velocity.comp", &fixedMacro, 1};
+            addShader(pRenderer, &shader, &gCameraVelocityPass.pFixedShader);
+
+            Shader * shaders[] = { gCameraVelocityPass.pShader, gCameraVelocityPass.pFixedShader };
+
+            RootSignatureDesc rootDesc = {};
+            rootDesc.mShaderCount = sizeof(shaders) / sizeof(shaders[0]);
+            rootDesc.ppShaders = shaders;
+            addRootSignature(pRenderer, &rootDesc, &gCameraVelocityPass.pRootSignature);
+
+            DescriptorSetDesc desc = { gCameraVelocityPass.pRootSignature, DESCRIPTOR_UPDATE_FREQ_PER_FRAME, gImageCount };
+            addDescriptorSet(pRenderer, &desc, &gCameraVelocityPass.pDescriptorSets_PerFrame);
+        }
+    }
+    bool loadCameraVelocityPass()
+    {
+        // Create the pipeline
+        {
+            PipelineDesc pipelineDesc = {};
+            pipelineDesc.pName = "Camera Velocity Pipeline";
+            pipelineDesc.mType = PIPELINE_TYPE_COMPUTE;
+
+            ComputePipelineDesc & computePipelineDesc = pipelineDesc.mComputeDesc;
+            computePipelineDesc.pRootSignature = gCameraVelocityPass.pRootSignature;
+            computePipelineDesc.pShaderProgram = VELOCITY_ENCODING_FIXED_8 == gVelocityEncodingLoaded ?
+                gCameraVelocityPass.pFixedShader : gCameraVelocityPass.pShader;
+            addPipeline(pRenderer, &pipelineDesc, &gCameraVelocityPass.pPipeline);
+        }
+
+        // Prepare descriptor sets
+        {
+            for (uint32_t i = 0; i < gImageCount; ++i)
+            {
+                constexpr uint32_t paramsCount = 3;
+                DescriptorData params[paramsCount] = {};
+                params[0].pName = "envUniformBlock";
+                params[0].ppBuffers = &gEnv.pUniformBuffer[i];
+                params[1].pName = "colorTexture";
+                params[1].ppTextures = &gGBufferPass.pColorRT->pTexture;
+                params[2].pName = "velocityTexture";
+                params[2].ppTextures = &gGBufferPass.pVelocityRT->pTexture;
+
+                updateDescriptorSet(pRenderer, i, gCameraVelocityPass.pDescriptorSets_PerFrame, paramsCount, params);
+            }
+        }
+
+        return true;
+    }
+    void unloadCameraVelocityPass()
+    {
+        removePipeline(pRenderer, gCameraVelocityPass.pPipeline);
+    }
+    void destroyCameraVelocityPass()
+    {
+        removeDescriptorSet(pRenderer, gCameraVelocityPass.pDescriptorSets_PerFrame);
+        removeShader(pRenderer, gCameraVelocityPass.pFixedShader);
+        removeShader(pRenderer, gCameraVelocityPass.pShader);
+        removeRootSignature(pRenderer, gCameraVelocityPass.pRootSignature);
+    }
+    void drawCameraVelocityPass(Cmd * cmd)
+    {
+        RenderTarget * velocityRT = gGBufferPass.pVelocityRT;
+
+        cmdFrameGraphBarriers(cmd, gFrameGraph.mCameraVelocityPass);
+
+        // Draw
+        {
+            cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Camera Velocity Pass");
+            cmdBindPipeline(cmd, gCameraVelocityPass.pPipeline);
+
+            CameraVelocityPass::PushConstant pushConstant =
+            {
+                { float(velocityRT->mWidth), float(velocityRT->mHeight) },
+                gTileSize,
+                gExposure,
+                gDeltaTime,
+            };
+            VelocityEncodingParams velocityParams;
+            getVelocityEncodingParams(VelocityEncoding(gVelocityEncodingLoaded), gTileSize, &velocityParams);
+            pushConstant.velocityEncodeScale = velocityParams.mEncodeScale;
+            pushConstant.velocityEncodeBias = velocityParams.mEncodeBias;
+            pushConstant.velocityDecodeScale = velocityParams.mDecodeScale;
+            pushConstant.velocityDecodeBias = velocityParams.mDecodeBias;
+            cmdBindPushConstants(cmd, gCameraVelocityPass.pRootSignature, "cbRootConstants", &pushConstant);
+
+            cmdBindDescriptorSet(cmd, gFrameIndex, gCameraVelocityPass.pDescriptorSets_PerFrame);
+
+            auto threadGroupSize = gCameraVelocityPass.pShader->pReflection->mStageReflections[0].mNumThreadsPerGroup;
+            uint32_t groupCountX = (velocityRT->mWidth  + threadGroupSize[0] - 1) / threadGroupSize[0];
+            uint32_t groupCountY = (velocityRT->mHeight + threadGroupSize[1] - 1) / threadGroupSize[1];
+            cmdDispatch(cmd, groupCountX, groupCountY, 1);
+        }
+
+        cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
+    }
+
     // Tile pass
     void createTilePass()
     {
@@ -1023,6 +2054,7 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
     }
     bool loadTilePass()
     {
+        gTilePassesFused = gFuseTilePasses;
         if (!addTileBuffer())
             return false;
 
@@ -1038,24 +2070,12 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
             addPipeline(pRenderer, &pipelineDesc, &gTilePass.pPipeline);
         }
 
-        // Prepare descriptor sets
-        {	
-            constexpr uint32_t paramsCount = 2;
-            DescriptorData params[paramsCount] = {};
-            params[0].pName = "outputTexture";
-            params[0].ppTextures = &gTilePass.pTileTexture;
-            params[1].pName = "velocityTexture";
-            params[1].ppTextures = &gGBufferPass.pVelocityRT->pTexture;
-
-            updateDescriptorSet(pRenderer, 0, gTilePass.pDescriptorSets_PerFrame, paramsCount, params);
-        }
-
         return true;
     }
     void unloadTilePass()
     {
         removePipeline(pRenderer, gTilePass.pPipeline);
-        removeResource(gTilePass.pTileTexture);
+        removeTileBuffer();
     }
     void destroyTilePass()
     {
@@ -1063,15 +2083,18 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
         removeShader(pRenderer, gTilePass.pShader);
         removeRootSignature(pRenderer, gTilePass.pRootSignature);
     }
+    // Only needed when the tile and neighbor passes run separately, also binds it to both of them
     bool addTileBuffer()
     {
+        if (gTilePassesFused)
+            return true;
+
         TextureDesc tileRT = {};
         tileRT.mArraySize = 1;
         tileRT.mMipLevels = 1;
         tileRT.mDepth = 1;
         tileRT.mDescriptors = DESCRIPTOR_TYPE_TEXTURE | DESCRIPTOR_TYPE_RW_TEXTURE;
-        tileRT.mWidth	= mSettings.mWidth / int32_t(gTileSize);
-        tileRT.mHeight	= mSettings.mHeight / int32_t(gTileSize);
+        getVelocityTileCount(mSettings.mWidth, mSettings.mHeight, gMinTileSize, &tileRT.mWidth, &tileRT.mHeight);
         tileRT.mSampleCount = SAMPLE_COUNT_1;
         tileRT.mHostVisible = false;
         tileRT.mFormat = TinyImageFormat_R16G16_SFLOAT;
@@ -1083,32 +2106,45 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
         textureDesc.ppTexture = &gTilePass.pTileTexture;
         addResource(&textureDesc, NULL);
 
-        return NULL != gTilePass.pTileTexture;
+        if (!gTilePass.pTileTexture)
+            return false;
+
+        // Prepare descriptor sets
+        {	
+            constexpr uint32_t paramsCount = 2;
+            DescriptorData params[paramsCount] = {};
+            params[0].pName = "outputTexture";
+            params[0].ppTextures = &gTilePass.pTileTexture;
+            params[1].pName = "velocityTexture";
+            params[1].ppTextures = &gGBufferPass.pVelocityRT->pTexture;
+
+            updateDescriptorSet(pRenderer, 0, gTilePass.pDescriptorSets_PerFrame, paramsCount, params);
+        }
+        {
+            DescriptorData params[1] = {};
+            params[0].pName = "tileTexture";
+            params[0].ppTextures = &gTilePass.pTileTexture;
+
+            updateDescriptorSet(pRenderer, 0, gNeighborPass.pDescriptorSets_PerFrame, 1, params);
+        }
+
+        return true;
+    }
+    void removeTileBuffer()
+    {
+        if (gTilePass.pTileTexture)
+            removeResource(gTilePass.pTileTexture);
+        gTilePass.pTileTexture = NULL;
     }
     void drawTilePass(Cmd * cmd)
     {		
-        RenderTarget * colorRT    = gGBufferPass.pColorRT;
         RenderTarget * velocityRT = gGBufferPass.pVelocityRT;
 
-        // Resources barriers
-        {
-            RenderTargetBarrier barriers[] =
-            {
-                { colorRT,	  RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_SHADER_RESOURCE },
-                { velocityRT, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_SHADER_RESOURCE },
-            };
-
-            TextureBarrier textureBarriers[] =
-            {
-                { gTilePass.pTileTexture, RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS },
-            };
-
-            cmdResourceBarrier(cmd, 0, NULL, 1, textureBarriers, 2, barriers);
-        }
+        cmdFrameGraphBarriers(cmd, gFrameGraph.mTilePass);
 
         // Draw
         {
-            cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Tile Pass");
+            gMotionBlurTimers.mTile = cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Tile Pass");
             cmdBindPipeline(cmd, gTilePass.pPipeline);
 
             gPushConstant =
@@ -1117,6 +2153,8 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
                 gTileSize,
                 gSampleCount,
             };
+            setVelocityDecode();
+            setTileCount();
             cmdBindPushConstants(cmd, gTilePass.pRootSignature, "cbRootConstants", &gPushConstant);
 
             cmdBindDescriptorSet(cmd, 0, gTilePass.pDescriptorSets_PerFrame);
@@ -1175,12 +2213,10 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
 
         // Prepare descriptor sets
         {
-            constexpr uint32_t paramsCount = 2;
+            constexpr uint32_t paramsCount = 1;
             DescriptorData params[paramsCount] = {};
             params[0].pName = "outputTexture";
             params[0].ppTextures = &gNeighborPass.pNeighborTexture;
-            params[1].pName = "tileTexture";
-            params[1].ppTextures = &gTilePass.pTileTexture;
 
             updateDescriptorSet(pRenderer, 0, gNeighborPass.pDescriptorSets_PerFrame, paramsCount, params);
         }
@@ -1205,8 +2241,7 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
         neighborRT.mMipLevels = 1;
         neighborRT.mDepth = 1;
         neighborRT.mDescriptors = DESCRIPTOR_TYPE_TEXTURE | DESCRIPTOR_TYPE_RW_TEXTURE;
-        neighborRT.mWidth	= mSettings.mWidth / int32_t(gTileSize);
-        neighborRT.mHeight	= mSettings.mHeight / int32_t(gTileSize);
+        getVelocityTileCount(mSettings.mWidth, mSettings.mHeight, gMinTileSize, &neighborRT.mWidth, &neighborRT.mHeight);
         neighborRT.mSampleCount = SAMPLE_COUNT_1;
         neighborRT.mHostVisible = false;
         neighborRT.mFormat = TinyImageFormat_R16G16_SFLOAT;
@@ -1222,29 +2257,22 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
     }
     void drawNeighborPass(Cmd * cmd)
     {    
-        Texture * tileTexture = gTilePass.pTileTexture;
-        RenderTarget * velocityRT = gGBufferPass.pVelocityRT;
-
-        // Resources barriers
-        {
-            TextureBarrier textureBarriers[] =
-            {
-                { tileTexture,                    RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_SHADER_RESOURCE  },
-                { gNeighborPass.pNeighborTexture, RESOURCE_STATE_SHADER_RESOURCE,  RESOURCE_STATE_UNORDERED_ACCESS },
-            };
-            cmdResourceBarrier(cmd, 0, NULL, 2, textureBarriers, 0, NULL);
-        }
+        cmdFrameGraphBarriers(cmd, gFrameGraph.mNeighborPass);
 
         // Draw
         {
-            cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Neighbor Pass");
+            gMotionBlurTimers.mNeighbor = cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Neighbor Pass");
             cmdBindPipeline(cmd, gNeighborPass.pPipeline);
 
+            gPushConstant = {};
+            setTileCount();
+            cmdBindPushConstants(cmd, gNeighborPass.pRootSignature, "cbRootConstants", &gPushConstant);
+
             cmdBindDescriptorSet(cmd, 0, gNeighborPass.pDescriptorSets_PerFrame);
             
             auto threadGroupSize = gNeighborPass.pShader->pReflection->mStageReflections[0].mNumThreadsPerGroup;
-            uint32_t groupCountX = tileTexture->mWidth  / threadGroupSize[0] + 1;
-            uint32_t groupCountY = tileTexture->mHeight / threadGroupSize[1] + 1;
+            uint32_t groupCountX = uint32_t(gPushConstant.tileCount.getX()) / threadGroupSize[0] + 1;
+            uint32_t groupCountY = uint32_t(gPushConstant.tileCount.getY()) / threadGroupSize[1] + 1;
             cmdDispatch(cmd, groupCountX, groupCountY, 1);
         }
 
@@ -1252,6 +2280,360 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
         cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
     }
     
+    // Fused tile + neighbor pass
+    void createTileNeighborPass()
+    {
+        // Root Sig, sets and shaders
+        {
+            ShaderLoadDesc shader = {};
+            shader.mStages[0] = {"tile_neighbor.comp", NULL, 0};
+            addShader(pRenderer, &shader, &gTileNeighborPass.pShader);
+            Shader * shaders[] = { gTileNeighborPass.pShader };
+
+            RootSignatureDesc rootDesc = {};
+            rootDesc.mStaticSamplerCount = 0;
+            rootDesc.ppStaticSamplerNames = NULL;
+            rootDesc.ppStaticSamplers = NULL;
+            rootDesc.mShaderCount = 1;
+            rootDesc.ppShaders = shaders;
+            addRootSignature(pRenderer, &rootDesc, &gTileNeighborPass.pRootSignature);
+
+            DescriptorSetDesc desc = { gTileNeighborPass.pRootSignature, DESCRIPTOR_UPDATE_FREQ_PER_FRAME, 1 };
+            addDescriptorSet(pRenderer, &desc, &gTileNeighborPass.pDescriptorSets_PerFrame);
+        }
+    }
+    bool loadTileNeighborPass()
+    {
+        // Create the pipeline
+        {
+            PipelineDesc pipelineDesc = {};
+            pipelineDesc.pName = "Tile Neighbor Pipeline";
+            pipelineDesc.mType = PIPELINE_TYPE_COMPUTE;
+
+            ComputePipelineDesc & computePipelineDesc = pipelineDesc.mComputeDesc;
+            computePipelineDesc.pRootSignature = gTileNeighborPass.pRootSignature;
+            computePipelineDesc.pShaderProgram = gTileNeighborPass.pShader;
+            addPipeline(pRenderer, &pipelineDesc, &gTileNeighborPass.pPipeline);
+        }
+
+        // Prepare descriptor sets
+        {
+            constexpr uint32_t paramsCount = 2;
+            DescriptorData params[paramsCount] = {};
+            params[0].pName = "outputTexture";
+            params[0].ppTextures = &gNeighborPass.pNeighborTexture;
+            params[1].pName = "velocityTexture";
+            params[1].ppTextures = &gGBufferPass.pVelocityRT->pTexture;
+
+            updateDescriptorSet(pRenderer, 0, gTileNeighborPass.pDescriptorSets_PerFrame, paramsCount, params);
+        }
+
+        return true;
+    }
+    void unloadTileNeighborPass()
+    {
+        removePipeline(pRenderer, gTileNeighborPass.pPipeline);
+    }
+    void destroyTileNeighborPass()
+    {
+        removeDescriptorSet(pRenderer, gTileNeighborPass.pDescriptorSets_PerFrame);
+        removeShader(pRenderer, gTileNeighborPass.pShader);
+        removeRootSignature(pRenderer, gTileNeighborPass.pRootSignature);
+    }
+    void drawTileNeighborPass(Cmd * cmd)
+    {
+        RenderTarget * velocityRT = gGBufferPass.pVelocityRT;
+
+        cmdFrameGraphBarriers(cmd, gFrameGraph.mTilePass);
+
+        // Draw
+        {
+            gMotionBlurTimers.mTileNeighbor = cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Tile + Neighbor Pass");
+            cmdBindPipeline(cmd, gTileNeighborPass.pPipeline);
+
+            gPushConstant =
+            {
+                { float(1.0f / velocityRT->pTexture->mWidth), float(1.0f / velocityRT->pTexture->mHeight) },
+                gTileSize,
+                gSampleCount,
+            };
+            setVelocityDecode();
+            setTileCount();
+            cmdBindPushConstants(cmd, gTileNeighborPass.pRootSignature, "cbRootConstants", &gPushConstant);
+
+            cmdBindDescriptorSet(cmd, 0, gTileNeighborPass.pDescriptorSets_PerFrame);
+
+            // One thread per neighbor max texel, the workgroup also computes the tiles around it
+            auto threadGroupSize = gTileNeighborPass.pShader->pReflection->mStageReflections[0].mNumThreadsPerGroup;
+            ASSERT(threadGroupSize[0] == VELOCITY_TILES_GROUP_SIZE && threadGroupSize[1] == VELOCITY_TILES_GROUP_SIZE);
+            uint32_t groupCountX = (uint32_t(gPushConstant.tileCount.getX()) + threadGroupSize[0] - 1) / threadGroupSize[0];
+            uint32_t groupCountY = (uint32_t(gPushConstant.tileCount.getY()) + threadGroupSize[1] - 1) / threadGroupSize[1];
+            cmdDispatch(cmd, groupCountX, groupCountY, 1);
+        }
+
+        cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
+    }
+
+    // Jitter
+    void createBlueNoiseTexture()
+    {
+        gBlueNoise.resize(BLUE_NOISE_SIZE * BLUE_NOISE_SIZE);
+        generateBlueNoise(BLUE_NOISE_SIZE, gBlueNoise.data());
+
+        TextureDesc blueNoiseDesc = {};
+        blueNoiseDesc.mArraySize = 1;
+        blueNoiseDesc.mDepth = 1;
+        blueNoiseDesc.mDescriptors = DESCRIPTOR_TYPE_TEXTURE;
+        blueNoiseDesc.mFormat = TinyImageFormat_R16_UNORM;
+        blueNoiseDesc.mHeight = BLUE_NOISE_SIZE;
+        blueNoiseDesc.mMipLevels = 1;
+        blueNoiseDesc.mSampleCount = SAMPLE_COUNT_1;
+        blueNoiseDesc.mStartState = RESOURCE_STATE_COMMON;
+        blueNoiseDesc.mWidth = BLUE_NOISE_SIZE;
+        blueNoiseDesc.pName = "Blue Noise";
+
+        SyncToken token = {};
+        TextureLoadDesc textureDesc = {};
+        textureDesc.pDesc = &blueNoiseDesc;
+        textureDesc.ppTexture = &pBlueNoiseTexture;
+        addResource(&textureDesc, &token);
+        waitForToken(&token);
+
+        TextureUpdateDesc updateDesc = { pBlueNoiseTexture };
+        beginUpdateResource(&updateDesc);
+        for (uint32_t r = 0; r < updateDesc.mRowCount; ++r)
+        {
+            uint16_t * pRow = (uint16_t *)(updateDesc.pMappedData + r * updateDesc.mDstRowStride);
+            for (uint32_t c = 0; c < BLUE_NOISE_SIZE; ++c)
+                pRow[c] = uint16_t(gBlueNoise[r * BLUE_NOISE_SIZE + c] * 65535.0f + 0.5f);
+        }
+        endUpdateResource(&updateDesc, &token);
+        waitForToken(&token);
+    }
+    void destroyBlueNoiseTexture()
+    {
+        removeResource(pBlueNoiseTexture);
+        gBlueNoise.set_capacity(0);
+    }
+    // Runs the reconstruction on the CPU for every jitter mode and logs the lowest S reaching the quality bar
+    static void logJitterQuality()
+    {
+        uint32_t const tileSize = uint32_t(gTileSize);
+        uint32_t const groundTruthSampleCount = 128;
+        uint32_t const maxSampleCount = 32;
+        double const targetPSNR = 35.0;
+
+        ReconstructTestScene scene;
+        generateReconstructTestScene(160, 90, tileSize, &scene);
+        scene.mInput.pBlueNoise = gBlueNoise.data();
+        scene.mInput.mBlueNoiseSize = BLUE_NOISE_SIZE;
+
+        static const char * jitterModeNames[JITTER_MODE_COUNT] = { "Hash", "Interleaved gradient noise", "Blue noise", "R2" };
+        JitterQualityResult results[JITTER_MODE_COUNT];
+        measureJitterQuality(&scene.mInput, groundTruthSampleCount, maxSampleCount, targetPSNR, results);
+
+        LOGF(LogLevel::eINFO, "Jitter quality, K = %u, %.1f dB against S = %u regular taps:", tileSize, targetPSNR, groundTruthSampleCount);
+        for (uint32_t mode = 0; mode < JITTER_MODE_COUNT; ++mode)
+        {
+            const JitterQualityResult & result = results[mode];
+            if (result.mLowestSampleCount)
+                LOGF(LogLevel::eINFO, "    %s: S = %u (%.2f dB)", jitterModeNames[mode], result.mLowestSampleCount, result.mPSNR[result.mLowestSampleCount - 1]);
+            else
+                LOGF(LogLevel::eINFO, "    %s: not reached up to S = %u (%.2f dB)", jitterModeNames[mode], maxSampleCount, result.mPSNR[maxSampleCount - 1]);
+        }
+    }
+
+    // Quantization error of every velocity encoding at the current K, and what it does to the reconstruction
+    static void logVelocityEncodingQuality()
+    {
+        static const char * velocityEncodingNames[VELOCITY_ENCODING_COUNT] = { "Half float", "Fixed point 8:8", "Polar / log 8:8 (CPU only)" };
+        uint32_t const tileSize = uint32_t(gTileSize);
+        uint32_t const sampleCount = uint32_t(gSampleCount);
+
+        LOGF(LogLevel::eINFO, "Velocity encodings, K = %u, reconstruction with S = %u against unquantized velocities:", tileSize, sampleCount);
+        for (uint32_t encoding = 0; encoding < VELOCITY_ENCODING_COUNT; ++encoding)
+        {
+            VelocityQuantizationStats stats;
+            measureVelocityQuantization(VelocityEncoding(encoding), tileSize, sampleCount, &stats);
+            LOGF(LogLevel::eINFO, "    %s, %u bits: mean error %.4f px, max %.4f px (%.2f%% above 1 px), %u of %u flip the early out, %.2f dB",
+                velocityEncodingNames[encoding], stats.mBitsPerPixel, stats.mMeanError, stats.mMaxError, stats.mMaxRelativeError * 100.0,
+                stats.mEarlyOutFlips, stats.mSampleCount, stats.mReconstructPSNR);
+        }
+    }
+
+    // Sample count the temporal reconstruction needs per frame for the quality a single frame gets, with the current jitter mode
+    static void logTemporalQuality()
+    {
+        uint32_t const tileSize = uint32_t(gTileSize);
+        uint32_t const groundTruthSampleCount = 128;
+        uint32_t const maxSampleCount = 32;
+        uint32_t const frameCount = 16;
+        double const targetPSNR = 35.0;
+
+        ReconstructTestScene scene;
+        generateReconstructTestScene(160, 90, tileSize, &scene);
+        scene.mInput.pBlueNoise = gBlueNoise.data();
+        scene.mInput.mBlueNoiseSize = BLUE_NOISE_SIZE;
+
+        // Hash jitter does not change with the frame, there is nothing for the history to add
+        if (JITTER_MODE_HASH == gJitterMode)
+            LOGF(LogLevel::eWARNING, "Hash jitter is the same every frame, use another jitter mode with the temporal reconstruction");
+
+        TemporalQualityResult result;
+        measureTemporalQuality(&scene.mInput, JitterMode(gJitterMode), groundTruthSampleCount, maxSampleCount, frameCount, gTemporalHistoryWeight, targetPSNR, &result);
+
+        LOGF(LogLevel::eINFO, "Temporal quality, K = %u, history weight %.2f, %.1f dB against S = %u regular taps:", tileSize, gTemporalHistoryWeight, targetPSNR, groundTruthSampleCount);
+        LOGF(LogLevel::eINFO, "    Single frame: S = %u", result.mLowestSingleSampleCount);
+        if (result.mLowestTemporalSampleCount)
+            LOGF(LogLevel::eINFO, "    Temporal: S = %u per frame (%.2f dB), divisor %.2f", result.mLowestTemporalSampleCount,
+                result.mTemporalPSNR[result.mLowestTemporalSampleCount - 1], float(max(1u, result.mLowestSingleSampleCount)) / result.mLowestTemporalSampleCount);
+        else
+            LOGF(LogLevel::eINFO, "    Temporal: not reached up to S = %u", maxSampleCount);
+    }
+
+    // Runs the auto-tuner on synthetic timing traces and logs where each one ended up
+    static void logTunerReplay()
+    {
+        MotionBlurTunerReplay results[MOTION_BLUR_TUNER_REPLAY_COUNT];
+        uint32_t const passedCount = replayMotionBlurTunerTraces(results);
+
+        LOGF(passedCount == MOTION_BLUR_TUNER_REPLAY_COUNT ? LogLevel::eINFO : LogLevel::eERROR,
+            "Auto-tune traces: %u of %u passed", passedCount, MOTION_BLUR_TUNER_REPLAY_COUNT);
+        for (const MotionBlurTunerReplay & result : results)
+        {
+            LOGF(result.mPassed ? LogLevel::eINFO : LogLevel::eERROR, "    %s: %s, %u steps, S = %u, K = %u, scale %.3f, %.2f ms",
+                result.pName, result.mPassed ? "passed" : "FAILED", result.mStepCount, result.mSampleCount, result.mTileSize, result.mScale, result.mFinalMs);
+        }
+    }
+
+    // Compares the CPU models of the fused and the two pass tile max + neighbor max on random velocities,
+    // the shaders themselves are not run
+    static void logFusedTileModelComparison()
+    {
+        static const uint32_t resolutions[][2] = { { 160, 90 }, { 333, 217 }, { 640, 360 } };
+
+        uint32_t failCount = 0;
+        for (uint32_t r = 0; r < sizeof(resolutions) / sizeof(resolutions[0]); ++r)
+        {
+            for (uint32_t tileSize = 3; tileSize <= 22; ++tileSize)
+            {
+                uint32_t const mismatchCount = compareFusedNeighborMaxModels(resolutions[r][0], resolutions[r][1], tileSize, r * 100 + tileSize);
+                if (mismatchCount)
+                {
+                    LOGF(LogLevel::eERROR, "    %ux%u, K = %u: %u tiles differ", resolutions[r][0], resolutions[r][1], tileSize, mismatchCount);
+                    ++failCount;
+                }
+            }
+        }
+        LOGF(failCount ? LogLevel::eERROR : LogLevel::eINFO, "Fused tile model comparison: %u of %u configurations differ from the two pass model",
+            failCount, uint32_t(sizeof(resolutions) / sizeof(resolutions[0])) * 20);
+    }
+
+    // Times the culling kernels on random boxes spread over the hall against the current view and logs the results
+    static void logCullingBenchmark()
+    {
+        static const uint32_t boxCounts[] = { 10000, 100000, 1000000 };
+
+        CullingFrustum frustum;
+        getCullingFrustum(gEnv.mUniformData.mProject * gEnv.mUniformData.mView, &frustum);
+
+        LOGF(LogLevel::eINFO, "Frustum culling of random boxes:");
+        for (uint32_t boxCount : boxCounts)
+        {
+            CullingBoxes boxes;
+            generateCullingBenchmarkBoxes(boxCount, 1, &boxes);
+            eastl::vector<uint32_t> visible(boxCount);
+
+            // Enough runs to average out the timer resolution
+            uint32_t const runCount = max(1u, 10000000u / boxCount);
+            uint32_t visibleCount = 0;
+
+            int64_t start = getUSec();
+            for (uint32_t run = 0; run < runCount; ++run)
+                visibleCount = cullBoxes(&boxes, &frustum, visible.data());
+            double const simdTime = double(getUSec() - start) / runCount;
+
+            start = getUSec();
+            for (uint32_t run = 0; run < runCount; ++run)
+                cullBoxesScalar(&boxes, &frustum, visible.data());
+            double const scalarTime = double(getUSec() - start) / runCount;
+
+            LOGF(LogLevel::eINFO, "    %u boxes, %u visible: %.1f us SIMD, %.1f us scalar (%.2f ns per box)",
+                boxCount, visibleCount, simdTime, scalarTime, simdTime * 1000.0 / boxCount);
+        }
+    }
+
+    // Compares cullBoxes against cullBoxesScalar on random boxes and views
+    static void logCullingCheck()
+    {
+        uint32_t const frustumCount = 256;
+        uint32_t const mismatchCount = verifyCullBoxes(10003, frustumCount, 1);
+        LOGF(mismatchCount ? LogLevel::eERROR : LogLevel::eINFO, "SIMD culling check: %u of %u views differ from the scalar version",
+            mismatchCount, frustumCount);
+    }
+
+    // Times AnimationWorld updates of stormtrooper crowds for a range of crowd sizes and worker counts, at the LOD of gCrowdOptions,
+    // and reports what a character costs in memory with the allocator and clip format gCrowdOptions selects
+    static void logAnimationCrowdBenchmark()
+    {
+        static const uint32_t objectCounts[] = { 1000, 2500, 5000, 10000 };
+        static const uint32_t workerCounts[] = { 0, 1, 2, 4, 8 };
+        uint32_t const objectCountCount = sizeof(objectCounts) / sizeof(objectCounts[0]);
+        uint32_t const workerCountCount = sizeof(workerCounts) / sizeof(workerCounts[0]);
+
+        AnimationCrowdTiming timings[objectCountCount * workerCountCount];
+        AnimationCrowdMemory memory;
+        uint32_t const timingCount = benchmarkAnimationCrowd(RD_ANIMATIONS, "stormtrooper/skeleton.ozz", "stormtrooper/animations/dance.ozz",
+            objectCounts, objectCountCount, workerCounts, workerCountCount, 30, &gCrowdOptions, timings, &memory);
+        if (!timingCount)
+        {
+            LOGF(LogLevel::eERROR, "Animation crowd benchmark: loading the clip or an update failed");
+            return;
+        }
+
+        LOGF(LogLevel::eINFO, "Animation crowd memory (%s, %s): %llu bytes per character, %llu bytes of shared clip, %llu bytes of arena blocks",
+            gCrowdOptions.mArenaAllocator ? "arena allocator" : "heap allocator", gCrowdOptions.mMappedClip ? "mapped clip" : "archived clip",
+            (unsigned long long)memory.mBytesPerCharacter, (unsigned long long)memory.mClipBytes, (unsigned long long)memory.mArenaReservedBytes);
+
+        LOGF(LogLevel::eINFO, "Animation crowd, AnimationWorld::Update per frame (update interval %u, offset stride %u, mask joint %d, %s):",
+            gCrowdOptions.mUpdateInterval, gCrowdOptions.mUpdateOffsetStride, gCrowdOptions.mMaskJoint,
+            gCrowdOptions.mPoseBones ? "bones posed" : "bones not posed");
+        for (uint32_t i = 0; i < timingCount; ++i)
+        {
+            // Speedup over the calling thread alone, which comes first
+            double const singleThreadMs = timings[i % objectCountCount].mUpdateMs;
+            LOGF(LogLevel::eINFO, "    %5u objects, %u workers: %.2f ms (%.2fx)", timings[i].mObjectCount, timings[i].mWorkerCount,
+                timings[i].mUpdateMs, singleThreadMs / timings[i].mUpdateMs);
+        }
+    }
+
+    // Times the Vectormath::Batch functions of every backend the CPU supports for a few stream sizes
+    static void logBatchBenchmark()
+    {
+        static const uint32_t elementCounts[] = { 1024, 65536, 1048576 };
+
+        LOGF(LogLevel::eINFO, "Batch math, ns per element (active backend %s):", Vectormath::Batch::getBackendName(Vectormath::Batch::getBackend()));
+        for (uint32_t elementCount : elementCounts)
+        {
+            // Enough runs to average out the timer resolution
+            uint32_t const runCount = max(1u, 10000000u / elementCount);
+
+            BatchBenchmarkTiming timings[Vectormath::Batch::BACKEND_COUNT];
+            benchmarkBatchTransforms(elementCount, runCount, 1, timings);
+            for (const BatchBenchmarkTiming & timing : timings)
+            {
+                char const * pName = Vectormath::Batch::getBackendName(timing.mBackend);
+                if (!timing.mSupported)
+                {
+                    LOGF(LogLevel::eINFO, "    %7u elements, %-7s: not supported", elementCount, pName);
+                    continue;
+                }
+                LOGF(LogLevel::eINFO, "    %7u elements, %-7s: points %.2f, vectors %.2f, boxes %.2f, matrix products %.2f",
+                    elementCount, pName, timing.mTransformPointsNs, timing.mTransformVectorsNs, timing.mTransformAabbsNs, timing.mMulMatricesNs);
+            }
+        }
+    }
+
     // Reconstruct pass
     void createReconstructPass()
     {
@@ -1303,7 +2685,7 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
         {
             for (uint32_t i = 0; i < gImageCount; ++i)
             {
-                constexpr uint32_t paramsCount = 5;
+                constexpr uint32_t paramsCount = 6;
                 DescriptorData params[paramsCount] = {};
 
                 params[0].pName = "envUniformBlock";
@@ -1321,6 +2703,9 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
                 params[4].pName = "neighborTexture";
                 params[4].ppTextures = &gNeighborPass.pNeighborTexture;
 
+                params[5].pName = "blueNoiseTexture";
+                params[5].ppTextures = &pBlueNoiseTexture;
+
                 updateDescriptorSet(pRenderer, i, gReconstructPass.pDescriptorSets, paramsCount, params);
             }
         }
@@ -1329,7 +2714,6 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
     void unloadReconstructPass()
     {
         removePipeline(pRenderer, gReconstructPass.pPipeline);
-        removeSwapChain(pRenderer, pSwapChain);
     }
     void destroyReconstructPass()
     {
@@ -1337,6 +2721,297 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
         removeShader(pRenderer, gReconstructPass.pShader);
         removeRootSignature(pRenderer, gReconstructPass.pRootSignature);
     }
+
+    // Reconstruct pass (compute)
+    void createReconstructComputePass()
+    {
+        // Root Sig, sets and shaders
+        {
+            ShaderLoadDesc shader = {};
+            shader.mStages[0] = {"reconstruct.comp", NULL, 0};
+            addShader(pRenderer, &shader, &gReconstructComputePass.pShader);
+
+            ShaderMacro temporalMacro = { "TEMPORAL", "1" };
+            shader.mStages[0] = {"reconstruct.comp", &temporalMacro, 1};
+            addShader(pRenderer, &shader, &gReconstructComputePass.pTemporalShader);
+
+            // Shared, so both variants use the same descriptor sets
+            Shader * shaders[] = { gReconstructComputePass.pShader, gReconstructComputePass.pTemporalShader };
+
+            RootSignatureDesc rootDesc = {};
+            rootDesc.mStaticSamplerCount = SAMPLERS_COUNT;
+            rootDesc.ppStaticSamplerNames = pStaticSamplersNames;
+            rootDesc.ppStaticSamplers = pStaticSamplers;
+            rootDesc.mShaderCount = sizeof(shaders) / sizeof(shaders[0]);
+            rootDesc.ppShaders = shaders;
+            addRootSignature(pRenderer, &rootDesc, &gReconstructComputePass.pRootSignature);
+
+            DescriptorSetDesc desc = { gReconstructComputePass.pRootSignature, DESCRIPTOR_UPDATE_FREQ_PER_FRAME, 2 };
+            addDescriptorSet(pRenderer, &desc, &gReconstructComputePass.pDescriptorSets);
+        }
+
+        // Blit
+        {
+            ShaderLoadDesc shader = {};
+            shader.mStages[0] = {"reconstruct.vert", NULL, 0};
+            shader.mStages[1] = {"blit.frag", NULL, 0};
+            addShader(pRenderer, &shader, &gReconstructComputePass.pBlitShader);
+            Shader * shaders[] = { gReconstructComputePass.pBlitShader };
+
+            RootSignatureDesc rootDesc = {};
+            rootDesc.mStaticSamplerCount = 1;
+            rootDesc.ppStaticSamplerNames = &pStaticSamplersNames[1];
+            rootDesc.ppStaticSamplers = &pStaticSamplers[1];
+            rootDesc.mShaderCount = 1;
+            rootDesc.ppShaders = shaders;
+            addRootSignature(pRenderer, &rootDesc, &gReconstructComputePass.pBlitRootSignature);
+
+            DescriptorSetDesc desc = { gReconstructComputePass.pBlitRootSignature, DESCRIPTOR_UPDATE_FREQ_PER_FRAME, 1 };
+            addDescriptorSet(pRenderer, &desc, &gReconstructComputePass.pBlitDescriptorSets);
+        }
+    }
+    bool loadReconstructComputePass()
+    {
+        gReconstructUsesCompute = gComputeReconstruct;
+        gTemporalReconstructActive = gTemporalReconstruct;
+        if (!addReconstructBuffer())
+            return false;
+
+        // Create the pipelines
+        {
+            PipelineDesc pipelineDesc = {};
+            pipelineDesc.pName = "Reconstruct Compute Pipeline";
+            pipelineDesc.mType = PIPELINE_TYPE_COMPUTE;
+
+            ComputePipelineDesc & computePipelineDesc = pipelineDesc.mComputeDesc;
+            computePipelineDesc.pRootSignature = gReconstructComputePass.pRootSignature;
+            computePipelineDesc.pShaderProgram = gReconstructComputePass.pShader;
+            addPipeline(pRenderer, &pipelineDesc, &gReconstructComputePass.pPipeline);
+
+            pipelineDesc.pName = "Reconstruct Temporal Pipeline";
+            computePipelineDesc.pShaderProgram = gReconstructComputePass.pTemporalShader;
+            addPipeline(pRenderer, &pipelineDesc, &gReconstructComputePass.pTemporalPipeline);
+        }
+        {
+            RasterizerStateDesc rasterizerStateDesc = {};
+            rasterizerStateDesc.mCullMode = CULL_MODE_NONE;
+
+            PipelineDesc pipelineDesc = {};
+            pipelineDesc.pName = "Blit Pipeline";
+            pipelineDesc.mType = PIPELINE_TYPE_GRAPHICS;
+
+            GraphicsPipelineDesc & graphicsPipelineDesc = pipelineDesc.mGraphicsDesc;
+            graphicsPipelineDesc.mPrimitiveTopo = PRIMITIVE_TOPO_TRI_LIST;
+            graphicsPipelineDesc.mRenderTargetCount = 1;
+            graphicsPipelineDesc.pColorFormats = &pSwapChain->ppRenderTargets[0]->mFormat;
+            graphicsPipelineDesc.mSampleCount = pSwapChain->ppRenderTargets[0]->mSampleCount;
+            graphicsPipelineDesc.mSampleQuality = pSwapChain->ppRenderTargets[0]->mSampleQuality;
+            graphicsPipelineDesc.pRootSignature = gReconstructComputePass.pBlitRootSignature;
+            graphicsPipelineDesc.pShaderProgram = gReconstructComputePass.pBlitShader;
+            graphicsPipelineDesc.pVertexLayout = NULL;
+            graphicsPipelineDesc.pRasterizerState = &rasterizerStateDesc;
+            addPipeline(pRenderer, &pipelineDesc, &gReconstructComputePass.pBlitPipeline);
+        }
+
+        return true;
+    }
+    void unloadReconstructComputePass()
+    {
+        removePipeline(pRenderer, gReconstructComputePass.pBlitPipeline);
+        removePipeline(pRenderer, gReconstructComputePass.pTemporalPipeline);
+        removePipeline(pRenderer, gReconstructComputePass.pPipeline);
+        removeReconstructBuffer();
+    }
+    void destroyReconstructComputePass()
+    {
+        removeDescriptorSet(pRenderer, gReconstructComputePass.pBlitDescriptorSets);
+        removeShader(pRenderer, gReconstructComputePass.pBlitShader);
+        removeRootSignature(pRenderer, gReconstructComputePass.pBlitRootSignature);
+
+        removeDescriptorSet(pRenderer, gReconstructComputePass.pDescriptorSets);
+        removeShader(pRenderer, gReconstructComputePass.pTemporalShader);
+        removeShader(pRenderer, gReconstructComputePass.pShader);
+        removeRootSignature(pRenderer, gReconstructComputePass.pRootSignature);
+    }
+    // Only needed when the reconstruction runs in compute, also binds it to the compute and blit passes
+    bool addReconstructBuffer()
+    {
+        if (!gReconstructUsesCompute)
+            return true;
+
+        TextureDesc reconstructRT = {};
+        reconstructRT.mArraySize = 1;
+        reconstructRT.mMipLevels = 1;
+        reconstructRT.mDepth = 1;
+        reconstructRT.mDescriptors = DESCRIPTOR_TYPE_TEXTURE | DESCRIPTOR_TYPE_RW_TEXTURE;
+        reconstructRT.mWidth	= mSettings.mWidth;
+        reconstructRT.mHeight	= mSettings.mHeight;
+        reconstructRT.mSampleCount = SAMPLE_COUNT_1;
+        reconstructRT.mHostVisible = false;
+        // Linear like the color the graphics path writes, the sRGB conversion happens when blitting to the back buffer
+        reconstructRT.mFormat = TinyImageFormat_R16G16B16A16_SFLOAT;
+        reconstructRT.mStartState = RESOURCE_STATE_SHADER_RESOURCE;
+        reconstructRT.pName = "Reconstruct RT";
+
+        TextureLoadDesc textureDesc = {};
+        textureDesc.pDesc = &reconstructRT;
+        textureDesc.ppTexture = &gReconstructComputePass.pOutputTexture;
+        addResource(&textureDesc, NULL);
+
+        if (!gReconstructComputePass.pOutputTexture)
+            return false;
+
+        // Depth, velocity and the averaged taps of every pixel, packed like the shared cache of reconstruct.comp
+        if (gTemporalReconstructActive)
+        {
+            TextureDesc historyRT = reconstructRT;
+            historyRT.mFormat = TinyImageFormat_R32G32B32A32_UINT;
+            for (uint32_t i = 0; i < 2; ++i)
+            {
+                historyRT.pName = i ? "History RT 1" : "History RT 0";
+                textureDesc.pDesc = &historyRT;
+                textureDesc.ppTexture = &gReconstructComputePass.pHistoryTextures[i];
+                addResource(&textureDesc, NULL);
+
+                if (!gReconstructComputePass.pHistoryTextures[i])
+                    return false;
+            }
+        }
+        // Nothing in them yet
+        gReconstructComputePass.mHistoryIndex = 0;
+        gReconstructComputePass.mHistoryValid = false;
+
+        // Prepare descriptor sets, set i writes history i and reads the other one
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            constexpr uint32_t paramsCount = 7;
+            DescriptorData params[paramsCount] = {};
+            params[0].pName = "colorTexture";
+            params[0].ppTextures = &gGBufferPass.pColorRT->pTexture;
+            params[1].pName = "velocityTexture";
+            params[1].ppTextures = &gGBufferPass.pVelocityRT->pTexture;
+            params[2].pName = "neighborTexture";
+            params[2].ppTextures = &gNeighborPass.pNeighborTexture;
+            params[3].pName = "outputTexture";
+            params[3].ppTextures = &gReconstructComputePass.pOutputTexture;
+            params[4].pName = "blueNoiseTexture";
+            params[4].ppTextures = &pBlueNoiseTexture;
+            params[5].pName = "historyTexture";
+            params[5].ppTextures = &gReconstructComputePass.pHistoryTextures[1 - i];
+            params[6].pName = "historyOutputTexture";
+            params[6].ppTextures = &gReconstructComputePass.pHistoryTextures[i];
+
+            // Only the temporal variant has the history bindings
+            uint32_t const count = gTemporalReconstructActive ? paramsCount : paramsCount - 2;
+            updateDescriptorSet(pRenderer, i, gReconstructComputePass.pDescriptorSets, count, params);
+        }
+        {
+            DescriptorData params[1] = {};
+            params[0].pName = "reconstructTexture";
+            params[0].ppTextures = &gReconstructComputePass.pOutputTexture;
+
+            updateDescriptorSet(pRenderer, 0, gReconstructComputePass.pBlitDescriptorSets, 1, params);
+        }
+
+        return true;
+    }
+    void removeReconstructBuffer()
+    {
+        if (gReconstructComputePass.pOutputTexture)
+            removeResource(gReconstructComputePass.pOutputTexture);
+        gReconstructComputePass.pOutputTexture = NULL;
+
+        for (Texture *& pHistoryTexture : gReconstructComputePass.pHistoryTextures)
+        {
+            if (pHistoryTexture)
+                removeResource(pHistoryTexture);
+            pHistoryTexture = NULL;
+        }
+    }
+    void drawReconstructComputePass(Cmd * cmd, uint32_t swapchainImageIndex)
+    {
+        auto renderTarget = pSwapChain->ppRenderTargets[swapchainImageIndex];
+        Texture * outputTexture = gReconstructComputePass.pOutputTexture;
+
+        // Only the top left corner gets filtered below full resolution, reconstruct.comp computes the same size
+        uint32_t const outputWidth  = uint32_t(ceilf(outputTexture->mWidth  * gReconstructScale));
+        uint32_t const outputHeight = uint32_t(ceilf(outputTexture->mHeight * gReconstructScale));
+
+        // The history is kept at full resolution, a scaled frame breaks it
+        bool const temporal = gTemporalReconstructActive && gReconstructScale >= 1.0f;
+        uint32_t const historyIndex = gReconstructComputePass.mHistoryIndex;
+        uint32_t const temporalSampleCount = max(1u, uint32_t(gSampleCount) / max(1u, gTemporalSampleDivisor));
+
+        cmdFrameGraphBarriers(cmd, gFrameGraph.mReconstructPass);
+
+        // Draw
+        {
+            gMotionBlurTimers.mReconstructCompute = cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Reconstruct Pass (Compute)");
+            cmdBindPipeline(cmd, temporal ? gReconstructComputePass.pTemporalPipeline : gReconstructComputePass.pPipeline);
+
+            gPushConstant =
+            {
+                { float(1.0f / gGBufferPass.pVelocityRT->mWidth), float(1.0f / gGBufferPass.pVelocityRT->mHeight) },
+                gTileSize,
+                temporal ? float(temporalSampleCount) : gSampleCount,
+                gJitterMode,
+                gFrameCounter,
+                gReconstructScale,
+                temporal && gReconstructComputePass.mHistoryValid ? gTemporalHistoryWeight : 0.0f,
+                // The velocity target holds half the motion over the exposure
+                2.0f * gDeltaTime / gExposure,
+                gSampleCount,
+            };
+            setVelocityDecode();
+            setTileCount();
+            // Inverse of the view depth is linear in the depth target value with a [0, 1] depth range
+            gPushConstant.depthLinearize = vec2(1.0f / gCameraNear, -(gCameraFar - gCameraNear) / (gCameraNear * gCameraFar));
+            cmdBindPushConstants(cmd, gReconstructComputePass.pRootSignature, "cbRootConstants", &gPushConstant);
+
+            cmdBindDescriptorSet(cmd, historyIndex, gReconstructComputePass.pDescriptorSets);
+
+            auto threadGroupSize = gReconstructComputePass.pShader->pReflection->mStageReflections[0].mNumThreadsPerGroup;
+            uint32_t groupCountX = (outputWidth  + threadGroupSize[0] - 1) / threadGroupSize[0];
+            uint32_t groupCountY = (outputHeight + threadGroupSize[1] - 1) / threadGroupSize[1];
+            cmdDispatch(cmd, groupCountX, groupCountY, 1);
+        }
+
+        // What got written becomes the history of the next frame
+        if (temporal)
+            gReconstructComputePass.mHistoryIndex = 1 - historyIndex;
+        gReconstructComputePass.mHistoryValid = temporal;
+
+        // Copy to the back buffer
+        {
+            cmdFrameGraphBarriers(cmd, gFrameGraph.mBlitPass);
+
+            LoadActionsDesc loadActions = {};
+            loadActions.mLoadActionsColor[0] = LOAD_ACTION_DONTCARE;
+            cmdBindRenderTargets(cmd, 1, &renderTarget, NULL, &loadActions, NULL, NULL, -1, -1);
+            cmdSetViewport(cmd, 0.0f, 0.0f, float(renderTarget->mWidth), float(renderTarget->mHeight), 0.0f, 1.0f);
+            cmdSetScissor(cmd, 0, 0, renderTarget->mWidth, renderTarget->mHeight);
+
+            // Stretches the filtered corner over the back buffer, without filtering in the stale texels next to it
+            struct
+            {
+                vec2 uvScale;
+                vec2 uvMax;
+            } blitConstants =
+            {
+                { gReconstructScale, gReconstructScale },
+                { (outputWidth - 0.5f) / outputTexture->mWidth, (outputHeight - 0.5f) / outputTexture->mHeight },
+            };
+
+            cmdBindPipeline(cmd, gReconstructComputePass.pBlitPipeline);
+            cmdBindPushConstants(cmd, gReconstructComputePass.pBlitRootSignature, "cbRootConstants", &blitConstants);
+            cmdBindDescriptorSet(cmd, 0, gReconstructComputePass.pBlitDescriptorSets);
+            cmdDraw(cmd, 3, 0);
+        }
+
+        cmdBindRenderTargets(cmd, 0, NULL, 0, NULL, NULL, NULL, -1, -1);
+        cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
+    }
+
     bool addSwapChain()
     {
         SwapChainDesc swapChainDesc = {};
@@ -1356,27 +3031,13 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
     {   
         auto renderTarget = pSwapChain->ppRenderTargets[swapchainImageIndex];
 
-        // Resources barriers
-        {
-            RenderTargetBarrier barriers[] =
-            {
-                { gGBufferPass.pNormRT, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_SHADER_RESOURCE },
-                { renderTarget,         RESOURCE_STATE_PRESENT,       RESOURCE_STATE_RENDER_TARGET   },
-            };
-
-            TextureBarrier textureBarriers[] =
-            {
-                { gNeighborPass.pNeighborTexture, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_SHADER_RESOURCE },
-            };
-
-            cmdResourceBarrier(cmd, 0, NULL, 1, textureBarriers, 2, barriers); // Other RTs are already in the correct state from previous passes
-        }
+        cmdFrameGraphBarriers(cmd, gFrameGraph.mReconstructPass);
 
         // Clear
         {
             LoadActionsDesc loadActions = {};
             loadActions.mLoadActionsColor[0] = LOAD_ACTION_CLEAR;
-            cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Reconstruct Pass");
+            gMotionBlurTimers.mReconstruct = cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Reconstruct Pass");
             cmdBindRenderTargets(cmd, 1, &renderTarget, NULL, &loadActions, NULL, NULL, -1, -1);
             cmdSetViewport(cmd, 0.0f, 0.0f, float(renderTarget->mWidth), float(renderTarget->mHeight), 0.0f, 1.0f);
             cmdSetScissor(cmd, 0, 0, renderTarget->mWidth, renderTarget->mHeight);
@@ -1391,7 +3052,11 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
                 { float(1.0f / gGBufferPass.pVelocityRT->mWidth), float(1.0f / gGBufferPass.pVelocityRT->mHeight) },
                 gTileSize,
                 gSampleCount,
+                gJitterMode,
+                gFrameCounter,
             };
+            setVelocityDecode();
+            setTileCount();
             cmdBindPushConstants(cmd, gReconstructPass.pRootSignature, "cbRootConstants", &gPushConstant);
 
             cmdBindDescriptorSet(cmd, gFrameIndex, gReconstructPass.pDescriptorSets);
@@ -1402,13 +3067,288 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
         cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
     }
 
+    // Frame time budget
+    static float getMotionBlurTimerMs(ProfileToken timer)
+    {
+        return PROFILE_INVALID_TOKEN == timer ? -1.0f : getGpuProfileTime(timer);
+    }
+    void updateMotionBlurTuning()
+    {
+        // Starts over from the sliders whenever it gets enabled, or the reconstruction path it measures changes
+        if (gAutoTune != gAutoTuneActive || (gAutoTune && gAutoTuneCompute != gReconstructUsesCompute))
+        {
+            gAutoTuneActive = gAutoTune;
+            gAutoTuneCompute = gReconstructUsesCompute;
+
+            MotionBlurTunerSettings settings = {};
+            settings.mBudgetMs = gMotionBlurBudget;
+            settings.mLatencyFrames = gImageCount;
+            // Only the compute reconstruction can filter below full resolution
+            if (!gReconstructUsesCompute)
+                settings.mMinScale = 1.0f;
+            initMotionBlurTuner(&gMotionBlurTuner, &settings, uint32_t(gSampleCount), uint32_t(gTileSize),
+                gReconstructUsesCompute ? gReconstructScale : 1.0f);
+        }
+
+        if (!gAutoTune)
+            return;
+
+        gMotionBlurTuner.mSettings.mBudgetMs = gMotionBlurBudget;
+
+        MotionBlurTunerTimes times;
+        if (gTilePassesFused)
+        {
+            times.mTileMs = getMotionBlurTimerMs(gMotionBlurTimers.mTileNeighbor);
+            times.mNeighborMs = -1.0f;
+        }
+        else
+        {
+            times.mTileMs = getMotionBlurTimerMs(gMotionBlurTimers.mTile);
+            times.mNeighborMs = getMotionBlurTimerMs(gMotionBlurTimers.mNeighbor);
+        }
+        times.mReconstructMs = getMotionBlurTimerMs(gReconstructUsesCompute ? gMotionBlurTimers.mReconstructCompute : gMotionBlurTimers.mReconstruct);
+
+        if (updateMotionBlurTuner(&gMotionBlurTuner, &times))
+        {
+            gSampleCount = float(gMotionBlurTuner.mSampleCount);
+            gTileSize = float(gMotionBlurTuner.mTileSize);
+            gReconstructScale = gMotionBlurTuner.mScale;
+        }
+    }
+    // Every pass reading the velocity target decodes it with these
+    static void setVelocityDecode()
+    {
+        VelocityEncodingParams velocityParams;
+        getVelocityEncodingParams(VelocityEncoding(gVelocityEncodingLoaded), gTileSize, &velocityParams);
+        gPushConstant.velocityDecodeScale = velocityParams.mDecodeScale;
+        gPushConstant.velocityDecodeBias = velocityParams.mDecodeBias;
+    }
+    // The tile and neighbor passes only use this much of their textures, see gMinTileSize
+    void setTileCount()
+    {
+        uint32_t tileWidth, tileHeight;
+        getVelocityTileCount(mSettings.mWidth, mSettings.mHeight, uint32_t(gTileSize), &tileWidth, &tileHeight);
+        gPushConstant.tileCount = vec2(float(tileWidth), float(tileHeight));
+    }
+
+    // Frame graph
+    void addFrameGraph()
+    {
+        FrameGraph * pGraph = &gFrameGraph.mGraph;
+
+        // Resources
+        {
+            auto addTargetResource = [pGraph](const char * pName, RenderTarget * pRT, FrameGraphAccess initialAccess, bool transient)
+            {
+                FrameGraphResourceDesc desc = {};
+                desc.pName = pName;
+                desc.mSize = uint64_t(pRT->mWidth) * pRT->mHeight * (TinyImageFormat_BitSizeOfBlock(pRT->mFormat) / 8);
+                desc.mAlignment = MotionBlurFrameGraph::RESOURCE_ALIGNMENT;
+                desc.mInitialAccess = initialAccess;
+                desc.mTransient = transient;
+                uint32_t index = addFrameGraphResource(pGraph, &desc);
+                gFrameGraph.pRenderTargets[index] = pRT;
+                return index;
+            };
+            auto addTextureResource = [pGraph](const char * pName, Texture * pTexture, FrameGraphAccess initialAccess, bool transient)
+            {
+                FrameGraphResourceDesc desc = {};
+                desc.pName = pName;
+                desc.mSize = uint64_t(pTexture->mWidth) * pTexture->mHeight * (TinyImageFormat_BitSizeOfBlock((TinyImageFormat)pTexture->mFormat) / 8);
+                desc.mAlignment = MotionBlurFrameGraph::RESOURCE_ALIGNMENT;
+                desc.mInitialAccess = initialAccess;
+                desc.mTransient = transient;
+                uint32_t index = addFrameGraphResource(pGraph, &desc);
+                gFrameGraph.pTextures[index] = pTexture;
+                return index;
+            };
+
+            gFrameGraph.mColor      = addTargetResource("Color RT",     gGBufferPass.pColorRT,     FRAME_GRAPH_ACCESS_SHADER_READ, true);
+            gFrameGraph.mNormal     = addTargetResource("Normal RT",    gGBufferPass.pNormRT,      FRAME_GRAPH_ACCESS_SHADER_READ, true);
+            gFrameGraph.mVelocity   = addTargetResource("Velocity RT",  gGBufferPass.pVelocityRT,  FRAME_GRAPH_ACCESS_SHADER_READ, true);
+            gFrameGraph.mDepth      = addTargetResource("Depth Buffer", gGBufferPass.pDepthBuffer, FRAME_GRAPH_ACCESS_DEPTH_WRITE, true);
+            // The fused pass keeps the tiles in shared memory
+            gFrameGraph.mTile       = gTilePassesFused ? FRAME_GRAPH_INVALID_INDEX :
+                                      addTextureResource("Tile RT",     gTilePass.pTileTexture,         FRAME_GRAPH_ACCESS_SHADER_READ, true);
+            gFrameGraph.mNeighbor   = addTextureResource("Neighbor RT", gNeighborPass.pNeighborTexture, FRAME_GRAPH_ACCESS_SHADER_READ, true);
+            gFrameGraph.mReconstruct = gReconstructUsesCompute ?
+                                      addTextureResource("Reconstruct RT", gReconstructComputePass.pOutputTexture, FRAME_GRAPH_ACCESS_SHADER_READ, true) :
+                                      FRAME_GRAPH_INVALID_INDEX;
+            // Has to survive until the next frame, so never aliased
+            bool const temporal = gReconstructUsesCompute && gTemporalReconstructActive;
+            uint32_t const historyIndex = gReconstructComputePass.mHistoryIndex;
+            gFrameGraph.mHistory    = temporal ?
+                                      addTextureResource("History", gReconstructComputePass.pHistoryTextures[1 - historyIndex], FRAME_GRAPH_ACCESS_SHADER_READ, false) :
+                                      FRAME_GRAPH_INVALID_INDEX;
+            gFrameGraph.mHistoryOutput = temporal ?
+                                      addTextureResource("History Output", gReconstructComputePass.pHistoryTextures[historyIndex], FRAME_GRAPH_ACCESS_SHADER_READ, false) :
+                                      FRAME_GRAPH_INVALID_INDEX;
+            // Swapchain image changes every frame, it gets patched in Draw
+            gFrameGraph.mBackBuffer = addTargetResource("Back Buffer",  pSwapChain->ppRenderTargets[0], FRAME_GRAPH_ACCESS_PRESENT, false);
+            ASSERT(pGraph->mResources.size() <= MotionBlurFrameGraph::MAX_RESOURCES);
+
+            for (uint32_t i = 0; i < (uint32_t)pGraph->mResources.size(); ++i)
+            {
+                ResourceState state = toResourceState(pGraph->mResources[i].mDesc.mInitialAccess);
+                if (i == gFrameGraph.mBackBuffer)
+                    continue;
+                else if (gFrameGraph.pRenderTargets[i])
+                    trackRenderTargetState(pStateTracker, gFrameGraph.pRenderTargets[i], state);
+                else
+                    trackTextureState(pStateTracker, gFrameGraph.pTextures[i], state);
+            }
+            for (uint32_t i = 0; i < pSwapChain->mImageCount; ++i)
+            {
+                trackRenderTargetState(pStateTracker, pSwapChain->ppRenderTargets[i], RESOURCE_STATE_PRESENT);
+            }
+        }
+
+        // Passes
+        {
+            gFrameGraph.mGBufferPass = addFrameGraphPass(pGraph, "GBuffer");
+            addFrameGraphAccess(pGraph, gFrameGraph.mGBufferPass, gFrameGraph.mColor,    FRAME_GRAPH_ACCESS_RENDER_TARGET);
+            addFrameGraphAccess(pGraph, gFrameGraph.mGBufferPass, gFrameGraph.mNormal,   FRAME_GRAPH_ACCESS_RENDER_TARGET);
+            addFrameGraphAccess(pGraph, gFrameGraph.mGBufferPass, gFrameGraph.mVelocity, FRAME_GRAPH_ACCESS_RENDER_TARGET);
+            addFrameGraphAccess(pGraph, gFrameGraph.mGBufferPass, gFrameGraph.mDepth,    FRAME_GRAPH_ACCESS_DEPTH_WRITE);
+
+            if (gCameraVelocityPassActive)
+            {
+                gFrameGraph.mCameraVelocityPass = addFrameGraphPass(pGraph, "Camera Velocity Pass");
+                addFrameGraphAccess(pGraph, gFrameGraph.mCameraVelocityPass, gFrameGraph.mColor,    FRAME_GRAPH_ACCESS_SHADER_READ);
+                addFrameGraphAccess(pGraph, gFrameGraph.mCameraVelocityPass, gFrameGraph.mVelocity, FRAME_GRAPH_ACCESS_UNORDERED_ACCESS);
+            }
+            else
+            {
+                gFrameGraph.mCameraVelocityPass = FRAME_GRAPH_INVALID_INDEX;
+            }
+
+            if (gTilePassesFused)
+            {
+                gFrameGraph.mTilePass = addFrameGraphPass(pGraph, "Tile + Neighbor Pass");
+                addFrameGraphAccess(pGraph, gFrameGraph.mTilePass, gFrameGraph.mVelocity, FRAME_GRAPH_ACCESS_SHADER_READ);
+                addFrameGraphAccess(pGraph, gFrameGraph.mTilePass, gFrameGraph.mNeighbor, FRAME_GRAPH_ACCESS_UNORDERED_ACCESS);
+
+                gFrameGraph.mNeighborPass = FRAME_GRAPH_INVALID_INDEX;
+            }
+            else
+            {
+                gFrameGraph.mTilePass = addFrameGraphPass(pGraph, "Tile Pass");
+                addFrameGraphAccess(pGraph, gFrameGraph.mTilePass, gFrameGraph.mVelocity, FRAME_GRAPH_ACCESS_SHADER_READ);
+                addFrameGraphAccess(pGraph, gFrameGraph.mTilePass, gFrameGraph.mTile,     FRAME_GRAPH_ACCESS_UNORDERED_ACCESS);
+
+                gFrameGraph.mNeighborPass = addFrameGraphPass(pGraph, "Neighbor Pass");
+                addFrameGraphAccess(pGraph, gFrameGraph.mNeighborPass, gFrameGraph.mTile,     FRAME_GRAPH_ACCESS_SHADER_READ);
+                addFrameGraphAccess(pGraph, gFrameGraph.mNeighborPass, gFrameGraph.mNeighbor, FRAME_GRAPH_ACCESS_UNORDERED_ACCESS);
+            }
+
+            if (gReconstructUsesCompute)
+            {
+                gFrameGraph.mReconstructPass = addFrameGraphPass(pGraph, "Reconstruct Pass");
+                addFrameGraphAccess(pGraph, gFrameGraph.mReconstructPass, gFrameGraph.mColor,       FRAME_GRAPH_ACCESS_SHADER_READ);
+                addFrameGraphAccess(pGraph, gFrameGraph.mReconstructPass, gFrameGraph.mVelocity,    FRAME_GRAPH_ACCESS_SHADER_READ);
+                addFrameGraphAccess(pGraph, gFrameGraph.mReconstructPass, gFrameGraph.mNeighbor,    FRAME_GRAPH_ACCESS_SHADER_READ);
+                addFrameGraphAccess(pGraph, gFrameGraph.mReconstructPass, gFrameGraph.mReconstruct, FRAME_GRAPH_ACCESS_UNORDERED_ACCESS);
+                if (FRAME_GRAPH_INVALID_INDEX != gFrameGraph.mHistory)
+                {
+                    addFrameGraphAccess(pGraph, gFrameGraph.mReconstructPass, gFrameGraph.mHistory,       FRAME_GRAPH_ACCESS_SHADER_READ);
+                    addFrameGraphAccess(pGraph, gFrameGraph.mReconstructPass, gFrameGraph.mHistoryOutput, FRAME_GRAPH_ACCESS_UNORDERED_ACCESS);
+                }
+
+                gFrameGraph.mBlitPass = addFrameGraphPass(pGraph, "Blit Pass");
+                addFrameGraphAccess(pGraph, gFrameGraph.mBlitPass, gFrameGraph.mReconstruct, FRAME_GRAPH_ACCESS_SHADER_READ);
+                addFrameGraphAccess(pGraph, gFrameGraph.mBlitPass, gFrameGraph.mBackBuffer,  FRAME_GRAPH_ACCESS_RENDER_TARGET);
+            }
+            else
+            {
+                gFrameGraph.mReconstructPass = addFrameGraphPass(pGraph, "Reconstruct Pass");
+                addFrameGraphAccess(pGraph, gFrameGraph.mReconstructPass, gFrameGraph.mColor,      FRAME_GRAPH_ACCESS_SHADER_READ);
+                addFrameGraphAccess(pGraph, gFrameGraph.mReconstructPass, gFrameGraph.mNormal,     FRAME_GRAPH_ACCESS_SHADER_READ);
+                addFrameGraphAccess(pGraph, gFrameGraph.mReconstructPass, gFrameGraph.mVelocity,   FRAME_GRAPH_ACCESS_SHADER_READ);
+                addFrameGraphAccess(pGraph, gFrameGraph.mReconstructPass, gFrameGraph.mNeighbor,   FRAME_GRAPH_ACCESS_SHADER_READ);
+                addFrameGraphAccess(pGraph, gFrameGraph.mReconstructPass, gFrameGraph.mBackBuffer, FRAME_GRAPH_ACCESS_RENDER_TARGET);
+
+                gFrameGraph.mBlitPass = FRAME_GRAPH_INVALID_INDEX;
+            }
+
+            gFrameGraph.mUIPass = addFrameGraphPass(pGraph, "Draw UI");
+            addFrameGraphAccess(pGraph, gFrameGraph.mUIPass, gFrameGraph.mBackBuffer, FRAME_GRAPH_ACCESS_RENDER_TARGET);
+        }
+
+        compileFrameGraph(pGraph);
+
+        LOGF(LogLevel::eINFO, "Frame graph: transient targets need %llu KB, %llu KB when aliased into %u heaps (%llu KB saved)",
+            (unsigned long long)(pGraph->mDedicatedMemory / 1024), (unsigned long long)(pGraph->mAliasedMemory / 1024), (uint32_t)pGraph->mHeaps.size(),
+            (unsigned long long)((pGraph->mDedicatedMemory - pGraph->mAliasedMemory) / 1024));
+    }
+    void removeFrameGraph()
+    {
+        for (uint32_t i = 0; i < (uint32_t)gFrameGraph.mGraph.mResources.size(); ++i)
+        {
+            if (i == gFrameGraph.mBackBuffer)
+                continue;
+            else if (gFrameGraph.pRenderTargets[i])
+                untrackRenderTargetState(pStateTracker, gFrameGraph.pRenderTargets[i]);
+            else
+                untrackTextureState(pStateTracker, gFrameGraph.pTextures[i]);
+        }
+        for (uint32_t i = 0; i < pSwapChain->mImageCount; ++i)
+        {
+            untrackRenderTargetState(pStateTracker, pSwapChain->ppRenderTargets[i]);
+        }
+
+        resetFrameGraph(&gFrameGraph.mGraph);
+        for (uint32_t i = 0; i < MotionBlurFrameGraph::MAX_RESOURCES; ++i)
+        {
+            gFrameGraph.pRenderTargets[i] = NULL;
+            gFrameGraph.pTextures[i] = NULL;
+        }
+    }
+    static ResourceState toResourceState(FrameGraphAccess access)
+    {
+        switch (access)
+        {
+        case FRAME_GRAPH_ACCESS_RENDER_TARGET:    return RESOURCE_STATE_RENDER_TARGET;
+        case FRAME_GRAPH_ACCESS_DEPTH_WRITE:      return RESOURCE_STATE_DEPTH_WRITE;
+        case FRAME_GRAPH_ACCESS_SHADER_READ:      return RESOURCE_STATE_SHADER_RESOURCE;
+        case FRAME_GRAPH_ACCESS_UNORDERED_ACCESS: return RESOURCE_STATE_UNORDERED_ACCESS;
+        case FRAME_GRAPH_ACCESS_PRESENT:          return RESOURCE_STATE_PRESENT;
+        default:                                  return RESOURCE_STATE_UNDEFINED;
+        }
+    }
+    // Requests the states a pass declared in the frame graph, the tracker drops the ones already in place
+    void requestFrameGraphState(uint32_t resource, FrameGraphAccess access)
+    {
+        if (gFrameGraph.pRenderTargets[resource])
+            requestRenderTargetState(pStateTracker, gFrameGraph.pRenderTargets[resource], toResourceState(access));
+        else
+            requestTextureState(pStateTracker, gFrameGraph.pTextures[resource], toResourceState(access));
+    }
+    void cmdFrameGraphBarriers(Cmd * cmd, uint32_t pass)
+    {
+        for (const FrameGraphAccessDesc & access : gFrameGraph.mGraph.mPasses[pass].mAccesses)
+        {
+            requestFrameGraphState(access.mResource, access.mAccess);
+        }
+        cmdFlushResourceStates(cmd, pStateTracker);
+    }
+    void cmdFrameGraphRestoreStates(Cmd * cmd)
+    {
+        for (uint32_t i = 0; i < (uint32_t)gFrameGraph.mGraph.mResources.size(); ++i)
+        {
+            FrameGraphAccess initialAccess = gFrameGraph.mGraph.mResources[i].mDesc.mInitialAccess;
+            if (FRAME_GRAPH_ACCESS_UNDEFINED != initialAccess)
+                requestFrameGraphState(i, initialAccess);
+        }
+        cmdFlushResourceStates(cmd, pStateTracker);
+    }
+
     void loadMesh(size_t index)
     {
         //Load Sponza
         GeometryLoadDesc loadDesc = {};
         loadDesc.pFileName = gSponza.mModelNames[index];
         loadDesc.ppGeometry = &gSponza.mModels[index];
-        loadDesc.pVertexLayout = &gVertexLayout;
+        loadDesc.pVertexLayout = gSponza.mSkinnedModels[index] ? &gSkinnedVertexLayout : &gVertexLayout;
         addResource(&loadDesc, NULL);
     }
 
@@ -1552,9 +3492,27 @@ cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
         TextureLoadDesc textureDesc = {};
         textureDesc.pFileName = MATERIAL_IMAGE_FILE_NAMES[index];
         textureDesc.ppTexture = &gSponza.pMaterialTextures[index];
+        textureDesc.mStreamMips = gStreamTextures;
         addResource(&textureDesc, NULL);
     }
 
+    // Textures used by more draws are likely to cover more of the screen, so they get streamed in first
+    void setTextureStreamingPriorities()
+    {
+        float drawCounts[Sponza::TOTAL_IMAGES] = {};
+        for (uint32_t i = 0; i < sizeof(gSponza.mMaterialIds) / sizeof(gSponza.mMaterialIds[0]); ++i)
+        {
+            uint32_t materialID = gSponza.mMaterialIds[i] * 5;
+            drawCounts[gSponza.mTextureIndexforMaterial[materialID + 0]] += 1.0f;
+        }
+        drawCounts[63] += 1.0f; // lion
+
+        for (uint32_t i = 0; i < Sponza::TOTAL_IMAGES; ++i)
+        {
+            setTextureStreamingPriority(gSponza.pMaterialTextures[i], drawCounts[i]);
+        }
+    }
+
     char const * GetName() { return "Motion Blur"; }
 };
 
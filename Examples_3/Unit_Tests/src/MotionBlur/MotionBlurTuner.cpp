@@ -0,0 +1,264 @@
+#include "MotionBlurTuner.h"
+#include "Random.h"
+
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+
+void initMotionBlurTuner(MotionBlurTuner * pTuner, const MotionBlurTunerSettings * pSettings,
+    uint32_t sampleCount, uint32_t tileSize, float scale)
+{
+    ASSERT(pTuner && pSettings);
+
+    *pTuner = MotionBlurTuner();
+    pTuner->mSettings = *pSettings;
+
+    pTuner->mSampleCount = sampleCount;
+    pTuner->mTileSize = tileSize;
+    pTuner->mScale = scale;
+    pTuner->mMaxSampleCount = sampleCount;
+    pTuner->mMaxTileSize = tileSize;
+    pTuner->mMaxScale = scale;
+
+    // Never below the starting point either, so the tuner can always get back to it
+    MotionBlurTunerSettings & settings = pTuner->mSettings;
+    settings.mMinSampleCount = settings.mMinSampleCount < sampleCount ? settings.mMinSampleCount : sampleCount;
+    settings.mMinTileSize = settings.mMinTileSize < tileSize ? settings.mMinTileSize : tileSize;
+    settings.mMinScale = settings.mMinScale < scale ? settings.mMinScale : scale;
+    ASSERT(settings.mSampleCountStep && settings.mTileSizeStep && settings.mScaleStep > 0.0f);
+
+    pTuner->mUpSettleFrames = settings.mSettleFrames;
+}
+
+// Quality knobs from the cheapest to lose to the most visible
+static bool stepMotionBlurTunerDown(MotionBlurTuner * pTuner)
+{
+    const MotionBlurTunerSettings & settings = pTuner->mSettings;
+
+    if (pTuner->mSampleCount > settings.mMinSampleCount)
+    {
+        uint32_t const step = settings.mSampleCountStep;
+        pTuner->mSampleCount = pTuner->mSampleCount > settings.mMinSampleCount + step ? pTuner->mSampleCount - step : settings.mMinSampleCount;
+        return true;
+    }
+    if (pTuner->mScale > settings.mMinScale)
+    {
+        float const scale = pTuner->mScale - settings.mScaleStep;
+        pTuner->mScale = scale > settings.mMinScale ? scale : settings.mMinScale;
+        return true;
+    }
+    if (pTuner->mTileSize > settings.mMinTileSize)
+    {
+        uint32_t const step = settings.mTileSizeStep;
+        pTuner->mTileSize = pTuner->mTileSize > settings.mMinTileSize + step ? pTuner->mTileSize - step : settings.mMinTileSize;
+        return true;
+    }
+    return false;
+}
+
+static bool stepMotionBlurTunerUp(MotionBlurTuner * pTuner)
+{
+    const MotionBlurTunerSettings & settings = pTuner->mSettings;
+
+    if (pTuner->mTileSize < pTuner->mMaxTileSize)
+    {
+        uint32_t const tileSize = pTuner->mTileSize + settings.mTileSizeStep;
+        pTuner->mTileSize = tileSize < pTuner->mMaxTileSize ? tileSize : pTuner->mMaxTileSize;
+        return true;
+    }
+    if (pTuner->mScale < pTuner->mMaxScale)
+    {
+        float const scale = pTuner->mScale + settings.mScaleStep;
+        pTuner->mScale = scale < pTuner->mMaxScale ? scale : pTuner->mMaxScale;
+        return true;
+    }
+    if (pTuner->mSampleCount < pTuner->mMaxSampleCount)
+    {
+        uint32_t const sampleCount = pTuner->mSampleCount + settings.mSampleCountStep;
+        pTuner->mSampleCount = sampleCount < pTuner->mMaxSampleCount ? sampleCount : pTuner->mMaxSampleCount;
+        return true;
+    }
+    return false;
+}
+
+bool updateMotionBlurTuner(MotionBlurTuner * pTuner, const MotionBlurTunerTimes * pTimes)
+{
+    ASSERT(pTuner && pTimes);
+    const MotionBlurTunerSettings & settings = pTuner->mSettings;
+
+    float const times[] = { pTimes->mTileMs, pTimes->mNeighborMs, pTimes->mReconstructMs };
+    float total = 0.0f;
+    bool measured = false;
+    for (float time : times)
+    {
+        if (time >= 0.0f)
+        {
+            total += time;
+            measured = true;
+        }
+    }
+    if (!measured)
+        return false;
+
+    // Still the times of the parameters before the last step
+    if (pTuner->mLatencyLeft)
+    {
+        --pTuner->mLatencyLeft;
+        return false;
+    }
+
+    if (!pTuner->mSmoothedValid)
+    {
+        pTuner->mSmoothedMs = total;
+        pTuner->mSmoothedValid = true;
+    }
+    else
+    {
+        pTuner->mSmoothedMs += (total - pTuner->mSmoothedMs) * settings.mSmoothing;
+    }
+
+    if (pTuner->mSmoothedMs > settings.mBudgetMs * (1.0f + settings.mHysteresis))
+    {
+        ++pTuner->mOverFrames;
+        pTuner->mUnderFrames = 0;
+    }
+    else if (pTuner->mSmoothedMs < settings.mBudgetMs * (1.0f - settings.mHysteresis))
+    {
+        ++pTuner->mUnderFrames;
+        pTuner->mOverFrames = 0;
+    }
+    else
+    {
+        pTuner->mOverFrames = 0;
+        pTuner->mUnderFrames = 0;
+    }
+
+    int32_t step = 0;
+    if (pTuner->mOverFrames >= settings.mSettleFrames)
+    {
+        pTuner->mOverFrames = 0;
+        if (stepMotionBlurTunerDown(pTuner))
+        {
+            // The last step up did not fit, wait longer before trying it again
+            if (pTuner->mLastStep > 0)
+            {
+                uint32_t const settleFrames = pTuner->mUpSettleFrames * 2;
+                pTuner->mUpSettleFrames = settleFrames < settings.mMaxUpSettleFrames ? settleFrames : settings.mMaxUpSettleFrames;
+            }
+            step = -1;
+        }
+    }
+    else if (pTuner->mUnderFrames >= pTuner->mUpSettleFrames)
+    {
+        pTuner->mUnderFrames = 0;
+        if (stepMotionBlurTunerUp(pTuner))
+        {
+            // The last step up held, so the headroom is real
+            if (pTuner->mLastStep > 0)
+                pTuner->mUpSettleFrames = settings.mSettleFrames;
+            step = 1;
+        }
+    }
+
+    if (!step)
+        return false;
+
+    // Start over with the times of the new parameters
+    pTuner->mLastStep = step;
+    pTuner->mLatencyLeft = settings.mLatencyFrames;
+    pTuner->mSmoothedValid = false;
+    ++pTuner->mStepCount;
+    return true;
+}
+
+// Synthetic GPU for replayMotionBlurTunerTraces, load scales the reconstruction like the amount of blur on screen does
+static float getSyntheticMotionBlurMs(const MotionBlurTuner * pTuner, float load)
+{
+    float const tileMs = 0.1f + 0.8f / float(pTuner->mTileSize);
+    float const reconstructMs = 0.12f * float(pTuner->mSampleCount) * pTuner->mScale * pTuner->mScale * load;
+    return tileMs + reconstructMs;
+}
+
+typedef float (*MotionBlurTunerLoadFn)(uint32_t frame);
+
+static void replayMotionBlurTunerTrace(MotionBlurTuner * pTuner, uint32_t frameCount, MotionBlurTunerLoadFn pLoad, float noise,
+    bool measured, uint32_t * pSeed, MotionBlurTunerReplay * pResult)
+{
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        float const random = randomUnorm(pSeed) * 2.0f - 1.0f;
+
+        MotionBlurTunerTimes times;
+        times.mTileMs = measured ? 0.0f : -1.0f;
+        times.mNeighborMs = -1.0f;
+        times.mReconstructMs = measured ? getSyntheticMotionBlurMs(pTuner, pLoad(frame)) * (1.0f + noise * random) : -1.0f;
+        updateMotionBlurTuner(pTuner, &times);
+    }
+
+    pResult->mStepCount = pTuner->mStepCount;
+    pResult->mSampleCount = pTuner->mSampleCount;
+    pResult->mTileSize = pTuner->mTileSize;
+    pResult->mScale = pTuner->mScale;
+    pResult->mFinalMs = getSyntheticMotionBlurMs(pTuner, pLoad(frameCount - 1));
+}
+
+uint32_t replayMotionBlurTunerTraces(MotionBlurTunerReplay results[MOTION_BLUR_TUNER_REPLAY_COUNT])
+{
+    ASSERT(results);
+
+    MotionBlurTunerSettings settings = {};
+    float const upperMs = settings.mBudgetMs * (1.0f + settings.mHysteresis);
+    uint32_t seed = 1;
+    uint32_t passedCount = 0;
+
+    // S = 16 and K = 20 at full scale take 1.58 ms with a load of 0.75, within 15% of the budget
+    {
+        MotionBlurTunerReplay & result = results[0];
+        result.pName = "Noisy times within the band";
+        MotionBlurTuner tuner;
+        initMotionBlurTuner(&tuner, &settings, 16, 20, 1.0f);
+        replayMotionBlurTunerTrace(&tuner, 10000, [](uint32_t) { return 0.75f; }, 0.2f, true, &seed, &result);
+        result.mPassed = 0 == result.mStepCount;
+    }
+    {
+        MotionBlurTunerReplay & result = results[1];
+        result.pName = "Heavy load";
+        MotionBlurTuner tuner;
+        initMotionBlurTuner(&tuner, &settings, 32, 40, 1.0f);
+        replayMotionBlurTunerTrace(&tuner, 4000, [](uint32_t) { return 4.0f; }, 0.1f, true, &seed, &result);
+        // S goes down first and the scale next, which gets it within the budget without touching K
+        result.mPassed = result.mFinalMs <= upperMs && settings.mMinSampleCount == result.mSampleCount && result.mScale < 1.0f &&
+            40 == result.mTileSize;
+    }
+    {
+        MotionBlurTunerReplay & result = results[2];
+        result.pName = "Heavy load, then light";
+        MotionBlurTuner tuner;
+        initMotionBlurTuner(&tuner, &settings, 32, 40, 1.0f);
+        replayMotionBlurTunerTrace(&tuner, 8000, [](uint32_t frame) { return frame < 3000 ? 6.0f : 0.25f; }, 0.1f, true, &seed, &result);
+        // Back to where it started
+        result.mPassed = 32 == result.mSampleCount && 40 == result.mTileSize && 1.0f == result.mScale;
+    }
+    {
+        MotionBlurTunerReplay & result = results[3];
+        result.pName = "Every step up goes over";
+        // Steps of 8 samples, S = 16 takes 1.77 ms, above the band, and S = 8 0.96 ms, below it
+        MotionBlurTunerSettings coarseSettings = settings;
+        coarseSettings.mSampleCountStep = 8;
+        MotionBlurTuner tuner;
+        initMotionBlurTuner(&tuner, &coarseSettings, 16, 20, 1.0f);
+        replayMotionBlurTunerTrace(&tuner, 20000, [](uint32_t) { return 0.85f; }, 0.05f, true, &seed, &result);
+        // Without the back off it would go up and down again every 30 frames or so
+        result.mPassed = result.mStepCount < 200;
+    }
+    {
+        MotionBlurTunerReplay & result = results[4];
+        result.pName = "No measurements";
+        MotionBlurTuner tuner;
+        initMotionBlurTuner(&tuner, &settings, 32, 40, 1.0f);
+        replayMotionBlurTunerTrace(&tuner, 1000, [](uint32_t) { return 6.0f; }, 0.0f, false, &seed, &result);
+        result.mPassed = 0 == result.mStepCount;
+    }
+
+    for (uint32_t i = 0; i < MOTION_BLUR_TUNER_REPLAY_COUNT; ++i)
+        passedCount += results[i].mPassed ? 1 : 0;
+    return passedCount;
+}
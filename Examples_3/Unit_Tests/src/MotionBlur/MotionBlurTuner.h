@@ -0,0 +1,92 @@
+// Keeps the motion blur passes within a GPU time budget by trading quality for speed.
+// Every frame it gets the measured times of the tile, neighbor and reconstruct passes and, when the smoothed total
+// stays out of a band around the budget for long enough, steps the sample count (S), the reconstruction scale or the
+// tile size (K) down or back up. Lowering S is the cheapest in quality so it goes first, K is only touched when the
+// others are exhausted. Going back up happens in the reverse order and never beyond the values the tuner started with.
+// It only deals with numbers, so timing traces can be replayed through it on the CPU.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct MotionBlurTunerSettings
+{
+    float       mBudgetMs           = 1.5f;
+    // Nothing changes while the smoothed time stays within mBudgetMs * (1 +- mHysteresis)
+    float       mHysteresis         = 0.15f;
+    // Weight of the newest frame in the smoothed time
+    float       mSmoothing          = 0.1f;
+    // Frames the smoothed time has to stay out of the band before a step is taken
+    uint32_t    mSettleFrames       = 10;
+    // Frames ignored after a step, the GPU timers lag behind by the frames in flight
+    uint32_t    mLatencyFrames      = 3;
+    // Stepping back up is postponed twice as long every time it had to be undone right away, up to this many frames
+    uint32_t    mMaxUpSettleFrames  = 320;
+
+    uint32_t    mMinSampleCount     = 4;
+    uint32_t    mSampleCountStep    = 2;
+    uint32_t    mMinTileSize        = 10;
+    uint32_t    mTileSizeStep       = 5;
+    // 1 disables the scale knob
+    float       mMinScale           = 0.5f;
+    float       mScaleStep          = 0.125f;
+};
+
+// Negative times are missing measurements and skipped
+struct MotionBlurTunerTimes
+{
+    float       mTileMs             = 0.0f;
+    float       mNeighborMs         = 0.0f;
+    float       mReconstructMs      = 0.0f;
+};
+
+struct MotionBlurTuner
+{
+    MotionBlurTunerSettings mSettings;
+
+    // Current parameters, and the ones the tuner started with which it never goes above
+    uint32_t    mSampleCount        = 0;
+    uint32_t    mTileSize           = 0;
+    float       mScale              = 1.0f;
+    uint32_t    mMaxSampleCount     = 0;
+    uint32_t    mMaxTileSize        = 0;
+    float       mMaxScale           = 1.0f;
+
+    float       mSmoothedMs         = 0.0f;
+    bool        mSmoothedValid      = false;
+    uint32_t    mOverFrames         = 0;
+    uint32_t    mUnderFrames        = 0;
+    uint32_t    mLatencyLeft        = 0;
+    uint32_t    mUpSettleFrames     = 0;
+    // Direction of the last step, +1 up, -1 down, 0 none yet
+    int32_t     mLastStep           = 0;
+    uint32_t    mStepCount          = 0;
+};
+
+void initMotionBlurTuner(MotionBlurTuner * pTuner, const MotionBlurTunerSettings * pSettings,
+    uint32_t sampleCount, uint32_t tileSize, float scale);
+
+// Feeds the times of the last measured frame in, returns true when the parameters changed
+bool updateMotionBlurTuner(MotionBlurTuner * pTuner, const MotionBlurTunerTimes * pTimes);
+
+// Result of one synthetic timing trace replayed through the tuner
+struct MotionBlurTunerReplay
+{
+    const char *    pName               = NULL;
+    bool            mPassed             = false;
+    uint32_t        mStepCount          = 0;
+    uint32_t        mSampleCount        = 0;
+    uint32_t        mTileSize           = 0;
+    float           mScale              = 1.0f;
+    // Noise free time of the final parameters under the final load
+    float           mFinalMs            = 0.0f;
+};
+
+static constexpr uint32_t MOTION_BLUR_TUNER_REPLAY_COUNT = 5;
+
+// Feeds timing traces of a synthetic GPU, whose reconstruct time grows with S, the scale squared and a varying load,
+// through a tuner with default settings and checks that it stays put within the band, gets under the budget in the
+// right knob order, recovers once the load drops, backs off when stepping up keeps failing, and ignores missing times.
+// Returns how many of the traces passed.
+uint32_t replayMotionBlurTunerTraces(MotionBlurTunerReplay results[MOTION_BLUR_TUNER_REPLAY_COUNT]);
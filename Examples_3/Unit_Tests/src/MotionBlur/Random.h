@@ -0,0 +1,12 @@
+// Small deterministic random numbers for the CPU harnesses, so their results are the same every run.
+
+#pragma once
+
+#include <stdint.h>
+
+// Advances the LCG in *pState and returns its top 24 bits as a float in [0, 1), every value is exact
+inline float randomUnorm(uint32_t * pState)
+{
+    *pState = *pState * 1664525u + 1013904223u;
+    return float(*pState >> 8) / float(1u << 24);
+}
@@ -0,0 +1,531 @@
+#include "ReconstructReference.h"
+#include "VelocityTiles.h"
+#include "Random.h"
+
+#include <math.h>
+
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+
+static inline float fractf(float x)
+{
+    return x - floorf(x);
+}
+
+static inline float clamp01(float x)
+{
+    return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+}
+
+// Filters, same as the shaders
+static inline float cone(float distance, float speed)
+{
+    return clamp01(1.0f - distance / speed);
+}
+static inline float cylinder(float distance, float speed)
+{
+    float const edge0 = 0.95f * speed;
+    float const edge1 = 1.05f * speed;
+    float const t = clamp01((distance - edge0) / (edge1 - edge0));
+    return 1.0f - t * t * (3.0f - 2.0f * t);
+}
+static inline float softDepthCompare(float za, float zb)
+{
+    return clamp01(1.0f - (za - zb) / fminf(za, zb));
+}
+
+// Bilinear filtering of a texture with channelCount floats per texel, wrap is ADDRESS_MODE_REPEAT and clamp ADDRESS_MODE_CLAMP_TO_EDGE
+static void sampleBilinear(const float * pData, uint32_t channelCount, uint32_t width, uint32_t height, float u, float v, bool wrap, float * pOut)
+{
+    float const x = u * float(width) - 0.5f;
+    float const y = v * float(height) - 0.5f;
+    int const x0 = int(floorf(x));
+    int const y0 = int(floorf(y));
+    float const fx = x - float(x0);
+    float const fy = y - float(y0);
+
+    auto address = [wrap](int i, uint32_t size)
+    {
+        int const s = int(size);
+        return wrap ? uint32_t(((i % s) + s) % s) : uint32_t(i < 0 ? 0 : (i >= s ? s - 1 : i));
+    };
+    uint32_t const xs[2] = { address(x0, width), address(x0 + 1, width) };
+    uint32_t const ys[2] = { address(y0, height), address(y0 + 1, height) };
+    float const weights[4] = { (1.0f - fx) * (1.0f - fy), fx * (1.0f - fy), (1.0f - fx) * fy, fx * fy };
+
+    for (uint32_t c = 0; c < channelCount; ++c)
+    {
+        pOut[c] = 0.0f;
+    }
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        const float * pTexel = pData + (ys[i / 2] * width + xs[i % 2]) * channelCount;
+        for (uint32_t c = 0; c < channelCount; ++c)
+        {
+            pOut[c] += pTexel[c] * weights[i];
+        }
+    }
+}
+
+void generateBlueNoise(uint32_t size, float * pOut)
+{
+    ASSERT(size && pOut);
+
+    uint32_t const count = size * size;
+    float const sigma = 1.5f;
+
+    // Toroidal gaussian energy of a set pixel, indexed by the wrapped offset to it
+    eastl::vector<float> kernel(count);
+    for (uint32_t y = 0; y < size; ++y)
+    {
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            float const dx = float(x < size / 2 ? x : size - x);
+            float const dy = float(y < size / 2 ? y : size - y);
+            kernel[y * size + x] = expf(-(dx * dx + dy * dy) / (2.0f * sigma * sigma));
+        }
+    }
+
+    eastl::vector<uint8_t> pattern(count, 0);
+    eastl::vector<float> energy(count, 0.0f);
+    auto splat = [&](uint32_t index, float sign)
+    {
+        uint32_t const px = index % size;
+        uint32_t const py = index / size;
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                uint32_t const kx = (x + size - px) % size;
+                uint32_t const ky = (y + size - py) % size;
+                energy[y * size + x] += sign * kernel[ky * size + kx];
+            }
+        }
+    };
+    // Tightest cluster is the set pixel with the most energy, largest void the empty one with the least
+    auto findExtreme = [&](uint8_t value, bool highest)
+    {
+        uint32_t best = 0;
+        float bestEnergy = highest ? -1e30f : 1e30f;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (pattern[i] == value && (highest ? energy[i] > bestEnergy : energy[i] < bestEnergy))
+            {
+                best = i;
+                bestEnergy = energy[i];
+            }
+        }
+        return best;
+    };
+
+    // Initial binary pattern, a tenth of the pixels set with a fixed LCG so the texture is the same every run
+    uint32_t const initialCount = count / 10;
+    uint32_t seed = 0x2545F491u;
+    for (uint32_t set = 0; set < initialCount;)
+    {
+        uint32_t const index = uint32_t(randomUnorm(&seed) * float(count));
+        if (!pattern[index])
+        {
+            pattern[index] = 1;
+            splat(index, 1.0f);
+            ++set;
+        }
+    }
+
+    // Move pixels from the tightest cluster to the largest void until that stops changing anything
+    for (uint32_t iteration = 0; iteration < count; ++iteration)
+    {
+        uint32_t const cluster = findExtreme(1, true);
+        pattern[cluster] = 0;
+        splat(cluster, -1.0f);
+
+        uint32_t const voidIndex = findExtreme(0, false);
+        pattern[voidIndex] = 1;
+        splat(voidIndex, 1.0f);
+
+        if (voidIndex == cluster)
+            break;
+    }
+
+    eastl::vector<uint8_t> prototype = pattern;
+    eastl::vector<float> prototypeEnergy = energy;
+    eastl::vector<uint32_t> rank(count, 0);
+
+    // Ranks below the prototype, removing the tightest clusters first
+    for (uint32_t r = initialCount; r-- > 0;)
+    {
+        uint32_t const cluster = findExtreme(1, true);
+        pattern[cluster] = 0;
+        splat(cluster, -1.0f);
+        rank[cluster] = r;
+    }
+
+    // Ranks above it, filling the largest voids. With the energy of the set pixels that also finds the
+    // tightest cluster of empty pixels once more than half are set, so one loop covers both phases.
+    pattern = prototype;
+    energy = prototypeEnergy;
+    for (uint32_t r = initialCount; r < count; ++r)
+    {
+        uint32_t const voidIndex = findExtreme(0, false);
+        pattern[voidIndex] = 1;
+        splat(voidIndex, 1.0f);
+        rank[voidIndex] = r;
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        pOut[i] = float(rank[i]) / float(count);
+    }
+}
+
+float computeJitter(JitterMode mode, uint32_t x, uint32_t y, uint32_t frameIndex, float u, float v,
+    const float * pBlueNoise, uint32_t blueNoiseSize)
+{
+    // Golden ratio rotation, so every frame gets a different but still well distributed set of offsets
+    float const rotation = fractf(float(frameIndex) * 0.61803398875f);
+
+    switch (mode)
+    {
+    case JITTER_MODE_IGN:
+    {
+        float const px = float(x) + 5.588238f * float(frameIndex % 64);
+        float const py = float(y) + 5.588238f * float(frameIndex % 64);
+        return fractf(52.9829189f * fractf(0.06711056f * px + 0.00583715f * py));
+    }
+    case JITTER_MODE_BLUE_NOISE:
+        ASSERT(pBlueNoise && blueNoiseSize);
+        return fractf(pBlueNoise[(y % blueNoiseSize) * blueNoiseSize + x % blueNoiseSize] + rotation);
+    case JITTER_MODE_R2:
+        // 1 / plastic number and its square
+        return fractf(0.5f + float(x) * 0.75487766624f + float(y) * 0.56984029099f + rotation);
+    case JITTER_MODE_HASH:
+    default:
+        return fractf(sinf(u * 12.9898f + v * 78.233f) * 43758.5453f);
+    }
+}
+
+// Center color and weight of a pixel and the sums over its taps, the filter result is
+// (center * centerWeight + tapColorSum) / (centerWeight + tapWeightSum)
+struct ReconstructTaps
+{
+    float   mCenter[3];
+    float   mCenterWeight;
+    float   mTapColorSum[3];
+    float   mTapWeightSum;
+    // Early out pixel, only mCenter is set
+    bool    mSharp;
+};
+
+static void reconstructReferenceTaps(const ReconstructInput * pInput, const ReconstructSettings * pSettings, ReconstructTaps * pTaps)
+{
+    ASSERT(pInput && pSettings && pTaps);
+    ASSERT(pInput->pColor && pInput->pVelocity && pInput->pNeighborMax);
+
+    uint32_t const width = pInput->mWidth;
+    uint32_t const height = pInput->mHeight;
+    float const texelSizeX = 1.0f / float(width);
+    float const texelSizeY = 1.0f / float(height);
+    float const s = float(pSettings->mSampleCount);
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            float const u = (float(x) + 0.5f) * texelSizeX;
+            float const v = (float(y) + 0.5f) * texelSizeY;
+            ReconstructTaps & taps = pTaps[y * width + x];
+
+            float sampledX[4];
+            sampleBilinear(pInput->pColor, 4, width, height, u, v, true, sampledX);
+            float const zX = sampledX[3];
+            taps.mCenter[0] = sampledX[0];
+            taps.mCenter[1] = sampledX[1];
+            taps.mCenter[2] = sampledX[2];
+
+            // Largest velocity in the neighborhood
+            float maxNeighbor[2];
+            sampleBilinear(pInput->pNeighborMax, 2, pInput->mTileWidth, pInput->mTileHeight, u, v, false, maxNeighbor);
+            float const maxNeighborLen = sqrtf(maxNeighbor[0] * maxNeighbor[0] + maxNeighbor[1] * maxNeighbor[1]);
+
+            taps.mSharp = maxNeighborLen <= 0.5f; // Early out
+            if (taps.mSharp)
+                continue;
+
+            // Sample the current point, no jitter puts the taps at the centers of s equal steps along the velocity
+            float const jitter = pSettings->mRegularTaps ? 0.0f : computeJitter(pSettings->mJitterMode, x, y, pSettings->mFrameIndex, u, v,
+                pInput->pBlueNoise, pInput->mBlueNoiseSize) * 2.0f - 1.0f;
+            float vX[2];
+            sampleBilinear(pInput->pVelocity, 2, width, height, u, v, false, vX);
+            float const vXLen = sqrtf(vX[0] * vX[0] + vX[1] * vX[1]) + 0.00000001f;
+            taps.mCenterWeight = 1.0f / fmaxf(vXLen, 0.5f);
+
+            float weight = 0.0f;
+            float sum[3] = { 0.0f, 0.0f, 0.0f };
+            for (float i = 0.0f; i < s; i += 1.0f)
+            {
+                float const t = -1.0f + 2.0f * ((i + jitter + 1.0f) / (s + 1.0f));
+                float const offsetX = texelSizeX * (maxNeighbor[0] * t);
+                float const offsetY = texelSizeY * -(maxNeighbor[1] * t);
+
+                float sampledY[4];
+                float vY[2];
+                sampleBilinear(pInput->pColor, 4, width, height, u + offsetX, v + offsetY, true, sampledY);
+                sampleBilinear(pInput->pVelocity, 2, width, height, u + offsetX, v + offsetY, false, vY);
+                float const vYLen = sqrtf(vY[0] * vY[0] + vY[1] * vY[1]);
+                float const dist = sqrtf(offsetX * offsetX + offsetY * offsetY);
+                float const zY = sampledY[3];
+
+                // Fore- vs. background classification of Y relative to X
+                float const f = softDepthCompare(zX, zY);
+                float const b = softDepthCompare(zY, zX);
+
+                float aY = f * cone(dist, vYLen);
+                aY += b * cone(dist, vXLen);
+                aY += cylinder(dist, vYLen) * cylinder(dist, vXLen) * 2.0f;
+
+                weight += aY;
+                sum[0] += aY * sampledY[0];
+                sum[1] += aY * sampledY[1];
+                sum[2] += aY * sampledY[2];
+            }
+
+            taps.mTapColorSum[0] = sum[0];
+            taps.mTapColorSum[1] = sum[1];
+            taps.mTapColorSum[2] = sum[2];
+            taps.mTapWeightSum = weight;
+        }
+    }
+}
+
+void reconstructReference(const ReconstructInput * pInput, const ReconstructSettings * pSettings, float * pOut)
+{
+    ASSERT(pOut);
+
+    uint32_t const pixelCount = pInput->mWidth * pInput->mHeight;
+    eastl::vector<ReconstructTaps> taps(pixelCount);
+    reconstructReferenceTaps(pInput, pSettings, taps.data());
+
+    for (uint32_t i = 0; i < pixelCount; ++i)
+    {
+        const ReconstructTaps & pixel = taps[i];
+        float * pColorOut = pOut + i * 3;
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            pColorOut[c] = pixel.mSharp ? pixel.mCenter[c] :
+                (pixel.mCenter[c] * pixel.mCenterWeight + pixel.mTapColorSum[c]) / (pixel.mCenterWeight + pixel.mTapWeightSum);
+        }
+    }
+}
+
+void reconstructTemporalReference(const ReconstructInput * pInput, const ReconstructSettings * pSettings, uint32_t frameCount,
+    float historyWeight, uint32_t targetSampleCount, float * pOut)
+{
+    ASSERT(pOut && frameCount);
+
+    uint32_t const pixelCount = pInput->mWidth * pInput->mHeight;
+    eastl::vector<ReconstructTaps> taps(pixelCount);
+    // Tap sums per tap, rgb and weight, like the history of reconstruct.comp
+    eastl::vector<float> history(pixelCount * 4);
+
+    ReconstructSettings settings = *pSettings;
+    float const tapScale = 1.0f / float(settings.mSampleCount);
+    for (uint32_t frame = 0; frame < frameCount; ++frame, ++settings.mFrameIndex)
+    {
+        reconstructReferenceTaps(pInput, &settings, taps.data());
+
+        // First frame has no history to blend with
+        float const blend = frame ? historyWeight : 0.0f;
+        for (uint32_t i = 0; i < pixelCount; ++i)
+        {
+            const ReconstructTaps & pixel = taps[i];
+            float * pHistory = &history[i * 4];
+            if (pixel.mSharp)
+                continue;
+
+            for (uint32_t c = 0; c < 3; ++c)
+                pHistory[c] = pixel.mTapColorSum[c] * tapScale + (pHistory[c] - pixel.mTapColorSum[c] * tapScale) * blend;
+            pHistory[3] = pixel.mTapWeightSum * tapScale + (pHistory[3] - pixel.mTapWeightSum * tapScale) * blend;
+        }
+    }
+
+    // The averaged taps stand in for targetSampleCount of them, so the center gets the weight it has at that sample count
+    float const s = float(targetSampleCount);
+    for (uint32_t i = 0; i < pixelCount; ++i)
+    {
+        const ReconstructTaps & pixel = taps[i];
+        const float * pHistory = &history[i * 4];
+        float * pColorOut = pOut + i * 3;
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            pColorOut[c] = pixel.mSharp ? pixel.mCenter[c] :
+                (pixel.mCenter[c] * pixel.mCenterWeight + pHistory[c] * s) / (pixel.mCenterWeight + pHistory[3] * s);
+        }
+    }
+}
+
+double computePSNR(const float * pImage, const float * pReference, uint32_t valueCount)
+{
+    ASSERT(pImage && pReference && valueCount);
+
+    double squaredError = 0.0;
+    for (uint32_t i = 0; i < valueCount; ++i)
+    {
+        double const d = double(clamp01(pImage[i])) - double(clamp01(pReference[i]));
+        squaredError += d * d;
+    }
+
+    double const mse = squaredError / double(valueCount);
+    // Identical images, report something finite
+    if (mse <= 1e-12)
+        return 120.0;
+    return 10.0 * log10(1.0 / mse);
+}
+
+void generateReconstructTestScene(uint32_t width, uint32_t height, uint32_t tileSize, ReconstructTestScene * pScene)
+{
+    ASSERT(pScene);
+
+    pScene->mColor.resize(width * height * 4);
+    pScene->mVelocity.resize(width * height * 2);
+
+    // Half velocities, like the G-buffer writes them
+    float const maxVelocity = float(tileSize) * 0.5f;
+    float const discX = float(width) * 0.5f;
+    float const discY = float(height) * 0.5f;
+    float const discRadius = float(width < height ? width : height) * 0.25f;
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            float * pColor = &pScene->mColor[(y * width + x) * 4];
+            float * pVelocity = &pScene->mVelocity[(y * width + x) * 2];
+
+            float const dx = float(x) + 0.5f - discX;
+            float const dy = float(y) + 0.5f - discY;
+            if (dx * dx + dy * dy < discRadius * discRadius)
+            {
+                // Bright rings on the disc
+                float const ring = 0.5f + 0.5f * cosf(sqrtf(dx * dx + dy * dy) * 0.6f);
+                pColor[0] = 0.9f * ring + 0.1f;
+                pColor[1] = 0.3f * ring;
+                pColor[2] = 0.1f;
+                pColor[3] = 0.3f;
+                pVelocity[0] = maxVelocity;
+                pVelocity[1] = 0.0f;
+            }
+            else
+            {
+                // Checkerboard background
+                bool const checker = ((x / 8) + (y / 8)) % 2 == 0;
+                pColor[0] = checker ? 0.8f : 0.2f;
+                pColor[1] = checker ? 0.8f : 0.2f;
+                pColor[2] = checker ? 0.9f : 0.3f;
+                pColor[3] = 0.9f;
+                pVelocity[0] = -maxVelocity * 0.25f;
+                pVelocity[1] = maxVelocity * 0.1f;
+            }
+        }
+    }
+
+    uint32_t tileWidth = 0;
+    uint32_t tileHeight = 0;
+    getVelocityTileCount(width, height, tileSize, &tileWidth, &tileHeight);
+    eastl::vector<float> tileMax(tileWidth * tileHeight * 2);
+    pScene->mNeighborMax.resize(tileWidth * tileHeight * 2);
+    computeTileMax(pScene->mVelocity.data(), width, height, tileSize, tileWidth, tileHeight, tileMax.data());
+    computeNeighborMax(tileMax.data(), tileWidth, tileHeight, pScene->mNeighborMax.data());
+
+    pScene->mInput = ReconstructInput();
+    pScene->mInput.mWidth = width;
+    pScene->mInput.mHeight = height;
+    pScene->mInput.pColor = pScene->mColor.data();
+    pScene->mInput.pVelocity = pScene->mVelocity.data();
+    pScene->mInput.mTileWidth = tileWidth;
+    pScene->mInput.mTileHeight = tileHeight;
+    pScene->mInput.pNeighborMax = pScene->mNeighborMax.data();
+}
+
+void measureJitterQuality(const ReconstructInput * pInput, uint32_t groundTruthSampleCount, uint32_t maxSampleCount, double targetPSNR,
+    JitterQualityResult results[JITTER_MODE_COUNT])
+{
+    ASSERT(pInput && results);
+    ASSERT(maxSampleCount <= groundTruthSampleCount);
+
+    uint32_t const valueCount = pInput->mWidth * pInput->mHeight * 3;
+    eastl::vector<float> groundTruth(valueCount);
+    eastl::vector<float> image(valueCount);
+
+    // Regular taps, taking one of the measured jitter modes would favour it
+    ReconstructSettings settings = {};
+    settings.mSampleCount = groundTruthSampleCount;
+    settings.mRegularTaps = true;
+    reconstructReference(pInput, &settings, groundTruth.data());
+    settings.mRegularTaps = false;
+
+    for (uint32_t mode = 0; mode < JITTER_MODE_COUNT; ++mode)
+    {
+        JitterQualityResult & result = results[mode];
+        result.mPSNR.resize(maxSampleCount);
+        result.mLowestSampleCount = 0;
+
+        if (JITTER_MODE_BLUE_NOISE == mode && !pInput->pBlueNoise)
+            continue;
+
+        settings.mJitterMode = (JitterMode)mode;
+        for (uint32_t s = 1; s <= maxSampleCount; ++s)
+        {
+            settings.mSampleCount = s;
+            reconstructReference(pInput, &settings, image.data());
+            result.mPSNR[s - 1] = computePSNR(image.data(), groundTruth.data(), valueCount);
+
+            if (!result.mLowestSampleCount && result.mPSNR[s - 1] >= targetPSNR)
+                result.mLowestSampleCount = s;
+        }
+    }
+}
+
+void measureTemporalQuality(const ReconstructInput * pInput, JitterMode jitterMode, uint32_t groundTruthSampleCount, uint32_t maxSampleCount,
+    uint32_t frameCount, float historyWeight, double targetPSNR, TemporalQualityResult * pResult)
+{
+    ASSERT(pInput && pResult);
+    ASSERT(maxSampleCount <= groundTruthSampleCount);
+
+    uint32_t const valueCount = pInput->mWidth * pInput->mHeight * 3;
+    eastl::vector<float> groundTruth(valueCount);
+    eastl::vector<float> image(valueCount);
+
+    // Regular taps, like measureJitterQuality, so the ground truth does not favour the jitter mode being measured
+    ReconstructSettings settings = {};
+    settings.mSampleCount = groundTruthSampleCount;
+    settings.mRegularTaps = true;
+    reconstructReference(pInput, &settings, groundTruth.data());
+    settings.mRegularTaps = false;
+
+    pResult->mSinglePSNR.resize(maxSampleCount);
+    pResult->mTemporalPSNR.resize(maxSampleCount);
+    pResult->mLowestSingleSampleCount = 0;
+    pResult->mLowestTemporalSampleCount = 0;
+
+    settings.mJitterMode = jitterMode;
+    for (uint32_t s = 1; s <= maxSampleCount; ++s)
+    {
+        settings.mSampleCount = s;
+        reconstructReference(pInput, &settings, image.data());
+        pResult->mSinglePSNR[s - 1] = computePSNR(image.data(), groundTruth.data(), valueCount);
+
+        if (!pResult->mLowestSingleSampleCount && pResult->mSinglePSNR[s - 1] >= targetPSNR)
+            pResult->mLowestSingleSampleCount = s;
+    }
+
+    // The temporal mode stands in for the sample count a single frame needs
+    uint32_t const targetSampleCount = pResult->mLowestSingleSampleCount ? pResult->mLowestSingleSampleCount : maxSampleCount;
+    for (uint32_t s = 1; s <= maxSampleCount; ++s)
+    {
+        settings.mSampleCount = s;
+        reconstructTemporalReference(pInput, &settings, frameCount, historyWeight, targetSampleCount, image.data());
+        pResult->mTemporalPSNR[s - 1] = computePSNR(image.data(), groundTruth.data(), valueCount);
+
+        if (!pResult->mLowestTemporalSampleCount && pResult->mTemporalPSNR[s - 1] >= targetPSNR)
+            pResult->mLowestTemporalSampleCount = s;
+    }
+}
@@ -0,0 +1,103 @@
+// CPU version of the reconstruction filter (reconstruct.frag / reconstruct.comp) and its jitter sources,
+// plus a harness which measures the PSNR of the filter against a ground truth taken with a high sample count.
+// It runs on a synthetic scene, so the sample count a jitter source needs can be picked without a GPU.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../../../../Common_3/ThirdParty/OpenSource/EASTL/vector.h"
+
+// Must match the JITTER_MODE_* defines in Shaders/Vulkan/reconstruct.comp
+enum JitterMode
+{
+    JITTER_MODE_HASH = 0,          // fract(sin(dot(...))) white noise, the original jitter
+    JITTER_MODE_IGN,               // Interleaved gradient noise
+    JITTER_MODE_BLUE_NOISE,        // Tiled blue noise texture
+    JITTER_MODE_R2,                // R2 sequence over the pixels, rotated every frame
+    JITTER_MODE_COUNT,
+};
+
+static constexpr uint32_t BLUE_NOISE_SIZE = 64;
+
+// Void and cluster blue noise, size * size ranks normalized to [0, 1). Tiles seamlessly.
+void generateBlueNoise(uint32_t size, float * pOut);
+
+// Jitter in [0, 1) of pixel (x, y), the same values the shaders use
+float computeJitter(JitterMode mode, uint32_t x, uint32_t y, uint32_t frameIndex, float u, float v,
+    const float * pBlueNoise, uint32_t blueNoiseSize);
+
+struct ReconstructInput
+{
+    uint32_t        mWidth          = 0;
+    uint32_t        mHeight         = 0;
+    // rgba, the alpha is the depth like in the color target
+    const float *   pColor          = NULL;
+    // xy pairs, half velocity in pixels like in the velocity target
+    const float *   pVelocity       = NULL;
+    uint32_t        mTileWidth      = 0;
+    uint32_t        mTileHeight     = 0;
+    const float *   pNeighborMax    = NULL;
+    // Only needed for JITTER_MODE_BLUE_NOISE
+    const float *   pBlueNoise      = NULL;
+    uint32_t        mBlueNoiseSize  = 0;
+};
+
+struct ReconstructSettings
+{
+    uint32_t    mSampleCount    = 15;
+    JitterMode  mJitterMode     = JITTER_MODE_HASH;
+    uint32_t    mFrameIndex     = 0;
+    // Ignores mJitterMode and puts the taps on a regular grid, for ground truths which favour no jitter mode
+    bool        mRegularTaps    = false;
+};
+
+// pOut receives width * height rgb triples
+void reconstructReference(const ReconstructInput * pInput, const ReconstructSettings * pSettings, float * pOut);
+
+// Temporal mode of reconstruct.comp under stable motion, where the history reprojects onto the same pixels.
+// Runs frameCount frames starting at pSettings->mFrameIndex. The history keeps the tap sums divided by the sample count,
+// blended with historyWeight, and the result weighs them like targetSampleCount taps against the center. Averaging
+// the sums instead of the results keeps the low per frame sample count from biasing the filter.
+void reconstructTemporalReference(const ReconstructInput * pInput, const ReconstructSettings * pSettings, uint32_t frameCount,
+    float historyWeight, uint32_t targetSampleCount, float * pOut);
+
+// Both images are clamped to [0, 1]
+double computePSNR(const float * pImage, const float * pReference, uint32_t valueCount);
+
+// Background moving to the left with a fast disc in front of it moving to the right
+struct ReconstructTestScene
+{
+    eastl::vector<float>    mColor;
+    eastl::vector<float>    mVelocity;
+    eastl::vector<float>    mNeighborMax;
+    ReconstructInput        mInput;
+};
+void generateReconstructTestScene(uint32_t width, uint32_t height, uint32_t tileSize, ReconstructTestScene * pScene);
+
+struct JitterQualityResult
+{
+    // PSNR at each sample count from 1 to maxSampleCount, mPSNR[s - 1]
+    eastl::vector<double>   mPSNR;
+    // Lowest sample count reaching targetPSNR, 0 if none did
+    uint32_t                mLowestSampleCount = 0;
+};
+
+// Measures every jitter mode against a groundTruthSampleCount reconstruction of the same scene with regular taps
+void measureJitterQuality(const ReconstructInput * pInput, uint32_t groundTruthSampleCount, uint32_t maxSampleCount, double targetPSNR,
+    JitterQualityResult results[JITTER_MODE_COUNT]);
+
+struct TemporalQualityResult
+{
+    // PSNR of a single frame and of the temporal history at each sample count from 1 to maxSampleCount
+    eastl::vector<double>   mSinglePSNR;
+    eastl::vector<double>   mTemporalPSNR;
+    // Lowest sample counts reaching targetPSNR, 0 if none did. The temporal mode targets mLowestSingleSampleCount taps.
+    uint32_t                mLowestSingleSampleCount    = 0;
+    uint32_t                mLowestTemporalSampleCount  = 0;
+};
+
+// Sample count the temporal mode needs for the quality of a single frame, with a jitter mode which rotates every frame.
+// Both are measured against a groundTruthSampleCount reconstruction with regular taps.
+void measureTemporalQuality(const ReconstructInput * pInput, JitterMode jitterMode, uint32_t groundTruthSampleCount, uint32_t maxSampleCount,
+    uint32_t frameCount, float historyWeight, double targetPSNR, TemporalQualityResult * pResult);
@@ -0,0 +1,46 @@
+#version 450 core
+
+/*
+ * Copyright (c) 2018-2020 The Forge Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Copies the output of reconstruct.comp to the back buffer, which cannot be written from compute.
+// When the reconstruction ran below full resolution the written corner gets stretched over the whole target.
+
+layout(location = 0) in vec4 vTexCoord;
+layout(location = 0) out vec4 oColor;
+
+layout (UPDATE_FREQ_NONE, binding = 0) uniform sampler uSamplerLinear;
+layout (UPDATE_FREQ_PER_FRAME, binding = 0) uniform texture2D reconstructTexture;
+
+layout(row_major, push_constant) uniform cbRootConstants_Block {
+    vec2  uvScale;
+    // Center of the last written texel, so the bilinear footprint stays within the corner
+    vec2  uvMax;
+} cbRootConstants;
+
+void main ()
+{
+    vec2 uv = min(vTexCoord.xy * cbRootConstants.uvScale, cbRootConstants.uvMax);
+    oColor = textureLod(sampler2D(reconstructTexture, uSamplerLinear), uv, 0);
+}
@@ -4,13 +4,17 @@
 #define albedoMap ((cbRootConstants.textureIds >> 0) & 0xFF)
 
 layout(location = 0) in vec4 vPosition;
+#ifndef STATIC_GEOMETRY
 layout(location = 1) in vec4 vPositionPrev;
+#endif
 layout(location = 2) in vec4 vNormal;
 layout(location = 3) in vec4 vTexCoord;
 
 layout(location = 0) out vec4 oColor; // rgb: albedo, a: depth
 layout(location = 1) out vec4 oNormal;
-layout(location = 2) out vec4 oVelocity;
+#ifndef STATIC_GEOMETRY
+layout(location = 2) out vec4 oVelocity; // Masked out for static geometry
+#endif
 
 layout (UPDATE_FREQ_NONE, binding = 0) uniform sampler   uSampler;
 layout (UPDATE_FREQ_NONE, binding = 1) uniform texture2D textureMaps[TOTAL_IMAGES];
@@ -19,24 +23,34 @@ layout(row_major, push_constant) uniform cbRootConstants_Block {
     vec2  viewport;
     float kFactor;
     uint  textureIds;
-    uint  objectIndex;
+    uint  instanceOffset;
     float exposure;
     float deltaTime;
+    uint  albedoMinLod;
+    uint  paletteOffset;
+    uint  jointCount;
+    float velocityEncodeScale;
+    float velocityEncodeBias;
 } cbRootConstants;
 
 void main ()
 {
-    oColor.rgb = texture(sampler2D(textureMaps[albedoMap], uSampler), vTexCoord.xy).rgb;
+    // Never sample mips which are still being streamed in
+    float lod = textureQueryLod(sampler2D(textureMaps[albedoMap], uSampler), vTexCoord.xy).y;
+    lod = max(lod, float(cbRootConstants.albedoMinLod));
+    oColor.rgb = textureLod(sampler2D(textureMaps[albedoMap], uSampler), vTexCoord.xy, lod).rgb;
     oColor.a   = gl_FragCoord.z;
 
     oNormal = vec4(vNormal.xyz, 1.0);
 
+#ifndef STATIC_GEOMETRY
     vec2 a = (vPosition.xy / vPosition.w);
     vec2 b = (vPositionPrev.xy / vPositionPrev.w);
     vec2 motion = (a - b) * (cbRootConstants.exposure / cbRootConstants.deltaTime);
     motion *= cbRootConstants.viewport * 0.5;
     motion /= max(1.0, length(motion) / cbRootConstants.kFactor);
     
-    // Encoding the half velocity
-    oVelocity = vec4(motion * 0.5, 0.0, 1.0);
+    // Encoding the half velocity, identity for the half float target, fixed point relative to K otherwise
+    oVelocity = vec4(motion * 0.5 * cbRootConstants.velocityEncodeScale + cbRootConstants.velocityEncodeBias, 0.0, 1.0);
+#endif
 }
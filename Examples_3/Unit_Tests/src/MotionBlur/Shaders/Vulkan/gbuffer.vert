@@ -1,15 +1,21 @@
 #version 450 core
 
 // Draw the objects, and calcs the velocity vectors
-
-#define TOTAL_MODELS 2
+// STATIC_GEOMETRY skips the previous frame transform, camera_velocity.comp fills in the velocity from the depth instead
+// SKINNED blends the joints of this frame and of the last one, so the velocity includes the motion of the animation
 
 layout(location = 0) in vec3 Position;
 layout(location = 1) in vec3 Normal;
 layout(location = 2) in vec2 TexCoord;
+#ifdef SKINNED
+layout(location = 3) in vec4 Weights;
+layout(location = 4) in uvec4 Joints;
+#endif
 
 layout(location = 0) out vec4 vPosition;
+#ifndef STATIC_GEOMETRY
 layout(location = 1) out vec4 vPositionPrev;
+#endif
 layout(location = 2) out vec4 vNormal;
 layout(location = 3) out vec4 vTexCoord;
 
@@ -27,29 +33,68 @@ struct ObjectInfo {
     mat4 mToWorldMatPrev;
 };
 
-layout (std140, UPDATE_FREQ_PER_FRAME, binding = 1) uniform objectsUniformBlock {
-    ObjectInfo objects[TOTAL_MODELS];
+// gImageCount slices of instances, instanceOffset points into the one of this frame
+layout (std430, UPDATE_FREQ_PER_FRAME, binding = 1) readonly buffer objectsBuffer {
+    ObjectInfo objects[];
+};
+
+#ifdef SKINNED
+// Model space palettes, every instance has jointCount matrices for this frame followed by jointCount for the last one
+layout (std430, UPDATE_FREQ_PER_FRAME, binding = 2) readonly buffer paletteBuffer {
+    mat4 palettes[];
 };
+#endif
 
 layout(row_major, push_constant) uniform cbRootConstants_Block {
     vec2  viewport;
     float kFactor;
     uint  textureIds;
-    uint  objectIndex;
+    uint  instanceOffset;
     float exposure;
     float deltaTime;
+    uint  albedoMinLod;
+    uint  paletteOffset;
+    uint  jointCount;
+    float velocityEncodeScale;
+    float velocityEncodeBias;
 } cbRootConstants;
 
 void main ()
 {
-    uint objectIndex = cbRootConstants.objectIndex;
+    uint objectIndex = cbRootConstants.instanceOffset + gl_InstanceIndex;
 
     vTexCoord = vec4(TexCoord.xy, 0.0, 1.0);
 
-    vPosition     = mProject * mView * objects[objectIndex].mToWorldMat * vec4(Position.xyz, 1.0); 
-    vPositionPrev = mProjectPrev * mViewPrev * objects[objectIndex].mToWorldMatPrev * vec4(Position.xyz, 1.0);
+#ifdef SKINNED
+    uint paletteIndex = cbRootConstants.paletteOffset + gl_InstanceIndex * 2 * cbRootConstants.jointCount;
+    uint paletteIndexPrev = paletteIndex + cbRootConstants.jointCount;
+
+    mat4 skin =
+        palettes[paletteIndex + Joints.x] * Weights.x +
+        palettes[paletteIndex + Joints.y] * Weights.y +
+        palettes[paletteIndex + Joints.z] * Weights.z +
+        palettes[paletteIndex + Joints.w] * Weights.w;
+    mat4 skinPrev =
+        palettes[paletteIndexPrev + Joints.x] * Weights.x +
+        palettes[paletteIndexPrev + Joints.y] * Weights.y +
+        palettes[paletteIndexPrev + Joints.z] * Weights.z +
+        palettes[paletteIndexPrev + Joints.w] * Weights.w;
+
+    vec4 position     = skin * vec4(Position.xyz, 1.0);
+    vec4 positionPrev = skinPrev * vec4(Position.xyz, 1.0);
+    vec3 normal       = (skin * vec4(Normal.xyz, 0.0)).xyz;
+#else
+    vec4 position     = vec4(Position.xyz, 1.0);
+    vec4 positionPrev = position;
+    vec3 normal       = Normal.xyz;
+#endif
+
+    vPosition     = mProject * mView * objects[objectIndex].mToWorldMat * position;
+#ifndef STATIC_GEOMETRY
+    vPositionPrev = mProjectPrev * mViewPrev * objects[objectIndex].mToWorldMatPrev * positionPrev;
+#endif
 
-    vNormal.xyz = (objects[objectIndex].mToWorldMat * vec4(Normal.xyz, 0.0)).xyz;
+    vNormal.xyz = (objects[objectIndex].mToWorldMat * vec4(normal, 0.0)).xyz;
 
     gl_Position = vPosition;
 }
@@ -1,4 +1,5 @@
 #version 450 core
+#extension GL_EXT_samplerless_texture_functions : enable
 
 layout(location = 0) in vec4 vTexCoord;
 layout(location = 0) out vec4 oColor;
@@ -20,15 +21,35 @@ layout (UPDATE_FREQ_PER_FRAME, binding = 1)  uniform texture2D colorTexture;
 layout (UPDATE_FREQ_PER_FRAME, binding = 2)  uniform texture2D normTexture;
 layout (UPDATE_FREQ_PER_FRAME, binding = 3)  uniform texture2D velocityTexture;
 layout (UPDATE_FREQ_PER_FRAME, binding = 4)  uniform texture2D neighborTexture;
+layout (UPDATE_FREQ_PER_FRAME, binding = 5)  uniform texture2D blueNoiseTexture;
 
 layout(row_major, push_constant) uniform cbRootConstants_Block {
     vec2  tileSize;
     float kFactor;
     float sFactor;
+    uint  jitterMode;
+    uint  frameIndex;
+    float reconstructScale;
+    float historyWeight;
+    float historyScale;
+    float targetSampleCount;
+    float velocityDecodeScale;
+    float velocityDecodeBias;
+    vec2  tileCount;
+    vec2  depthLinearize;
 } cbRootConstants;
 
+// Must match JitterMode in ReconstructReference.h
+#define JITTER_MODE_HASH        0
+#define JITTER_MODE_IGN         1
+#define JITTER_MODE_BLUE_NOISE  2
+#define JITTER_MODE_R2          3
+
 // Utils
 float rand(vec2 co);
+float computeJitter(ivec2 pixel, vec2 uv);
+vec2  decodeVelocity(vec2 raw);
+vec2  neighborUV(vec2 uv);
 
 // Filters
 float cone(float distance, float speed);
@@ -53,7 +74,7 @@ void main ()
     int s = int(cbRootConstants.sFactor);
     vec2 texelSize = cbRootConstants.tileSize;
 
-    vec2  maxNeighbor    = texture(sampler2D(neighborTexture, uSamplerLinear), X).xy;
+    vec2  maxNeighbor    = texture(sampler2D(neighborTexture, uSamplerLinear), neighborUV(X)).xy;
     float maxNeighborLen = length(maxNeighbor);
 
     if (maxNeighborLen <= 0.5) // Early out
@@ -63,8 +84,8 @@ void main ()
     }
     
     // Sample the current point
-    float jitter = rand(X) * 2.0 - 1.0;
-    vec2  vX    = texture(sampler2D(velocityTexture, uSamplerLinear), X).xy;
+    float jitter = computeJitter(ivec2(gl_FragCoord.xy), X) * 2.0 - 1.0;
+    vec2  vX    = decodeVelocity(texture(sampler2D(velocityTexture, uSamplerLinear), X).xy);
     float vXLen = length(vX) + 0.00000001;
     float weight = 1.0 / max(vXLen, 0.5);
     vec3  sum 	 = color.rgb * weight;
@@ -81,7 +102,7 @@ void main ()
         vec2  Y        =  X + offset; // Round to nearest
         vec4  sampledY = texture(sampler2D(colorTexture, uSampler), Y).rgba;
         vec3  cY       = sampledY.rgb;
-        vec2  vY       = texture(sampler2D(velocityTexture, uSamplerLinear), Y).xy;
+        vec2  vY       = decodeVelocity(texture(sampler2D(velocityTexture, uSamplerLinear), Y).xy);
         float vYLen    = length(vY);
         float dist     = length(offset);
         float zY       = sampledY.a;
@@ -113,6 +134,44 @@ float rand(vec2 co)
     return fract(sin(dot(co.xy, vec2(12.9898, 78.233)) * 43758.5453));
 }
 
+// Jitter in [0, 1) of a pixel, must match computeJitter in ReconstructReference.cpp
+float computeJitter(ivec2 pixel, vec2 uv)
+{
+    // Golden ratio rotation, so every frame gets a different but still well distributed set of offsets
+    float rotation = fract(float(cbRootConstants.frameIndex) * 0.61803398875);
+
+    if (cbRootConstants.jitterMode == JITTER_MODE_IGN)
+    {
+        vec2 p = vec2(pixel) + 5.588238 * float(cbRootConstants.frameIndex % 64);
+        return fract(52.9829189 * fract(dot(p, vec2(0.06711056, 0.00583715))));
+    }
+    if (cbRootConstants.jitterMode == JITTER_MODE_BLUE_NOISE)
+    {
+        ivec2 size = textureSize(blueNoiseTexture, 0);
+        return fract(texelFetch(blueNoiseTexture, pixel % size, 0).r + rotation);
+    }
+    if (cbRootConstants.jitterMode == JITTER_MODE_R2)
+    {
+        // 1 / plastic number and its square
+        return fract(0.5 + dot(vec2(pixel), vec2(0.75487766624, 0.56984029099)) + rotation);
+    }
+    return rand(uv);
+}
+
+// Velocity target value to half velocity, see VelocityEncoding.h. Affine, so it can be applied after filtering.
+vec2 decodeVelocity(vec2 raw)
+{
+    return raw * cbRootConstants.velocityDecodeScale + cbRootConstants.velocityDecodeBias;
+}
+
+// The neighbor texture is sized for the smallest K and only tileCount texels of it are in use.
+// Maps uv onto those and clamps to their edge like the sampler does at the edge of the texture.
+vec2 neighborUV(vec2 uv)
+{
+    vec2 tileCount = cbRootConstants.tileCount;
+    return clamp(uv * tileCount, vec2(0.5), tileCount - 0.5) / vec2(textureSize(neighborTexture, 0));
+}
+
 // Filters - impl
 float cone(float distance, float speed)
 {
@@ -0,0 +1,172 @@
+#include "VelocityEncoding.h"
+
+#include <math.h>
+
+#include "../../../../Common_3/ThirdParty/OpenSource/tinyimageformat/tinyimageformat_decode.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/tinyimageformat/tinyimageformat_encode.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/EASTL/vector.h"
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+
+#include "ReconstructReference.h"
+#include "VelocityTiles.h"
+#include "Random.h"
+
+// Shortest velocity the polar encoding keeps, anything shorter becomes 0
+static constexpr float POLAR_LOG_MIN_LENGTH = 1.0f / 32.0f;
+static constexpr float PI_F = 3.14159265358979f;
+
+TinyImageFormat getVelocityEncodingFormat(VelocityEncoding encoding)
+{
+    ASSERT(encoding < VELOCITY_ENCODING_GPU_COUNT);
+    return VELOCITY_ENCODING_FIXED_8 == encoding ? TinyImageFormat_R8G8_UNORM : TinyImageFormat_R16G16_SFLOAT;
+}
+
+void getVelocityEncodingParams(VelocityEncoding encoding, float kFactor, VelocityEncodingParams * pParams)
+{
+    ASSERT(pParams);
+    *pParams = VelocityEncodingParams();
+
+    if (VELOCITY_ENCODING_FIXED_8 == encoding)
+    {
+        // 128 is 0, so resting pixels decode to exactly 0. 1 to 255 cover -K / 2 to K / 2 in 127 steps each way.
+        float const halfK = kFactor * 0.5f;
+        pParams->mEncodeScale = 127.0f / (255.0f * halfK);
+        pParams->mEncodeBias = 128.0f / 255.0f;
+        pParams->mDecodeScale = halfK * 255.0f / 127.0f;
+        pParams->mDecodeBias = -halfK * 128.0f / 127.0f;
+    }
+}
+
+static inline float quantizeUnorm8(float x)
+{
+    x = x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+    return floorf(x * 255.0f + 0.5f) / 255.0f;
+}
+
+void quantizeVelocity(VelocityEncoding encoding, float kFactor, const float * pIn, float * pOut, uint32_t count)
+{
+    ASSERT(pIn && pOut);
+
+    switch (encoding)
+    {
+    case VELOCITY_ENCODING_HALF:
+        for (uint32_t i = 0; i < count * 2; ++i)
+            pOut[i] = TinyImageFormat_HalfAsUintToFloat(TinyImageFormat_FloatToHalfAsUint(pIn[i]));
+        break;
+
+    case VELOCITY_ENCODING_FIXED_8:
+    {
+        VelocityEncodingParams params;
+        getVelocityEncodingParams(encoding, kFactor, &params);
+        for (uint32_t i = 0; i < count * 2; ++i)
+            pOut[i] = quantizeUnorm8(pIn[i] * params.mEncodeScale + params.mEncodeBias) * params.mDecodeScale + params.mDecodeBias;
+        break;
+    }
+
+    case VELOCITY_ENCODING_POLAR_LOG_8:
+    {
+        // Log spacing between POLAR_LOG_MIN_LENGTH and K / 2, code 0 is reserved for 0
+        float const logRange = logf(kFactor * 0.5f / POLAR_LOG_MIN_LENGTH);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            float const x = pIn[i * 2 + 0];
+            float const y = pIn[i * 2 + 1];
+            float const length = sqrtf(x * x + y * y);
+            if (length < POLAR_LOG_MIN_LENGTH)
+            {
+                pOut[i * 2 + 0] = 0.0f;
+                pOut[i * 2 + 1] = 0.0f;
+                continue;
+            }
+
+            float const t = logf(length / POLAR_LOG_MIN_LENGTH) / logRange;
+            float const lengthCode = 1.0f + floorf((t < 1.0f ? t : 1.0f) * 254.0f + 0.5f);
+            float const angleCode = floorf((atan2f(y, x) + PI_F) / (2.0f * PI_F) * 256.0f + 0.5f);
+
+            float const decodedLength = POLAR_LOG_MIN_LENGTH * expf((lengthCode - 1.0f) / 254.0f * logRange);
+            float const decodedAngle = angleCode / 256.0f * 2.0f * PI_F - PI_F;
+            pOut[i * 2 + 0] = decodedLength * cosf(decodedAngle);
+            pOut[i * 2 + 1] = decodedLength * sinf(decodedAngle);
+        }
+        break;
+    }
+
+    default:
+        ASSERT(false);
+        break;
+    }
+}
+
+void measureVelocityQuantization(VelocityEncoding encoding, uint32_t tileSize, uint32_t reconstructSampleCount,
+    VelocityQuantizationStats * pStats)
+{
+    ASSERT(pStats);
+    *pStats = VelocityQuantizationStats();
+    pStats->mBitsPerPixel = VELOCITY_ENCODING_HALF == encoding ? 32 : 16;
+
+    float const kFactor = float(tileSize);
+    float const halfK = kFactor * 0.5f;
+
+    // Random half velocities, more of them short like in a real frame
+    uint32_t const sampleCount = 1 << 16;
+    eastl::vector<float> velocities(sampleCount * 2);
+    eastl::vector<float> quantized(sampleCount * 2);
+
+    uint32_t state = 1;
+    for (uint32_t i = 0; i < sampleCount; ++i)
+    {
+        float const u = randomUnorm(&state);
+        float const length = halfK * u * u;
+        float const angle = randomUnorm(&state) * 2.0f * PI_F;
+        velocities[i * 2 + 0] = length * cosf(angle);
+        velocities[i * 2 + 1] = length * sinf(angle);
+    }
+    quantizeVelocity(encoding, kFactor, velocities.data(), quantized.data(), sampleCount);
+
+    double errorSum = 0.0;
+    for (uint32_t i = 0; i < sampleCount; ++i)
+    {
+        float const x = velocities[i * 2 + 0];
+        float const y = velocities[i * 2 + 1];
+        float const dx = quantized[i * 2 + 0] - x;
+        float const dy = quantized[i * 2 + 1] - y;
+        double const error = sqrt(double(dx) * dx + double(dy) * dy);
+        double const length = sqrt(double(x) * x + double(y) * y);
+        double const quantizedLength = sqrt(double(quantized[i * 2 + 0]) * quantized[i * 2 + 0] + double(quantized[i * 2 + 1]) * quantized[i * 2 + 1]);
+
+        errorSum += error;
+        pStats->mMaxError = error > pStats->mMaxError ? error : pStats->mMaxError;
+        if (length >= 1.0)
+            pStats->mMaxRelativeError = error / length > pStats->mMaxRelativeError ? error / length : pStats->mMaxRelativeError;
+        pStats->mEarlyOutFlips += (length > 0.5) != (quantizedLength > 0.5) ? 1 : 0;
+    }
+    pStats->mMeanError = errorSum / sampleCount;
+    pStats->mSampleCount = sampleCount;
+
+    // The tile passes and the filter see the quantized velocities
+    ReconstructTestScene scene;
+    generateReconstructTestScene(160, 90, tileSize, &scene);
+    ReconstructInput const & input = scene.mInput;
+    uint32_t const pixelCount = input.mWidth * input.mHeight;
+
+    eastl::vector<float> quantizedVelocity(pixelCount * 2);
+    eastl::vector<float> tileMax(input.mTileWidth * input.mTileHeight * 2);
+    eastl::vector<float> neighborMax(input.mTileWidth * input.mTileHeight * 2);
+    quantizeVelocity(encoding, kFactor, input.pVelocity, quantizedVelocity.data(), pixelCount);
+    computeTileMax(quantizedVelocity.data(), input.mWidth, input.mHeight, tileSize, input.mTileWidth, input.mTileHeight, tileMax.data());
+    computeNeighborMax(tileMax.data(), input.mTileWidth, input.mTileHeight, neighborMax.data());
+
+    ReconstructInput quantizedInput = input;
+    quantizedInput.pVelocity = quantizedVelocity.data();
+    quantizedInput.pNeighborMax = neighborMax.data();
+
+    ReconstructSettings settings;
+    settings.mSampleCount = reconstructSampleCount;
+    settings.mJitterMode = JITTER_MODE_IGN;
+
+    eastl::vector<float> reference(pixelCount * 3);
+    eastl::vector<float> result(pixelCount * 3);
+    reconstructReference(&input, &settings, reference.data());
+    reconstructReference(&quantizedInput, &settings, result.data());
+    pStats->mReconstructPSNR = computePSNR(result.data(), reference.data(), pixelCount * 3);
+}
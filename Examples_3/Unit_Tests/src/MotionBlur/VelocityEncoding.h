@@ -0,0 +1,57 @@
+// Encodings of the half velocity in the velocity target, and a CPU harness measuring what they lose.
+// The velocity is clamped to K by the G-buffer pass, so the half velocity never gets longer than K / 2 and a fixed
+// point format relative to K covers it. The fixed point encoding is affine, so the bilinear filtering the
+// reconstruction does on the raw values gives the same result as filtering the decoded ones. The shaders decode with
+// raw * decodeScale + decodeBias and the G-buffer encodes with v * encodeScale + encodeBias, both from
+// getVelocityEncodingParams. The polar / log encoding only exists here for comparison, interpolating angles and
+// logarithms does not give the interpolated velocity, so it cannot go through the samplers.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../../../../Common_3/ThirdParty/OpenSource/tinyimageformat/tinyimageformat_base.h"
+
+enum VelocityEncoding
+{
+    VELOCITY_ENCODING_HALF = 0,        // R16G16_SFLOAT, the original target
+    VELOCITY_ENCODING_FIXED_8,         // R8G8_UNORM, signed fixed point relative to K / 2
+    VELOCITY_ENCODING_GPU_COUNT,
+    VELOCITY_ENCODING_POLAR_LOG_8 = VELOCITY_ENCODING_GPU_COUNT,   // 8 bit angle and 8 bit log length, CPU only
+    VELOCITY_ENCODING_COUNT,
+};
+
+struct VelocityEncodingParams
+{
+    float   mEncodeScale    = 1.0f;
+    float   mEncodeBias     = 0.0f;
+    float   mDecodeScale    = 1.0f;
+    float   mDecodeBias     = 0.0f;
+};
+
+// Velocity target format of the encodings the GPU renders
+TinyImageFormat getVelocityEncodingFormat(VelocityEncoding encoding);
+
+// Constants of the affine encodings for tile size K
+void getVelocityEncodingParams(VelocityEncoding encoding, float kFactor, VelocityEncodingParams * pParams);
+
+// Round trips count xy pairs through the storage of the encoding, pIn and pOut may be the same
+void quantizeVelocity(VelocityEncoding encoding, float kFactor, const float * pIn, float * pOut, uint32_t count);
+
+struct VelocityQuantizationStats
+{
+    uint32_t    mBitsPerPixel       = 0;
+    // Error of the half velocity in pixels, over random velocities up to K / 2
+    double      mMeanError          = 0.0;
+    double      mMaxError           = 0.0;
+    // Over the velocities of at least one pixel
+    double      mMaxRelativeError   = 0.0;
+    // Velocities which end up on the other side of the 0.5 pixel early out of the reconstruction
+    uint32_t    mEarlyOutFlips      = 0;
+    uint32_t    mSampleCount        = 0;
+    // Reconstruction of the test scene from the quantized velocities against the one from the unquantized velocities
+    double      mReconstructPSNR    = 0.0;
+};
+
+void measureVelocityQuantization(VelocityEncoding encoding, uint32_t tileSize, uint32_t reconstructSampleCount,
+    VelocityQuantizationStats * pStats);
@@ -0,0 +1,196 @@
+#include "VelocityTiles.h"
+#include "Random.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "../../../../Common_3/ThirdParty/OpenSource/EASTL/vector.h"
+
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+
+// vmax() of the shaders, ties keep v1
+static inline void velocityMax(float & x1, float & y1, float x2, float y2)
+{
+    float const d = (x1 * x1 + y1 * y1) - (x2 * x2 + y2 * y2);
+    if (d < 0.0f)
+    {
+        x1 = x2;
+        y1 = y2;
+    }
+}
+
+// texelFetch outside of the texture reads zero
+static inline void fetchVelocity(const float * pVelocity, uint32_t width, uint32_t height, uint32_t x, uint32_t y, float & outX, float & outY)
+{
+    if (x < width && y < height)
+    {
+        outX = pVelocity[(y * width + x) * 2 + 0];
+        outY = pVelocity[(y * width + x) * 2 + 1];
+    }
+    else
+    {
+        outX = 0.0f;
+        outY = 0.0f;
+    }
+}
+
+static void computeSingleTileMax(const float * pVelocity, uint32_t width, uint32_t height, uint32_t tileSize,
+    uint32_t tileX, uint32_t tileY, float & outX, float & outY)
+{
+    outX = 0.0f;
+    outY = 0.0f;
+    for (uint32_t u = 0; u < tileSize; ++u)
+    {
+        for (uint32_t v = 0; v < tileSize; ++v)
+        {
+            float x, y;
+            fetchVelocity(pVelocity, width, height, tileX * tileSize + v, tileY * tileSize + u, x, y);
+            velocityMax(outX, outY, x, y);
+        }
+    }
+}
+
+void getVelocityTileCount(uint32_t width, uint32_t height, uint32_t tileSize, uint32_t * pTileWidth, uint32_t * pTileHeight)
+{
+    ASSERT(tileSize);
+    ASSERT(pTileWidth && pTileHeight);
+
+    *pTileWidth = width / tileSize;
+    *pTileHeight = height / tileSize;
+}
+
+void computeTileMax(const float * pVelocity, uint32_t width, uint32_t height, uint32_t tileSize,
+    uint32_t tileWidth, uint32_t tileHeight, float * pTileMax)
+{
+    ASSERT(pVelocity && pTileMax);
+
+    for (uint32_t y = 0; y < tileHeight; ++y)
+    {
+        for (uint32_t x = 0; x < tileWidth; ++x)
+        {
+            float * pOut = pTileMax + (y * tileWidth + x) * 2;
+            computeSingleTileMax(pVelocity, width, height, tileSize, x, y, pOut[0], pOut[1]);
+        }
+    }
+}
+
+void computeNeighborMax(const float * pTileMax, uint32_t tileWidth, uint32_t tileHeight, float * pNeighborMax)
+{
+    ASSERT(pTileMax && pNeighborMax);
+
+    for (uint32_t y = 0; y < tileHeight; ++y)
+    {
+        for (uint32_t x = 0; x < tileWidth; ++x)
+        {
+            float maxX = 0.0f;
+            float maxY = 0.0f;
+            // u offsets x and v offsets y, the same order as in the shader
+            for (int u = -1; u <= 1; ++u)
+            {
+                for (int v = -1; v <= 1; ++v)
+                {
+                    float sampleX, sampleY;
+                    fetchVelocity(pTileMax, tileWidth, tileHeight, uint32_t(int(x) + u), uint32_t(int(y) + v), sampleX, sampleY);
+                    velocityMax(maxX, maxY, sampleX, sampleY);
+                }
+            }
+
+            pNeighborMax[(y * tileWidth + x) * 2 + 0] = maxX;
+            pNeighborMax[(y * tileWidth + x) * 2 + 1] = maxY;
+        }
+    }
+}
+
+void computeFusedNeighborMax(const float * pVelocity, uint32_t width, uint32_t height, uint32_t tileSize,
+    uint32_t tileWidth, uint32_t tileHeight, float * pNeighborMax)
+{
+    ASSERT(pVelocity && pNeighborMax);
+
+    uint32_t const groupSize = VELOCITY_TILES_GROUP_SIZE;
+    uint32_t const haloSize = groupSize + 2;
+
+    // Shared memory of one workgroup
+    eastl::vector<float> tileMax(haloSize * haloSize * 2);
+
+    for (uint32_t groupY = 0; groupY < (tileHeight + groupSize - 1) / groupSize; ++groupY)
+    {
+        for (uint32_t groupX = 0; groupX < (tileWidth + groupSize - 1) / groupSize; ++groupX)
+        {
+            int const haloStartX = int(groupX * groupSize) - 1;
+            int const haloStartY = int(groupY * groupSize) - 1;
+
+            for (uint32_t i = 0; i < haloSize * haloSize; ++i)
+            {
+                int const tileX = haloStartX + int(i % haloSize);
+                int const tileY = haloStartY + int(i / haloSize);
+
+                float & outX = tileMax[i * 2 + 0];
+                float & outY = tileMax[i * 2 + 1];
+                if (tileX >= 0 && tileY >= 0 && tileX < int(tileWidth) && tileY < int(tileHeight))
+                {
+                    computeSingleTileMax(pVelocity, width, height, tileSize, uint32_t(tileX), uint32_t(tileY), outX, outY);
+                }
+                else
+                {
+                    outX = 0.0f;
+                    outY = 0.0f;
+                }
+            }
+
+            for (uint32_t localY = 0; localY < groupSize; ++localY)
+            {
+                for (uint32_t localX = 0; localX < groupSize; ++localX)
+                {
+                    uint32_t const x = groupX * groupSize + localX;
+                    uint32_t const y = groupY * groupSize + localY;
+                    // imageStore outside of the texture is dropped
+                    if (x >= tileWidth || y >= tileHeight)
+                        continue;
+
+                    float maxX = 0.0f;
+                    float maxY = 0.0f;
+                    for (int u = -1; u <= 1; ++u)
+                    {
+                        for (int v = -1; v <= 1; ++v)
+                        {
+                            uint32_t const index = uint32_t(int(localY) + 1 + v) * haloSize + uint32_t(int(localX) + 1 + u);
+                            velocityMax(maxX, maxY, tileMax[index * 2 + 0], tileMax[index * 2 + 1]);
+                        }
+                    }
+
+                    pNeighborMax[(y * tileWidth + x) * 2 + 0] = maxX;
+                    pNeighborMax[(y * tileWidth + x) * 2 + 1] = maxY;
+                }
+            }
+        }
+    }
+}
+
+uint32_t compareFusedNeighborMaxModels(uint32_t width, uint32_t height, uint32_t tileSize, uint32_t seed)
+{
+    uint32_t tileWidth, tileHeight;
+    getVelocityTileCount(width, height, tileSize, &tileWidth, &tileHeight);
+
+    uint32_t state = seed;
+    eastl::vector<float> velocity(width * height * 2);
+    for (float & v : velocity)
+    {
+        // Multiples of 1/16 in [-64, 64] are exact in half floats, the coarse steps also give the tie-breaking some work
+        v = (floorf(randomUnorm(&state) * 2048.0f) - 1024.0f) / 16.0f;
+    }
+
+    eastl::vector<float> tileMax(tileWidth * tileHeight * 2);
+    eastl::vector<float> neighborMax(tileWidth * tileHeight * 2);
+    eastl::vector<float> fusedNeighborMax(tileWidth * tileHeight * 2);
+    computeTileMax(velocity.data(), width, height, tileSize, tileWidth, tileHeight, tileMax.data());
+    computeNeighborMax(tileMax.data(), tileWidth, tileHeight, neighborMax.data());
+    computeFusedNeighborMax(velocity.data(), width, height, tileSize, tileWidth, tileHeight, fusedNeighborMax.data());
+
+    uint32_t mismatchCount = 0;
+    for (uint32_t i = 0; i < tileWidth * tileHeight; ++i)
+    {
+        if (memcmp(&neighborMax[i * 2], &fusedNeighborMax[i * 2], sizeof(float) * 2))
+            ++mismatchCount;
+    }
+    return mismatchCount;
+}
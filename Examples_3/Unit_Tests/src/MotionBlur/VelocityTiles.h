@@ -0,0 +1,29 @@
+// CPU versions of the tile max and neighbor max passes (tile.comp, neighbor.comp and the fused tile_neighbor.comp).
+// Velocities are interleaved xy pairs. The functions follow the loop order and the vmax tie-breaking of the shaders,
+// they have not been compared against a GPU readback.
+// The fused version follows the workgroup layout of tile_neighbor.comp, so the two CPU models can be compared against
+// each other, see compareFusedNeighborMaxModels. That does not check the shader itself.
+
+#pragma once
+
+#include <stdint.h>
+
+static constexpr uint32_t VELOCITY_TILES_GROUP_SIZE = 8;
+
+// Tile grid used by the passes, partial tiles at the right and bottom edges are dropped
+void getVelocityTileCount(uint32_t width, uint32_t height, uint32_t tileSize, uint32_t * pTileWidth, uint32_t * pTileHeight);
+
+// tile.comp, pTileMax holds tileWidth * tileHeight pairs
+void computeTileMax(const float * pVelocity, uint32_t width, uint32_t height, uint32_t tileSize,
+    uint32_t tileWidth, uint32_t tileHeight, float * pTileMax);
+
+// neighbor.comp, pNeighborMax holds tileWidth * tileHeight pairs
+void computeNeighborMax(const float * pTileMax, uint32_t tileWidth, uint32_t tileHeight, float * pNeighborMax);
+
+// tile_neighbor.comp, same output as computeTileMax followed by computeNeighborMax
+void computeFusedNeighborMax(const float * pVelocity, uint32_t width, uint32_t height, uint32_t tileSize,
+    uint32_t tileWidth, uint32_t tileHeight, float * pNeighborMax);
+
+// Runs computeFusedNeighborMax and computeTileMax + computeNeighborMax on a random velocity field of half float
+// values and returns the number of neighbor max tiles which differ in any bit
+uint32_t compareFusedNeighborMaxModels(uint32_t width, uint32_t height, uint32_t tileSize, uint32_t seed);
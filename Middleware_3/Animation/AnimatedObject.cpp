@@ -39,30 +39,106 @@ void MultiplySoATransformQuaternion(int _index, const Quat& _quat, ozz::Range<So
 
 	transpose4x4(aos_quats, &soa_transform_ref.rotation.x);
 }
+
+// Interpolates each of the 4 joints of _a and _b by the matching element of _f, rotations take the shortest path
+SoaTransform InterpolateSoATransform(const SoaTransform& _a, const SoaTransform& _b, const Vector4& _f)
+{
+	const Vector4 dot = mulPerElem(_a.rotation.x, _b.rotation.x) + mulPerElem(_a.rotation.y, _b.rotation.y) +
+						mulPerElem(_a.rotation.z, _b.rotation.z) + mulPerElem(_a.rotation.w, _b.rotation.w);
+	const Vector4Int    sign = signBit(dot);
+	const SoaQuaternion rotation = { xorPerElem(_b.rotation.x, sign), xorPerElem(_b.rotation.y, sign), xorPerElem(_b.rotation.z, sign),
+									 xorPerElem(_b.rotation.w, sign) };
+
+	const SoaTransform result = { Lerp(_a.translation, _b.translation, _f), NLerpEst(_a.rotation, rotation, _f),
+								  Lerp(_a.scale, _b.scale, _f) };
+	return result;
+}
+
+inline bool AllElementsEqual(const Vector4& _v, float _value)
+{
+	return _v.getX() == _value && _v.getY() == _value && _v.getZ() == _value && _v.getW() == _value;
+}
 }    // namespace
 
-void AnimatedObject::Initialize(Rig* rig, Animation* animation)
+void AnimatedObject::Initialize(Rig* rig, Animation* animation, ozz::memory::Allocator* allocator)
 {
 	mRig = rig;
 	mAnimation = animation;
-
-	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+	mAllocator = allocator ? allocator : ozz::memory::default_allocator();
 
 	// Allocates sampler runtime buffer.
-	mLocalTrans = allocator->AllocateRange<SoaTransform>(rig->GetNumSoaJoints());
+	mLocalTrans = mAllocator->AllocateRange<SoaTransform>(rig->GetNumSoaJoints());
 }
 
 void AnimatedObject::Destroy()
 {
-	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
-	allocator->Deallocate(mLocalTrans);
+	mAllocator->Deallocate(mLocalTrans);
+	mAllocator->Deallocate(mSampledTrans[0]);
+	mAllocator->Deallocate(mSampledTrans[1]);
+	mSampledTrans[0] = ozz::Range<SoaTransform>();
+	mSampledTrans[1] = ozz::Range<SoaTransform>();
+	mSamplesValid = false;
 }
 
-bool AnimatedObject::Update(float dt)
+void AnimatedObject::SetLOD(const AnimationLOD& lod)
 {
-	// sample the current animation to get mLocalTrans
-	if (!mAnimation->Sample(dt, mLocalTrans))
-		return false;
+	ASSERT(lod.mUpdateInterval > 0);
+
+	mLOD = lod;
+	mRig->SetUpdateBones(lod.mPoseBones);
+
+	if (lod.mUpdateInterval > 1 && !mSampledTrans[0].begin)
+	{
+		mSampledTrans[0] = mAllocator->AllocateRange<SoaTransform>(mRig->GetNumSoaJoints());
+		mSampledTrans[1] = mAllocator->AllocateRange<SoaTransform>(mRig->GetNumSoaJoints());
+	}
+
+	// Start over from a fresh sample instead of interpolating from one taken at another rate
+	mSamplesValid = false;
+}
+
+bool AnimatedObject::Update(float dt, AnimationScratch* scratch)
+{
+	if (mLOD.mUpdateInterval <= 1)
+	{
+		// sample the current animation to get mLocalTrans
+		if (!(scratch ? mAnimation->Sample(dt, mLocalTrans, scratch) : mAnimation->Sample(dt, mLocalTrans)))
+			return false;
+
+		if (mLOD.mJointMask)
+			ApplyJointMask();
+	}
+	else
+	{
+		mTimeSinceSample += dt;
+		++mUpdatesSinceSample;
+
+		if (!mSamplesValid || mUpdatesSinceSample >= mLOD.mUpdateInterval)
+		{
+			// Advance the animation by all the time since the last sample
+			mCurrentSample ^= 1;
+			ozz::Range<SoaTransform>& sample = mSampledTrans[mCurrentSample];
+			if (!(scratch ? mAnimation->Sample(mTimeSinceSample, sample, scratch) : mAnimation->Sample(mTimeSinceSample, sample)))
+				return false;
+
+			mUpdatesSinceSample = 0;
+
+			// Nothing to interpolate from yet
+			if (!mSamplesValid)
+			{
+				SoaTransform* previousSample = mSampledTrans[mCurrentSample ^ 1].begin;
+				for (unsigned int i = 0; i < mRig->GetNumSoaJoints(); ++i)
+					previousSample[i] = sample.begin[i];
+				mUpdatesSinceSample = mLOD.mUpdateOffset % mLOD.mUpdateInterval;
+				mSamplesValid = true;
+			}
+
+			mSampleDeltaTime = mTimeSinceSample;
+			mTimeSinceSample = 0.0f;
+		}
+
+		InterpolateSamples(mSampleDeltaTime > 0.0f ? min(mTimeSinceSample / mSampleDeltaTime, 1.0f) : 1.0f);
+	}
 
 	// Local to model job
 
@@ -79,6 +155,53 @@ bool AnimatedObject::Update(float dt)
 	return true;
 }
 
+void AnimatedObject::ApplyJointMask()
+{
+	ozz::Range<const SoaTransform> bindPose = mRig->GetSkeleton()->bind_pose();
+	ozz::Range<Vector4>            weights = mLOD.mJointMask->GetJointWeights();
+
+	for (unsigned int i = 0; i < mRig->GetNumSoaJoints(); i++)
+	{
+		const Vector4& weight = weights[i];
+		if (AllElementsEqual(weight, 1.0f))
+			continue;
+
+		mLocalTrans[i] = AllElementsEqual(weight, 0.0f) ? bindPose[i] : InterpolateSoATransform(bindPose[i], mLocalTrans[i], weight);
+	}
+}
+
+void AnimatedObject::InterpolateSamples(float ratio)
+{
+	const ozz::Range<SoaTransform>& from = mSampledTrans[mCurrentSample ^ 1];
+	const ozz::Range<SoaTransform>& to = mSampledTrans[mCurrentSample];
+	const Vector4                   f(ratio);
+
+	if (!mLOD.mJointMask)
+	{
+		for (unsigned int i = 0; i < mRig->GetNumSoaJoints(); i++)
+			mLocalTrans[i] = InterpolateSoATransform(from[i], to[i], f);
+		return;
+	}
+
+	// Masked out joints skip the interpolation
+	ozz::Range<const SoaTransform> bindPose = mRig->GetSkeleton()->bind_pose();
+	ozz::Range<Vector4>            weights = mLOD.mJointMask->GetJointWeights();
+
+	for (unsigned int i = 0; i < mRig->GetNumSoaJoints(); i++)
+	{
+		const Vector4& weight = weights[i];
+		if (AllElementsEqual(weight, 0.0f))
+		{
+			mLocalTrans[i] = bindPose[i];
+			continue;
+		}
+
+		mLocalTrans[i] = InterpolateSoATransform(from[i], to[i], f);
+		if (!AllElementsEqual(weight, 1.0f))
+			mLocalTrans[i] = InterpolateSoATransform(bindPose[i], mLocalTrans[i], weight);
+	}
+}
+
 bool AnimatedObject::AimIK(AimIKDesc* params, Point3 target)
 {
 	ozz::Range<Matrix4> models = mRig->GetJointModelMats();
@@ -31,6 +31,7 @@
 
 #include "Rig.h"
 #include "Animation.h"
+#include "ClipMask.h"
 
 struct AimIKDesc
 {
@@ -82,18 +83,39 @@ struct TwoBonesIKDesc
 	bool mReached;
 };
 
+// Level of detail of an AnimatedObject, for objects that are small on screen or far away
+struct AnimationLOD
+{
+	// Samples the animation only every mUpdateInterval updates, the updates in between interpolate the local transforms
+	// of the last two samples. The pose trails the animation by one interval in exchange.
+	unsigned int mUpdateInterval = 1;
+	// Shifts the updates that sample, objects with the same interval and different offsets spread their samples over
+	// the frames instead of all sampling in the same one
+	unsigned int mUpdateOffset = 0;
+	// Joints with a weight of 0 in the mask keep their bind pose and are not interpolated, weights in between blend
+	// toward it. NULL animates all joints
+	ClipMask*    mJointMask = NULL;
+	// Whether posing the rig computes the bone matrices, which are only needed to draw the skeleton
+	bool         mPoseBones = true;
+};
+
 // Responsible for coordinating the posing of a Rig by an Animation
 class AnimatedObject
 {
 	public:
 	// Set up an Animated object with the Rig it will be posing and the default animation to play when idle
-	void Initialize(Rig* rig, Animation* animation);
+	// The sampling buffers come from allocator, such as an AnimationArena, or the default allocator if NULL
+	void Initialize(Rig* rig, Animation* animation, ozz::memory::Allocator* allocator = NULL);
 
 	// Must be called to clean up the system if it has been initialized
 	void Destroy();
 
 	// To be called every frame of the main application, handles sampling and updating the current animation
-	bool Update(float dt);
+	// A scratch shared with other objects can be passed to sample into, see AnimationWorld
+	bool Update(float dt, AnimationScratch* scratch = NULL);
+
+	// Set the level of detail, takes effect on the next update
+	void SetLOD(const AnimationLOD& lod);
 
 	bool AimIK(AimIKDesc* params, Point3 target);
 
@@ -115,7 +137,16 @@ class AnimatedObject
 	// Get the rig of this animated object
 	inline Rig* GetRig() { return mRig; };
 
+	// Get the level of detail of this animated object
+	inline const AnimationLOD& GetLOD() const { return mLOD; };
+
 	private:
+	// Replaces the joints masked out by mLOD with the bind pose
+	void ApplyJointMask();
+
+	// Interpolates the last two samples into mLocalTrans
+	void InterpolateSamples(float ratio);
+
 	// The Rig the AnimatedObject will be posing
 	Rig* mRig;
 
@@ -125,6 +156,21 @@ class AnimatedObject
 	// Buffer of local transforms as sampled from the animation.
 	ozz::Range<SoaTransform> mLocalTrans;
 
+	// Allocator of mLocalTrans and mSampledTrans
+	ozz::memory::Allocator* mAllocator;
+
 	// Transform to apply to entire rig
 	Matrix4 mRootTransform = Matrix4::identity();
+
+	AnimationLOD mLOD;
+
+	// The last two samples when the update interval is above 1, mCurrentSample selects the newer one
+	ozz::Range<SoaTransform> mSampledTrans[2];
+	unsigned int             mCurrentSample = 0;
+	bool                     mSamplesValid = false;
+
+	// Updates and time since the newer sample and the time between the last two samples
+	unsigned int mUpdatesSinceSample = 0;
+	float        mTimeSinceSample = 0.0f;
+	float        mSampleDeltaTime = 0.0f;
 };
@@ -29,8 +29,9 @@ void Animation::Initialize(AnimationDesc animationDesc)
 	mRig = animationDesc.mRig;
 	mNumClips = min(animationDesc.mNumLayers, MAX_NUM_CLIPS);
 	mBlendType = animationDesc.mBlendType;
+	mAllocator = animationDesc.mAllocator ? animationDesc.mAllocator : ozz::memory::default_allocator();
 
-	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+	ozz::memory::Allocator* allocator = mAllocator;
 
 	for (unsigned int i = 0; i < mNumClips; i++)
 	{
@@ -51,13 +52,10 @@ void Animation::Initialize(AnimationDesc animationDesc)
 			mLongestClipIndex = i;
 		}
 
-		// Prepare input and output of clip sampling
-
-		// Allocates sampler runtime buffers.
-		mClipLocalTrans[i] = allocator->AllocateRange<SoaTransform>(mRig->GetNumSoaJoints());
+		// Prepare input of clip sampling, the output buffers are allocated on first use
 
 		// Allocates a cache that matches animation requirements.
-		mClipSamplingCaches[i] = allocator->New<ozz::animation::SamplingCache>(mRig->GetNumJoints());
+		mClipSamplingCaches[i] = allocator->New<ozz::animation::SamplingCache>(mRig->GetNumJoints(), allocator);
 	}
 
 	// Allocate the blend layers that will be set each sampling based on each clip's properties
@@ -67,18 +65,32 @@ void Animation::Initialize(AnimationDesc animationDesc)
 
 void Animation::Destroy()
 {
-	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+	ozz::memory::Allocator* allocator = mAllocator;
 
 	for (unsigned int i = 0; i < mNumClips; i++)
 	{
 		allocator->Delete(mClipSamplingCaches[i]);
-		allocator->Deallocate(mClipLocalTrans[i]);
+		allocator->Deallocate(mScratch.mClipLocalTrans[i]);
+		mScratch.mClipLocalTrans[i] = ozz::Range<SoaTransform>();
 	}
 	allocator->Deallocate(mLayers);
 	allocator->Deallocate(mAdditiveLayers);
 }
 
 bool Animation::Sample(float dt, ozz::Range<SoaTransform>& localTrans)
+{
+	if (!mScratch.mClipLocalTrans[0].begin)
+	{
+		// Allocates sampler runtime buffers.
+		ozz::memory::Allocator* allocator = mAllocator;
+		for (unsigned int i = 0; i < mNumClips; i++)
+			mScratch.mClipLocalTrans[i] = allocator->AllocateRange<SoaTransform>(mRig->GetNumSoaJoints());
+	}
+
+	return Sample(dt, localTrans, &mScratch);
+}
+
+bool Animation::Sample(float dt, ozz::Range<SoaTransform>& localTrans, AnimationScratch* scratch)
 {
 	//update blend and sample parameters
 	if (mAutoSetBlendParams)
@@ -96,7 +108,7 @@ bool Animation::Sample(float dt, ozz::Range<SoaTransform>& localTrans)
 		if (mClipControllers[i]->GetWeight() != 0.f)
 		{
 			//if (!mClips[i]->Sample(mClipControllers[i]->GetTimeRatio()))
-			if (!mClips[i]->Sample(mClipSamplingCaches[i], mClipLocalTrans[i], mClipControllers[i]->GetTimeRatio()))
+			if (!mClips[i]->Sample(mClipSamplingCaches[i], scratch->mClipLocalTrans[i], mClipControllers[i]->GetTimeRatio()))
 				return false;
 		}
 	}
@@ -105,7 +117,7 @@ bool Animation::Sample(float dt, ozz::Range<SoaTransform>& localTrans)
 	mTimeRatio = mClipControllers[mLongestClipIndex]->GetTimeRatio();
 
 	//blend these samples together
-	return Blend(localTrans);
+	return Blend(localTrans, scratch);
 }
 
 void Animation::UpdateBlendParameters()
@@ -182,14 +194,14 @@ void Animation::UpdateBlendParameters()
 	}
 }
 
-bool Animation::Blend(ozz::Range<SoaTransform>& localTrans)
+bool Animation::Blend(ozz::Range<SoaTransform>& localTrans, AnimationScratch* scratch)
 {
 	unsigned int additiveIndex = 0;
 	for (unsigned int i = 0; i < mNumClips; i++)
 	{
 		if (mClipControllers[i]->IsAdditive())
 		{
-			mAdditiveLayers[additiveIndex].transform = mClipLocalTrans[i];
+			mAdditiveLayers[additiveIndex].transform = scratch->mClipLocalTrans[i];
 			mAdditiveLayers[additiveIndex].weight = mClipControllers[i]->GetWeight();
 
 			if (mClipMasks[i])
@@ -201,7 +213,7 @@ bool Animation::Blend(ozz::Range<SoaTransform>& localTrans)
 		}
 		else
 		{
-			mLayers[i].transform = mClipLocalTrans[i];
+			mLayers[i].transform = scratch->mClipLocalTrans[i];
 			mLayers[i].weight = mClipControllers[i]->GetWeight();
 
 			if (mClipMasks[i])
@@ -56,6 +56,13 @@ enum BlendType
 	MANUAL    // The user is always responsible for setting all the animations weights and playback speeds
 };
 
+// Sampling output of each clip, only needed while an animation samples and blends. Animations sampled one after the
+// other on the same thread can share one instead of each holding its own, see AnimationWorld.
+struct AnimationScratch
+{
+	ozz::Range<SoaTransform> mClipLocalTrans[MAX_NUM_CLIPS];
+};
+
 // User will have to predefine to pass into Animation's intialize function
 struct AnimationDesc
 {
@@ -63,6 +70,8 @@ struct AnimationDesc
 	unsigned int  mNumLayers;
 	LayerProperty mLayerProperties[MAX_NUM_CLIPS];
 	BlendType     mBlendType = BlendType::EQUAL;
+	// Allocator of the per instance sampling state, such as an AnimationArena. The default allocator if NULL
+	ozz::memory::Allocator* mAllocator = NULL;
 };
 
 // Allows for blending and sampling of loaded clips
@@ -78,6 +87,9 @@ class Animation
 	// Will sample the animation at dt, storing the local transform results in localTrans
 	bool Sample(float dt, ozz::Range<SoaTransform>& localTrans);
 
+	// Same as above with the per clip sampling output in scratch, which needs GetNumSoaJoints() transforms per clip
+	bool Sample(float dt, ozz::Range<SoaTransform>& localTrans, AnimationScratch* scratch);
+
 	// Set if UpdateBlendParameters() be called or not
 	inline void SetAutoSetBlendParams(bool setValue) { mAutoSetBlendParams = setValue; };
 
@@ -104,11 +116,14 @@ class Animation
 	void UpdateBlendParameters();
 
 	// Blend the sampled clips together based on their blend parameters
-	bool Blend(ozz::Range<SoaTransform>& localTrans);
+	bool Blend(ozz::Range<SoaTransform>& localTrans, AnimationScratch* scratch);
 
 	// Pointer to the rig that this animation corresponds to
 	Rig* mRig;
 
+	// Allocator of the sampling caches, blend layers and mScratch
+	ozz::memory::Allocator* mAllocator;
+
 	// Array of objects responsible for managing clip specifc sample and blend properties
 	ClipController* mClipControllers[MAX_NUM_CLIPS];
 
@@ -121,8 +136,9 @@ class Animation
 	// Sampling cache that will be given as input when each clip is sampled
 	ozz::animation::SamplingCache* mClipSamplingCaches[MAX_NUM_CLIPS];
 
-	// The buffer of local transforms that will be updated as output when each clip is sampled
-	ozz::Range<SoaTransform> mClipLocalTrans[MAX_NUM_CLIPS];
+	// The buffers of local transforms that will be updated as output when each clip is sampled
+	// Only allocated once the animation is sampled without a scratch of its caller
+	AnimationScratch mScratch = {};
 
 	// The blend layers that will be set each sampling based on each clip's properties
 	ozz::Range<ozz::animation::BlendingJob::Layer> mLayers;
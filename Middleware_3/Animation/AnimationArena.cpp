@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2018-2020 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#include "AnimationArena.h"
+
+#include "../../Common_3/OS/Interfaces/ILog.h"
+
+#include "../../Common_3/OS/Interfaces/IMemory.h"
+
+void AnimationArena::Initialize(size_t blockSize)
+{
+	ASSERT(blockSize > 0);
+
+	mBlockSize = blockSize;
+	mCursor = NULL;
+	mEnd = NULL;
+	mUsedSize = 0;
+	mReservedSize = 0;
+}
+
+void AnimationArena::Destroy()
+{
+	for (Block& block : mBlocks)
+		tf_free(block.mData);
+
+	mBlocks.set_capacity(0);
+	mCursor = NULL;
+	mEnd = NULL;
+	mUsedSize = 0;
+	mReservedSize = 0;
+}
+
+void AnimationArena::Reset()
+{
+	if (mBlocks.empty())
+		return;
+
+	for (unsigned int i = 1; i < mBlocks.size(); ++i)
+		tf_free(mBlocks[i].mData);
+	mBlocks.resize(1);
+
+	mCursor = mBlocks[0].mData;
+	mEnd = mCursor + mBlocks[0].mSize;
+	mUsedSize = 0;
+	mReservedSize = mBlocks[0].mSize;
+}
+
+void* AnimationArena::Allocate(size_t size, size_t alignment)
+{
+	uintptr_t aligned = ((uintptr_t)mCursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	if (!mCursor || aligned + size > (uintptr_t)mEnd)
+	{
+		// Start a new block, the rest of the last one is not used anymore
+		const size_t blockSize = size + alignment > mBlockSize ? size + alignment : mBlockSize;
+		Block        block = { (char*)tf_memalign(ozz::memory::kDefaultAlignment, blockSize), blockSize };
+		if (!block.mData)
+			return NULL;
+
+		mBlocks.push_back(block);
+		mReservedSize += blockSize;
+		mCursor = block.mData;
+		mEnd = block.mData + blockSize;
+		aligned = ((uintptr_t)mCursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	}
+
+	mUsedSize += aligned + size - (uintptr_t)mCursor;
+	mCursor = (char*)(aligned + size);
+	return (void*)aligned;
+}
+
+void AnimationArena::Deallocate(void* /*block*/) {}
+
+void* AnimationArena::Reallocate(void* block, size_t size, size_t alignment)
+{
+	ASSERT(!block && "AnimationArena cannot reallocate");
+	return block ? NULL : Allocate(size, alignment);
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2018-2020 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#pragma once
+
+#include "../../Common_3/ThirdParty/OpenSource/EASTL/vector.h"
+
+#include "../../Common_3/ThirdParty/OpenSource/ozz-animation/include/ozz/base/memory/allocator.h"
+
+// Linear allocator for the per instance state of many animations: sampling caches, blend layers and sampling buffers.
+// Packs the state of all instances into a few large blocks instead of many small heap allocations. Deallocate does
+// nothing, the memory is only given back by Reset or Destroy. Not thread safe, instances are expected to be set up
+// on one thread (updating them in parallel afterwards is fine).
+class AnimationArena : public ozz::memory::Allocator
+{
+	public:
+	// The arena takes blocks of blockSize bytes from the heap as it fills up, larger allocations get a block of their own
+	void Initialize(size_t blockSize);
+
+	// Must be called to clean up the arena if it was initialized, after everything allocated from it was destroyed
+	void Destroy();
+
+	// Frees everything allocated from the arena at once, after everything allocated from it was destroyed.
+	// Keeps the first block around for reuse
+	void Reset();
+
+	// Bytes handed out since the last reset, including alignment padding
+	inline size_t GetUsedSize() const { return mUsedSize; };
+
+	// Bytes taken from the heap
+	inline size_t GetReservedSize() const { return mReservedSize; };
+
+	void* Allocate(size_t size, size_t alignment) override;
+
+	void Deallocate(void* block) override;
+
+	// Only supports NULL blocks, the arena does not track the size of its allocations
+	void* Reallocate(void* block, size_t size, size_t alignment) override;
+
+	private:
+	struct Block
+	{
+		char*  mData;
+		size_t mSize;
+	};
+
+	eastl::vector<Block> mBlocks;
+	size_t               mBlockSize;
+
+	// Free space of the last block
+	char* mCursor;
+	char* mEnd;
+
+	size_t mUsedSize;
+	size_t mReservedSize;
+};
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2018-2020 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+
+#include "AnimationWorld.h"
+
+#include "../../Common_3/OS/Core/Atomics.h"
+#include "../../Common_3/OS/Core/ThreadSystem.h"
+
+#include "../../Common_3/OS/Interfaces/IMemory.h"
+
+// A few tasks per thread so characters with costly animations even out
+const unsigned int TASKS_PER_THREAD = 4;
+
+void AnimationWorld::Initialize(ThreadSystem* threadSystem, unsigned int maxJoints)
+{
+	mThreadSystem = threadSystem;
+	mMaxSoaJoints = (maxJoints + 3) / 4;
+
+	const unsigned int threadCount = threadSystem ? getThreadSystemThreadCount(threadSystem) + 1 : 1;
+	mScratches.resize(threadCount * TASKS_PER_THREAD);
+
+	// Allocates sampler runtime buffers for every task.
+	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+	for (AnimationScratch& scratch : mScratches)
+	{
+		for (unsigned int i = 0; i < MAX_NUM_CLIPS; i++)
+			scratch.mClipLocalTrans[i] = allocator->AllocateRange<SoaTransform>(mMaxSoaJoints);
+	}
+}
+
+void AnimationWorld::Destroy()
+{
+	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+	for (AnimationScratch& scratch : mScratches)
+	{
+		for (unsigned int i = 0; i < MAX_NUM_CLIPS; i++)
+			allocator->Deallocate(scratch.mClipLocalTrans[i]);
+	}
+
+	mScratches.set_capacity(0);
+	mObjects.set_capacity(0);
+}
+
+void AnimationWorld::AddObject(AnimatedObject* animatedObject, bool poseRig, AnimationWorldPostUpdate postUpdate, void* userData)
+{
+	ASSERT(animatedObject);
+	ASSERT(animatedObject->GetRig()->GetNumSoaJoints() <= mMaxSoaJoints);
+
+	mObjects.push_back({ animatedObject, poseRig, postUpdate, userData });
+}
+
+void AnimationWorld::RemoveObject(AnimatedObject* animatedObject)
+{
+	for (unsigned int i = 0; i < mObjects.size(); ++i)
+	{
+		if (mObjects[i].mAnimatedObject == animatedObject)
+		{
+			mObjects.erase(mObjects.begin() + i);
+			return;
+		}
+	}
+}
+
+struct AnimationWorldUpdate
+{
+	AnimationWorld* mWorld;
+	float           mDeltaTime;
+	unsigned int    mTaskCount;
+	tfrg_atomic32_t mFailed;
+};
+
+void AnimationWorld::UpdateTask(void* user, uintptr_t index)
+{
+	AnimationWorldUpdate* update = (AnimationWorldUpdate*)user;
+	AnimationWorld*       world = update->mWorld;
+	AnimationScratch*     scratch = &world->mScratches[index];
+
+	const unsigned int objectCount = (unsigned int)world->mObjects.size();
+	const unsigned int begin = (unsigned int)(objectCount * (uint64_t)index / update->mTaskCount);
+	const unsigned int end = (unsigned int)(objectCount * (uint64_t)(index + 1) / update->mTaskCount);
+
+	bool failed = false;
+	for (unsigned int i = begin; i < end; ++i)
+	{
+		const Object& object = world->mObjects[i];
+		if (!object.mAnimatedObject->Update(update->mDeltaTime, scratch))
+		{
+			failed = true;
+			continue;
+		}
+
+		if (object.mPoseRig)
+			object.mAnimatedObject->PoseRig();
+
+		if (object.mPostUpdate)
+			object.mPostUpdate(object.mAnimatedObject, object.mUserData);
+	}
+
+	if (failed)
+		tfrg_atomic32_store_relaxed(&update->mFailed, 1);
+}
+
+bool AnimationWorld::Update(float dt)
+{
+	const unsigned int objectCount = (unsigned int)mObjects.size();
+	const unsigned int maxTaskCount = (unsigned int)mScratches.size();
+
+	AnimationWorldUpdate update = {};
+	update.mWorld = this;
+	update.mDeltaTime = dt;
+	update.mTaskCount = objectCount < maxTaskCount ? objectCount : maxTaskCount;
+	tfrg_atomic32_store_relaxed(&update.mFailed, 0);
+
+	runThreadSystemRangeTaskAndWait(mThreadSystem, UpdateTask, &update, update.mTaskCount);
+
+	return tfrg_atomic32_load_acquire(&update.mFailed) == 0;
+}
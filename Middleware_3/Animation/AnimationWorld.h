@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2018-2020 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#pragma once
+
+#include "../../Common_3/ThirdParty/OpenSource/EASTL/vector.h"
+
+#include "AnimatedObject.h"
+
+struct ThreadSystem;
+
+// Called on the thread which updated the object, right after it was sampled (and posed when AddObject asked for it).
+// userData is the pointer given to AddObject.
+typedef void (*AnimationWorldPostUpdate)(AnimatedObject* animatedObject, void* userData);
+
+// Updates many AnimatedObjects each frame, spread over the worker threads of a ThreadSystem.
+// Objects are handed out to the threads in contiguous groups, and the objects of a group are sampled one after the
+// other into the same AnimationScratch, so the per clip sampling buffers exist once per group instead of once per object.
+// Each object has to have its own Rig and Animation.
+class AnimationWorld
+{
+	public:
+	// maxJoints is the joint count of the largest rig that will be added. Updates run on the calling thread when threadSystem is NULL.
+	void Initialize(ThreadSystem* threadSystem, unsigned int maxJoints);
+
+	// Must be called to clean up the world if it was initialized, the objects themselves are not destroyed
+	void Destroy();
+
+	// poseRig also computes the world matrices of the rig after sampling, as AnimatedObject::PoseRig.
+	// postUpdate runs after every successful update of the object, for work which needs the new pose such as skinning palettes.
+	void AddObject(AnimatedObject* animatedObject, bool poseRig = true, AnimationWorldPostUpdate postUpdate = NULL, void* userData = NULL);
+
+	void RemoveObject(AnimatedObject* animatedObject);
+
+	// Advances the animations of all objects by dt, false if any of them failed to sample
+	bool Update(float dt);
+
+	inline unsigned int GetObjectCount() const { return (unsigned int)mObjects.size(); };
+
+	private:
+	struct Object
+	{
+		AnimatedObject*          mAnimatedObject;
+		bool                     mPoseRig;
+		AnimationWorldPostUpdate mPostUpdate;
+		void*                    mUserData;
+	};
+
+	static void UpdateTask(void* user, uintptr_t index);
+
+	ThreadSystem* mThreadSystem;
+
+	eastl::vector<Object> mObjects;
+
+	// One per task, a task never runs more than once at a time
+	eastl::vector<AnimationScratch> mScratches;
+	unsigned int                    mMaxSoaJoints;
+};
@@ -29,9 +29,23 @@ void Clip::Initialize(const ResourceDirectory resourceDir, const char* fileName,
 	LoadClip(resourceDir, fileName);
 }
 
+bool Clip::Initialize(const void* data, size_t size, Rig* rig)
+{
+	if (!mAnimation.Map(data, size))
+	{
+		LOGF(eERROR, "Cannot map clip");
+		return false;
+	}
+
+	return true;
+}
+
 void Clip::Destroy()
 {
 	mAnimation.Deallocate();
+
+	tf_free(mMappedData);
+	mMappedData = NULL;
 }
 
 bool Clip::Sample(ozz::animation::SamplingCache* cacheInput, ozz::Range<SoaTransform>& localTransOutput, float timeRatio)
@@ -64,6 +78,19 @@ bool Clip::LoadClip(const ResourceDirectory resourceDir, const char* fileName)
 	fsReadFromStream(&file, data, (size_t)size);
 	fsCloseStream(&file);
 
+	// Clips in the mapped format are used as they are in the file contents, there is nothing to decode
+	if (ozz::animation::Animation::IsMapped(data, (size_t)size))
+	{
+		if (!mAnimation.Map(data, (size_t)size))
+		{
+			tf_free(data);
+			return false;
+		}
+
+		mMappedData = data;
+		return true;
+	}
+
 	// Archive is doing a lot of freads from disk which is slow on some platforms and also generally not good
 	// So we just read the entire file once into a mem stream so the freads from IArchive are actually
 	// only reading from system memory instead of disk or network
@@ -42,6 +42,11 @@ class Clip
 	// Set up a clip associated with a rig and read from an ozz animation file path
 	void Initialize(const ResourceDirectory resourceDir, const char* fileName, Rig* rig);
 
+	// Set up a clip from a mapped animation in memory (see AssetPipeline::CreateRuntimeAnimation), which could be a memory
+	// mapped file. The keys are used in place, so data is not copied and must outlive the clip.
+	// Returns false if data does not hold a valid mapped animation
+	bool Initialize(const void* data, size_t size, Rig* rig);
+
 	// Must be called to clean up if the clip was initialized
 	void Destroy();
 
@@ -57,4 +62,7 @@ class Clip
 
 	// Runtime animation.
 	ozz::animation::Animation mAnimation;
+
+	// File contents mAnimation is mapped to, when loaded from a file in the mapped format
+	void* mMappedData = NULL;
 };
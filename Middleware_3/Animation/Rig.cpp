@@ -66,11 +66,8 @@ void Rig::Destroy()
 
 void Rig::Pose(const Matrix4& rootTransform)
 {
-	// Set the world matrix of each joint
-	for (unsigned int jointIndex = 0; jointIndex < mNumJoints; jointIndex++)
-	{
-		mJointWorldMats[jointIndex] = rootTransform * mJointModelMats[jointIndex];
-	}
+	// Set the world matrix of each joint, as one batch over all of them
+	Vectormath::Batch::mulMatrices(rootTransform, mJointModelMats.begin, mJointWorldMats.data(), mNumJoints);
 
 	// If we wish to update the world matricies of the bones and the scales of the joints
 	// based on the distance between each joint
@@ -80,6 +77,8 @@ void Rig::Pose(const Matrix4& rootTransform)
 		// joints and altering the size of joints and bones to reflect distances
 		// between joints
 
+		const ozz::animation::Skeleton::JointProperties* jointProperties = mSkeleton.joint_properties().begin;
+
 		// Store smallest bone lenth to be reused for root joint scale
 		float minBoneLen = 0.f;
 		bool  minBoneLenSet = false;
@@ -91,16 +90,15 @@ void Rig::Pose(const Matrix4& rootTransform)
 			// Handle the root joint specially after the loop
 			if (childIndex == mRootIndex)
 			{
-				mBoneWorldMats[childIndex] = mat4::scale(vec3(0.0f, 0.0f, 0.0f));
 				continue;
 			}
 
 			// Get the index of the parent of childIndex
-			const int parentIndex = mSkeleton.joint_properties()[childIndex].parent;
+			const int parentIndex = jointProperties[childIndex].parent;
 
 			// Selects joint matrices.
-			const mat4 parentMat = mJointModelMats[parentIndex];
-			const mat4 childMat = mJointModelMats[childIndex];
+			const mat4& parentMat = mJointModelMats[parentIndex];
+			const mat4& childMat = mJointModelMats[childIndex];
 
 			vec3  boneDir = childMat.getCol3().getXYZ() - parentMat.getCol3().getXYZ();
 			float boneLen = length(boneDir);
@@ -111,7 +109,7 @@ void Rig::Pose(const Matrix4& rootTransform)
 				minBoneLen = boneLen;
 			}
 
-			// Use the parent and child world matricies to create a bone world
+			// Use the parent and child model matricies to create a bone model
 			// matrix which will place it between the two joints
 			// Using Gramm Schmidt process'
 			float dotProd = dot(parentMat.getCol2().getXYZ(), boneDir);
@@ -121,13 +119,17 @@ void Rig::Pose(const Matrix4& rootTransform)
 			vec4 col1 = vec4(boneLen * normalize(cross(binormal, boneDir)), 0.0f);
 			vec4 col2 = vec4(boneLen * normalize(cross(boneDir, col1.getXYZ())), 0.0f);
 			vec4 col3 = vec4(parentMat.getCol3().getXYZ(), 1.0f);
-			mBoneWorldMats[childIndex] = rootTransform * mat4(col0, col1, col2, col3);
+			mBoneWorldMats[childIndex] = mat4(col0, col1, col2, col3);
 
 			// Sets the scale of the joint equivilant to the boneLen between it and its parent joint
 			// Separete from world so outside objects can use a joint's world mat w/o its scale
 			mJointScales[childIndex] = vec3(boneLen / 2.0f);
 		}
 
+		// Moves all bones to world space in one batch, the root has no bone
+		Vectormath::Batch::mulMatrices(rootTransform, mBoneWorldMats.data(), mBoneWorldMats.data(), mNumJoints);
+		mBoneWorldMats[mRootIndex] = mat4::scale(vec3(0.0f, 0.0f, 0.0f));
+
 		// Set the root joints scale based on the saved min value
 		mJointScales[mRootIndex] = vec3(minBoneLen / 2.0f);
 	}
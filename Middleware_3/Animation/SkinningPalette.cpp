@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2018-2020 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#include "SkinningPalette.h"
+
+#include "../../Common_3/OS/Interfaces/IMemory.h"
+
+void SkinningPalette::Initialize(AnimatedObject* animatedObject, unsigned int jointCount, const Matrix4* inverseBindPoses, const uint32_t* jointRemaps)
+{
+	ASSERT(animatedObject && inverseBindPoses && jointRemaps);
+
+	mAnimatedObject = animatedObject;
+	mInverseBindPoses = inverseBindPoses;
+	mJointRemaps = jointRemaps;
+	mJointCount = jointCount;
+
+	// One allocation for both palettes
+	mPalettes[0] = (Matrix4*)tf_memalign(alignof(Matrix4), 2 * jointCount * sizeof(Matrix4));
+	mPalettes[1] = mPalettes[0] + jointCount;
+	for (unsigned int i = 0; i < 2 * jointCount; ++i)
+		mPalettes[0][i] = Matrix4::identity();
+
+	mCurrent = 0;
+	mHistoryValid = false;
+}
+
+void SkinningPalette::Destroy()
+{
+	tf_free(mPalettes[0]);
+	mPalettes[0] = NULL;
+	mPalettes[1] = NULL;
+}
+
+bool SkinningPalette::Update(float dt)
+{
+	if (!mAnimatedObject->Update(dt))
+		return false;
+
+	BuildPalette();
+	return true;
+}
+
+void SkinningPalette::BuildPalette()
+{
+	mCurrent ^= 1;
+
+	ozz::Range<Matrix4> jointModelMats = mAnimatedObject->GetRig()->GetJointModelMats();
+	Matrix4*            palette = mPalettes[mCurrent];
+	for (unsigned int i = 0; i < mJointCount; ++i)
+	{
+		ASSERT(mJointRemaps[i] < jointModelMats.count());
+		palette[i] = jointModelMats[mJointRemaps[i]] * mInverseBindPoses[i];
+	}
+
+	if (!mHistoryValid)
+	{
+		ResetHistory();
+		mHistoryValid = true;
+	}
+}
+
+void SkinningPalette::PostUpdate(AnimatedObject* animatedObject, void* userData)
+{
+	SkinningPalette* palette = (SkinningPalette*)userData;
+	ASSERT(palette->mAnimatedObject == animatedObject);
+	UNREF_PARAM(animatedObject);
+	palette->BuildPalette();
+}
+
+void SkinningPalette::ResetHistory()
+{
+	Matrix4* previousPalette = mPalettes[mCurrent ^ 1];
+	for (unsigned int i = 0; i < mJointCount; ++i)
+		previousPalette[i] = mPalettes[mCurrent][i];
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2018-2020 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#pragma once
+
+#include "../../Common_3/OS/Math/MathTypes.h"
+
+#include "AnimatedObject.h"
+
+// Skinning matrices of an AnimatedObject for the current and the previous frame.
+// Both are in the model space of the rig, so the object transform (and the one of the previous frame) still has to be applied.
+// Having the previous palette around lets the renderer skin every vertex twice and output per vertex velocity.
+class SkinningPalette
+{
+	public:
+	// inverseBindPoses and jointRemaps are the ones loaded with the skinned geometry (Geometry::pInverseBindPoses and pJointRemaps)
+	void Initialize(AnimatedObject* animatedObject, unsigned int jointCount, const Matrix4* inverseBindPoses, const uint32_t* jointRemaps);
+
+	// Must be called to clean up the object if it was initialized
+	void Destroy();
+
+	// Advances the animation by dt and computes the new palette, the last one becomes the previous palette
+	bool Update(float dt);
+
+	// Computes the new palette from the pose the AnimatedObject sampled last, the last one becomes the previous palette
+	void BuildPalette();
+
+	// An AnimationWorldPostUpdate building the SkinningPalette passed as userData, so the palettes of the objects in an
+	// AnimationWorld get built on the threads which sampled them: world.AddObject(object, false, SkinningPalette::PostUpdate, &palette)
+	static void PostUpdate(AnimatedObject* animatedObject, void* userData);
+
+	// Makes the previous palette match the current one, for objects which were not updated for a while or got teleported
+	void ResetHistory();
+
+	inline const Matrix4* GetPalette() const { return mPalettes[mCurrent]; };
+
+	inline const Matrix4* GetPreviousPalette() const { return mPalettes[mCurrent ^ 1]; };
+
+	inline unsigned int GetJointCount() const { return mJointCount; };
+
+	inline AnimatedObject* GetAnimatedObject() { return mAnimatedObject; };
+
+	private:
+	AnimatedObject* mAnimatedObject;
+
+	const Matrix4*  mInverseBindPoses;
+	const uint32_t* mJointRemaps;
+	unsigned int    mJointCount;
+
+	// Double buffered, mCurrent selects the palette of this frame
+	Matrix4*        mPalettes[2];
+	unsigned int    mCurrent;
+
+	// Nothing sensible to blend from before the first update
+	bool            mHistoryValid;
+};
@@ -0,0 +1,279 @@
+#include "ArchetypeStorage.h"
+
+#include "../../Common_3/OS/Interfaces/IMemory.h" // NOTE: this should be the last include in a .cpp
+
+static DataComponentTypeInfo gDataComponentTypes[MAX_DATA_COMPONENT_TYPES] = {};
+static tfrg_atomic32_t gDataComponentTypeCount = 0;
+
+static const uint32_t INVALID_ARCHETYPE = UINT32_MAX;
+
+uint32_t registerDataComponentType(const DataComponentTypeInfo& info)
+{
+	uint32_t typeId = (uint32_t)tfrg_atomic32_add_relaxed(&gDataComponentTypeCount, 1);
+	ASSERT(typeId < MAX_DATA_COMPONENT_TYPES && "Too many data component types, raise MAX_DATA_COMPONENT_TYPES");
+	ASSERT(info.mAlignment <= ARCHETYPE_COLUMN_ALIGNMENT);
+	gDataComponentTypes[typeId] = info;
+	return typeId;
+}
+
+const DataComponentTypeInfo& getDataComponentTypeInfo(uint32_t typeId)
+{
+	ASSERT(typeId < MAX_DATA_COMPONENT_TYPES);
+	return gDataComponentTypes[typeId];
+}
+
+static uint32_t alignColumn(uint32_t offset)
+{
+	return (offset + ARCHETYPE_COLUMN_ALIGNMENT - 1) & ~(ARCHETYPE_COLUMN_ALIGNMENT - 1);
+}
+
+// Size of a chunk holding capacity rows, with the column offsets written to pArchetype
+static uint32_t layoutChunk(Archetype* pArchetype, uint32_t capacity)
+{
+	uint32_t offset = alignColumn(capacity * (uint32_t)sizeof(EntityId));
+	for (uint32_t typeId : pArchetype->mTypeIds)
+	{
+		pArchetype->mColumnOffsets[typeId] = offset;
+		offset = alignColumn(offset + capacity * getDataComponentTypeInfo(typeId).mSize);
+	}
+	return offset;
+}
+
+ArchetypeStorage::ArchetypeStorage()
+{
+}
+
+ArchetypeStorage::~ArchetypeStorage()
+{
+	reset();
+	for (Archetype* pArchetype : mArchetypes)
+	{
+		pArchetype->~Archetype();
+		tf_free(pArchetype);
+	}
+	mArchetypes.clear();
+	mArchetypeLookup.clear();
+}
+
+ArchetypeStorage::EntityLocation* ArchetypeStorage::getLocation(EntityId id)
+{
+	ASSERT(id > 0);
+	const uint32_t index = getEntityIndex(id);
+	if (index >= mLocations.size())
+		mLocations.resize(index + 1, { INVALID_ARCHETYPE, 0 });
+	return &mLocations[index];
+}
+
+uint32_t ArchetypeStorage::findOrCreateArchetype(DataComponentMask mask)
+{
+	eastl::hash_map<DataComponentMask, uint32_t>::iterator it = mArchetypeLookup.find(mask);
+	if (it != mArchetypeLookup.end())
+		return it->second;
+
+	Archetype* pArchetype = tf_placement_new<Archetype>(tf_calloc(1, sizeof(Archetype)));
+	pArchetype->mMask = mask;
+	for (uint32_t typeId = 0; typeId < MAX_DATA_COMPONENT_TYPES; ++typeId)
+	{
+		pArchetype->mColumnOffsets[typeId] = UINT32_MAX;
+		if (mask & (1ull << typeId))
+			pArchetype->mTypeIds.push_back(typeId);
+	}
+
+	// Fit as many rows as the padding between the columns leaves room for, archetypes with huge components get
+	// bigger chunks instead of none
+	uint32_t rowSize = sizeof(EntityId);
+	for (uint32_t typeId : pArchetype->mTypeIds)
+		rowSize += getDataComponentTypeInfo(typeId).mSize;
+	const uint32_t padding = ARCHETYPE_COLUMN_ALIGNMENT * (uint32_t)(pArchetype->mTypeIds.size() + 1);
+	uint32_t capacity = ARCHETYPE_CHUNK_SIZE > padding ? (ARCHETYPE_CHUNK_SIZE - padding) / rowSize : 0;
+	capacity = capacity > 0 ? capacity : 1;
+
+	const uint32_t chunkSize = layoutChunk(pArchetype, capacity);
+	ASSERT(capacity == 1 || chunkSize <= ARCHETYPE_CHUNK_SIZE);
+	pArchetype->mChunkCapacity = capacity;
+	pArchetype->mChunkSize = chunkSize > ARCHETYPE_CHUNK_SIZE ? chunkSize : ARCHETYPE_CHUNK_SIZE;
+
+	const uint32_t index = (uint32_t)mArchetypes.size();
+	mArchetypes.push_back(pArchetype);
+	mArchetypeLookup.insert(eastl::pair<DataComponentMask, uint32_t>(mask, index));
+	return index;
+}
+
+uint32_t ArchetypeStorage::allocateRow(Archetype* pArchetype, EntityId id)
+{
+	const uint32_t row = pArchetype->mEntityCount++;
+	if (row / pArchetype->mChunkCapacity >= pArchetype->mChunks.size())
+	{
+		ArchetypeChunk chunk = { (uint8_t*)tf_memalign(ARCHETYPE_COLUMN_ALIGNMENT, pArchetype->mChunkSize), 0 };
+		pArchetype->mChunks.push_back(chunk);
+	}
+
+	ArchetypeChunk& chunk = pArchetype->mChunks.back();
+	pArchetype->getEntities(chunk)[chunk.mCount++] = id;
+	return row;
+}
+
+void ArchetypeStorage::freeRow(Archetype* pArchetype, uint32_t row)
+{
+	const uint32_t lastRow = --pArchetype->mEntityCount;
+	ArchetypeChunk& lastChunk = pArchetype->mChunks.back();
+
+	if (row != lastRow)
+	{
+		// Fill the hole with the last row so the chunks stay dense
+		ArchetypeChunk& chunk = pArchetype->mChunks[row / pArchetype->mChunkCapacity];
+		const uint32_t index = row % pArchetype->mChunkCapacity;
+		const uint32_t lastIndex = lastRow % pArchetype->mChunkCapacity;
+		for (uint32_t typeId : pArchetype->mTypeIds)
+		{
+			const uint32_t size = getDataComponentTypeInfo(typeId).mSize;
+			getDataComponentTypeInfo(typeId).pMove(
+				(uint8_t*)pArchetype->getColumn(chunk, typeId) + index * size,
+				(uint8_t*)pArchetype->getColumn(lastChunk, typeId) + lastIndex * size);
+		}
+
+		const EntityId movedId = pArchetype->getEntities(lastChunk)[lastIndex];
+		pArchetype->getEntities(chunk)[index] = movedId;
+		mLocations[getEntityIndex(movedId)].mRow = row;
+	}
+
+	// Keep one empty chunk around so an archetype going back and forth between 0 and 1 entities does not allocate
+	if (--lastChunk.mCount == 0 && pArchetype->mChunks.size() > 1)
+	{
+		tf_free(lastChunk.pData);
+		pArchetype->mChunks.pop_back();
+	}
+}
+
+void* ArchetypeStorage::addComponent(EntityId id, uint32_t typeId)
+{
+	const DataComponentMask typeMask = 1ull << typeId;
+	EntityLocation* pLocation = getLocation(id);
+
+	Archetype* pSource = pLocation->mArchetype != INVALID_ARCHETYPE ? mArchetypes[pLocation->mArchetype] : NULL;
+	const DataComponentMask sourceMask = pSource ? pSource->mMask : 0;
+	ASSERT(!(sourceMask & typeMask) && "data component for entity already exist");
+
+	const uint32_t targetIndex = findOrCreateArchetype(sourceMask | typeMask);
+	Archetype* pTarget = mArchetypes[targetIndex];
+
+	const uint32_t row = allocateRow(pTarget, id);
+	if (pSource)
+	{
+		for (uint32_t sourceTypeId : pSource->mTypeIds)
+		{
+			getDataComponentTypeInfo(sourceTypeId).pMove(
+				pTarget->getComponent(row, sourceTypeId), pSource->getComponent(pLocation->mRow, sourceTypeId));
+		}
+		freeRow(pSource, pLocation->mRow);
+	}
+
+	pLocation->mArchetype = targetIndex;
+	pLocation->mRow = row;
+
+	void* pComponent = pTarget->getComponent(row, typeId);
+	getDataComponentTypeInfo(typeId).pConstruct(pComponent);
+	return pComponent;
+}
+
+void ArchetypeStorage::removeComponent(EntityId id, uint32_t typeId)
+{
+	const DataComponentMask typeMask = 1ull << typeId;
+	EntityLocation* pLocation = getLocation(id);
+	ASSERT(pLocation->mArchetype != INVALID_ARCHETYPE && (mArchetypes[pLocation->mArchetype]->mMask & typeMask));
+
+	const DataComponentMask targetMask = mArchetypes[pLocation->mArchetype]->mMask & ~typeMask;
+	const uint32_t targetIndex = targetMask ? findOrCreateArchetype(targetMask) : INVALID_ARCHETYPE;
+	Archetype* pSource = mArchetypes[pLocation->mArchetype];
+
+	getDataComponentTypeInfo(typeId).pDestruct(pSource->getComponent(pLocation->mRow, typeId));
+
+	uint32_t row = 0;
+	if (targetIndex != INVALID_ARCHETYPE)
+	{
+		Archetype* pTarget = mArchetypes[targetIndex];
+		row = allocateRow(pTarget, id);
+		for (uint32_t targetTypeId : pTarget->mTypeIds)
+		{
+			getDataComponentTypeInfo(targetTypeId).pMove(
+				pTarget->getComponent(row, targetTypeId), pSource->getComponent(pLocation->mRow, targetTypeId));
+		}
+	}
+	freeRow(pSource, pLocation->mRow);
+
+	pLocation->mArchetype = targetIndex;
+	pLocation->mRow = row;
+}
+
+void* ArchetypeStorage::getComponent(EntityId id, uint32_t typeId) const
+{
+	if (id <= 0 || getEntityIndex(id) >= mLocations.size())
+		return NULL;
+
+	const EntityLocation& location = mLocations[getEntityIndex(id)];
+	if (location.mArchetype == INVALID_ARCHETYPE)
+		return NULL;
+
+	// The index may belong to a newer generation by now
+	const Archetype* pArchetype = mArchetypes[location.mArchetype];
+	if (!(pArchetype->mMask & (1ull << typeId)) || pArchetype->getEntity(location.mRow) != id)
+		return NULL;
+
+	return pArchetype->getComponent(location.mRow, typeId);
+}
+
+void ArchetypeStorage::removeEntity(EntityId id)
+{
+	if (id <= 0 || getEntityIndex(id) >= mLocations.size() || mLocations[getEntityIndex(id)].mArchetype == INVALID_ARCHETYPE)
+		return;
+
+	EntityLocation* pLocation = &mLocations[getEntityIndex(id)];
+	Archetype* pArchetype = mArchetypes[pLocation->mArchetype];
+	if (pArchetype->getEntity(pLocation->mRow) != id)
+		return;
+
+	for (uint32_t typeId : pArchetype->mTypeIds)
+		getDataComponentTypeInfo(typeId).pDestruct(pArchetype->getComponent(pLocation->mRow, typeId));
+	freeRow(pArchetype, pLocation->mRow);
+
+	pLocation->mArchetype = INVALID_ARCHETYPE;
+	pLocation->mRow = 0;
+}
+
+void ArchetypeStorage::cloneEntity(EntityId sourceId, EntityId id)
+{
+	const uint32_t sourceIndex = getEntityIndex(sourceId);
+	if (sourceId <= 0 || sourceIndex >= mLocations.size() || mLocations[sourceIndex].mArchetype == INVALID_ARCHETYPE)
+		return;
+
+	EntityLocation* pLocation = getLocation(id);
+	ASSERT(pLocation->mArchetype == INVALID_ARCHETYPE);
+
+	// getLocation may have grown mLocations
+	const EntityLocation& source = mLocations[sourceIndex];
+	Archetype* pArchetype = mArchetypes[source.mArchetype];
+	const uint32_t row = allocateRow(pArchetype, id);
+	for (uint32_t typeId : pArchetype->mTypeIds)
+		getDataComponentTypeInfo(typeId).pCopy(pArchetype->getComponent(row, typeId), pArchetype->getComponent(source.mRow, typeId));
+
+	pLocation->mArchetype = source.mArchetype;
+	pLocation->mRow = row;
+}
+
+void ArchetypeStorage::reset()
+{
+	// Archetypes stay, queries keep indices into mArchetypes
+	for (Archetype* pArchetype : mArchetypes)
+	{
+		for (uint32_t row = 0; row < pArchetype->mEntityCount; ++row)
+		{
+			for (uint32_t typeId : pArchetype->mTypeIds)
+				getDataComponentTypeInfo(typeId).pDestruct(pArchetype->getComponent(row, typeId));
+		}
+		for (ArchetypeChunk& chunk : pArchetype->mChunks)
+			tf_free(chunk.pData);
+		pArchetype->mChunks.clear();
+		pArchetype->mEntityCount = 0;
+	}
+	mLocations.clear();
+}
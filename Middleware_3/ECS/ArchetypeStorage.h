@@ -0,0 +1,267 @@
+#pragma once
+
+#include "../../Common_3/OS/Interfaces/ILog.h"
+#include "../../Common_3/OS/Core/Atomics.h"
+#include "../../Common_3/OS/Core/ThreadSystem.h"
+
+#include "../../Common_3/ThirdParty/OpenSource/EASTL/vector.h"
+#include "../../Common_3/ThirdParty/OpenSource/EASTL/hash_map.h"
+
+#define IMEMORY_FROM_HEADER
+#include "../../Common_3/OS/Interfaces/IMemory.h"
+
+/* Entity ids:
+ * The low ENTITY_INDEX_BITS are an index into the per entity arrays, the bits above it a generation which is bumped
+ * every time the index gets reused, so an id of a deleted entity never finds the entity that reuses its slot.
+ * The sign bit stays clear and index 0 is reserved for the scene root, so valid ids are always > 0.
+ */
+typedef int32_t EntityId;
+
+#define ENTITY_INDEX_BITS 22
+#define ENTITY_GENERATION_BITS 9
+#define ENTITY_INDEX_MASK ((1u << ENTITY_INDEX_BITS) - 1)
+#define ENTITY_GENERATION_MASK ((1u << ENTITY_GENERATION_BITS) - 1)
+
+inline uint32_t getEntityIndex(EntityId id) { return (uint32_t)id & ENTITY_INDEX_MASK; }
+inline uint32_t getEntityGeneration(EntityId id) { return ((uint32_t)id >> ENTITY_INDEX_BITS) & ENTITY_GENERATION_MASK; }
+inline EntityId makeEntityId(uint32_t index, uint32_t generation)
+{
+	return (EntityId)((index & ENTITY_INDEX_MASK) | ((generation & ENTITY_GENERATION_MASK) << ENTITY_INDEX_BITS));
+}
+
+/* Data components:
+ * Plain structs stored next to the BaseComponent maps of the entities. Entities with the same set of data
+ * components share an archetype, which keeps them in fixed size chunks with one array per component type, so a
+ * query walks contiguous arrays instead of looking every component up in a hash map.
+ *
+ * Adding or removing a data component moves the entity's row to another archetype, and rows are kept dense by
+ * moving the last row of an archetype into the hole, so pointers to data components only hold until the next
+ * structural change of the same archetype.
+ */
+
+#define MAX_DATA_COMPONENT_TYPES 64
+#define ARCHETYPE_CHUNK_SIZE (16 * 1024)
+// Every component array of a chunk starts on its own cache line
+#define ARCHETYPE_COLUMN_ALIGNMENT 64
+
+typedef uint64_t DataComponentMask;
+
+// Type erased operations of a data component type
+struct DataComponentTypeInfo
+{
+	uint32_t mSize;
+	uint32_t mAlignment;
+	void (*pConstruct)(void* pDst);
+	void (*pDestruct)(void* pDst);
+	// Move constructs pDst from pSrc and destructs pSrc
+	void (*pMove)(void* pDst, void* pSrc);
+	void (*pCopy)(void* pDst, const void* pSrc);
+};
+
+uint32_t registerDataComponentType(const DataComponentTypeInfo& info);
+const DataComponentTypeInfo& getDataComponentTypeInfo(uint32_t typeId);
+
+template <typename T>
+struct DataComponentTypeOps
+{
+	static void construct(void* pDst) { tf_placement_new<T>(pDst); }
+	static void destruct(void* pDst) { ((T*)pDst)->~T(); }
+	static void move(void* pDst, void* pSrc)
+	{
+		tf_placement_new<T>(pDst, eastl::move(*(T*)pSrc));
+		((T*)pSrc)->~T();
+	}
+	static void copy(void* pDst, const void* pSrc) { tf_placement_new<T>(pDst, *(const T*)pSrc); }
+};
+
+// Ids are handed out on first use, in the order the types are first used
+template <typename T>
+uint32_t getDataComponentTypeId()
+{
+	static const uint32_t typeId = registerDataComponentType({ (uint32_t)sizeof(T), (uint32_t)alignof(T),
+		DataComponentTypeOps<T>::construct, DataComponentTypeOps<T>::destruct, DataComponentTypeOps<T>::move, DataComponentTypeOps<T>::copy });
+	return typeId;
+}
+
+struct ArchetypeChunk
+{
+	uint8_t* pData;
+	uint32_t mCount;
+};
+
+// All entities with one set of data components. Every chunk starts with the ids of its entities, followed by one
+// array per component type. Rows are dense, only the last chunk is not full.
+struct Archetype
+{
+	DataComponentMask			  mMask;
+	uint32_t					  mChunkSize;
+	uint32_t					  mChunkCapacity;
+	uint32_t					  mEntityCount;
+	eastl::vector<uint32_t>		  mTypeIds;
+	// Byte offset of each component array in a chunk by type id, UINT32_MAX for the types this archetype lacks
+	uint32_t					  mColumnOffsets[MAX_DATA_COMPONENT_TYPES];
+	eastl::vector<ArchetypeChunk> mChunks;
+
+	EntityId* getEntities(const ArchetypeChunk& chunk) const { return (EntityId*)chunk.pData; }
+	EntityId getEntity(uint32_t row) const { return getEntities(mChunks[row / mChunkCapacity])[row % mChunkCapacity]; }
+	void* getColumn(const ArchetypeChunk& chunk, uint32_t typeId) const { return chunk.pData + mColumnOffsets[typeId]; }
+	void* getComponent(uint32_t row, uint32_t typeId) const
+	{
+		const ArchetypeChunk& chunk = mChunks[row / mChunkCapacity];
+		return chunk.pData + mColumnOffsets[typeId] + (row % mChunkCapacity) * getDataComponentTypeInfo(typeId).mSize;
+	}
+};
+
+class ArchetypeStorage
+{
+public:
+	ArchetypeStorage();
+	~ArchetypeStorage();
+
+	// Adds a default constructed component and returns it
+	void* addComponent(EntityId id, uint32_t typeId);
+	void removeComponent(EntityId id, uint32_t typeId);
+	// NULL when the entity does not have the component
+	void* getComponent(EntityId id, uint32_t typeId) const;
+
+	void removeEntity(EntityId id);
+	// Copies the data components of sourceId to id, which must not have any yet
+	void cloneEntity(EntityId sourceId, EntityId id);
+	void reset();
+
+	// Archetypes are never removed, so their indices stay valid
+	uint32_t getArchetypeCount() const { return (uint32_t)mArchetypes.size(); }
+	const Archetype* getArchetype(uint32_t index) const { return mArchetypes[index]; }
+
+private:
+	struct EntityLocation
+	{
+		uint32_t mArchetype;
+		uint32_t mRow;
+	};
+
+	EntityLocation* getLocation(EntityId id);
+	uint32_t findOrCreateArchetype(DataComponentMask mask);
+	uint32_t allocateRow(Archetype* pArchetype, EntityId id);
+	// The components of the row have to be destructed or moved out already
+	void freeRow(Archetype* pArchetype, uint32_t row);
+
+	eastl::vector<Archetype*>					mArchetypes;
+	eastl::hash_map<DataComponentMask, uint32_t> mArchetypeLookup;
+	// By entity index
+	eastl::vector<EntityLocation>				mLocations;
+};
+
+// Iterates the chunks of every archetype with at least the components T. The archetypes are matched lazily, so a
+// query can be kept around and reused while new archetypes appear.
+template <typename... T>
+class DataComponentQuery
+{
+public:
+	DataComponentQuery(const ArchetypeStorage* pStorage) : pStorage(pStorage), mMask(0), mCheckedArchetypeCount(0)
+	{
+		DataComponentMask masks[] = { 0, (1ull << getDataComponentTypeId<T>())... };
+		for (DataComponentMask mask : masks)
+			mMask |= mask;
+	}
+
+	uint32_t getEntityCount()
+	{
+		updateMatches();
+		uint32_t count = 0;
+		for (uint32_t archetypeIndex : mMatches)
+			count += pStorage->getArchetype(archetypeIndex)->mEntityCount;
+		return count;
+	}
+
+	// function(const EntityId* pEntities, T*... pComponents, uint32_t count) once per chunk
+	template <typename F>
+	void forEachChunk(F function)
+	{
+		updateMatches();
+		for (uint32_t archetypeIndex : mMatches)
+		{
+			const Archetype* pArchetype = pStorage->getArchetype(archetypeIndex);
+			for (const ArchetypeChunk& chunk : pArchetype->mChunks)
+				runChunk(pArchetype, chunk, function);
+		}
+	}
+
+	// As forEachChunk with the chunks spread over the workers of pThreadSystem, the calling thread helps until all of
+	// them are done. function runs concurrently and no entity may change its data components until this returns.
+	template <typename F>
+	void forEachChunkParallel(ThreadSystem* pThreadSystem, F function)
+	{
+		updateMatches();
+
+		ParallelJob<F> job;
+		job.pFunction = &function;
+		for (uint32_t archetypeIndex : mMatches)
+		{
+			const Archetype* pArchetype = pStorage->getArchetype(archetypeIndex);
+			for (const ArchetypeChunk& chunk : pArchetype->mChunks)
+				job.mChunks.push_back({ pArchetype, &chunk });
+		}
+
+		const uint32_t chunkCount = (uint32_t)job.mChunks.size();
+		// A few tasks per thread so uneven chunks even out, the calling thread works too
+		const uint32_t threadCount = pThreadSystem ? getThreadSystemThreadCount(pThreadSystem) + 1 : 1;
+		const uint32_t taskCount = chunkCount < threadCount * 4 ? chunkCount : threadCount * 4;
+		if (!pThreadSystem || taskCount <= 1)
+		{
+			for (const ChunkRef& ref : job.mChunks)
+				runChunk(ref.pArchetype, *ref.pChunk, function);
+			return;
+		}
+
+		job.mTaskCount = taskCount;
+		runThreadSystemRangeTaskAndWait(pThreadSystem, parallelTask<F>, &job, taskCount);
+	}
+
+private:
+	struct ChunkRef
+	{
+		const Archetype*	  pArchetype;
+		const ArchetypeChunk* pChunk;
+	};
+
+	template <typename F>
+	struct ParallelJob
+	{
+		F*						 pFunction;
+		eastl::vector<ChunkRef>	 mChunks;
+		uint32_t				 mTaskCount;
+	};
+
+	template <typename F>
+	static void runChunk(const Archetype* pArchetype, const ArchetypeChunk& chunk, F& function)
+	{
+		function(pArchetype->getEntities(chunk), (T*)pArchetype->getColumn(chunk, getDataComponentTypeId<T>())..., chunk.mCount);
+	}
+
+	template <typename F>
+	static void parallelTask(void* pUser, uintptr_t taskIndex)
+	{
+		ParallelJob<F>* pJob = (ParallelJob<F>*)pUser;
+		const uint32_t chunkCount = (uint32_t)pJob->mChunks.size();
+		const uint32_t begin = (uint32_t)(chunkCount * (uint64_t)taskIndex / pJob->mTaskCount);
+		const uint32_t end = (uint32_t)(chunkCount * (uint64_t)(taskIndex + 1) / pJob->mTaskCount);
+		for (uint32_t i = begin; i < end; ++i)
+			runChunk(pJob->mChunks[i].pArchetype, *pJob->mChunks[i].pChunk, *pJob->pFunction);
+	}
+
+	void updateMatches()
+	{
+		const uint32_t archetypeCount = pStorage->getArchetypeCount();
+		for (; mCheckedArchetypeCount < archetypeCount; ++mCheckedArchetypeCount)
+		{
+			if ((pStorage->getArchetype(mCheckedArchetypeCount)->mMask & mMask) == mMask)
+				mMatches.push_back(mCheckedArchetypeCount);
+		}
+	}
+
+	const ArchetypeStorage* pStorage;
+	DataComponentMask		mMask;
+	uint32_t				mCheckedArchetypeCount;
+	eastl::vector<uint32_t> mMatches;
+};
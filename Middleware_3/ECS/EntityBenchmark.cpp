@@ -0,0 +1,112 @@
+#include "EntityBenchmark.h"
+
+#if defined(ENABLE_ECS_BENCHMARK)
+
+#include "../../Common_3/OS/Interfaces/ITime.h"
+
+#include "EntityManager.h"
+#include "ComponentRepresentation.h"
+#include "../../Common_3/OS/Interfaces/IMemory.h" // NOTE: this should be the last include in a .cpp
+
+// The same data once as a BaseComponent and once as data components
+class BenchmarkMotionComponent : public BaseComponent
+{
+	FORGE_DECLARE_COMPONENT(BenchmarkMotionComponent)
+public:
+	float mPosition[3] = { 0.0f, 0.0f, 0.0f };
+	float mVelocity[3] = { 1.0f, 2.0f, 3.0f };
+};
+
+FORGE_START_GENERATE_COMPONENT_REPRESENTATION(BenchmarkMotionComponent)
+FORGE_END_GENERATE_COMPONENT_REPRESENTATION
+FORGE_IMPLEMENT_COMPONENT(BenchmarkMotionComponent)
+FORGE_DEFINE_COMPONENT_ID(BenchmarkMotionComponent)
+FORGE_START_VAR_REPRESENTATIONS_BUILD(BenchmarkMotionComponent)
+FORGE_END_VAR_REPRESENTATIONS_BUILD(BenchmarkMotionComponent)
+FORGE_START_VAR_REFERENCES(BenchmarkMotionComponent)
+FORGE_END_VAR_REFERENCES
+
+struct BenchmarkPosition
+{
+	float x, y, z;
+};
+
+struct BenchmarkVelocity
+{
+	float x, y, z;
+};
+
+struct BenchmarkTag
+{
+	uint32_t mValue;
+};
+
+static double elapsedMs(int64_t startUSec) { return double(getUSec() - startUSec) / 1000.0; }
+
+static void integrate(const EntityId*, BenchmarkPosition* pPositions, BenchmarkVelocity* pVelocities, uint32_t count)
+{
+	const float dt = 1.0f / 60.0f;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		pPositions[i].x += pVelocities[i].x * dt;
+		pPositions[i].y += pVelocities[i].y * dt;
+		pPositions[i].z += pVelocities[i].z * dt;
+	}
+}
+
+void registerEntityBenchmarkComponents()
+{
+	FORGE_INIT_COMPONENT_ID(BenchmarkMotionComponent)
+	BenchmarkMotionComponentRepresentation::BUILD_VAR_REPRESENTATIONS();
+}
+
+void benchmarkEntityIteration(EntityManager* pEntityManager, ThreadSystem* pThreadSystem, uint32_t entityCount, uint32_t passCount,
+	EntityIterationTimings* pOutTimings)
+{
+	ASSERT(pEntityManager && pOutTimings);
+	ASSERT(passCount);
+
+	pEntityManager->reset();
+	for (uint32_t i = 0; i < entityCount; ++i)
+	{
+		EntityId id = pEntityManager->createEntity();
+		pEntityManager->addComponentToEntity<BenchmarkMotionComponent>(id);
+		pEntityManager->addDataComponentToEntity<BenchmarkPosition>(id) = { 0.0f, 0.0f, 0.0f };
+		pEntityManager->addDataComponentToEntity<BenchmarkVelocity>(id) = { 1.0f, 2.0f, 3.0f };
+		if (i % 3 == 0)
+			pEntityManager->addDataComponentToEntity<BenchmarkTag>(id).mValue = i;
+	}
+
+	pOutTimings->mEntityCount = entityCount;
+	pOutTimings->mWorkerCount = pThreadSystem ? getThreadSystemThreadCount(pThreadSystem) : 0;
+	pOutTimings->mComponentMapMs = 1e9;
+	pOutTimings->mQueryMs = 1e9;
+	pOutTimings->mParallelQueryMs = 1e9;
+
+	DataComponentQuery<BenchmarkPosition, BenchmarkVelocity> query = pEntityManager->queryDataComponents<BenchmarkPosition, BenchmarkVelocity>();
+	for (uint32_t pass = 0; pass < passCount; ++pass)
+	{
+		int64_t start = getUSec();
+		const float dt = 1.0f / 60.0f;
+		Lookup& motionComponents = pEntityManager->getByComponent<BenchmarkMotionComponent>();
+		for (Lookup::const_iterator it = motionComponents.begin(); it != motionComponents.end(); ++it)
+		{
+			BenchmarkMotionComponent* pMotion = (BenchmarkMotionComponent*)it->second;
+			for (uint32_t k = 0; k < 3; ++k)
+				pMotion->mPosition[k] += pMotion->mVelocity[k] * dt;
+		}
+		pOutTimings->mComponentMapMs = eastl::min(pOutTimings->mComponentMapMs, elapsedMs(start));
+
+		start = getUSec();
+		query.forEachChunk(integrate);
+		pOutTimings->mQueryMs = eastl::min(pOutTimings->mQueryMs, elapsedMs(start));
+
+		start = getUSec();
+		query.forEachChunkParallel(pThreadSystem, integrate);
+		pOutTimings->mParallelQueryMs = eastl::min(pOutTimings->mParallelQueryMs, elapsedMs(start));
+	}
+
+	pEntityManager->reset();
+}
+
+#endif
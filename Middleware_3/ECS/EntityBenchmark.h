@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../../Common_3/OS/Interfaces/IThread.h"
+#include "../../Common_3/OS/Core/ThreadSystem.h"
+
+class EntityManager;
+
+// Only built with ENABLE_ECS_BENCHMARK defined, it is not part of the ECS itself.
+#if defined(ENABLE_ECS_BENCHMARK)
+
+// Best time out of passCount passes of p += v * dt over every entity, once per way of iterating them
+struct EntityIterationTimings
+{
+	uint32_t mEntityCount;
+	uint32_t mWorkerCount;
+	double	 mComponentMapMs;	// BaseComponent found through EntityManager::getByComponent
+	double	 mQueryMs;			// Data components through DataComponentQuery::forEachChunk
+	double	 mParallelQueryMs;	// Same as mQueryMs through forEachChunkParallel
+};
+
+// Registers the BaseComponent of the benchmark, call it before constructing the EntityManager it runs on
+void registerEntityBenchmarkComponents();
+
+// Resets pEntityManager and fills it with entityCount entities, a third of them in a second archetype, then resets
+// it again. pThreadSystem may be NULL, the parallel query then runs on the calling thread.
+void benchmarkEntityIteration(EntityManager* pEntityManager, ThreadSystem* pThreadSystem, uint32_t entityCount, uint32_t passCount,
+	EntityIterationTimings* pOutTimings);
+
+#endif
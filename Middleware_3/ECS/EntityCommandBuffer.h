@@ -0,0 +1,95 @@
+#pragma once
+
+#include "EntityManager.h"
+
+#include <type_traits>
+
+/* Entity command buffers:
+ * Record entity creation, deletion and component changes without touching the EntityManager's locks or maps, so
+ * worker threads can spawn and despawn in bulk. Give every thread its own buffer, recording is not thread safe but
+ * needs no synchronization with other buffers. EntityManager::applyCommandBuffers plays them back at a sync point.
+ *
+ * Ids of created entities are reserved right away and can be used in later commands of any buffer applied in the
+ * same batch, the entities only exist once the buffer is applied. A buffer that is dropped without being applied
+ * leaks the ids it reserved.
+ */
+class EntityCommandBuffer
+{
+	friend class EntityManager;
+
+public:
+	EntityCommandBuffer(EntityManager* pManager) : pManager(pManager), mCreateCount(0) {}
+
+	EntityId createEntity()
+	{
+		EntityId id = 0;
+		createEntities(&id, 1);
+		return id;
+	}
+
+	void createEntities(EntityId* pIds, uint32_t count)
+	{
+		pManager->reserveEntityIds(pIds, count);
+		mCreateCount += count;
+		for (uint32_t i = 0; i < count; ++i)
+			mCommands.push_back({ COMMAND_CREATE_ENTITY, pIds[i], 0, 0 });
+	}
+
+	void deleteEntity(EntityId id) { mCommands.push_back({ COMMAND_DELETE_ENTITY, id, 0, 0 }); }
+
+	void deleteEntities(const EntityId* pIds, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+			mCommands.push_back({ COMMAND_DELETE_ENTITY, pIds[i], 0, 0 });
+	}
+
+	template <typename T>
+	void addComponent(EntityId id)
+	{
+		mCommands.push_back({ COMMAND_ADD_COMPONENT, id, T::getTypeStatic(), 0 });
+	}
+
+	// The value is copied as bytes into the buffer and again into the chunk when it gets applied
+	template <typename T>
+	void addDataComponent(EntityId id, const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Command buffers only carry trivially copyable data components");
+		const uint32_t offset = (uint32_t)mData.size();
+		mData.resize(offset + sizeof(T));
+		memcpy(mData.data() + offset, &value, sizeof(T));
+		mCommands.push_back({ COMMAND_ADD_DATA_COMPONENT, id, getDataComponentTypeId<T>(), offset });
+	}
+
+	template <typename T>
+	void removeDataComponent(EntityId id)
+	{
+		mCommands.push_back({ COMMAND_REMOVE_DATA_COMPONENT, id, getDataComponentTypeId<T>(), 0 });
+	}
+
+	bool isEmpty() const { return mCommands.empty(); }
+
+private:
+	enum CommandType
+	{
+		COMMAND_CREATE_ENTITY,
+		COMMAND_DELETE_ENTITY,
+		COMMAND_ADD_COMPONENT,
+		COMMAND_ADD_DATA_COMPONENT,
+		COMMAND_REMOVE_DATA_COMPONENT,
+	};
+
+	struct Command
+	{
+		uint32_t mType;
+		EntityId mId;
+		// Component type hash or data component type id
+		uint32_t mComponentType;
+		// Of the data component value in mData
+		uint32_t mDataOffset;
+	};
+
+	EntityManager*			pManager;
+	eastl::vector<Command>	mCommands;
+	eastl::vector<uint8_t>	mData;
+	uint32_t				mCreateCount;
+};
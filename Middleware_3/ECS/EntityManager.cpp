@@ -1,6 +1,7 @@
 #include "../../Common_3/OS/Interfaces/ILog.h"
 
 #include "EntityManager.h"
+#include "EntityCommandBuffer.h"
 // Components ////////////////////////////////////
 //----
 //////////////////////////////////////////////////
@@ -76,9 +77,20 @@ void Entity::addComponent(BaseComponent* component)
 	}
 }
 
+// reserve() always rehashes to just fit, so only grow when the batch would cause a rehash anyway and then at least
+// double like the map itself would
+static void reserveEntities(EntityMap& entities, uint32_t count)
+{
+	const size_t size = entities.size() + count;
+	if ((float)size > (float)entities.bucket_count() * entities.get_max_load_factor())
+		entities.reserve(size > entities.size() * 2 ? size : entities.size() * 2);
+}
+
 EntityManager::EntityManager()
 {
-	mEntityIdCounter = 1; // entity ids will be used in scene graph tree for transformations... 0 will be dedicated to scene root.
+	// entity ids will be used in scene graph tree for transformations... index 0 will be dedicated to scene root.
+	tfrg_atomic32_store_relaxed(&mFreeIdCursor, 0);
+	tfrg_atomic32_store_relaxed(&mNextEntityIndex, 1);
 
 	mComponentViseMap.rehash(93);
 	const eastl::unordered_map<uint32_t, ComponentGeneratorFctPtr>& CompGenMap = ComponentRegistrator::getInstance()->getComponentGeneratorMap();
@@ -105,77 +117,258 @@ EntityManager::~EntityManager()
 
 void EntityManager::reset()
 {
-	eastl::unordered_map<EntityId, Entity*> entities = getEntities();
-	// Release memory for each entity
-	for (eastl::pair<EntityId, Entity*> entity : entities)
+	eastl::vector<EntityId> ids;
+	ids.reserve(mEntities.size());
+	for (eastl::pair<EntityId, Entity*> entity : mEntities)
 	{
-		deleteEntity(entity.first);
+		ids.push_back(entity.first);
 	}
+	// Release memory for each entity
+	deleteEntities(ids.data(), (uint32_t)ids.size());
 	mEntities.clear();
 
 	// Clear stale component pointers
-	for (eastl::pair<uint32_t, ComponentLookup> pair : mComponentViseMap)
+	for (eastl::pair<const uint32_t, ComponentLookup>& pair : mComponentViseMap)
 	{
 		pair.second.clear();
 	}
+
+	{
+		MutexLock lock(mComponentMutex);
+		mArchetypeStorage.reset();
+	}
+
+	MutexLock lock(mIdMutex);
+	recycleDeletedIds();
 }
 
-EntityId EntityManager::createEntity()
+void EntityManager::reserveEntityIds(EntityId* pIds, uint32_t count)
 {
-	Entity* new_entity = tf_placement_new<Entity>(tf_calloc(1, sizeof(Entity)));
+	if (!count)
+		return;
 
-	EntityId id = 0;
+	// Take from the top of the free list, the cursor going negative just means it ran out
+	const int32_t freeEnd = (int32_t)tfrg_atomic32_add_relaxed(&mFreeIdCursor, -(int32_t)count);
+	const uint32_t reuseCount = freeEnd > 0 ? ((uint32_t)freeEnd < count ? (uint32_t)freeEnd : count) : 0;
+	for (uint32_t i = 0; i < reuseCount; ++i)
+		pIds[i] = mFreeIds[freeEnd - 1 - i];
+
+	if (reuseCount < count)
 	{
-		MutexLock lock(mIdMutex);
-		id = mEntityIdCounter++;
-		MutexLock entLock(mEntitiesMutex);
-		mEntities[id] = new_entity;
+		const uint32_t firstIndex = (uint32_t)tfrg_atomic32_add_relaxed(&mNextEntityIndex, count - reuseCount);
+		// id == 0 is reserved for SCENE_ROOT, running out of indices would wrap around to it
+		ASSERT(firstIndex + (count - reuseCount) - 1 <= ENTITY_INDEX_MASK && "Out of entity indices, raise ENTITY_INDEX_BITS");
+		for (uint32_t i = reuseCount; i < count; ++i)
+			pIds[i] = makeEntityId(firstIndex + i - reuseCount, 0);
 	}
+}
 
-    // If id < 0, the m_EntityIdCounter is over flow.
-    // id == 0 is reserved for SCENE_ROOT.
-    ASSERT(id > 0);
+void EntityManager::recycleDeletedIds()
+{
+	// Drop the ids taken from the free list since the last sync point, then add the deleted ones
+	const int32_t freeEnd = (int32_t)tfrg_atomic32_load_relaxed(&mFreeIdCursor);
+	mFreeIds.resize(freeEnd > 0 ? (uint32_t)freeEnd : 0);
+	mFreeIds.insert(mFreeIds.end(), mDeletedIds.begin(), mDeletedIds.end());
+	mDeletedIds.clear();
+	tfrg_atomic32_store_release(&mFreeIdCursor, (uint32_t)mFreeIds.size());
+}
 
+void EntityManager::takeEntityIds(EntityId* pIds, uint32_t count)
+{
+	// Command buffers never touch mDeletedIds, so the immediate API can reuse deleted ids without a sync point
+	uint32_t reuseCount = 0;
+	{
+		MutexLock lock(mIdMutex);
+		while (reuseCount < count && !mDeletedIds.empty())
+		{
+			pIds[reuseCount++] = mDeletedIds.back();
+			mDeletedIds.pop_back();
+		}
+	}
+	reserveEntityIds(pIds + reuseCount, count - reuseCount);
+}
+
+EntityId EntityManager::createEntity()
+{
+	EntityId id = 0;
+	createEntities(&id, 1);
 	return id;
 }
 
+void EntityManager::createEntities(EntityId* pIds, uint32_t count)
+{
+	takeEntityIds(pIds, count);
+
+	eastl::vector<Entity*> newEntities(count);
+	for (uint32_t i = 0; i < count; ++i)
+		newEntities[i] = tf_placement_new<Entity>(tf_calloc(1, sizeof(Entity)));
+
+	MutexLock entLock(mEntitiesMutex);
+	reserveEntities(mEntities, count);
+	for (uint32_t i = 0; i < count; ++i)
+		mEntities[pIds[i]] = newEntities[i];
+}
+
 EntityId EntityManager::cloneEntity(EntityId id)
 {
 	Entity* source_entity = getEntityById(id);
 	Entity* new_entity	  = source_entity->clone();
 
 	EntityId newid = 0;
+	takeEntityIds(&newid, 1);
 	{
-		MutexLock lock(mIdMutex);
-		newid = mEntityIdCounter++;
 		MutexLock entLock(mEntitiesMutex);
 		mEntities[newid] = new_entity;
 	}
+
+	{
+		MutexLock lock(mComponentMutex);
+		for (Entity::ComponentMap::iterator it = new_entity->mComponents.begin(); it != new_entity->mComponents.end(); ++it)
+			mComponentViseMap[it->first].insert(Pair(newid, it->second));
+		mArchetypeStorage.cloneEntity(id, newid);
+	}
 	
 	return newid;
 }
 
 void EntityManager::deleteEntity(EntityId id)
 {
-	ASSERT (id != 0); // 0 is reserved for describing to root of the scene in the scene graph
+	deleteEntities(&id, 1);
+}
+
+void EntityManager::deleteEntities(const EntityId* pIds, uint32_t count)
+{
+	eastl::vector<Entity*> deletedEntities(count);
+	{
+		MutexLock lock(mEntitiesMutex);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			ASSERT (pIds[i] != 0); // 0 is reserved for describing to root of the scene in the scene graph
+			// Unpopulate data structures
+			eastl::unordered_map<EntityId, Entity*>::iterator entities_iter = mEntities.find(pIds[i]);
+			ASSERT(entities_iter != mEntities.end());
+			deletedEntities[i] = entities_iter->second;
+			mEntities.erase(entities_iter);
+		}
+	}
+	{
+		MutexLock lock(mComponentMutex);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			// Component lookups would otherwise keep pointers to the freed components
+			for (Entity::ComponentMap::iterator it = deletedEntities[i]->mComponents.begin(); it != deletedEntities[i]->mComponents.end(); ++it)
+				mComponentViseMap[it->first].erase(pIds[i]);
+			mArchetypeStorage.removeEntity(pIds[i]);
+		}
+	}
+	{
+		MutexLock lock(mIdMutex);
+		for (uint32_t i = 0; i < count; ++i)
+			mDeletedIds.push_back(makeEntityId(getEntityIndex(pIds[i]), getEntityGeneration(pIds[i]) + 1));
+	}
 
 	// Free components and actual entity memory
-	Entity* entity = NULL;
+	for (Entity* entity : deletedEntities)
+	{
+		entity->~Entity();
+		tf_free(entity);
+	}
+}
 
-	entity = getEntityById(id);
-	ASSERT(entity);
+BaseComponent* EntityManager::createComponent(Entity* pEntity, EntityId id, uint32_t componentType)
+{
+	BaseComponent* pComponent = nullptr;
 
+	const eastl::unordered_map< uint32_t, ComponentGeneratorFctPtr >& CompGenMap   = ComponentRegistrator::getInstance()->getComponentGeneratorMap();
+	eastl::unordered_map< uint32_t, ComponentGeneratorFctPtr >::const_iterator itr = CompGenMap.find(componentType);
+	if (itr != CompGenMap.end())
 	{
-		MutexLock lock(mEntitiesMutex);
-		// Unpopulate data structures
-		eastl::unordered_map<EntityId, Entity*>::iterator entities_iter = mEntities.find(id);
-		ASSERT(entities_iter != mEntities.end());
-		mEntities.erase(entities_iter);
+		pComponent = itr->second();
+		pEntity->addComponent(pComponent);
+
+		ComponentViseMap::iterator itr = mComponentViseMap.find(componentType);
+		if (itr != mComponentViseMap.end())
+		{
+			ComponentLookup& componentMap = itr->second;
+			componentMap.insert(Pair(id, pComponent));
+		}
+		else
+		{
+			ASSERT(0);
+		}
+	}
+	else
+	{
+		ASSERT(0 && "COMPONENT OF GIVEN NAME NOT FOUND");
 	}
-	entity->~Entity();
-	tf_free(entity);
+
+	return pComponent;
 }
 
+void EntityManager::applyCommandBuffers(EntityCommandBuffer* const* ppBuffers, uint32_t count)
+{
+	// Same lock order as addComponentToEntity, held for the whole batch instead of per entity
+	MutexLock componentLock(mComponentMutex);
+
+	// Creations first, in one go, so commands can refer to entities created by buffers applied after them
+	eastl::vector<EntityId> deletedIds;
+	{
+		MutexLock entLock(mEntitiesMutex);
+		uint32_t createCount = 0;
+		for (uint32_t b = 0; b < count; ++b)
+			createCount += ppBuffers[b]->mCreateCount;
+		reserveEntities(mEntities, createCount);
+		for (uint32_t b = 0; b < count; ++b)
+		{
+			for (const EntityCommandBuffer::Command& command : ppBuffers[b]->mCommands)
+			{
+				if (EntityCommandBuffer::COMMAND_CREATE_ENTITY == command.mType)
+					mEntities[command.mId] = tf_placement_new<Entity>(tf_calloc(1, sizeof(Entity)));
+			}
+		}
+
+		for (uint32_t b = 0; b < count; ++b)
+		{
+			EntityCommandBuffer* pBuffer = ppBuffers[b];
+			for (const EntityCommandBuffer::Command& command : pBuffer->mCommands)
+			{
+				switch (command.mType)
+				{
+				case EntityCommandBuffer::COMMAND_DELETE_ENTITY:
+					deletedIds.push_back(command.mId);
+					break;
+				case EntityCommandBuffer::COMMAND_ADD_COMPONENT:
+				{
+					EntityMap::iterator iter = mEntities.find(command.mId);
+					ASSERT(iter != mEntities.end());
+					createComponent(iter->second, command.mId, command.mComponentType);
+					break;
+				}
+				case EntityCommandBuffer::COMMAND_ADD_DATA_COMPONENT:
+				{
+					void* pComponent = mArchetypeStorage.addComponent(command.mId, command.mComponentType);
+					memcpy(pComponent, pBuffer->mData.data() + command.mDataOffset, getDataComponentTypeInfo(command.mComponentType).mSize);
+					break;
+				}
+				case EntityCommandBuffer::COMMAND_REMOVE_DATA_COMPONENT:
+					mArchetypeStorage.removeComponent(command.mId, command.mComponentType);
+					break;
+				default:
+					break;
+				}
+			}
+			pBuffer->mCommands.clear();
+			pBuffer->mData.clear();
+			pBuffer->mCreateCount = 0;
+		}
+	}
+
+	// Deletions last, a buffer may add components to an entity another one deletes
+	deleteEntities(deletedIds.data(), (uint32_t)deletedIds.size());
+
+	MutexLock idLock(mIdMutex);
+	recycleDeletedIds();
+}
 
 Entity* EntityManager::getEntityById(EntityId const id)
 {
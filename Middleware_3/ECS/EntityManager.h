@@ -13,8 +13,11 @@ namespace FCR
 	class ComponentRepresentation;
 };
 
+class EntityCommandBuffer;
+
 //class BaseComponent;
 #include "BaseComponent.h"
+#include "ArchetypeStorage.h"
 
 // An entity is collection of components.
 // An entity has a name.
@@ -84,8 +87,6 @@ void Entity::getComponent(T*& componentOut)
 	componentOut = getComponent<T>();
 }
 
-typedef int32_t EntityId;
-
 typedef eastl::unordered_map<EntityId, Entity*>					 EntityMap;
 typedef eastl::unordered_map<EntityId, Entity*>::iterator		 EntityMapIterator;
 typedef eastl::unordered_map<EntityId, Entity*>::const_iterator  EntityMapConstIterator;
@@ -107,6 +108,18 @@ public:
 	EntityId cloneEntity(EntityId id);
 	void deleteEntity(EntityId id);
 
+	// Bulk versions of createEntity / deleteEntity, each takes the locks once
+	void createEntities(EntityId* pIds, uint32_t count);
+	void deleteEntities(const EntityId* pIds, uint32_t count);
+
+	// Hands out ids for entities that get created later, see EntityCommandBuffer. Lock free, but must not run
+	// concurrently with applyCommandBuffers or reset.
+	void reserveEntityIds(EntityId* pIds, uint32_t count);
+
+	// Sync point: plays back the buffers in order, then clears them. Ids of entities deleted since the last sync
+	// point become available to command buffers afterwards, createEntity and cloneEntity reuse them right away.
+	void applyCommandBuffers(EntityCommandBuffer* const* ppBuffers, uint32_t count);
+
 	Entity* getEntityById(EntityId const id);
     
 	bool entityExist(EntityId const id);
@@ -133,7 +146,31 @@ public:
 		return *map;
 	}
 
+	// Data components live in archetype chunks instead of the component maps, see ArchetypeStorage.h
+	template <typename T>
+	T& addDataComponentToEntity(EntityId id);
+
+	template <typename T>
+	void removeDataComponentFromEntity(EntityId id);
+
+	// NULL when the entity does not have the data component
+	template <typename T>
+	T* getDataComponent(EntityId id);
+
+	// Entities with at least the data components T, see DataComponentQuery
+	template <typename... T>
+	DataComponentQuery<T...> queryDataComponents() const { return DataComponentQuery<T...>(&mArchetypeStorage); }
+
+	const ArchetypeStorage& getArchetypeStorage() const { return mArchetypeStorage; }
+
 private:
+	// Expects mComponentMutex to be held
+	BaseComponent* createComponent(Entity* pEntity, EntityId id, uint32_t componentType);
+	// Expects mIdMutex to be held
+	void recycleDeletedIds();
+	// Ids for the immediate API, deleted ones first
+	void takeEntityIds(EntityId* pIds, uint32_t count);
+
 	Mutex mIdMutex;
 	Mutex mEntitiesMutex;
 	Mutex mComponentMutex;
@@ -148,11 +185,22 @@ private:
 	//eastl::unordered_map<EntityId, EEntityType>		mEntitiesType;
 	eastl::unordered_map<eastl::string, EntityId>	mEntitiesName;
 
-	// incr. on entity creation... used to fetch entities.
-	EntityId										mEntityIdCounter;
+	/* Note:	ids are handed out without locks. mFreeIds only changes at sync
+	 *			points and mFreeIdCursor counts down through it, once it is
+	 *			used up fresh indices come from mNextEntityIndex. Deleted ids
+	 *			wait in mDeletedIds (guarded by mIdMutex), with their generation
+	 *			already bumped. createEntity and cloneEntity take them from
+	 *			there directly, the rest move to mFreeIds at the next sync point.
+	 */
+	eastl::vector<EntityId>							mFreeIds;
+	tfrg_atomic32_t									mFreeIdCursor;
+	tfrg_atomic32_t									mNextEntityIndex;
+	eastl::vector<EntityId>							mDeletedIds;
 	/////////////////////////////////////////////////////////////////
 
 	ComponentViseMap mComponentViseMap;
+	// Guarded by mComponentMutex
+	ArchetypeStorage mArchetypeStorage;
 };
 
 
@@ -160,32 +208,27 @@ template <typename T>
 T& EntityManager::addComponentToEntity(EntityId _id)
 {
 	MutexLock lock(mComponentMutex);
-	
-	BaseComponent* pComponent = nullptr;
+	return *(static_cast<T*>(createComponent(getEntityById(_id), _id, T::getTypeStatic())));
+}
 
-	const eastl::unordered_map< uint32_t, ComponentGeneratorFctPtr >& CompGenMap   = ComponentRegistrator::getInstance()->getComponentGeneratorMap();
-	eastl::unordered_map< uint32_t, ComponentGeneratorFctPtr >::const_iterator itr = CompGenMap.find(T::getTypeStatic());
-	if (itr != CompGenMap.end())
-	{
-		pComponent = itr->second();
-		Entity* pEntity = getEntityById(_id);
-		pEntity->addComponent(pComponent);
+template <typename T>
+T& EntityManager::addDataComponentToEntity(EntityId id)
+{
+	ASSERT(entityExist(id) && id != 0);
+	MutexLock lock(mComponentMutex);
+	return *(T*)mArchetypeStorage.addComponent(id, getDataComponentTypeId<T>());
+}
 
-		ComponentViseMap::iterator itr = mComponentViseMap.find(T::getTypeStatic());
-		if (itr != mComponentViseMap.end())
-		{
-			ComponentLookup& componentMap = itr->second;
-			componentMap.insert(Pair(_id, pComponent));
-		}
-		else
-		{
-			ASSERT(0);
-		}
-	}
-	else
-	{
-		ASSERT(0 && "COMPONENT OF GIVEN NAME NOT FOUND");
-	}
+template <typename T>
+void EntityManager::removeDataComponentFromEntity(EntityId id)
+{
+	MutexLock lock(mComponentMutex);
+	mArchetypeStorage.removeComponent(id, getDataComponentTypeId<T>());
+}
 
-	return *(static_cast<T*>(pComponent));
+template <typename T>
+T* EntityManager::getDataComponent(EntityId id)
+{
+	MutexLock lock(mComponentMutex);
+	return (T*)mArchetypeStorage.getComponent(id, getDataComponentTypeId<T>());
 }
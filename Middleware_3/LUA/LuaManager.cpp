@@ -28,28 +28,64 @@ void LuaManager::SetFunction(ILuaFunctionWrap* wrap)
 	m_Impl->SetFunction(wrap);
 }
 
+void LuaManager::SetScriptCacheDirectory(ResourceDirectory cacheDir)
+{
+	ASSERT(m_Impl != nullptr);
+	m_Impl->SetScriptCacheDirectory(cacheDir);
+}
+
 bool LuaManager::RunScript(const char* scriptFile)
 {
 	ASSERT(m_Impl != nullptr);
 	return m_Impl->RunScript(scriptFile);
 }
 
-void LuaManager::AddAsyncScript(const char* scriptFile, ScriptDoneCallback callback)
+uint32_t LuaManager::AddAsyncScript(const char* scriptFile, ScriptDoneCallback callback)
+{
+	ASSERT(m_Impl != nullptr);
+	return m_Impl->AddAsyncScript(scriptFile, callback);
+}
+
+uint32_t LuaManager::AddAsyncScript(const char* scriptFile)
+{
+	ASSERT(m_Impl != nullptr);
+	return m_Impl->AddAsyncScript(scriptFile);
+}
+
+uint32_t LuaManager::AddAsyncScript(const char* scriptFile, IScriptCallbackWrap* callbackLambda)
+{
+	ASSERT(m_Impl != nullptr);
+	return m_Impl->AddAsyncScript(scriptFile, callbackLambda);
+}
+
+uint32_t LuaManager::DispatchAsyncScriptCallbacks()
+{
+	ASSERT(m_Impl != nullptr);
+	return m_Impl->DispatchAsyncScriptCallbacks();
+}
+
+bool LuaManager::IsAsyncScriptFinished(uint32_t scriptId)
+{
+	ASSERT(m_Impl != nullptr);
+	return m_Impl->IsAsyncScriptFinished(scriptId);
+}
+
+uint32_t LuaManager::GetRunningAsyncScriptCount()
 {
 	ASSERT(m_Impl != nullptr);
-	m_Impl->AddAsyncScript(scriptFile, callback);
+	return m_Impl->GetRunningAsyncScriptCount();
 }
 
-void LuaManager::AddAsyncScript(const char* scriptFile)
+void LuaManager::WaitForAsyncScript(uint32_t scriptId)
 {
 	ASSERT(m_Impl != nullptr);
-	m_Impl->AddAsyncScript(scriptFile);
+	m_Impl->WaitForAsyncScript(scriptId);
 }
 
-void LuaManager::AddAsyncScript(const char* scriptFile, IScriptCallbackWrap* callbackLambda)
+void LuaManager::WaitForAsyncScripts()
 {
 	ASSERT(m_Impl != nullptr);
-	m_Impl->AddAsyncScript(scriptFile, callbackLambda);
+	m_Impl->WaitForAsyncScripts();
 }
 
 bool LuaManager::SetUpdatableScript(const char* scriptFile, const char* updateFunctionName, const char* exitFunctionName)
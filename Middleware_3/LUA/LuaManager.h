@@ -15,28 +15,44 @@ class LuaManager
 	void Exit();
 	~LuaManager();
 
+	//Call it from the thread running RunScript() and Update(), it does not wait for running async scripts.
 	template <class T>
 	void SetFunction(const char* functionName, T function);
 
+	//Scripts compiled once are cached as lua bytecode in cacheDir and later runs skip parsing them.
+	//cacheDir has to be writable, RD_COUNT (the default) disables the cache. Set it before running scripts.
+	void SetScriptCacheDirectory(ResourceDirectory cacheDir);
 	bool RunScript(const char* scriptFile);
-	void AddAsyncScript(const char* scriptFile, ScriptDoneCallback callback);
-	void AddAsyncScript(const char* scriptFile);
+	//Async scripts run on worker threads and return an id for the functions below.
+	//Their callbacks are run on the thread calling Update() or DispatchAsyncScriptCallbacks(), not on the workers.
+	//Functions set with SetFunction() can be called from the workers, so they have to be thread safe.
+	uint32_t AddAsyncScript(const char* scriptFile, ScriptDoneCallback callback);
+	uint32_t AddAsyncScript(const char* scriptFile);
 
 	template <class T>
-	void AddAsyncScript(const char* scriptFile, T callbackLambda);
+	uint32_t AddAsyncScript(const char* scriptFile, T callbackLambda);
+
+	//Runs the callbacks of the async scripts which finished since the last call, returns how many were run
+	uint32_t DispatchAsyncScriptCallbacks();
+	bool     IsAsyncScriptFinished(uint32_t scriptId);
+	uint32_t GetRunningAsyncScriptCount();
+	//Block until the script(s) finished. Callbacks still wait for Update() or DispatchAsyncScriptCallbacks().
+	void     WaitForAsyncScript(uint32_t scriptId);
+	void     WaitForAsyncScripts();
 
 	//updateFunctionName - function that will be called on Update()
 	bool SetUpdatableScript(const char* scriptFile, const char* updateFunctionName, const char* exitFunctionName);
 	bool ReloadUpdatableScript();
 	//updateFunctionName - function that will be called.
 	//If nullptr then function from SetUpdateScript arg is used.
+	//Also dispatches the callbacks of finished async scripts.
 	bool Update(float deltaTime, const char* updateFunctionName = nullptr);
 
 	private:
 	LuaManagerImpl* m_Impl;
 
 	void SetFunction(ILuaFunctionWrap* wrap);
-	void AddAsyncScript(const char* scriptFile, IScriptCallbackWrap* callbackLambda);
+	uint32_t AddAsyncScript(const char* scriptFile, IScriptCallbackWrap* callbackLambda);
 };
 
 template <typename T>
@@ -48,11 +64,11 @@ void LuaManager::SetFunction(const char* functionName, T function)
 }
 
 template <class T>
-void LuaManager::AddAsyncScript(const char* scriptFile, T callbackLambda)
+uint32_t LuaManager::AddAsyncScript(const char* scriptFile, T callbackLambda)
 {
 	IScriptCallbackWrap* lambdaWrap = (IScriptCallbackWrap*)tf_calloc(1, sizeof(ScriptCallbackWrap<T>));
 	tf_placement_new<ScriptCallbackWrap<T> >(lambdaWrap, callbackLambda);
-	AddAsyncScript(scriptFile, lambdaWrap);
+	return AddAsyncScript(scriptFile, lambdaWrap);
 }
 
 #include "../../Common_3/ThirdParty/OpenSource/FluidStudios/MemoryManager/nommgr.h"
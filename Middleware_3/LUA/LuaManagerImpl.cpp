@@ -1,9 +1,11 @@
 #include "LuaManagerImpl.h"
 
 #include "../../Common_3/ThirdParty/OpenSource/EASTL/string.h"
+#include "../../Common_3/ThirdParty/OpenSource/EASTL/algorithm.h"
 #include "../../Common_3/OS/Interfaces/IFileSystem.h"
 #include "../../Common_3/OS/Interfaces/ICameraController.h"
 #include "../../Common_3/OS/Interfaces/IMemory.h"
+#include "../../Common_3/ThirdParty/OpenSource/murmurhash3/MurmurHash3_32.h"
 
 const char LuaManagerImpl::className[] = "LuaManager";
 bool       LuaManagerImpl::m_registered = false;
@@ -40,21 +42,31 @@ Luna<LuaManagerImpl>::FunctionType LuaManagerImpl::methods[] = { { NULL, NULL }
 
 Luna<LuaManagerImpl>::PropertyType LuaManagerImpl::properties[] = { { NULL, NULL } };
 
-LuaManagerImpl::LuaManagerImpl(lua_State* L): m_SyncLuaState(nullptr) { memset(m_AsyncLuaStates, 0, MAX_LUA_WORKERS * sizeof(lua_State*)); }
+LuaManagerImpl::LuaManagerImpl(lua_State* L): m_SyncLuaState(nullptr), m_pAsyncThreadSystem(nullptr), m_ScriptCacheDir(RD_COUNT) { memset(m_AsyncLuaStates, 0, MAX_LUA_WORKERS * sizeof(lua_State*)); }
 
-LuaManagerImpl::LuaManagerImpl(): m_SyncLuaState(nullptr), m_AsyncScriptsCounter(0)
+LuaManagerImpl::LuaManagerImpl(): m_SyncLuaState(nullptr), m_pAsyncThreadSystem(nullptr), m_ScriptCacheDir(RD_COUNT), m_AsyncScriptsCounter(0)
 {
 	memset(m_AsyncLuaStates, 0, MAX_LUA_WORKERS * sizeof(lua_State*));
+	memset(m_AsyncLuaStateFunctionCount, 0, MAX_LUA_WORKERS * sizeof(uint32_t));
 
 	Register();
 	
-	for (uint32_t i = 0; i <  MAX_LUA_WORKERS; ++i)
-		m_AsyncLuaStatesMutex[i].Init();
-	m_AddAsyncScriptMutex.Init();
+	m_FunctionsMutex.Init();
+	m_AsyncScriptsMutex.Init();
+	m_AsyncScriptsCond.Init();
+	m_FreeAsyncLuaStates = (1u << MAX_LUA_WORKERS) - 1;
+
+	initThreadSystem(&m_pAsyncThreadSystem, MAX_LUA_WORKERS, 0, true, "LuaWorker");
 }
 
 LuaManagerImpl::~LuaManagerImpl()
 {
+	//Scripts still running use the async states, the callbacks of the finished ones still own their lambdas
+	WaitForAsyncScripts();
+	DispatchAsyncScriptCallbacks();
+	shutdownThreadSystem(m_pAsyncThreadSystem);
+	m_pAsyncThreadSystem = nullptr;
+
 	DestroyLuaState(m_SyncLuaState);
 	m_SyncLuaState = nullptr;
 
@@ -72,15 +84,16 @@ LuaManagerImpl::~LuaManagerImpl()
 		m_AsyncLuaStates[i] = nullptr;
 	}
 
+	ReleaseRetiredFunctions();
 	for (size_t i = 0; i < m_Functions.size(); ++i)
 	{
 		m_Functions[i]->~ILuaFunctionWrap();
 		tf_free(m_Functions[i]);
 	}
 
-	for (uint32_t i = 0; i <  MAX_LUA_WORKERS; ++i)
-		m_AsyncLuaStatesMutex[i].Destroy();
-	m_AddAsyncScriptMutex.Destroy();
+	m_FunctionsMutex.Destroy();
+	m_AsyncScriptsCond.Destroy();
+	m_AsyncScriptsMutex.Destroy();
 	
 	m_registered = false;
 }
@@ -115,36 +128,111 @@ static int msghandler(lua_State* L)
 	return 1; /* return the traceback */
 }
 
-const char* luaReaderFunction(lua_State *L, void *ud, size_t *sz)
+//The whole file in one allocation, lua parses straight out of it instead of through a reader copying chunks
+static char* ReadScriptFile(ResourceDirectory resourceDir, const char* fileName, size_t* pSize)
 {
-	FileStream* pHandle = (FileStream*)ud;
-	const size_t size = 1024;
-	static char buffer[size];
-	//*sz = read_file((void*)buffer, size, pHandle);
-	*sz = fsReadFromStream(pHandle, buffer, size);
+	FileStream fh = {};
+	if (!fsOpenStreamFromPath(resourceDir, fileName, FM_READ_BINARY, &fh))
+		return nullptr;
+
+	ssize_t size = fsGetStreamFileSize(&fh);
+	char* buffer = size >= 0 ? (char*)tf_malloc((size_t)size + 1) : nullptr;
+	if (buffer != nullptr && fsReadFromStream(&fh, buffer, (size_t)size) != (size_t)size)
+	{
+		tf_free(buffer);
+		buffer = nullptr;
+	}
+	fsCloseStream(&fh);
+
+	*pSize = buffer != nullptr ? (size_t)size : 0;
 	return buffer;
 }
 
-int RunScriptFile(const char* scriptFile, lua_State* L)
+static int luaWriterFunction(lua_State* L, const void* p, size_t sz, void* ud)
 {
-	//int loadfile_error = luaL_loadfile(L, scriptFile);
-	lua_Reader reader = luaReaderFunction;
-    
-	FileStream fh = {};
-	
-    if (!fsOpenStreamFromPath(RD_SCRIPTS, scriptFile, FM_READ_BINARY, &fh))
-    {
-        return false;
-    }
-    
-	int loadfile_error = lua_load(L, reader, &fh, NULL, NULL);
-    fsCloseStream(&fh);
-	if (loadfile_error != 0)
+	eastl::vector<char>* pByteCode = (eastl::vector<char>*)ud;
+	pByteCode->insert(pByteCode->end(), (const char*)p, (const char*)p + sz);
+	return 0;
+}
+
+//Named after the hash and size of the source, an edited script misses the cache instead of loading stale bytecode.
+//Bytecode from another lua build fails the header check of lua_load and is rebuilt.
+static void GetScriptCacheFileName(const char* scriptFile, const char* source, size_t sourceSize, char* output)
+{
+	uint32_t hash = 0;
+	MurmurHash3_x86_32(source, (int)sourceSize, 0, &hash);
+
+	char scriptName[FS_MAX_PATH] = {};
+	fsGetPathFileName(scriptFile, scriptName);
+	snprintf(output, FS_MAX_PATH, "%s.%zx_%08x.luac", scriptName, sourceSize, hash);
+}
+
+//Pushes the compiled chunk of scriptFile, from the bytecode cache when there is one
+static bool LoadScriptChunk(const char* scriptFile, lua_State* L, ResourceDirectory cacheDir)
+{
+	size_t sourceSize = 0;
+	char* source = ReadScriptFile(RD_SCRIPTS, scriptFile, &sourceSize);
+	if (source == nullptr)
 	{
-		LOGF(eERROR, "Can't load script %s\n", scriptFile);
+		LOGF(eERROR, "Can't open script %s\n", scriptFile);
 		return false;
 	}
 
+	//'@' makes lua report errors against the file name
+	char chunkName[FS_MAX_PATH + 1] = {};
+	snprintf(chunkName, sizeof(chunkName), "@%s", scriptFile);
+
+	int status = LUA_ERRFILE;
+	char cacheFile[FS_MAX_PATH] = {};
+	if (cacheDir != RD_COUNT)
+	{
+		GetScriptCacheFileName(scriptFile, source, sourceSize, cacheFile);
+		size_t byteCodeSize = 0;
+		char* byteCode = ReadScriptFile(cacheDir, cacheFile, &byteCodeSize);
+		if (byteCode != nullptr)
+		{
+			status = luaL_loadbufferx(L, byteCode, byteCodeSize, chunkName, "b");
+			tf_free(byteCode);
+			if (status != LUA_OK)
+			{
+				LOGF(eWARNING, "Rebuilding script cache %s: %s\n", cacheFile, lua_tostring(L, -1));
+				lua_pop(L, 1);
+			}
+		}
+	}
+
+	if (status != LUA_OK)
+	{
+		status = luaL_loadbufferx(L, source, sourceSize, chunkName, NULL);
+		//Debug info is kept so errors still have line numbers.
+		//Workers compiling the same script at once write the same bytes, a reader catching a partial file falls back to the source.
+		if (status == LUA_OK && cacheDir != RD_COUNT)
+		{
+			eastl::vector<char> byteCode;
+			FileStream fh = {};
+			if (lua_dump(L, luaWriterFunction, &byteCode, 0) == 0 && fsOpenStreamFromPath(cacheDir, cacheFile, FM_WRITE_BINARY, &fh))
+			{
+				fsWriteToStream(&fh, byteCode.data(), byteCode.size());
+				fsCloseStream(&fh);
+			}
+		}
+	}
+	tf_free(source);
+
+	if (status != LUA_OK)
+	{
+		LOGF(eERROR, "Can't load script %s: %s\n", scriptFile, lua_tostring(L, -1));
+		lua_pop(L, 1);
+		return false;
+	}
+	return true;
+}
+
+bool RunScriptFile(const char* scriptFile, lua_State* L, ResourceDirectory cacheDir)
+{
+	if (!LoadScriptChunk(scriptFile, L, cacheDir))
+		return false;
+
 	int status;
 	int narg = 0;
 	int nres = 0;
@@ -186,24 +274,9 @@ bool LuaManagerImpl::SetUpdatableScript(const char* scriptFile, const char* upda
 	m_UpdateFunctonName = updateFunctionName;
     m_UpdatableScriptFile = scriptFile;
 	m_UpdatableScriptExitName = exitFunctionName;
-	//int loadfile_error = luaL_loadfile(m_UpdatableScriptLuaState, m_UpdatableScriptName.c_str());
-	lua_Reader reader = luaReaderFunction;
-	//int loadfile_error = lua_load(m_UpdatableScriptLuaState, reader, open_file(scriptFile, "rb"), NULL, NULL);
-    
-	FileStream fHandle = {};
-    if (!fsOpenStreamFromPath(RD_SCRIPTS, scriptFile, FM_READ_BINARY, &fHandle))
-    {
-        return false;
-    }
-    
-	int loadfile_error = lua_load(m_UpdatableScriptLuaState, reader, &fHandle, NULL, NULL);
-    fsCloseStream(&fHandle);
-    
-	if (loadfile_error != 0)
-	{
-		LOGF(eERROR, "Can't load script %s\n", scriptFile);
+	if (!LoadScriptChunk(scriptFile, m_UpdatableScriptLuaState, m_ScriptCacheDir))
 		return false;
-	}
+
 	int narg = 0;
 	int nres = 0;
 	int base = lua_gettop(m_UpdatableScriptLuaState) - narg;  /* function index */
@@ -231,6 +304,12 @@ void LuaManagerImpl::RegisterFunctionsForState(lua_State* state)
 
 bool LuaManagerImpl::Update(float deltaTime, const char* updateFunctionName)
 {
+	DispatchAsyncScriptCallbacks();
+
+	//No updatable script set, only the async callbacks
+	if (m_UpdatableScriptLuaState == nullptr)
+		return false;
+
 	int narg = 1;    //we are going to push "deltaTime"
 	int nres = 0;
 	int base = lua_gettop(m_UpdatableScriptLuaState) - narg; /* function index */
@@ -252,83 +331,167 @@ bool LuaManagerImpl::Update(float deltaTime, const char* updateFunctionName)
 	return false;
 }
 
+void LuaManagerImpl::SetScriptCacheDirectory(ResourceDirectory cacheDir) { m_ScriptCacheDir = cacheDir; }
+
 bool LuaManagerImpl::RunScript(const char* scriptFile)
 {
-	int status = RunScriptFile(scriptFile, m_SyncLuaState);
-	return status == 0;
+	return RunScriptFile(scriptFile, m_SyncLuaState, m_ScriptCacheDir);
 }
 
-void AsyncScriptExecute(void* pData)
+void LuaManagerImpl::AsyncScriptTask(void* pData, uintptr_t)
 {
 	ASSERT(pData != nullptr);
 	ScriptTaskInfo* info = (ScriptTaskInfo*)pData;
-	MutexLock       lock(*(info->mutex));
-	int             status = RunScriptFile(info->scriptFile, info->luaState);
+	info->manager->ExecuteAsyncScript(info);
+}
+
+void LuaManagerImpl::ExecuteAsyncScript(ScriptTaskInfo* info)
+{
+	//There are as many states as workers, so one is free unless another thread system shares the workload
+	uint32_t stateIndex = 0;
+	{
+		MutexLock lock(m_AsyncScriptsMutex);
+		while (m_FreeAsyncLuaStates == 0)
+			m_AsyncScriptsCond.Wait(m_AsyncScriptsMutex);
+		while (!(m_FreeAsyncLuaStates & (1u << stateIndex)))
+			++stateIndex;
+		m_FreeAsyncLuaStates &= ~(1u << stateIndex);
+	}
+
+	//Functions set since the state last ran a script, SetFunction leaves them to the worker so it never waits for a script
+	lua_State* state = m_AsyncLuaStates[stateIndex];
+	{
+		MutexLock lock(m_FunctionsMutex);
+		for (uint32_t i = m_AsyncLuaStateFunctionCount[stateIndex]; i < (uint32_t)m_Functions.size(); ++i)
+			Luna<LuaManagerImpl>::RegisterMethod(state, m_Functions[i]->functionName.c_str(), (int)i);
+		m_AsyncLuaStateFunctionCount[stateIndex] = (uint32_t)m_Functions.size();
+	}
+
+	bool succeeded = RunScriptFile(info->scriptFile.c_str(), state, m_ScriptCacheDir);
+	info->resultState = succeeded ? FINISHED_OK : FINISHED_ERROR;
+
+	{
+		MutexLock lock(m_AsyncScriptsMutex);
+		m_FreeAsyncLuaStates |= 1u << stateIndex;
+		m_RunningScriptIds.erase(eastl::find(m_RunningScriptIds.begin(), m_RunningScriptIds.end(), info->scriptId));
+		m_FinishedScripts.push_back(info);
+	}
+	m_AsyncScriptsCond.WakeAll();
+}
+
+void LuaManagerImpl::DeliverAsyncScriptCallback(ScriptTaskInfo* info)
+{
 	if (info->callback)
 	{
-		info->callback(status == 0 ? FINISHED_OK : FINISHED_ERROR);
+		info->callback(info->resultState);
 	}
 	if (info->callbackLambda)
 	{
-		info->callbackLambda->ExecuteCallback(status == 0 ? FINISHED_OK : FINISHED_ERROR);
+		info->callbackLambda->ExecuteCallback(info->resultState);
 		info->callbackLambda->~IScriptCallbackWrap();
 		tf_free(info->callbackLambda);
 	}
-	info->~ScriptTaskInfo();           //call destructors of non-trivial members of the struct
-	memset(info, 0, sizeof(*info));    //set zeros just in case if someone will try to use released chunk of memory
-	tf_free(info);
+	tf_delete(info);
+}
+
+uint32_t LuaManagerImpl::AddAsyncScriptTask(ScriptTaskInfo* info)
+{
+	info->manager = this;
+	{
+		MutexLock lock(m_AsyncScriptsMutex);
+		//0 is never handed out
+		info->scriptId = ++m_AsyncScriptsCounter;
+		m_RunningScriptIds.push_back(info->scriptId);
+	}
+
+	uint32_t scriptId = info->scriptId;
+	addThreadSystemTask(m_pAsyncThreadSystem, AsyncScriptTask, info);
+	return scriptId;
 }
 
-void LuaManagerImpl::AddAsyncScript(const char* scriptFile, IScriptCallbackWrap* callbackLambda)
+uint32_t LuaManagerImpl::AddAsyncScript(const char* scriptFile, IScriptCallbackWrap* callbackLambda)
 {
-	ScriptTaskInfo* info = (ScriptTaskInfo*)tf_calloc(1, sizeof(ScriptTaskInfo));
+	ScriptTaskInfo* info = tf_new(ScriptTaskInfo);
 	info->scriptFile = scriptFile;
 	info->callback = nullptr;
-
 	info->callbackLambda = callbackLambda;
+	return AddAsyncScriptTask(info);
+}
 
-	//ThreadDesc* pItem = (ThreadDesc*)tf_calloc(1, sizeof(*pItem));
+uint32_t LuaManagerImpl::AddAsyncScript(const char* scriptFile, ScriptDoneCallback callback)
+{
+	ScriptTaskInfo* info = tf_new(ScriptTaskInfo);
+	info->scriptFile = scriptFile;
+	info->callback = callback;
+	info->callbackLambda = nullptr;
+	return AddAsyncScriptTask(info);
+}
 
-	//pItem->pFunc = AsyncScriptExecute;
-	//pItem->pData = info;
+uint32_t LuaManagerImpl::AddAsyncScript(const char* scriptFile)
+{
+	ScriptDoneCallback cb = nullptr;
+	return AddAsyncScript(scriptFile, cb);
+}
 
+uint32_t LuaManagerImpl::DispatchAsyncScriptCallbacks()
+{
+	//Callbacks may add new scripts, so they run outside of the lock
+	eastl::vector<ScriptTaskInfo*> finishedScripts;
 	{
-		MutexLock lock(m_AddAsyncScriptMutex);
-		info->luaState = m_AsyncLuaStates[m_AsyncScriptsCounter % MAX_LUA_WORKERS];
-		info->mutex = &m_AsyncLuaStatesMutex[m_AsyncScriptsCounter % MAX_LUA_WORKERS];
-		++m_AsyncScriptsCounter;
-
-		//for now we run scripts in synchronous way
-		//m_ThreadPool->AddWorkItem(pItem);
-		AsyncScriptExecute(info);
+		MutexLock lock(m_AsyncScriptsMutex);
+		finishedScripts.swap(m_FinishedScripts);
 	}
+
+	for (ScriptTaskInfo* info : finishedScripts)
+		DeliverAsyncScriptCallback(info);
+
+	ReleaseRetiredFunctions();
+	return (uint32_t)finishedScripts.size();
 }
 
-void LuaManagerImpl::AddAsyncScript(const char* scriptFile, ScriptDoneCallback callback)
+void LuaManagerImpl::ReleaseRetiredFunctions()
 {
-	ScriptTaskInfo* info = (ScriptTaskInfo*)tf_calloc(1, sizeof(ScriptTaskInfo));
-    info->scriptFile = scriptFile;
-	info->callback = callback;
-	info->callbackLambda = nullptr;
-	//ThreadDesc* pItem = (ThreadDesc*)tf_calloc(1, sizeof(*pItem));
-
-	//pItem->pFunc = AsyncScriptExecute;
-	//pItem->pData = info;
+	//Scripts started after a function was replaced only ever see the new one
+	eastl::vector<ILuaFunctionWrap*> retiredFunctions;
+	{
+		MutexLock lock(m_AsyncScriptsMutex);
+		if (!m_RunningScriptIds.empty())
+			return;
+		retiredFunctions.swap(m_RetiredFunctions);
+	}
 
+	for (ILuaFunctionWrap* function : retiredFunctions)
 	{
-		MutexLock lock(m_AddAsyncScriptMutex);
-		info->luaState = m_AsyncLuaStates[m_AsyncScriptsCounter % MAX_LUA_WORKERS];
-		info->mutex = &m_AsyncLuaStatesMutex[m_AsyncScriptsCounter % MAX_LUA_WORKERS];
-		++m_AsyncScriptsCounter;
-		//m_ThreadPool->AddWorkItem(pItem);
-		AsyncScriptExecute(info);
+		function->~ILuaFunctionWrap();
+		tf_free(function);
 	}
 }
 
-void LuaManagerImpl::AddAsyncScript(const char* scriptFile)
+bool LuaManagerImpl::IsAsyncScriptFinished(uint32_t scriptId)
 {
-	ScriptDoneCallback cb = nullptr;
-	AddAsyncScript(scriptFile, cb);
+	MutexLock lock(m_AsyncScriptsMutex);
+	ASSERT(scriptId != 0 && scriptId <= m_AsyncScriptsCounter);
+	return eastl::find(m_RunningScriptIds.begin(), m_RunningScriptIds.end(), scriptId) == m_RunningScriptIds.end();
+}
+
+uint32_t LuaManagerImpl::GetRunningAsyncScriptCount()
+{
+	MutexLock lock(m_AsyncScriptsMutex);
+	return (uint32_t)m_RunningScriptIds.size();
+}
+
+void LuaManagerImpl::WaitForAsyncScript(uint32_t scriptId)
+{
+	MutexLock lock(m_AsyncScriptsMutex);
+	while (eastl::find(m_RunningScriptIds.begin(), m_RunningScriptIds.end(), scriptId) != m_RunningScriptIds.end())
+		m_AsyncScriptsCond.Wait(m_AsyncScriptsMutex);
+}
+
+void LuaManagerImpl::WaitForAsyncScripts()
+{
+	MutexLock lock(m_AsyncScriptsMutex);
+	while (!m_RunningScriptIds.empty())
+		m_AsyncScriptsCond.Wait(m_AsyncScriptsMutex);
 }
 
 void LuaManagerImpl::SetFunction(ILuaFunctionWrap* wrap)
@@ -336,28 +499,45 @@ void LuaManagerImpl::SetFunction(ILuaFunctionWrap* wrap)
 	//1. Check if function is already registered
 	//Since this shouldn't be called often then just
 	//use string compare. We can implement more fast search if needed
-	for (size_t i = 0; i < m_Functions.size(); ++i)
+	//The workers index m_Functions while scripts run, so it only changes under m_FunctionsMutex
+	ILuaFunctionWrap* replacedFunction = nullptr;
+	int               functionIndex = 0;
 	{
-		if (m_Functions[i]->functionName == wrap->functionName)
+		MutexLock lock(m_FunctionsMutex);
+		for (size_t i = 0; i < m_Functions.size(); ++i)
 		{
-			m_Functions[i]->~ILuaFunctionWrap();
-			tf_free(m_Functions[i]);
-			m_Functions[i] = wrap;
-			return;
+			if (m_Functions[i]->functionName == wrap->functionName)
+			{
+				replacedFunction = m_Functions[i];
+				m_Functions[i] = wrap;
+				break;
+			}
+		}
+		//2.
+		if (replacedFunction == nullptr)
+		{
+			m_Functions.push_back(wrap);
+			functionIndex = (int)m_Functions.size() - 1;
 		}
 	}
-	//2.
-	m_Functions.push_back(wrap);
-	Luna<LuaManagerImpl>::RegisterMethod(m_SyncLuaState, wrap->functionName.c_str(), (int)m_Functions.size() - 1);
+
+	//A running async script may be inside the old one, it is freed once none is running
+	if (replacedFunction != nullptr)
+	{
+		{
+			MutexLock lock(m_AsyncScriptsMutex);
+			m_RetiredFunctions.push_back(replacedFunction);
+		}
+		ReleaseRetiredFunctions();
+		return;
+	}
+
+	Luna<LuaManagerImpl>::RegisterMethod(m_SyncLuaState, wrap->functionName.c_str(), functionIndex);
 	//m_UpdatableScriptLuaState is created in LuaManagerImpl::SetUpdatableScript() so it may not exist here.
 	//When LuaManagerImpl::SetUpdatableScript() is invoked all these functions will be registered in new state.
 	if (m_UpdatableScriptLuaState != nullptr)
-		Luna<LuaManagerImpl>::RegisterMethod(m_UpdatableScriptLuaState, wrap->functionName.c_str(), (int)m_Functions.size() - 1);
-	for (int i = 0; i < MAX_LUA_WORKERS; ++i)
-	{
-		MutexLock lock(m_AsyncLuaStatesMutex[i]);
-		Luna<LuaManagerImpl>::RegisterMethod(m_AsyncLuaStates[i], wrap->functionName.c_str(), (int)m_Functions.size() - 1);
-	}
+		Luna<LuaManagerImpl>::RegisterMethod(m_UpdatableScriptLuaState, wrap->functionName.c_str(), functionIndex);
+	//The async states get it when a worker next takes them, see ExecuteAsyncScript
 }
 
 //allocate and free function. Used in lua_newstate and in lua_close
@@ -428,12 +608,14 @@ int LuaManagerImpl::FunctionDispatch(int functionIndex, lua_State* state)
 {
 	LuaStateWrap stateWrap;
 	stateWrap.luaState = state;
-	ASSERT(m_Functions.size() > functionIndex);
-	if (m_Functions.size() > functionIndex)
+	ILuaFunctionWrap* function = nullptr;
 	{
-		return m_Functions[functionIndex]->ExecuteFunction(&stateWrap);
+		MutexLock lock(m_FunctionsMutex);
+		ASSERT(m_Functions.size() > functionIndex);
+		if (m_Functions.size() > functionIndex)
+			function = m_Functions[functionIndex];
 	}
-	return 0;
+	return function != nullptr ? function->ExecuteFunction(&stateWrap) : 0;
 }
 
 int LuaStateWrap::GetArgumentsCount() { return Luna<LuaManagerImpl>::GetArgCount(luaState); }
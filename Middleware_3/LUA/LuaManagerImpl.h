@@ -16,7 +16,9 @@ extern "C"
 
 #include "../../Common_3/OS/Interfaces/IFileSystem.h"
 #include "../../Common_3/OS/Interfaces/IThread.h"
+#include "../../Common_3/OS/Core/ThreadSystem.h"
 
+//Async scripts run on a ThreadSystem of this many workers, each running script has one of the async lua states to itself
 #define MAX_LUA_WORKERS 4
 
 struct LuaStateWrap: public ILuaStateWrap
@@ -34,13 +36,17 @@ struct LuaStateWrap: public ILuaStateWrap
 	lua_State* luaState;
 };
 
+class LuaManagerImpl;
+
 struct ScriptTaskInfo
 {
-	lua_State*           luaState;
-	Mutex*               mutex;
-    const char*          scriptFile;
+	LuaManagerImpl*      manager;
+	uint32_t             scriptId;
+	//Copied, the caller's string does not have to outlive the script
+	eastl::string        scriptFile;
 	ScriptDoneCallback   callback;
 	IScriptCallbackWrap* callbackLambda;
+	ScriptState          resultState;
 };
 
 class LuaManagerImpl
@@ -48,11 +54,25 @@ class LuaManagerImpl
 	public:
 	LuaManagerImpl();
 	~LuaManagerImpl();
+	//Compiled scripts are cached as bytecode in cacheDir, RD_COUNT disables the cache.
+	//Set it before any script runs, the workers read it without a lock.
+	void SetScriptCacheDirectory(ResourceDirectory cacheDir);
 	bool RunScript(const char* scriptFile);
-	void AddAsyncScript(const char* scriptFile, ScriptDoneCallback callback);
-	void AddAsyncScript(const char* scriptFile);
-	void AddAsyncScript(const char* scriptFile, IScriptCallbackWrap* callbackLambda);
-
+	uint32_t AddAsyncScript(const char* scriptFile, ScriptDoneCallback callback);
+	uint32_t AddAsyncScript(const char* scriptFile);
+	uint32_t AddAsyncScript(const char* scriptFile, IScriptCallbackWrap* callbackLambda);
+
+	//Runs the callbacks of the async scripts which finished since the last call, on the calling thread.
+	//Returns how many were run.
+	uint32_t DispatchAsyncScriptCallbacks();
+	bool     IsAsyncScriptFinished(uint32_t scriptId);
+	uint32_t GetRunningAsyncScriptCount();
+	//Block until the script(s) finished, their callbacks still wait for DispatchAsyncScriptCallbacks
+	void     WaitForAsyncScript(uint32_t scriptId);
+	void     WaitForAsyncScripts();
+
+	//Call it from the thread running RunScript() and Update(). Async scripts started later can call a new function,
+	//a replaced function is freed once no async script is running.
 	void SetFunction(ILuaFunctionWrap* wrap);
 
 	//updateFunctionName - function that will be called on Update()
@@ -69,9 +89,22 @@ class LuaManagerImpl
 	lua_State*  m_UpdatableScriptLuaState;
 	lua_State*  m_SyncLuaState;
 	lua_State*  m_AsyncLuaStates[MAX_LUA_WORKERS];
-	Mutex       m_AsyncLuaStatesMutex[MAX_LUA_WORKERS];
-	Mutex       m_AddAsyncScriptMutex;
-
+	//Functions of m_Functions registered in each async state, the worker taking a state registers the rest
+	uint32_t    m_AsyncLuaStateFunctionCount[MAX_LUA_WORKERS];
+
+	ThreadSystem* m_pAsyncThreadSystem;
+	ResourceDirectory m_ScriptCacheDir;
+	//Guards everything below, m_AsyncScriptsCond is signaled when a script finishes or a lua state is released
+	Mutex             m_AsyncScriptsMutex;
+	ConditionVariable m_AsyncScriptsCond;
+	uint32_t          m_FreeAsyncLuaStates;    //bit i set when m_AsyncLuaStates[i] is not running a script
+	eastl::vector<uint32_t>        m_RunningScriptIds;
+	eastl::vector<ScriptTaskInfo*> m_FinishedScripts;
+	//Replaced by SetFunction while a running script could still be calling them
+	eastl::vector<ILuaFunctionWrap*> m_RetiredFunctions;
+
+	//Guards m_Functions, the workers look functions up while SetFunction adds or replaces them
+	Mutex                            m_FunctionsMutex;
 	eastl::vector<ILuaFunctionWrap*> m_Functions;
 	eastl::string                    m_UpdateFunctonName;
 	const char*                      m_UpdatableScriptFile;
@@ -87,6 +120,12 @@ class LuaManagerImpl
 	void       RegisterFunctionsForState(lua_State* state);
 	void       ExitScript(lua_State* state, const char* exitFunctionName);
 
+	uint32_t    AddAsyncScriptTask(ScriptTaskInfo* info);
+	static void AsyncScriptTask(void* pData, uintptr_t);
+	void        ExecuteAsyncScript(ScriptTaskInfo* info);
+	void        DeliverAsyncScriptCallback(ScriptTaskInfo* info);
+	void        ReleaseRetiredFunctions();
+
 	LuaManagerImpl(lua_State* L);
 	static const char                         className[];
 	static Luna<LuaManagerImpl>::FunctionType methods[];
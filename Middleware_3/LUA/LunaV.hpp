@@ -220,6 +220,7 @@ class Luna
 		lua_pushstring(L, methodName);                // Register some functions in it
 		lua_pushnumber(L, methodIndex | (1 << 9));    // Add a number indexing which func it is
 		lua_settable(L, metatable);                   //
+		lua_pop(L, 1);                                // Metatable, states register many functions in a row
 	}
 
 	/*
@@ -48,9 +48,9 @@
 #include "../../Common_3/OS/Interfaces/ILog.h"
 #include "../../Common_3/OS/Interfaces/IMemory.h"
 
-ParallelPrimitives::PipelineComponents::PipelineComponents() : mNextSetIndex(0), pDescriptorSet(NULL), pShader(NULL), pPipeline(NULL), pRootSignature(NULL) {}
+ParallelPrimitives::PipelineComponents::PipelineComponents() : mUsedSetCount(0), pDescriptorSet(NULL), pShader(NULL), pPipeline(NULL), pRootSignature(NULL) {}
 
-void ParallelPrimitives::PipelineComponents::init(Renderer* renderer, const char* functionName) {
+void ParallelPrimitives::PipelineComponents::init(Renderer* renderer, const char* functionName, uint32_t frameCount) {
 	pRenderer = renderer;
 	
 	ShaderLoadDesc shaderLoadDesc = {};
@@ -71,7 +71,7 @@ void ParallelPrimitives::PipelineComponents::init(Renderer* renderer, const char
 	addPipeline(pRenderer, &pipelineDesc, &pPipeline);
 	
 	DescriptorSetDesc descSetDesc = {};
-	descSetDesc.mMaxSets = ParallelPrimitives::setsPerPipeline;
+	descSetDesc.mMaxSets = ParallelPrimitives::setsPerFrame * frameCount;
 	descSetDesc.mUpdateFrequency = DESCRIPTOR_UPDATE_FREQ_PER_DRAW;
 	descSetDesc.pRootSignature = pRootSignature;
 	addDescriptorSet(pRenderer, &descSetDesc, &pDescriptorSet);
@@ -92,13 +92,17 @@ ParallelPrimitives::PipelineComponents::~PipelineComponents() {
 	}
 }
 
-ParallelPrimitives::ParallelPrimitives(Renderer* renderer) : pRenderer(renderer) {
+ParallelPrimitives::ParallelPrimitives(Renderer* renderer, uint32_t frameCount) : pRenderer(renderer), mFrameCount(frameCount), mFrameIndex(0) {
+	ASSERT(frameCount > 0);
+	
 	const char *functionNames[] = { "scan_exclusive_int4", "scan_exclusive_part_int4", "distribute_part_sum_int4", "BitHistogram", "ScatterKeys", "ScatterKeysAndValues", "ClearOffsetBuffer", "GenerateOffsetBuffer", "GenerateIndirectArgumentsFromOffsetBuffer"  };
 	PipelineComponents* components[] = { &mScanExclusiveInt4, &mScanExclusivePartInt4, &mDistributePartSumInt4, &mBitHistogram, &mScatterKeys, &mScatterKeysAndValues, &mClearOffsetBuffer, &mGenerateOffsetBuffer, &mIndirectArgsFromOffsetBuffer };
 	
 	for (size_t i = 0; i < sizeof(components) / sizeof(components[0]); i += 1) {
-		components[i]->init(pRenderer, functionNames[i]);
+		components[i]->init(pRenderer, functionNames[i], mFrameCount);
 	}
+	
+	mScratchArenas.resize(mFrameCount);
 
 	IndirectArgumentDescriptor argDescriptor = { };
 	argDescriptor.mType = INDIRECT_DISPATCH;
@@ -111,60 +115,93 @@ ParallelPrimitives::ParallelPrimitives(Renderer* renderer) : pRenderer(renderer)
 }
 
 ParallelPrimitives::~ParallelPrimitives() {
-	for (Buffer* buffer : mTemporaryBuffers) {
-		removeResource(buffer);
+	for (uint32_t i = 0; i < mFrameCount; ++i) {
+		for (Buffer* buffer : mScratchArenas[i].mChunks) {
+			removeResource(buffer);
+		}
 	}
-	mTemporaryBuffers.set_capacity(0);
+	mScratchArenas.set_capacity(0);
 	removeIndirectCommandSignature(pRenderer, pCommandSignature);
 }
 
-Buffer* ParallelPrimitives::temporaryBuffer(size_t length) {
-	eastl::vector<Buffer*>::const_iterator bestBufferIt = mTemporaryBuffers.end();
-	Buffer* buffer = NULL;
-	for (eastl::vector<Buffer*>::const_iterator it = mTemporaryBuffers.begin(); it < mTemporaryBuffers.end(); ++it) {
-		Buffer* candidateBuffer = *it;
-		uint64_t candidateLength = candidateBuffer->mSize;
-		if (candidateLength >= length && (buffer == NULL || buffer->mSize > candidateLength)) {
-			buffer = candidateBuffer;
-			bestBufferIt = it;
-		}
-	}
+void ParallelPrimitives::beginFrame(uint32_t frameIndex) {
+	ASSERT(frameIndex < mFrameCount);
+	mFrameIndex = frameIndex;
 	
-	if (!buffer) {
-		BufferLoadDesc bufferLoadDesc = {};
-		bufferLoadDesc.ppBuffer = &buffer;
-		
-		bufferLoadDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
-		bufferLoadDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
-		bufferLoadDesc.mDesc.mSize = length;
-		bufferLoadDesc.mDesc.mStartState = RESOURCE_STATE_UNORDERED_ACCESS;
-		bufferLoadDesc.mDesc.mElementCount = length / sizeof(int32_t);
-		addResource(&bufferLoadDesc, NULL);
-	} else {
-		mTemporaryBuffers.erase_unsorted(bestBufferIt);
+	PipelineComponents* components[] = { &mScanExclusiveInt4, &mScanExclusivePartInt4, &mDistributePartSumInt4, &mBitHistogram, &mScatterKeys, &mScatterKeysAndValues, &mClearOffsetBuffer, &mGenerateOffsetBuffer, &mIndirectArgsFromOffsetBuffer };
+	for (size_t i = 0; i < sizeof(components) / sizeof(components[0]); i += 1) {
+		components[i]->mUsedSetCount = 0;
 	}
 	
+	// The frame spilled into more chunks last time, replace them with one big enough for all of it
+	ScratchArena& arena = mScratchArenas[frameIndex];
+	if (arena.mChunks.size() > 1) {
+		uint64_t totalSize = 0;
+		for (Buffer* buffer : arena.mChunks) {
+			totalSize += buffer->mSize;
+			removeResource(buffer);
+		}
+		arena.mChunks.clear();
+		arena.mChunks.push_back(addScratchChunk(totalSize));
+	}
+	arena.mChunkIndex = 0;
+	arena.mChunkOffset = 0;
+}
+
+void ParallelPrimitives::setBufferParam(DescriptorData* pParam, const char* name, BufferRange* pRange) {
+	pParam->pName = name;
+	pParam->ppBuffers = &pRange->pBuffer;
+	pParam->pOffsets = &pRange->mOffset;
+	pParam->pSizes = &pRange->mSize;
+}
+
+Buffer* ParallelPrimitives::addScratchChunk(uint64_t size) {
+	Buffer* buffer = NULL;
+	BufferLoadDesc bufferLoadDesc = {};
+	bufferLoadDesc.ppBuffer = &buffer;
+	
+	bufferLoadDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
+	bufferLoadDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+	bufferLoadDesc.mDesc.mSize = size;
+	bufferLoadDesc.mDesc.mStartState = RESOURCE_STATE_UNORDERED_ACCESS;
+	bufferLoadDesc.mDesc.mElementCount = size / sizeof(int32_t);
+	bufferLoadDesc.mDesc.pName = "ParallelPrimitives Scratch";
+	addResource(&bufferLoadDesc, NULL);
 	return buffer;
 }
 
-void ParallelPrimitives::depositTemporaryBuffer(Buffer* buffer) {
-	ASSERT(buffer);
-	mTemporaryBuffers.push_back(buffer);
+ParallelPrimitives::BufferRange ParallelPrimitives::temporaryBuffer(uint64_t length) {
+	ScratchArena& arena = mScratchArenas[mFrameIndex];
+	uint64_t offset = (arena.mChunkOffset + ParallelPrimitives::scratchAlignment - 1) & ~(ParallelPrimitives::scratchAlignment - 1);
+	
+	// Move on to the next chunk of the frame, adding one if this frame needs more than ever before
+	while (arena.mChunkIndex < arena.mChunks.size() && offset + length > arena.mChunks[arena.mChunkIndex]->mSize) {
+		++arena.mChunkIndex;
+		offset = 0;
+	}
+	if (arena.mChunkIndex == arena.mChunks.size()) {
+		arena.mChunks.push_back(addScratchChunk(max(length, ParallelPrimitives::minScratchChunkSize)));
+	}
+	
+	BufferRange range;
+	range.pBuffer = arena.mChunks[arena.mChunkIndex];
+	range.mOffset = offset;
+	range.mSize = length;
+	arena.mChunkOffset = offset + length;
+	return range;
 }
 
-void ParallelPrimitives::scanExclusiveAddWG(Cmd* pCmd, Buffer* input, Buffer* output, uint32_t elementCount) {
+void ParallelPrimitives::scanExclusiveAddWG(Cmd* pCmd, BufferRange input, BufferRange output, uint32_t elementCount) {
 	
 	cmdBindPipeline(pCmd, mScanExclusiveInt4.pPipeline);
 	cmdBindPushConstants(pCmd, mScanExclusiveInt4.pRootSignature, "elementCountRootConstant", &elementCount);
 	
 	DescriptorData params[2] = {};
 	
-	params[0].ppBuffers = &input;
-	params[0].pName = "inputArray";
-	params[1].ppBuffers = &output;
-	params[1].pName = "outputArray";
+	setBufferParam(&params[0], "inputArray", &input);
+	setBufferParam(&params[1], "outputArray", &output);
 	
-	uint32_t setIndex = incrementSetIndex(&mScanExclusiveInt4.mNextSetIndex);
+	uint32_t setIndex = nextSetIndex(&mScanExclusiveInt4);
 	updateDescriptorSet(pCmd->pRenderer, setIndex, mScanExclusiveInt4.pDescriptorSet, 2, params);
 	cmdBindDescriptorSet(pCmd, setIndex, mScanExclusiveInt4.pDescriptorSet);
 	
@@ -172,12 +209,12 @@ void ParallelPrimitives::scanExclusiveAddWG(Cmd* pCmd, Buffer* input, Buffer* ou
 	
 
 	BufferBarrier barriers[] = {
-		{ output, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+		{ output.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
 	};
 	cmdResourceBarrier(pCmd, sizeof(barriers) / sizeof(barriers[0]), barriers, 0, NULL, 0, NULL);
 }
 
-void ParallelPrimitives::scanExclusiveAddTwoLevel(Cmd* pCmd, Buffer* input, Buffer* output, uint32_t elementCount) {
+void ParallelPrimitives::scanExclusiveAddTwoLevel(Cmd* pCmd, BufferRange input, BufferRange output, uint32_t elementCount) {
 	uint32_t groupBlockSizeScan = ParallelPrimitives::workgroupSize << 3;
 	uint32_t groupBlockSizeDistribute = ParallelPrimitives::workgroupSize << 2;
 	
@@ -186,7 +223,7 @@ void ParallelPrimitives::scanExclusiveAddTwoLevel(Cmd* pCmd, Buffer* input, Buff
 	
 	uint32_t bottomLevelDistributeGroupCount = (elementCount + groupBlockSizeDistribute - 1) / groupBlockSizeDistribute;
 	
-	Buffer* devicePartSums = this->temporaryBuffer(sizeof(int32_t) * max(bottomLevelScanGroupCount, (uint32_t)4));
+	BufferRange devicePartSums = this->temporaryBuffer(sizeof(int32_t) * max(bottomLevelScanGroupCount, (uint32_t)4));
 	
 	PipelineComponents& bottomLevelScan = mScanExclusivePartInt4;
 	PipelineComponents& topLevelScan = mScanExclusiveInt4;
@@ -197,24 +234,21 @@ void ParallelPrimitives::scanExclusiveAddTwoLevel(Cmd* pCmd, Buffer* input, Buff
 	{
 		cmdBindPipeline(pCmd, bottomLevelScan.pPipeline);
 		
-		params[0].ppBuffers = &input;
-		params[0].pName = "inputArray";
-		params[1].ppBuffers = &output;
-		params[1].pName = "outputArray";
-		params[2].ppBuffers = &devicePartSums;
-		params[2].pName = "outputSums";
+		setBufferParam(&params[0], "inputArray", &input);
+		setBufferParam(&params[1], "outputArray", &output);
+		setBufferParam(&params[2], "outputSums", &devicePartSums);
 		
 		cmdBindPushConstants(pCmd, bottomLevelScan.pRootSignature, "elementCountRootConstant", &elementCount);
 		
-		uint32_t setIndex = incrementSetIndex(&bottomLevelScan.mNextSetIndex);
+		uint32_t setIndex = nextSetIndex(&bottomLevelScan);
 		updateDescriptorSet(pCmd->pRenderer, setIndex, bottomLevelScan.pDescriptorSet, 3, params);
 		cmdBindDescriptorSet(pCmd, setIndex, bottomLevelScan.pDescriptorSet);
 		
 		cmdDispatch(pCmd, (uint32_t)bottomLevelScanGroupCount, 1, 1);
 
 		BufferBarrier barriers[] = {
-			{ output, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
-			{ devicePartSums, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false }
+			{ output.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+			{ devicePartSums.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false }
 		};
 		cmdResourceBarrier(pCmd, sizeof(barriers) / sizeof(barriers[0]), barriers, 0, NULL, 0, NULL);
 	}
@@ -222,20 +256,18 @@ void ParallelPrimitives::scanExclusiveAddTwoLevel(Cmd* pCmd, Buffer* input, Buff
 	{
 		cmdBindPipeline(pCmd, topLevelScan.pPipeline);
 		
-		params[0].ppBuffers = &devicePartSums;
-		params[0].pName = "inputArray";
-		params[1].ppBuffers = &devicePartSums;
-		params[1].pName = "outputArray";
+		setBufferParam(&params[0], "inputArray", &devicePartSums);
+		setBufferParam(&params[1], "outputArray", &devicePartSums);
 		
 		cmdBindPushConstants(pCmd, topLevelScan.pRootSignature, "elementCountRootConstant", &bottomLevelScanGroupCount);
 		
-		uint32_t setIndex = incrementSetIndex(&topLevelScan.mNextSetIndex);
+		uint32_t setIndex = nextSetIndex(&topLevelScan);
 		updateDescriptorSet(pCmd->pRenderer, setIndex, topLevelScan.pDescriptorSet, 2, params);
 		cmdBindDescriptorSet(pCmd, setIndex, topLevelScan.pDescriptorSet);
 		cmdDispatch(pCmd, topLevelScanGroupCount, 1, 1);
 		
 		BufferBarrier barriers[] = {
-			{ devicePartSums, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false }
+			{ devicePartSums.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false }
 		};
 		cmdResourceBarrier(pCmd, sizeof(barriers) / sizeof(barriers[0]), barriers, 0, NULL, 0, NULL);
 	}
@@ -243,30 +275,26 @@ void ParallelPrimitives::scanExclusiveAddTwoLevel(Cmd* pCmd, Buffer* input, Buff
 	{
 		cmdBindPipeline(pCmd, distributeSums.pPipeline);
 		
-		params[0].ppBuffers = &devicePartSums;
-		params[0].pName = "inputSums";
-		params[1].ppBuffers = &output;
-		params[1].pName = "inoutArray";
+		setBufferParam(&params[0], "inputSums", &devicePartSums);
+		setBufferParam(&params[1], "inoutArray", &output);
 		
 		cmdBindPushConstants(pCmd, distributeSums.pRootSignature, "elementCountRootConstant", &elementCount);
 		
-		uint32_t setIndex = incrementSetIndex(&distributeSums.mNextSetIndex);
+		uint32_t setIndex = nextSetIndex(&distributeSums);
 		updateDescriptorSet(pCmd->pRenderer, setIndex, distributeSums.pDescriptorSet, 2, params);
 		cmdBindDescriptorSet(pCmd, setIndex, distributeSums.pDescriptorSet);
 		
 		cmdDispatch(pCmd, bottomLevelDistributeGroupCount, 1, 1);
 		
 		BufferBarrier barriers[] = {
-			{ output, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false }
+			{ output.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false }
 		};
 		cmdResourceBarrier(pCmd, sizeof(barriers) / sizeof(barriers[0]), barriers, 0, NULL, 0, NULL);
 	}
-	
-	depositTemporaryBuffer(devicePartSums);
 }
 
 
-void ParallelPrimitives::scanExclusiveAddThreeLevel(Cmd* pCmd, Buffer* input, Buffer* output, uint32_t elementCount) {
+void ParallelPrimitives::scanExclusiveAddThreeLevel(Cmd* pCmd, BufferRange input, BufferRange output, uint32_t elementCount) {
 	uint32_t groupBlockSizeScan = (ParallelPrimitives::workgroupSize << 3);
 	uint32_t groupBlockSizeDistribute = (ParallelPrimitives::workgroupSize << 2);
 	
@@ -277,8 +305,8 @@ void ParallelPrimitives::scanExclusiveAddThreeLevel(Cmd* pCmd, Buffer* input, Bu
 	uint32_t bottomLevelDistributeGroupCount = (elementCount + groupBlockSizeDistribute - 1) / groupBlockSizeDistribute;
 	uint32_t midLevelDistributeGroupCount = (bottomLevelDistributeGroupCount + groupBlockSizeDistribute - 1) / groupBlockSizeDistribute;
 	
-	Buffer* devicePartSumsBottomLevel = this->temporaryBuffer(sizeof(int32_t) * max(bottomLevelScanGroupCount, 4u));
-	Buffer* devicePartSumsMidLevel = this->temporaryBuffer(sizeof(int32_t) * max(midLevelScanGroupCount, 4u));
+	BufferRange devicePartSumsBottomLevel = this->temporaryBuffer(sizeof(int32_t) * max(bottomLevelScanGroupCount, 4u));
+	BufferRange devicePartSumsMidLevel = this->temporaryBuffer(sizeof(int32_t) * max(midLevelScanGroupCount, 4u));
 	
 	PipelineComponents& bottomLevelScan = mScanExclusivePartInt4;
 	PipelineComponents& topLevelScan = mScanExclusiveInt4;
@@ -289,24 +317,21 @@ void ParallelPrimitives::scanExclusiveAddThreeLevel(Cmd* pCmd, Buffer* input, Bu
 	{
 		cmdBindPipeline(pCmd, bottomLevelScan.pPipeline);
 		
-		params[0].ppBuffers = &input;
-		params[0].pName = "inputArray";
-		params[1].ppBuffers = &output;
-		params[1].pName = "outputArray";
-		params[2].ppBuffers = &devicePartSumsBottomLevel;
-		params[2].pName = "outputSums";
+		setBufferParam(&params[0], "inputArray", &input);
+		setBufferParam(&params[1], "outputArray", &output);
+		setBufferParam(&params[2], "outputSums", &devicePartSumsBottomLevel);
 		
 		cmdBindPushConstants(pCmd, bottomLevelScan.pRootSignature, "elementCountRootConstant", &elementCount);
 		
-		uint32_t setIndex = incrementSetIndex(&bottomLevelScan.mNextSetIndex);
+		uint32_t setIndex = nextSetIndex(&bottomLevelScan);
 		updateDescriptorSet(pCmd->pRenderer, setIndex, bottomLevelScan.pDescriptorSet, 3, params);
 		cmdBindDescriptorSet(pCmd, setIndex, bottomLevelScan.pDescriptorSet);
 		
 		cmdDispatch(pCmd, bottomLevelScanGroupCount, 1, 1);
 		
 		BufferBarrier barriers[] = {
-			{ output, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
-			{ devicePartSumsBottomLevel, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+			{ output.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+			{ devicePartSumsBottomLevel.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
 		};
 		cmdResourceBarrier(pCmd, sizeof(barriers) / sizeof(barriers[0]), barriers, 0, NULL, 0, NULL);
 	}
@@ -314,24 +339,21 @@ void ParallelPrimitives::scanExclusiveAddThreeLevel(Cmd* pCmd, Buffer* input, Bu
 	{
 		cmdBindPipeline(pCmd, bottomLevelScan.pPipeline);
 		
-		params[0].ppBuffers = &devicePartSumsBottomLevel;
-		params[0].pName = "inputArray";
-		params[1].ppBuffers = &devicePartSumsBottomLevel;
-		params[1].pName = "outputArray";
-		params[2].ppBuffers = &devicePartSumsMidLevel;
-		params[2].pName = "outputSums";
+		setBufferParam(&params[0], "inputArray", &devicePartSumsBottomLevel);
+		setBufferParam(&params[1], "outputArray", &devicePartSumsBottomLevel);
+		setBufferParam(&params[2], "outputSums", &devicePartSumsMidLevel);
 		
 		cmdBindPushConstants(pCmd, bottomLevelScan.pRootSignature, "elementCountRootConstant", &bottomLevelScanGroupCount);
 		
-		uint32_t setIndex = incrementSetIndex(&bottomLevelScan.mNextSetIndex);
+		uint32_t setIndex = nextSetIndex(&bottomLevelScan);
 		updateDescriptorSet(pCmd->pRenderer, setIndex, bottomLevelScan.pDescriptorSet, 3, params);
 		cmdBindDescriptorSet(pCmd, setIndex, bottomLevelScan.pDescriptorSet);
 		
 		cmdDispatch(pCmd, midLevelScanGroupCount, 1, 1);
 		
 		BufferBarrier barriers[] = {
-			{ devicePartSumsBottomLevel, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
-			{ devicePartSumsMidLevel, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+			{ devicePartSumsBottomLevel.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+			{ devicePartSumsMidLevel.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
 		};
 		cmdResourceBarrier(pCmd, sizeof(barriers) / sizeof(barriers[0]), barriers, 0, NULL, 0, NULL);
 	}
@@ -339,21 +361,19 @@ void ParallelPrimitives::scanExclusiveAddThreeLevel(Cmd* pCmd, Buffer* input, Bu
 	{
 		cmdBindPipeline(pCmd, topLevelScan.pPipeline);
 		
-		params[0].ppBuffers = &devicePartSumsMidLevel;
-		params[0].pName = "inputArray";
-		params[1].ppBuffers = &devicePartSumsMidLevel;
-		params[1].pName = "outputArray";
+		setBufferParam(&params[0], "inputArray", &devicePartSumsMidLevel);
+		setBufferParam(&params[1], "outputArray", &devicePartSumsMidLevel);
 		
 		cmdBindPushConstants(pCmd, topLevelScan.pRootSignature, "elementCountRootConstant", &midLevelScanGroupCount);
 		
-		uint32_t setIndex = incrementSetIndex(&topLevelScan.mNextSetIndex);
+		uint32_t setIndex = nextSetIndex(&topLevelScan);
 		updateDescriptorSet(pCmd->pRenderer, setIndex, topLevelScan.pDescriptorSet, 2, params);
 		cmdBindDescriptorSet(pCmd, setIndex, topLevelScan.pDescriptorSet);
 		
 		cmdDispatch(pCmd, topLevelScanGroupCount, 1, 1);
 		
 		BufferBarrier barriers[] = {
-			{ devicePartSumsMidLevel, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+			{ devicePartSumsMidLevel.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
 		};
 		cmdResourceBarrier(pCmd, sizeof(barriers) / sizeof(barriers[0]), barriers, 0, NULL, 0, NULL);
 	}
@@ -361,21 +381,19 @@ void ParallelPrimitives::scanExclusiveAddThreeLevel(Cmd* pCmd, Buffer* input, Bu
 	{
 		cmdBindPipeline(pCmd, distributeSums.pPipeline);
 		
-		params[0].ppBuffers = &devicePartSumsMidLevel;
-		params[0].pName = "inputArray";
-		params[1].ppBuffers = &devicePartSumsBottomLevel;
-		params[1].pName = "outputArray";
+		setBufferParam(&params[0], "inputArray", &devicePartSumsMidLevel);
+		setBufferParam(&params[1], "outputArray", &devicePartSumsBottomLevel);
 		
 		cmdBindPushConstants(pCmd, distributeSums.pRootSignature, "elementCountRootConstant", &bottomLevelScanGroupCount);
 		
-		uint32_t setIndex = incrementSetIndex(&distributeSums.mNextSetIndex);
+		uint32_t setIndex = nextSetIndex(&distributeSums);
 		updateDescriptorSet(pCmd->pRenderer, setIndex, distributeSums.pDescriptorSet, 2, params);
 		cmdBindDescriptorSet(pCmd, setIndex, distributeSums.pDescriptorSet);
 		
 		cmdDispatch(pCmd, midLevelDistributeGroupCount, 1, 1);
 		
 		BufferBarrier barriers[] = {
-			{ devicePartSumsBottomLevel, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+			{ devicePartSumsBottomLevel.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
 		};
 		cmdResourceBarrier(pCmd, sizeof(barriers) / sizeof(barriers[0]), barriers, 0, NULL, 0, NULL);
 	}
@@ -383,30 +401,29 @@ void ParallelPrimitives::scanExclusiveAddThreeLevel(Cmd* pCmd, Buffer* input, Bu
 	{
 		cmdBindPipeline(pCmd, distributeSums.pPipeline);
 		
-		params[0].ppBuffers = &devicePartSumsBottomLevel;
-		params[0].pName = "inputSums";
-		params[1].ppBuffers = &output;
-		params[1].pName = "inoutArray";
+		setBufferParam(&params[0], "inputSums", &devicePartSumsBottomLevel);
+		setBufferParam(&params[1], "inoutArray", &output);
 		
 		cmdBindPushConstants(pCmd, distributeSums.pRootSignature, "elementCountRootConstant", &elementCount);
 		
-		uint32_t setIndex = incrementSetIndex(&distributeSums.mNextSetIndex);
+		uint32_t setIndex = nextSetIndex(&distributeSums);
 		updateDescriptorSet(pCmd->pRenderer, setIndex, distributeSums.pDescriptorSet, 2, params);
 		cmdBindDescriptorSet(pCmd, setIndex, distributeSums.pDescriptorSet);
 		
 		cmdDispatch(pCmd, bottomLevelDistributeGroupCount, 1, 1);
 		
 		BufferBarrier barriers[] = {
-			{ output, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+			{ output.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
 		};
 		cmdResourceBarrier(pCmd, sizeof(barriers) / sizeof(barriers[0]), barriers, 0, NULL, 0, NULL);
 	}
-	
-	depositTemporaryBuffer(devicePartSumsBottomLevel);
-	depositTemporaryBuffer(devicePartSumsMidLevel);
 }
 
 void ParallelPrimitives::scanExclusiveAdd(Cmd* pCmd, Buffer* input, Buffer* output, uint32_t elementCount) {
+	scanExclusiveAdd(pCmd, BufferRange(input), BufferRange(output), elementCount);
+}
+
+void ParallelPrimitives::scanExclusiveAdd(Cmd* pCmd, BufferRange input, BufferRange output, uint32_t elementCount) {
 	if (elementCount < ParallelPrimitives::scanElementsPerWorkgroup) {
 		return scanExclusiveAddWG(pCmd, input, output, elementCount);
 	} else if (elementCount <= ParallelPrimitives::scanElementsPerWorkgroup * ParallelPrimitives::scanElementsPerWorkgroup) {
@@ -426,14 +443,15 @@ void ParallelPrimitives::sortRadixKeysValues(Cmd* pCmd, Buffer* inputKeys, Buffe
 	uint32_t groupBlockSize = (ParallelPrimitives::workgroupSize * 4 * 8);
 	uint32_t blockCount = (elementCount.mUpperLimit + groupBlockSize - 1) / groupBlockSize;
 	
-	Buffer* deviceHistograms = this->temporaryBuffer(sizeof(int32_t) * blockCount * 16);
-	Buffer* deviceTempKeysBuffer = this->temporaryBuffer(sizeof(int32_t) * elementCount.mUpperLimit);
-	Buffer* deviceTempValsBuffer = this->temporaryBuffer(sizeof(int32_t) * elementCount.mUpperLimit);
+	BufferRange deviceHistograms = this->temporaryBuffer(sizeof(int32_t) * blockCount * 16);
+	BufferRange deviceTempKeysBuffer = this->temporaryBuffer(sizeof(int32_t) * elementCount.mUpperLimit);
+	BufferRange deviceTempValsBuffer = this->temporaryBuffer(sizeof(int32_t) * elementCount.mUpperLimit);
 	
-	Buffer* fromKeys = inputKeys;
-	Buffer* fromVals = inputValues;
-	Buffer* toKeys = deviceTempKeysBuffer;
-	Buffer* toVals = deviceTempValsBuffer;
+	BufferRange countRange(elementCount.pBuffer);
+	BufferRange fromKeys = inputKeys;
+	BufferRange fromVals = inputValues;
+	BufferRange toKeys = deviceTempKeysBuffer;
+	BufferRange toVals = deviceTempValsBuffer;
 	
 	PipelineComponents& histogramKernel = mBitHistogram;
 	PipelineComponents& scatterKeysAndVals = mScatterKeysAndValues;
@@ -456,21 +474,18 @@ void ParallelPrimitives::sortRadixKeysValues(Cmd* pCmd, Buffer* inputKeys, Buffe
 			
 			cmdBindPushConstants(pCmd, histogramKernel.pRootSignature, "rootConstants", &offset);
 			
-			params[0].ppBuffers = &fromKeys;
-			params[0].pName = "inputArray";
-			params[1].ppBuffers = &deviceHistograms;
-			params[1].pName = "outHistogram";
-			params[2].ppBuffers = &elementCount.pBuffer;
-			params[2].pName = "elementCount";
+			setBufferParam(&params[0], "inputArray", &fromKeys);
+			setBufferParam(&params[1], "outHistogram", &deviceHistograms);
+			setBufferParam(&params[2], "elementCount", &countRange);
 
-			uint32_t setIndex = incrementSetIndex(&histogramKernel.mNextSetIndex);
+			uint32_t setIndex = nextSetIndex(&histogramKernel);
 			updateDescriptorSet(pCmd->pRenderer, setIndex, histogramKernel.pDescriptorSet, 3, params);
 			cmdBindDescriptorSet(pCmd, setIndex, histogramKernel.pDescriptorSet);
 			
 			cmdDispatch(pCmd, blockCount, 1, 1);
 
 			BufferBarrier barriers[] = {
-				{ deviceHistograms, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+				{ deviceHistograms.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
 			};
 			cmdResourceBarrier(pCmd, sizeof(barriers) / sizeof(barriers[0]), barriers, 0, NULL, 0, NULL);
 		}
@@ -484,28 +499,22 @@ void ParallelPrimitives::sortRadixKeysValues(Cmd* pCmd, Buffer* inputKeys, Buffe
 			
 			cmdBindPushConstants(pCmd, scatterKeysAndVals.pRootSignature, "rootConstants", &offset);
 			
-			params[0].ppBuffers = &fromKeys;
-			params[0].pName = "inputKeys";
-			params[1].ppBuffers = &fromVals;
-			params[1].pName = "inputValues";
-			params[2].ppBuffers = &elementCount.pBuffer;
-			params[2].pName = "elementCount";
-			params[3].ppBuffers = &deviceHistograms;
-			params[3].pName = "inputHistograms";
-			params[4].ppBuffers = &toKeys;
-			params[4].pName = "outputKeys";
-			params[5].ppBuffers = &toVals;
-			params[5].pName = "outputValues";
+			setBufferParam(&params[0], "inputKeys", &fromKeys);
+			setBufferParam(&params[1], "inputValues", &fromVals);
+			setBufferParam(&params[2], "elementCount", &countRange);
+			setBufferParam(&params[3], "inputHistograms", &deviceHistograms);
+			setBufferParam(&params[4], "outputKeys", &toKeys);
+			setBufferParam(&params[5], "outputValues", &toVals);
 			
-			uint32_t setIndex = incrementSetIndex(&scatterKeysAndVals.mNextSetIndex);
+			uint32_t setIndex = nextSetIndex(&scatterKeysAndVals);
 			updateDescriptorSet(pCmd->pRenderer, setIndex, scatterKeysAndVals.pDescriptorSet, 6, params);
 			cmdBindDescriptorSet(pCmd, setIndex, scatterKeysAndVals.pDescriptorSet);
 			
 			cmdDispatch(pCmd, blockCount, 1, 1);
 			
 			BufferBarrier barriers[] = {
-				{ toKeys, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
-				{ toVals, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+				{ toKeys.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+				{ toVals.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
 			};
 			cmdResourceBarrier(pCmd, sizeof(barriers) / sizeof(barriers[0]), barriers, 0, NULL, 0, NULL);
 		}
@@ -521,21 +530,17 @@ void ParallelPrimitives::sortRadixKeysValues(Cmd* pCmd, Buffer* inputKeys, Buffe
 		}
 		
 		// Swap pointers
-		Buffer* tmpKeys = fromKeys;
+		BufferRange tmpKeys = fromKeys;
 		fromKeys = toKeys;
 		toKeys = tmpKeys;
 		
-		Buffer* tmpVals = fromVals;
+		BufferRange tmpVals = fromVals;
 		fromVals = toVals;
 		toVals = tmpVals;
 	}
 	
-	depositTemporaryBuffer(deviceHistograms);
-	depositTemporaryBuffer(deviceTempKeysBuffer);
-	depositTemporaryBuffer(deviceTempValsBuffer);
-	
-	ASSERT(fromKeys == outputKeys);
-	ASSERT(fromVals == outputValues);
+	ASSERT(fromKeys == BufferRange(outputKeys));
+	ASSERT(fromVals == BufferRange(outputValues));
 	
 	cmdEndDebugMarker(pCmd);
 }
@@ -548,11 +553,12 @@ void ParallelPrimitives::sortRadix(Cmd* pCmd, Buffer* inputKeys, Buffer* outputK
 	uint32_t groupBlockSize = (ParallelPrimitives::workgroupSize * 4 * 8);
 	uint32_t blockCount = (elementCount.mUpperLimit + groupBlockSize - 1) / groupBlockSize;
 	
-	Buffer* deviceHistograms = this->temporaryBuffer(sizeof(int32_t) * blockCount * 16);
-	Buffer* deviceTempKeys = this->temporaryBuffer(sizeof(int32_t) * elementCount.mUpperLimit);
+	BufferRange deviceHistograms = this->temporaryBuffer(sizeof(int32_t) * blockCount * 16);
+	BufferRange deviceTempKeys = this->temporaryBuffer(sizeof(int32_t) * elementCount.mUpperLimit);
 	
-	Buffer* fromKeys = inputKeys;
-	Buffer* toKeys = deviceTempKeys;
+	BufferRange countRange(elementCount.pBuffer);
+	BufferRange fromKeys = inputKeys;
+	BufferRange toKeys = deviceTempKeys;
 	
 	PipelineComponents& histogramKernel = mBitHistogram;
 	PipelineComponents& scatterKeys = mScatterKeys;
@@ -573,21 +579,18 @@ void ParallelPrimitives::sortRadix(Cmd* pCmd, Buffer* inputKeys, Buffer* outputK
 			cmdBindPipeline(pCmd, histogramKernel.pPipeline);
 			
 			cmdBindPushConstants(pCmd, histogramKernel.pRootSignature, "rootConstants", &offset);
-			params[0].ppBuffers = &fromKeys;
-			params[0].pName = "inputArray";
-			params[1].ppBuffers = &deviceHistograms;
-			params[1].pName = "outHistogram";
-			params[2].ppBuffers = &elementCount.pBuffer;
-			params[2].pName = "elementCount";
+			setBufferParam(&params[0], "inputArray", &fromKeys);
+			setBufferParam(&params[1], "outHistogram", &deviceHistograms);
+			setBufferParam(&params[2], "elementCount", &countRange);
 			
-			uint32_t setIndex = incrementSetIndex(&histogramKernel.mNextSetIndex);
+			uint32_t setIndex = nextSetIndex(&histogramKernel);
 			updateDescriptorSet(pCmd->pRenderer, setIndex, histogramKernel.pDescriptorSet, 3, params);
 			cmdBindDescriptorSet(pCmd, setIndex, histogramKernel.pDescriptorSet);
 			
 			cmdDispatch(pCmd, blockCount, 1, 1);
 			
 			BufferBarrier barriers[] = {
-				{ deviceHistograms, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+				{ deviceHistograms.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
 			};
 			cmdResourceBarrier(pCmd, sizeof(barriers) / sizeof(barriers[0]), barriers, 0, NULL, 0, NULL);
 		}
@@ -600,23 +603,19 @@ void ParallelPrimitives::sortRadix(Cmd* pCmd, Buffer* inputKeys, Buffer* outputK
 			cmdBindPipeline(pCmd, scatterKeys.pPipeline);
 			
 			cmdBindPushConstants(pCmd, scatterKeys.pRootSignature, "rootConstants", &offset);
-			params[0].ppBuffers = &fromKeys;
-			params[0].pName = "inputKeys";
-			params[1].ppBuffers = &elementCount.pBuffer;
-			params[1].pName = "elementCount";
-			params[2].ppBuffers = &deviceHistograms;
-			params[2].pName = "inputHistograms";
-			params[3].ppBuffers = &toKeys;
-			params[3].pName = "outputKeys";
+			setBufferParam(&params[0], "inputKeys", &fromKeys);
+			setBufferParam(&params[1], "elementCount", &countRange);
+			setBufferParam(&params[2], "inputHistograms", &deviceHistograms);
+			setBufferParam(&params[3], "outputKeys", &toKeys);
 			
-			uint32_t setIndex = incrementSetIndex(&scatterKeys.mNextSetIndex);
+			uint32_t setIndex = nextSetIndex(&scatterKeys);
 			updateDescriptorSet(pCmd->pRenderer, setIndex, scatterKeys.pDescriptorSet, 4, params);
 			cmdBindDescriptorSet(pCmd, setIndex, scatterKeys.pDescriptorSet);
 			
 			cmdDispatch(pCmd, blockCount, 1, 1);
 			
 			BufferBarrier barriers[] = {
-				{ toKeys, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
+				{ toKeys.pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS, false },
 			};
 			cmdResourceBarrier(pCmd, sizeof(barriers) / sizeof(barriers[0]), barriers, 0, NULL, 0, NULL);
 		}
@@ -630,12 +629,12 @@ void ParallelPrimitives::sortRadix(Cmd* pCmd, Buffer* inputKeys, Buffer* outputK
 		}
 		
 		// Swap pointers
-		Buffer* tmpKeys = fromKeys;
+		BufferRange tmpKeys = fromKeys;
 		fromKeys = toKeys;
 		toKeys = tmpKeys;
 	}
 	
-	ASSERT(fromKeys == outputKeys);
+	ASSERT(fromKeys == BufferRange(outputKeys));
 	
 	cmdEndDebugMarker(pCmd);
 }
@@ -654,23 +653,24 @@ void ParallelPrimitives::generateOffsetBuffer(Cmd* pCmd, Buffer* sortedCategoryI
 	pushConstants.categoryCount = categoryCount;
 	pushConstants.indirectThreadsPerThreadgroup = indirectThreadsPerThreadgroup;
 	
+	BufferRange sortedIndices(sortedCategoryIndices);
+	BufferRange indicesCount(sortedIndicesCount.pBuffer);
+	BufferRange offsets(outputBuffer);
+	BufferRange totals(totalCountOutputBuffer);
+
 	DescriptorData params[4] = {};
 	
-	params[0].ppBuffers = &sortedCategoryIndices;
-	params[0].pName = "sortedIndices";
-	params[1].ppBuffers = &sortedIndicesCount.pBuffer;
-	params[1].pName = "sortedIndicesCount";
-	params[2].ppBuffers = &outputBuffer;
-	params[2].pName = "offsetBuffer";
-	params[3].ppBuffers = &totalCountOutputBuffer;
-	params[3].pName = "totalCountAndIndirectArgs";
+	setBufferParam(&params[0], "sortedIndices", &sortedIndices);
+	setBufferParam(&params[1], "sortedIndicesCount", &indicesCount);
+	setBufferParam(&params[2], "offsetBuffer", &offsets);
+	setBufferParam(&params[3], "totalCountAndIndirectArgs", &totals);
 
 	{
 		cmdBindPipeline(pCmd, mClearOffsetBuffer.pPipeline);
 		
 		cmdBindPushConstants(pCmd, mClearOffsetBuffer.pRootSignature, "rootConstants", &pushConstants);
 		
-		uint32_t setIndex = incrementSetIndex(&mClearOffsetBuffer.mNextSetIndex);
+		uint32_t setIndex = nextSetIndex(&mClearOffsetBuffer);
 		updateDescriptorSet(pCmd->pRenderer, setIndex, mClearOffsetBuffer.pDescriptorSet, 4, params);
 		cmdBindDescriptorSet(pCmd, setIndex, mClearOffsetBuffer.pDescriptorSet);
 		
@@ -687,7 +687,7 @@ void ParallelPrimitives::generateOffsetBuffer(Cmd* pCmd, Buffer* sortedCategoryI
 		
 		cmdBindPushConstants(pCmd, mGenerateOffsetBuffer.pRootSignature, "rootConstants", &pushConstants);
 		
-		uint32_t setIndex = incrementSetIndex(&mGenerateOffsetBuffer.mNextSetIndex);
+		uint32_t setIndex = nextSetIndex(&mGenerateOffsetBuffer);
 		updateDescriptorSet(pCmd->pRenderer, setIndex, mGenerateOffsetBuffer.pDescriptorSet, 4, params);
 		cmdBindDescriptorSet(pCmd, setIndex, mGenerateOffsetBuffer.pDescriptorSet);
 		
@@ -721,16 +721,17 @@ void ParallelPrimitives::generateIndirectArgumentsFromOffsetBuffer(Cmd* pCmd, Bu
 	
 	cmdBindPushConstants(pCmd, mIndirectArgsFromOffsetBuffer.pRootSignature, "rootConstants", &pushConstants);
 	
+	BufferRange offsets(offsetBuffer);
+	BufferRange totalIndexCount(activeIndexCountBuffer);
+	BufferRange indirectArguments(outIndirectArgumentsBuffer);
+
 	DescriptorData params[3] = {};
 	
-	params[0].ppBuffers = &offsetBuffer;
-	params[0].pName = "offsetBuffer";
-	params[1].ppBuffers = &activeIndexCountBuffer;
-	params[1].pName = "totalIndexCount";
-	params[2].ppBuffers = &outIndirectArgumentsBuffer;
-	params[2].pName = "indirectArgumentsBuffer";
+	setBufferParam(&params[0], "offsetBuffer", &offsets);
+	setBufferParam(&params[1], "totalIndexCount", &totalIndexCount);
+	setBufferParam(&params[2], "indirectArgumentsBuffer", &indirectArguments);
 	
-	uint32_t setIndex = incrementSetIndex(&mIndirectArgsFromOffsetBuffer.mNextSetIndex);
+	uint32_t setIndex = nextSetIndex(&mIndirectArgsFromOffsetBuffer);
 	updateDescriptorSet(pCmd->pRenderer, setIndex, mIndirectArgsFromOffsetBuffer.pDescriptorSet, 3, params);
 	cmdBindDescriptorSet(pCmd, setIndex, mIndirectArgsFromOffsetBuffer.pDescriptorSet);
 		
@@ -53,9 +53,15 @@ struct IndirectCountBuffer {
 	IndirectCountBuffer(uint32_t count, Buffer* buffer) : mUpperLimit(count), pBuffer(buffer) {};
 };
 
+// Temporaries are sub-allocated from a linear scratch arena per frame in flight, and every pipeline has a ring of
+// descriptor sets per frame. Both are only recycled by beginFrame, once the GPU is done with that frame, so any
+// number of sorts can be recorded in a frame without one reusing memory or sets another one is still reading.
 struct ParallelPrimitives {
 public:
-	static const uint32_t setsPerPipeline = 1024;
+	static const uint32_t setsPerFrame = 512;
+	// Offsets of sub-allocations, enough for the storage buffer offset alignment of every API
+	static const uint64_t scratchAlignment = 256;
+	static const uint64_t minScratchChunkSize = 4 * 1024 * 1024;
 	
 	static const uint32_t workgroupSize = 64;
 	static const uint32_t scanElementsPerWorkItem = 8;
@@ -63,8 +69,13 @@ public:
 	static const uint32_t scanElementsPerWorkgroup = workgroupSize * scanElementsPerWorkItem;
 	static const uint32_t segmentScanElementsPerWorkgroup = workgroupSize * segmentScanElementsPerWorkItem;
 	
-	ParallelPrimitives(Renderer* pRenderer);
+	// frameCount is the number of frames in flight
+	ParallelPrimitives(Renderer* pRenderer, uint32_t frameCount);
 	~ParallelPrimitives();
+	
+	// Recycles the scratch memory and descriptor sets of frameIndex, call it before recording any work for the frame.
+	// The GPU has to be done with everything recorded the last time frameIndex was used.
+	void beginFrame(uint32_t frameIndex);
     
 	void scanExclusiveAdd(Cmd* pCmd, Buffer* input, Buffer* output, uint32_t elementCount);
 	void sortRadix(Cmd* pCmd, Buffer* inputKeys, Buffer* outputKeys, IndirectCountBuffer elementCount, uint32_t maxKey = ~0);
@@ -75,8 +86,28 @@ public:
 	void generateIndirectArgumentsFromOffsetBuffer(Cmd* pCmd, Buffer* offsetBuffer, Buffer* activeIndexCountBuffer, Buffer* outIndirectArgumentsBuffer, uint32_t categoryCount, uint32_t indirectThreadsPerThreadgroup);
 	
 private:
+	// A whole buffer or a sub-allocation of the scratch arena, bound with an offset
+	struct BufferRange {
+		Buffer* pBuffer;
+		uint64_t mOffset;
+		uint64_t mSize;
+		
+		BufferRange() : pBuffer(NULL), mOffset(0), mSize(0) {}
+		BufferRange(Buffer* buffer) : pBuffer(buffer), mOffset(0), mSize(buffer->mSize) {}
+		bool operator==(const BufferRange& other) const { return pBuffer == other.pBuffer && mOffset == other.mOffset; }
+	};
+	
+	struct ScratchArena {
+		eastl::vector<Buffer*> mChunks;
+		uint32_t mChunkIndex;
+		uint64_t mChunkOffset;
+		
+		ScratchArena() : mChunkIndex(0), mChunkOffset(0) {}
+	};
+	
 	struct PipelineComponents {
-		uint32_t mNextSetIndex;
+		// Sets handed out in the current frame, the frame owns sets [frameIndex * setsPerFrame, (frameIndex + 1) * setsPerFrame)
+		uint32_t mUsedSetCount;
 		Renderer* pRenderer;
 		DescriptorSet* pDescriptorSet;
 		Shader* pShader;
@@ -86,10 +117,12 @@ private:
 		PipelineComponents();
 		~PipelineComponents();
 		
-		void init(Renderer* renderer, const char* functionName);
+		void init(Renderer* renderer, const char* functionName, uint32_t frameCount);
 	};
 	
 	Renderer* pRenderer;
+	uint32_t mFrameCount;
+	uint32_t mFrameIndex;
 	
 	PipelineComponents mScanExclusiveInt4;
 	PipelineComponents mScanExclusivePartInt4;
@@ -101,18 +134,24 @@ private:
 	PipelineComponents mGenerateOffsetBuffer;
 	PipelineComponents mIndirectArgsFromOffsetBuffer;
 	
-	eastl::vector<Buffer*> mTemporaryBuffers;
+	// One per frame in flight
+	eastl::vector<ScratchArena> mScratchArenas;
 	
 	CommandSignature* pCommandSignature;
 	
-	Buffer* temporaryBuffer(size_t length);
-	void depositTemporaryBuffer(Buffer* buffer);
+	// Binds the range, offset included
+	static void setBufferParam(DescriptorData* pParam, const char* name, BufferRange* pRange);
 	
+	Buffer* addScratchChunk(uint64_t size);
+	BufferRange temporaryBuffer(uint64_t length);
 	
-	inline uint32_t incrementSetIndex(uint32_t* setIndex) {
-		uint32_t index = *setIndex;
-		*setIndex = (*setIndex + 1) % ParallelPrimitives::setsPerPipeline;
-		return index;
+	inline uint32_t nextSetIndex(PipelineComponents* pipeline) {
+		if (pipeline->mUsedSetCount >= ParallelPrimitives::setsPerFrame) {
+			LOGF(LogLevel::eERROR, "ParallelPrimitives ran out of descriptor sets for this frame, increase setsPerFrame");
+			ASSERT(false);
+			pipeline->mUsedSetCount = 0;
+		}
+		return mFrameIndex * ParallelPrimitives::setsPerFrame + pipeline->mUsedSetCount++;
 	}
 	
 	inline unsigned int clz32a( uint32_t x ) /* 32-bit clz */
@@ -125,9 +164,11 @@ private:
 		return n;
 	}
 	
-	void scanExclusiveAddWG(Cmd* pCmd, Buffer* input, Buffer* output, uint32_t elementCount);
+	void scanExclusiveAdd(Cmd* pCmd, BufferRange input, BufferRange output, uint32_t elementCount);
+	
+	void scanExclusiveAddWG(Cmd* pCmd, BufferRange input, BufferRange output, uint32_t elementCount);
     
-	void scanExclusiveAddTwoLevel(Cmd* pCmd, Buffer* input, Buffer* output, uint32_t elementCount);
+	void scanExclusiveAddTwoLevel(Cmd* pCmd, BufferRange input, BufferRange output, uint32_t elementCount);
     
-	void scanExclusiveAddThreeLevel(Cmd* pCmd, Buffer* input, Buffer* output, uint32_t elementCount);
+	void scanExclusiveAddThreeLevel(Cmd* pCmd, BufferRange input, BufferRange output, uint32_t elementCount);
 };
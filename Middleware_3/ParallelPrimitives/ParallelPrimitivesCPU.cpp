@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2018-2020 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "ParallelPrimitivesCPU.h"
+
+#include "../../Common_3/OS/Math/MathTypes.h"
+#include "../../Common_3/OS/Interfaces/ILog.h"
+
+#if VECTORMATH_MODE_SSE
+#include <emmintrin.h>
+#endif
+
+#include "../../Common_3/OS/Interfaces/IMemory.h"
+
+struct BlockJob {
+	void (*pfnBlock)(void* pUser, uint32_t blockIndex);
+	void* pUser;
+};
+
+static void blockTask(void* pUser, uintptr_t index) {
+	BlockJob* pJob = (BlockJob*)pUser;
+	pJob->pfnBlock(pJob->pUser, (uint32_t)index);
+}
+
+// Elements [begin, end) of block blockIndex out of blockCount, blocks are multiples of 4 so the SIMD loops line up
+static void blockRange(uint32_t elementCount, uint32_t blockCount, uint32_t blockIndex, uint32_t* pBegin, uint32_t* pEnd) {
+	uint32_t blockSize = ((elementCount + blockCount - 1) / blockCount + 3) & ~3u;
+	*pBegin = min(blockIndex * blockSize, elementCount);
+	*pEnd = min(*pBegin + blockSize, elementCount);
+}
+
+// Exclusive scan of count elements on top of carry, returns the carry for the elements after them
+static uint32_t scanExclusiveBlock(const uint32_t* input, uint32_t* output, uint32_t count, uint32_t carry) {
+	uint32_t i = 0;
+#if VECTORMATH_MODE_SSE
+	__m128i sum = _mm_set1_epi32((int)carry);
+	for (; i + 4 <= count; i += 4) {
+		// Inclusive scan of the 4 lanes in two shifted adds, the exclusive one is that shifted up by a lane
+		__m128i x = _mm_loadu_si128((const __m128i*)(input + i));
+		x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+		x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+		_mm_storeu_si128((__m128i*)(output + i), _mm_add_epi32(sum, _mm_slli_si128(x, 4)));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3)));
+	}
+	carry = (uint32_t)_mm_cvtsi128_si32(sum);
+#elif VECTORMATH_MODE_NEON
+	uint32x4_t zero = vdupq_n_u32(0);
+	uint32x4_t sum = vdupq_n_u32(carry);
+	for (; i + 4 <= count; i += 4) {
+		uint32x4_t x = vld1q_u32(input + i);
+		x = vaddq_u32(x, vextq_u32(zero, x, 3));
+		x = vaddq_u32(x, vextq_u32(zero, x, 2));
+		vst1q_u32(output + i, vaddq_u32(sum, vextq_u32(zero, x, 3)));
+		sum = vaddq_u32(sum, vdupq_n_u32(vgetq_lane_u32(x, 3)));
+	}
+	carry = vgetq_lane_u32(sum, 0);
+#endif
+	for (; i < count; ++i) {
+		uint32_t value = input[i];
+		output[i] = carry;
+		carry += value;
+	}
+	return carry;
+}
+
+static uint32_t sumBlock(const uint32_t* input, uint32_t count) {
+	uint32_t i = 0;
+	uint32_t sum = 0;
+#if VECTORMATH_MODE_SSE
+	__m128i sums = _mm_setzero_si128();
+	for (; i + 4 <= count; i += 4) {
+		sums = _mm_add_epi32(sums, _mm_loadu_si128((const __m128i*)(input + i)));
+	}
+	sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(1, 0, 3, 2)));
+	sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(2, 3, 0, 1)));
+	sum = (uint32_t)_mm_cvtsi128_si32(sums);
+#elif VECTORMATH_MODE_NEON
+	uint32x4_t sums = vdupq_n_u32(0);
+	for (; i + 4 <= count; i += 4) {
+		sums = vaddq_u32(sums, vld1q_u32(input + i));
+	}
+	sum = vgetq_lane_u32(sums, 0) + vgetq_lane_u32(sums, 1) + vgetq_lane_u32(sums, 2) + vgetq_lane_u32(sums, 3);
+#endif
+	for (; i < count; ++i) {
+		sum += input[i];
+	}
+	return sum;
+}
+
+ParallelPrimitivesCPU::ParallelPrimitivesCPU(ThreadSystem* threadSystem) : pThreadSystem(threadSystem) {}
+
+ParallelPrimitivesCPU::~ParallelPrimitivesCPU() {
+	mTemporaryKeys.set_capacity(0);
+	mTemporaryValues.set_capacity(0);
+	mBlockHistograms.set_capacity(0);
+	mBlockSums.set_capacity(0);
+}
+
+uint32_t ParallelPrimitivesCPU::blockCount(uint32_t elementCount) const {
+	if (!pThreadSystem) {
+		return 1;
+	}
+	// The calling thread works too
+	uint32_t threadCount = getThreadSystemThreadCount(pThreadSystem) + 1;
+	uint32_t count = min(threadCount, (elementCount + minElementsPerBlock - 1) / minElementsPerBlock);
+	return max(min(count, maxBlockCount), 1u);
+}
+
+void ParallelPrimitivesCPU::runBlocks(BlockFunc func, void* pUser, uint32_t blockCount) {
+	BlockJob job = {};
+	job.pfnBlock = func;
+	job.pUser = pUser;
+	runThreadSystemRangeTaskAndWait(pThreadSystem, blockTask, &job, blockCount);
+}
+
+struct ScanJob {
+	const uint32_t* input;
+	uint32_t* output;
+	uint32_t* blockSums;
+	uint32_t elementCount;
+	uint32_t blockCount;
+};
+
+static void scanSumBlock(void* pUser, uint32_t blockIndex) {
+	ScanJob* pJob = (ScanJob*)pUser;
+	uint32_t begin, end;
+	blockRange(pJob->elementCount, pJob->blockCount, blockIndex, &begin, &end);
+	pJob->blockSums[blockIndex] = sumBlock(pJob->input + begin, end - begin);
+}
+
+static void scanDistributeBlock(void* pUser, uint32_t blockIndex) {
+	ScanJob* pJob = (ScanJob*)pUser;
+	uint32_t begin, end;
+	blockRange(pJob->elementCount, pJob->blockCount, blockIndex, &begin, &end);
+	scanExclusiveBlock(pJob->input + begin, pJob->output + begin, end - begin, pJob->blockSums[blockIndex]);
+}
+
+void ParallelPrimitivesCPU::scanExclusiveAdd(const uint32_t* input, uint32_t* output, uint32_t elementCount) {
+	ASSERT((input && output) || !elementCount);
+
+	uint32_t blocks = blockCount(elementCount);
+	if (blocks <= 1) {
+		scanExclusiveBlock(input, output, elementCount, 0);
+		return;
+	}
+
+	// Sum every block, scan the sums, then scan every block on top of its sum
+	mBlockSums.resize(blocks);
+	ScanJob job = { input, output, mBlockSums.data(), elementCount, blocks };
+	runBlocks(scanSumBlock, &job, blocks);
+	scanExclusiveBlock(mBlockSums.data(), mBlockSums.data(), blocks, 0);
+	runBlocks(scanDistributeBlock, &job, blocks);
+}
+
+struct RadixJob {
+	const uint32_t* fromKeys;
+	const uint32_t* fromValues;
+	uint32_t* toKeys;
+	uint32_t* toValues;
+	uint32_t* histograms;
+	uint32_t elementCount;
+	uint32_t blockCount;
+	uint32_t shift;
+	uint32_t mask;
+};
+
+static void radixHistogramBlock(void* pUser, uint32_t blockIndex) {
+	RadixJob* pJob = (RadixJob*)pUser;
+	uint32_t begin, end;
+	blockRange(pJob->elementCount, pJob->blockCount, blockIndex, &begin, &end);
+
+	uint32_t* histogram = pJob->histograms + blockIndex * ParallelPrimitivesCPU::radixBinCount;
+	memset(histogram, 0, ParallelPrimitivesCPU::radixBinCount * sizeof(uint32_t));
+	for (uint32_t i = begin; i < end; ++i) {
+		++histogram[(pJob->fromKeys[i] >> pJob->shift) & pJob->mask];
+	}
+}
+
+static void radixScatterBlock(void* pUser, uint32_t blockIndex) {
+	RadixJob* pJob = (RadixJob*)pUser;
+	uint32_t begin, end;
+	blockRange(pJob->elementCount, pJob->blockCount, blockIndex, &begin, &end);
+
+	// Offsets of this block's elements for each digit, in element order to keep the sort stable
+	uint32_t offsets[ParallelPrimitivesCPU::radixBinCount];
+	memcpy(offsets, pJob->histograms + blockIndex * ParallelPrimitivesCPU::radixBinCount, sizeof(offsets));
+
+	if (pJob->fromValues) {
+		for (uint32_t i = begin; i < end; ++i) {
+			uint32_t key = pJob->fromKeys[i];
+			uint32_t destination = offsets[(key >> pJob->shift) & pJob->mask]++;
+			pJob->toKeys[destination] = key;
+			pJob->toValues[destination] = pJob->fromValues[i];
+		}
+	} else {
+		for (uint32_t i = begin; i < end; ++i) {
+			uint32_t key = pJob->fromKeys[i];
+			pJob->toKeys[offsets[(key >> pJob->shift) & pJob->mask]++] = key;
+		}
+	}
+}
+
+void ParallelPrimitivesCPU::sortRadix(const uint32_t* inputKeys, const uint32_t* inputValues, uint32_t* outputKeys, uint32_t* outputValues, uint32_t elementCount, uint32_t maxKey) {
+	ASSERT((inputKeys && outputKeys) || !elementCount);
+	ASSERT(!inputValues == !outputValues);
+
+	// The GPU sorts 4 bits per pass up to the highest bit of maxKey, higher bits keep their input order
+	uint32_t keyBits = 0;
+	while (keyBits < 32 && (maxKey >> keyBits)) {
+		keyBits += 4;
+	}
+	uint32_t passCount = (keyBits + radixBits - 1) / radixBits;
+
+	if (passCount == 0 || elementCount <= 1) {
+		if (elementCount && outputKeys != inputKeys) {
+			memcpy(outputKeys, inputKeys, elementCount * sizeof(uint32_t));
+		}
+		if (elementCount && outputValues != inputValues) {
+			memcpy(outputValues, inputValues, elementCount * sizeof(uint32_t));
+		}
+		return;
+	}
+
+	// Ping-pong so the last pass lands in the output, or through the temporaries if the output is also the input
+	mTemporaryKeys.resize(elementCount);
+	if (inputValues) {
+		mTemporaryValues.resize(elementCount);
+	}
+	uint32_t* keyBuffers[2] = { outputKeys, mTemporaryKeys.data() };
+	uint32_t* valueBuffers[2] = { outputValues, inputValues ? mTemporaryValues.data() : NULL };
+	bool inPlace = inputKeys == outputKeys || (inputValues && inputValues == outputValues);
+	uint32_t target = (passCount % 2 == 1 && !inPlace) ? 0 : 1;
+
+	uint32_t blocks = blockCount(elementCount);
+	mBlockHistograms.resize(blocks * radixBinCount);
+
+	RadixJob job = {};
+	job.fromKeys = inputKeys;
+	job.fromValues = inputValues;
+	job.histograms = mBlockHistograms.data();
+	job.elementCount = elementCount;
+	job.blockCount = blocks;
+
+	for (uint32_t pass = 0; pass < passCount; ++pass) {
+		job.toKeys = keyBuffers[target];
+		job.toValues = valueBuffers[target];
+		job.shift = pass * radixBits;
+		job.mask = (1u << min(radixBits, keyBits - job.shift)) - 1;
+
+		runBlocks(radixHistogramBlock, &job, blocks);
+
+		// Digit major, block minor, so equal digits keep the block order
+		uint32_t offset = 0;
+		for (uint32_t digit = 0; digit <= job.mask; ++digit) {
+			for (uint32_t block = 0; block < blocks; ++block) {
+				uint32_t& count = mBlockHistograms[block * radixBinCount + digit];
+				uint32_t digitCount = count;
+				count = offset;
+				offset += digitCount;
+			}
+		}
+
+		runBlocks(radixScatterBlock, &job, blocks);
+
+		job.fromKeys = job.toKeys;
+		job.fromValues = job.toValues;
+		target ^= 1;
+	}
+
+	if (job.fromKeys != outputKeys) {
+		memcpy(outputKeys, job.fromKeys, elementCount * sizeof(uint32_t));
+	}
+	if (inputValues && job.fromValues != outputValues) {
+		memcpy(outputValues, job.fromValues, elementCount * sizeof(uint32_t));
+	}
+}
+
+void ParallelPrimitivesCPU::sortRadix(const uint32_t* inputKeys, uint32_t* outputKeys, uint32_t elementCount, uint32_t maxKey) {
+	sortRadix(inputKeys, NULL, outputKeys, NULL, elementCount, maxKey);
+}
+
+void ParallelPrimitivesCPU::sortRadixKeysValues(const uint32_t* inputKeys, const uint32_t* inputValues, uint32_t* outputKeys, uint32_t* outputValues, uint32_t elementCount, uint32_t maxKey) {
+	ASSERT((inputValues && outputValues) || !elementCount);
+	sortRadix(inputKeys, inputValues, outputKeys, outputValues, elementCount, maxKey);
+}
+
+struct OffsetBufferJob {
+	const uint32_t* sortedIndices;
+	uint32_t* offsetBuffer;
+	uint32_t* totalCountAndIndirectArgs;
+	uint32_t sortedIndicesCount;
+	uint32_t categoryCount;
+	uint32_t indirectThreadsPerThreadgroup;
+	uint32_t blockCount;
+};
+
+// Same as the GenerateOffsetBuffer kernel, one element at a time. Elements only write to offsets nobody else writes.
+static void generateOffsetBufferBlock(void* pUser, uint32_t blockIndex) {
+	OffsetBufferJob* pJob = (OffsetBufferJob*)pUser;
+	uint32_t begin, end;
+	blockRange(pJob->sortedIndicesCount, pJob->blockCount, blockIndex, &begin, &end);
+
+	const uint32_t categoryCount = pJob->categoryCount;
+	for (uint32_t globalId = begin; globalId < end; ++globalId) {
+		uint32_t indexInIndices = globalId + 1;
+		uint32_t previousIndex = pJob->sortedIndices[indexInIndices - 1];
+		uint32_t currentIndex = indexInIndices == pJob->sortedIndicesCount ? categoryCount : pJob->sortedIndices[indexInIndices];
+
+		if (previousIndex < currentIndex && previousIndex + 1 < categoryCount) {
+			pJob->offsetBuffer[previousIndex + 1] = indexInIndices;
+			if (currentIndex < categoryCount) {
+				pJob->offsetBuffer[currentIndex] = indexInIndices;
+			}
+		}
+
+		if (globalId == 0) {
+			pJob->offsetBuffer[0] = 0;
+			if (previousIndex < categoryCount) {
+				pJob->offsetBuffer[previousIndex] = 0;
+			}
+		}
+
+		// The last active element, or the first one when none is active
+		if (currentIndex >= categoryCount && (previousIndex < categoryCount || globalId == 0)) {
+			uint32_t activeCount = previousIndex < categoryCount ? indexInIndices : 0;
+			uint32_t threadgroupsX = (activeCount + pJob->indirectThreadsPerThreadgroup - 1) / pJob->indirectThreadsPerThreadgroup;
+			pJob->totalCountAndIndirectArgs[0] = activeCount;
+			pJob->totalCountAndIndirectArgs[1] = max(1u, threadgroupsX);
+			pJob->totalCountAndIndirectArgs[2] = 1;
+			pJob->totalCountAndIndirectArgs[3] = 1;
+		}
+	}
+}
+
+void ParallelPrimitivesCPU::generateOffsetBuffer(const uint32_t* sortedCategoryIndices, uint32_t* outputBuffer, uint32_t* totalCountOutput, uint32_t sortedIndicesCount, uint32_t categoryCount, uint32_t indirectThreadsPerThreadgroup) {
+	ASSERT(outputBuffer && totalCountOutput);
+	ASSERT(sortedCategoryIndices || !sortedIndicesCount);
+	ASSERT(indirectThreadsPerThreadgroup);
+
+	// ClearOffsetBuffer
+	memset(outputBuffer, 0xFF, categoryCount * sizeof(uint32_t));
+
+	if (sortedIndicesCount == 0) {
+		memset(totalCountOutput, 0, 4 * sizeof(uint32_t));
+		return;
+	}
+
+	uint32_t blocks = blockCount(sortedIndicesCount);
+	OffsetBufferJob job = { sortedCategoryIndices, outputBuffer, totalCountOutput, sortedIndicesCount, categoryCount, indirectThreadsPerThreadgroup, blocks };
+	runBlocks(generateOffsetBufferBlock, &job, blocks);
+}
+
+struct IndirectArgumentsJob {
+	const uint32_t* offsetBuffer;
+	uint32_t* indirectArguments;
+	uint32_t totalIndexCount;
+	uint32_t categoryCount;
+	uint32_t indirectThreadsPerThreadgroup;
+	uint32_t blockCount;
+};
+
+static void generateIndirectArgumentsBlock(void* pUser, uint32_t blockIndex) {
+	IndirectArgumentsJob* pJob = (IndirectArgumentsJob*)pUser;
+	uint32_t begin, end;
+	blockRange(pJob->categoryCount, pJob->blockCount, blockIndex, &begin, &end);
+
+	for (uint32_t categoryIndex = begin; categoryIndex < end; ++categoryIndex) {
+		uint32_t threadIndexLowerBound = pJob->offsetBuffer[categoryIndex];
+		uint32_t threadIndexUpperBound = threadIndexLowerBound;
+		if (threadIndexLowerBound != UINT32_MAX) {
+			threadIndexUpperBound = (categoryIndex + 1 >= pJob->categoryCount) ? pJob->totalIndexCount : pJob->offsetBuffer[categoryIndex + 1];
+			if (threadIndexUpperBound == UINT32_MAX) {
+				threadIndexUpperBound = threadIndexLowerBound;
+			}
+		}
+
+		uint32_t count = threadIndexUpperBound - threadIndexLowerBound;
+		uint32_t* output = pJob->indirectArguments + ParallelPrimitivesCPU::indirectArgumentsStride * categoryIndex;
+		output[0] = threadIndexLowerBound;
+		output[1] = count;
+		output[2] = (count + pJob->indirectThreadsPerThreadgroup - 1) / pJob->indirectThreadsPerThreadgroup;
+		output[3] = 1;
+		output[4] = 1;
+	}
+}
+
+void ParallelPrimitivesCPU::generateIndirectArgumentsFromOffsetBuffer(const uint32_t* offsetBuffer, uint32_t activeIndexCount, uint32_t* outIndirectArguments, uint32_t categoryCount, uint32_t indirectThreadsPerThreadgroup) {
+	ASSERT((offsetBuffer && outIndirectArguments) || !categoryCount);
+	ASSERT(indirectThreadsPerThreadgroup);
+
+	uint32_t blocks = blockCount(categoryCount);
+	IndirectArgumentsJob job = { offsetBuffer, outIndirectArguments, activeIndexCount, categoryCount, indirectThreadsPerThreadgroup, blocks };
+	runBlocks(generateIndirectArgumentsBlock, &job, blocks);
+}
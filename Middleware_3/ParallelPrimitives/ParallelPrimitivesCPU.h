@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2018-2020 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// CPU twin of ParallelPrimitives, working on plain arrays instead of GPU buffers.
+// Every function produces the same output the matching GPU pipeline writes, bit for bit, so it can run the same
+// culling and sorting on the CPU and serve as a reference for the shaders. Work is split into blocks run on the
+// ThreadSystem passed in, the calling thread helps out until its blocks are done. Without a ThreadSystem, or for
+// small inputs, everything runs on the calling thread.
+
+#pragma once
+
+#include "../../Common_3/ThirdParty/OpenSource/EASTL/vector.h"
+#include "../../Common_3/OS/Core/ThreadSystem.h"
+
+struct ParallelPrimitivesCPU {
+public:
+	// Below this many elements per block the fork / join costs more than the work
+	static const uint32_t minElementsPerBlock = 16 * 1024;
+	static const uint32_t maxBlockCount = MAX_LOAD_THREADS * 4;
+	// LSD radix sort digit, the sorted bit range is still rounded to the 4 bits of the GPU passes
+	static const uint32_t radixBits = 8;
+	static const uint32_t radixBinCount = 1 << radixBits;
+	// Stride in uint32_t of an entry written by generateIndirectArgumentsFromOffsetBuffer
+	static const uint32_t indirectArgumentsStride = 8;
+
+	ParallelPrimitivesCPU(ThreadSystem* pThreadSystem);
+	~ParallelPrimitivesCPU();
+
+	// Wraps around like the int adds of the GPU. output may be input.
+	void scanExclusiveAdd(const uint32_t* input, uint32_t* output, uint32_t elementCount);
+	// Stable, ascending in the low bits up to the highest set bit of maxKey, rounded up to a multiple of 4.
+	// Output may be the input.
+	void sortRadix(const uint32_t* inputKeys, uint32_t* outputKeys, uint32_t elementCount, uint32_t maxKey = ~0);
+	void sortRadixKeysValues(const uint32_t* inputKeys, const uint32_t* inputValues, uint32_t* outputKeys, uint32_t* outputValues, uint32_t elementCount, uint32_t maxKey = ~0);
+
+	// outputBuffer gets categoryCount entries, the index of the first element of each category or ~0.
+	// totalCountOutput gets the count of elements below categoryCount and the dispatch arguments for them.
+	void generateOffsetBuffer(const uint32_t* sortedCategoryIndices, uint32_t* outputBuffer, uint32_t* totalCountOutput, uint32_t sortedIndicesCount, uint32_t categoryCount, uint32_t indirectThreadsPerThreadgroup);
+
+	// indirectArgumentsStride uint32_t per category: offset, count, then threadgroups X, Y, Z. The rest is left alone.
+	void generateIndirectArgumentsFromOffsetBuffer(const uint32_t* offsetBuffer, uint32_t activeIndexCount, uint32_t* outIndirectArguments, uint32_t categoryCount, uint32_t indirectThreadsPerThreadgroup);
+
+private:
+	typedef void (*BlockFunc)(void* pUser, uint32_t blockIndex);
+
+	ThreadSystem* pThreadSystem;
+
+	eastl::vector<uint32_t> mTemporaryKeys;
+	eastl::vector<uint32_t> mTemporaryValues;
+	// radixBinCount counts per block, turned into scatter offsets in place
+	eastl::vector<uint32_t> mBlockHistograms;
+	eastl::vector<uint32_t> mBlockSums;
+
+	uint32_t blockCount(uint32_t elementCount) const;
+	void runBlocks(BlockFunc func, void* pUser, uint32_t blockCount);
+
+	void sortRadix(const uint32_t* inputKeys, const uint32_t* inputValues, uint32_t* outputKeys, uint32_t* outputValues, uint32_t elementCount, uint32_t maxKey);
+};